@@ -0,0 +1,53 @@
+/*
+ * Copyright ©2024 Hannah C. Tang.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Washington
+ * CSE 333 for use solely during Spring Quarter 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#ifndef HW3_BM25_H_
+#define HW3_BM25_H_
+
+#include <cmath>  // for std::log()
+
+namespace hw3 {
+
+// Okapi BM25 scoring.  These helpers are shared by WriteIndex, which
+// precomputes each word's maximum possible score, and QueryProcessor, which
+// scores postings at query time; using the same code on both sides keeps
+// the stored upper bounds consistent with the scores they bound.
+
+// The BM25 free parameters, set to the usual defaults: k1 controls how
+// quickly repeated occurrences of a word saturate, and b how strongly
+// scores are normalized by document length.
+static constexpr float kBM25K1 = 1.2f;
+static constexpr float kBM25B = 0.75f;
+
+// Returns the inverse document frequency of a word that appears in
+// "doc_freq" of "num_docs" documents.  Always positive.
+inline float BM25IDF(float num_docs, float doc_freq) {
+  return std::log(1.0f + (num_docs - doc_freq + 0.5f) / (doc_freq + 0.5f));
+}
+
+// Returns the length normalization term for a document with "doc_length"
+// words, in a collection whose mean document length is "avg_doc_length".
+inline float BM25LengthNorm(double doc_length, double avg_doc_length) {
+  double rel_length = avg_doc_length > 0.0 ?
+    doc_length / avg_doc_length : 1.0;
+  return kBM25K1 * (1.0f - kBM25B + kBM25B * rel_length);
+}
+
+// Returns the score contribution of a word with inverse document frequency
+// "idf" appearing "tf" times in a document with normalization term
+// "length_norm".
+inline float BM25Score(float idf, float tf, float length_norm) {
+  return idf * tf * (kBM25K1 + 1.0f) / (tf + length_norm);
+}
+
+}  // namespace hw3
+
+#endif  // HW3_BM25_H_
@@ -0,0 +1,82 @@
+/*
+ * Copyright ©2024 Hannah C. Tang.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Washington
+ * CSE 333 for use solely during Spring Quarter 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#include "./BloomFilter.h"
+
+#include <arpa/inet.h>  // for ntohl().
+#include <cstdio>       // for (FILE*)
+#include <vector>       // for std::vector
+
+extern "C" {
+  #include "libhw1/CSE333.h"
+}
+
+using std::vector;
+
+namespace hw3 {
+
+// The odd constants that pick each word's bit; any odd constants with
+// well-mixed bits would do.
+static const uint32_t kSalts[BloomFilter::kBlockWords] = {
+  0x47b6137bU, 0x44974d91U, 0x8824ad5bU, 0xa2b7289dU,
+  0x705495c7U, 0x2df1424bU, 0x9efc4947U, 0x5c6bfb31U
+};
+
+BloomFilter::BloomFilter(int64_t num_words) {
+  static constexpr int64_t kBlockBits = kBlockWords * 32;
+  num_blocks_ = (num_words * kBitsPerWord + kBlockBits - 1) / kBlockBits;
+  if (num_blocks_ == 0) {
+    num_blocks_ = 1;
+  }
+  words_.resize(num_blocks_ * kBlockWords, 0);
+}
+
+BloomFilter::BloomFilter(FILE* f, IndexFileOffset_t offset, int32_t bytes) {
+  static constexpr int32_t kBlockBytes = kBlockWords * sizeof(uint32_t);
+  Verify333(bytes > 0 && bytes % kBlockBytes == 0);
+  num_blocks_ = bytes / kBlockBytes;
+  words_.resize(num_blocks_ * kBlockWords);
+  Verify333(fseek(f, offset, SEEK_SET) == 0);
+  Verify333(fread(words_.data(), sizeof(uint32_t), words_.size(), f) ==
+            words_.size());
+  for (uint32_t& word : words_) {
+    word = ntohl(word);
+  }
+}
+
+void BloomFilter::Add(HTKey_t hash) {
+  uint32_t* block = &words_[BlockFor(hash)];
+  for (int i = 0; i < kBlockWords; i++) {
+    block[i] |= BitFor(hash, i);
+  }
+}
+
+bool BloomFilter::MayContain(HTKey_t hash) const {
+  const uint32_t* block = &words_[BlockFor(hash)];
+  for (int i = 0; i < kBlockWords; i++) {
+    if ((block[i] & BitFor(hash, i)) == 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+size_t BloomFilter::BlockFor(HTKey_t hash) const {
+  // Scale the upper half of the hash into [0, num_blocks_), which avoids a
+  // division.
+  return ((hash >> 32) * num_blocks_ >> 32) * kBlockWords;
+}
+
+uint32_t BloomFilter::BitFor(HTKey_t hash, int i) {
+  return 1U << ((static_cast<uint32_t>(hash) * kSalts[i]) >> 27);
+}
+
+}  // namespace hw3
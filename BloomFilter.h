@@ -0,0 +1,90 @@
+/*
+ * Copyright ©2024 Hannah C. Tang.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Washington
+ * CSE 333 for use solely during Spring Quarter 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#ifndef HW3_BLOOMFILTER_H_
+#define HW3_BLOOMFILTER_H_
+
+#include <stdint.h>  // for uint32_t, etc.
+#include <cstdio>    // for (FILE*)
+#include <vector>    // for std::vector
+
+#include "./LayoutStructs.h"
+#include "./Utils.h"
+
+extern "C" {
+  #include "libhw1/HashTable.h"  // for HTKey_t.
+}
+
+namespace hw3 {
+
+// A BloomFilter remembers a set of word hashes approximately: it can say
+// for certain that a hash was never added, but may claim that one was when
+// it wasn't.  Every index file carries one for its words, so that a lookup
+// in an index that doesn't have the word can usually stop without reading
+// any of the index.
+//
+// The filter is "blocked": it's an array of 256-bit blocks, and all of a
+// hash's bits are in the same block, chosen by the hash's upper 32 bits.
+// Within the block, the hash sets one bit in each of the block's eight
+// 32-bit words, chosen by multiplying its lower 32 bits by a different odd
+// constant for each word and keeping the top 5 bits of the product.  So a
+// probe touches a single cache line.  With kBitsPerWord bits per word, it
+// wrongly claims about 1 in 200 absent hashes.
+class BloomFilter {
+ public:
+  // The number of 32-bit words in a block.
+  static constexpr int kBlockWords = 8;
+
+  // The filter's size, in bits per word added.
+  static constexpr int kBitsPerWord = 12;
+
+  // Constructs an empty filter sized for "num_words" words.
+  explicit BloomFilter(int64_t num_words);
+
+  // Reads a filter out of the Bloom filter section of an index file.
+  // Arguments:
+  //
+  // - f: an open (FILE*) for the underlying index file.  Unlike the
+  //   index's other readers, the filter is read entirely into memory by
+  //   the constructor, so the caller keeps ownership of "f".
+  //
+  // - offset: the byte offset of the section's payload (i.e., just past
+  //   its SectionHeader) within the file.
+  //
+  // - bytes: the size of the section's payload.
+  BloomFilter(FILE* f, IndexFileOffset_t offset, int32_t bytes);
+
+  // Adds "hash" to the filter.
+  void Add(HTKey_t hash);
+
+  // Returns false if "hash" was certainly never added to the filter, and
+  // true if it probably was.
+  bool MayContain(HTKey_t hash) const;
+
+  // Returns the filter's words, in host byte order, for writing out.
+  const std::vector<uint32_t>& words() const { return words_; }
+
+ private:
+  // Returns the index of the first word of the block for "hash".
+  size_t BlockFor(HTKey_t hash) const;
+
+  // Returns the bit that "hash" sets in word "i" of its block.
+  static uint32_t BitFor(HTKey_t hash, int i);
+
+  std::vector<uint32_t> words_;
+  uint64_t num_blocks_;
+
+  DISALLOW_COPY_AND_ASSIGN(BloomFilter);
+};
+
+}  // namespace hw3
+
+#endif  // HW3_BLOOMFILTER_H_
@@ -0,0 +1,124 @@
+/*
+ * Copyright ©2024 Hannah C. Tang.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Washington
+ * CSE 333 for use solely during Spring Quarter 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <iterator>
+#include <memory>
+#include <string>
+
+#include "./CompressedFileCache.h"
+
+extern "C" {
+  #include "libhw1/CSE333.h"
+}
+
+using std::shared_ptr;
+using std::string;
+
+namespace hw4 {
+
+// A rough estimate of the bookkeeping overhead of a single entry, as for
+// QueryCache.
+static constexpr size_t kEntryOverheadBytes = 128;
+
+CompressedFileCache::CompressedFileCache(size_t byte_budget)
+  : byte_budget_(byte_budget), bytes_(0), hits_(0), misses_(0) {
+  Verify333(pthread_mutex_init(&lock_, nullptr) == 0);
+}
+
+CompressedFileCache::~CompressedFileCache() {
+  Verify333(pthread_mutex_destroy(&lock_) == 0);
+}
+
+shared_ptr<const string> CompressedFileCache::Lookup(const string& path,
+                                                     ContentCoding coding,
+                                                     const struct stat& st) {
+  string key = KeyFor(path, coding);
+  shared_ptr<const string> compressed;
+
+  Verify333(pthread_mutex_lock(&lock_) == 0);
+  auto it = map_.find(key);
+  if (it != map_.end()) {
+    if (it->second->version == VersionOf(st)) {
+      // Move the entry to the front of the LRU list.
+      lru_.splice(lru_.begin(), lru_, it->second);
+      compressed = it->second->compressed;
+    } else {
+      // The file has changed since it was compressed.
+      EraseLocked(it->second);
+    }
+  }
+  Verify333(pthread_mutex_unlock(&lock_) == 0);
+
+  if (compressed != nullptr) {
+    hits_++;
+  } else {
+    misses_++;
+  }
+  return compressed;
+}
+
+void CompressedFileCache::Insert(const string& path, ContentCoding coding,
+                                 const struct stat& st,
+                                 shared_ptr<const string> compressed) {
+  Entry entry = { KeyFor(path, coding), VersionOf(st), compressed };
+  size_t bytes = EntryBytes(entry);
+  if (bytes > byte_budget_) {
+    return;
+  }
+
+  Verify333(pthread_mutex_lock(&lock_) == 0);
+  auto it = map_.find(entry.key);
+  if (it != map_.end()) {
+    EraseLocked(it->second);
+  }
+
+  // Evict from the back of the LRU list until the new entry fits.
+  while (!lru_.empty() && bytes_ + bytes > byte_budget_) {
+    EraseLocked(std::prev(lru_.end()));
+  }
+
+  lru_.push_front(entry);
+  map_[entry.key] = lru_.begin();
+  bytes_ += bytes;
+  Verify333(pthread_mutex_unlock(&lock_) == 0);
+}
+
+size_t CompressedFileCache::bytes_used() const {
+  Verify333(pthread_mutex_lock(&lock_) == 0);
+  size_t bytes = bytes_;
+  Verify333(pthread_mutex_unlock(&lock_) == 0);
+  return bytes;
+}
+
+string CompressedFileCache::KeyFor(const string& path, ContentCoding coding) {
+  return string(ContentCodingName(coding)) + ":" + path;
+}
+
+string CompressedFileCache::VersionOf(const struct stat& st) {
+  return std::to_string(st.st_ino) + ":" + std::to_string(st.st_size) + ":" +
+         std::to_string(st.st_mtim.tv_sec) + "." +
+         std::to_string(st.st_mtim.tv_nsec);
+}
+
+size_t CompressedFileCache::EntryBytes(const Entry& entry) {
+  return kEntryOverheadBytes + entry.key.size() + entry.version.size() +
+         entry.compressed->size();
+}
+
+void CompressedFileCache::EraseLocked(LruList::iterator it) {
+  bytes_ -= EntryBytes(*it);
+  map_.erase(it->key);
+  lru_.erase(it);
+}
+
+}  // namespace hw4
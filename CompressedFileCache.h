@@ -0,0 +1,103 @@
+/*
+ * Copyright ©2024 Hannah C. Tang.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Washington
+ * CSE 333 for use solely during Spring Quarter 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#ifndef HW4_COMPRESSEDFILECACHE_H_
+#define HW4_COMPRESSEDFILECACHE_H_
+
+extern "C" {
+#include <pthread.h>  // for pthread_mutex_t
+}
+
+#include <stdint.h>    // for uint64_t, etc.
+#include <sys/stat.h>  // for struct stat
+#include <atomic>
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+#include "./HttpCompression.h"
+
+namespace hw4 {
+
+// A CompressedFileCache keeps compressed copies of static files in memory,
+// so that a hot file is compressed once, at the highest level, rather than
+// on every request for it.
+//
+// Entries are keyed on a file's path and coding, and remember the version
+// of the file they were made from: its inode, size and modification time,
+// as stat() reports them.  A lookup passes in the file's current version,
+// so a file that has been modified or replaced misses and has its stale
+// entry dropped.  Entries are evicted least-recently-used first once the
+// cache is over its byte budget.
+class CompressedFileCache {
+ public:
+  // Construct a cache holding at most about "byte_budget" bytes of
+  // compressed files.
+  explicit CompressedFileCache(size_t byte_budget);
+  virtual ~CompressedFileCache();
+
+  // Returns the cached "coding" compression of the file at "path", or
+  // nullptr if there isn't one for the version of it described by "st".
+  std::shared_ptr<const std::string> Lookup(const std::string& path,
+                                            ContentCoding coding,
+                                            const struct stat& st);
+
+  // Caches "compressed" as the "coding" compression of the version of
+  // "path" described by "st", replacing any other version of it.  Files
+  // bigger than the whole budget aren't cached.
+  void Insert(const std::string& path, ContentCoding coding,
+              const struct stat& st,
+              std::shared_ptr<const std::string> compressed);
+
+  // Counters, for monitoring.
+  uint64_t hits() const { return hits_.load(); }
+  uint64_t misses() const { return misses_.load(); }
+  size_t bytes_used() const;
+
+  CompressedFileCache(const CompressedFileCache&) = delete;
+  CompressedFileCache& operator=(const CompressedFileCache&) = delete;
+
+ private:
+  struct Entry {
+    std::string key;
+    std::string version;
+    std::shared_ptr<const std::string> compressed;
+  };
+  typedef std::list<Entry> LruList;
+
+  // Returns the key for the "coding" compression of "path".
+  static std::string KeyFor(const std::string& path, ContentCoding coding);
+
+  // Returns a string identifying the version of a file described by "st".
+  static std::string VersionOf(const struct stat& st);
+
+  // Returns the number of bytes we charge against the budget for an entry.
+  static size_t EntryBytes(const Entry& entry);
+
+  // Removes an entry; lock_ must be held.
+  void EraseLocked(LruList::iterator it);
+
+  size_t byte_budget_;
+
+  // Guards everything below.
+  mutable pthread_mutex_t lock_;
+  size_t bytes_;
+  LruList lru_;  // most recently used at the front
+  std::unordered_map<std::string, LruList::iterator> map_;
+
+  std::atomic<uint64_t> hits_;
+  std::atomic<uint64_t> misses_;
+};
+
+}  // namespace hw4
+
+#endif  // HW4_COMPRESSEDFILECACHE_H_
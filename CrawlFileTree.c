@@ -9,15 +9,21 @@
  * author.
  */
 
+// Feature test macro enabling clock_gettime (c.f., Linux Programming
+// Interface p. 63)
+#define _XOPEN_SOURCE 600
+
 #include "./CrawlFileTree.h"
 
 #include <dirent.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <time.h>
 #include <unistd.h>
 
 #include "libhw1/CSE333.h"
@@ -43,6 +49,26 @@ int alphasort(const void* v1, const void* v2) {
   return strncmp(e1->path_name, e2->path_name, MAX_PATHNAME_LENGTH);
 }
 
+// The state of a crawl, shared by HandleDir() and HandleFile().
+typedef struct {
+  DocTable*    doc_table;      // the documents crawled so far
+  MemIndex*    index;          // the documents' postings since the last spill
+
+  // The rest is only used by CrawlFileTree_Spill(); spill_fn is NULL for
+  // CrawlFileTree().
+  size_t       budget_bytes;   // the most memory "index" may use
+  CrawlSpillFn spill_fn;       // where to spill "index" when it's full
+  void*        spill_arg;      // the argument to pass to spill_fn
+  int64_t      num_postings;   // the number of posting lists in "index"
+  int64_t      num_positions;  // the number of positions in "index"
+  bool         failed;         // whether a spill failed
+
+  // Only used by the _Timed() variants; timed is false otherwise, and the
+  // clock isn't read.
+  bool         timed;          // whether to time the crawl
+  CrawlTimes   times;          // where the crawl's time went
+} CrawlState;
+
 // Recursively descend into the passed-in directory, looking for files and
 // subdirectories.  Any encountered files are processed via HandleFile(); any
 // subdirectories are recursively handled by HandleDir().
@@ -52,11 +78,37 @@ int alphasort(const void* v1, const void* v2) {
 // to generate consistent DocTables and MemIndices, we do two passes over the
 // contents: the first to extract the data necessary for populating
 // entry_name_st and the second to actually handle the recursive call.
-static void HandleDir(char* dir_path, DIR* d,
-                      DocTable** doc_table, MemIndex** index);
+static void HandleDir(char* dir_path, DIR* d, CrawlState* state);
+
+// Read and parse the specified file, then inject it into the MemIndex.  If
+// that takes the MemIndex over its budget, spill it.
+static void HandleFile(char* file_path, CrawlState* state);
+
+// Passes the crawl's MemIndex to its spill_fn and replaces it with an empty
+// one.
+static void Spill(CrawlState* state);
 
-// Read and parse the specified file, then inject it into the MemIndex.
-static void HandleFile(char* file_path, DocTable** doc_table, MemIndex** index);
+// Opens "root_dir" and crawls it, after allocating state->doc_table and
+// state->index.  Returns false, having allocated nothing, if "root_dir"
+// isn't a directory that we can open.
+static bool Crawl(char* root_dir, CrawlState* state);
+
+// Returns the current time, in nanoseconds, if the crawl is timed, and 0
+// if not.
+static int64_t NowNanos(const CrawlState* state);
+
+// The state CrawlFileTree_AddDocument() passes to AddWordPositions().
+typedef struct {
+  MemIndex* index;          // the index to add to
+  DocID_t   doc_id;         // the document whose words are being added
+  int64_t   num_postings;   // the number of posting lists added so far
+  int64_t   num_positions;  // the number of positions added so far
+} AddWordPositionsArg;
+
+// HashTable_Drain() callback which moves one WordPositions structure out of
+// a file's word table and into the MemIndex; "arg" is an
+// AddWordPositionsArg.
+static void AddWordPositions(HTKeyValue_t kv, void* arg);
 
 
 //////////////////////////////////////////////////////////////////////////////
@@ -64,13 +116,97 @@ static void HandleFile(char* file_path, DocTable** doc_table, MemIndex** index);
 //////////////////////////////////////////////////////////////////////////////
 
 bool CrawlFileTree(char* root_dir, DocTable** doc_table, MemIndex** index) {
-  struct stat root_stat;
-  DIR *rd;
+  return CrawlFileTree_Timed(root_dir, doc_table, index, NULL);
+}
+
+bool CrawlFileTree_Timed(char* root_dir, DocTable** doc_table,
+                         MemIndex** index, CrawlTimes* times) {
+  CrawlState state = { 0 };
 
   // Verify we got some valid args.
   if (root_dir == NULL || doc_table == NULL || index == NULL) {
     return false;
   }
+  state.timed = times != NULL;
+  if (!Crawl(root_dir, &state)) {
+    return false;
+  }
+
+  // Transfer ownership of the results to the caller.
+  *doc_table = state.doc_table;
+  *index = state.index;
+  if (times != NULL) {
+    *times = state.times;
+  }
+  return true;
+}
+
+bool CrawlFileTree_Spill(char* root_dir, DocTable** doc_table,
+                         size_t budget_bytes, CrawlSpillFn spill_fn,
+                         void* arg) {
+  return CrawlFileTree_SpillTimed(root_dir, doc_table, budget_bytes,
+                                  spill_fn, arg, NULL);
+}
+
+bool CrawlFileTree_SpillTimed(char* root_dir, DocTable** doc_table,
+                              size_t budget_bytes, CrawlSpillFn spill_fn,
+                              void* arg, CrawlTimes* times) {
+  CrawlState state = { 0 };
+
+  // Verify we got some valid args.
+  if (root_dir == NULL || doc_table == NULL || spill_fn == NULL) {
+    return false;
+  }
+  state.budget_bytes = budget_bytes;
+  state.spill_fn = spill_fn;
+  state.spill_arg = arg;
+  state.timed = times != NULL;
+  if (!Crawl(root_dir, &state)) {
+    return false;
+  }
+
+  // Spill whatever is left, so that every document ends up in a spill.
+  if (!state.failed && MemIndex_NumWords(state.index) > 0) {
+    Spill(&state);
+  }
+  MemIndex_Free(state.index);
+  if (state.failed) {
+    DocTable_Free(state.doc_table);
+    return false;
+  }
+  *doc_table = state.doc_table;
+  if (times != NULL) {
+    *times = state.times;
+  }
+  return true;
+}
+
+void CrawlFileTree_AddDocument(MemIndex* index, DocID_t doc_id,
+                               HashTable* tab, int64_t* num_postings,
+                               int64_t* num_positions) {
+  AddWordPositionsArg arg = { index, doc_id, 0, 0 };
+  HashTable_Drain(tab, &AddWordPositions, &arg);
+
+  // We're all done with the word hashtable, since we've added all of its
+  // contents to the inverted index. Free the table.
+  FreeWordPositionsTable(tab);
+
+  if (num_postings != NULL) {
+    *num_postings += arg.num_postings;
+  }
+  if (num_positions != NULL) {
+    *num_positions += arg.num_positions;
+  }
+}
+
+
+//////////////////////////////////////////////////////////////////////////////
+// Internal helper functions
+//////////////////////////////////////////////////////////////////////////////
+
+static bool Crawl(char* root_dir, CrawlState* state) {
+  struct stat root_stat;
+  DIR *rd;
 
   // Verify that rootdir is a directory.
   if (stat((char*) root_dir, &root_stat) == -1) {
@@ -91,26 +227,30 @@ bool CrawlFileTree(char* root_dir, DocTable** doc_table, MemIndex** index) {
   }
 
   // Since we're able to open the directory, allocate our objects.
-  *doc_table = DocTable_Allocate();
-  Verify333(*doc_table != NULL);
-  *index = MemIndex_Allocate();
-  Verify333(*index != NULL);
+  state->doc_table = DocTable_Allocate();
+  Verify333(state->doc_table != NULL);
+  state->index = MemIndex_Allocate();
+  Verify333(state->index != NULL);
 
   // Begin the recursive handling of the directory.
-  HandleDir(root_dir, rd, doc_table, index);
+  HandleDir(root_dir, rd, state);
 
-  // All done.  Release and/or transfer ownership of resources.
+  // All done.  Release resources.
   Verify333(closedir(rd) == 0);
   return true;
 }
 
+static int64_t NowNanos(const CrawlState* state) {
+  struct timespec ts;
 
-//////////////////////////////////////////////////////////////////////////////
-// Internal helper functions
-//////////////////////////////////////////////////////////////////////////////
+  if (!state->timed) {
+    return 0;
+  }
+  Verify333(clock_gettime(CLOCK_MONOTONIC, &ts) == 0);
+  return (int64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
 
-static void HandleDir(char* dir_path, DIR* d, DocTable** doc_table,
-                      MemIndex** index) {
+static void HandleDir(char* dir_path, DIR* d, CrawlState* state) {
   // We make two passes through the directory.  The first gets the list of
   // all the metadata necessary to process its entries; the second iterates
   // does the actual recursive descent.
@@ -125,6 +265,7 @@ static void HandleDir(char* dir_path, DIR* d, DocTable** doc_table,
   struct stat st;
 
   int num_entries;
+  int64_t start = NowNanos(state);
 
   // First pass, to populate the "entries" list of item metadata.
   //
@@ -204,15 +345,18 @@ static void HandleDir(char* dir_path, DIR* d, DocTable** doc_table,
   // Sort the directory's metadata alphabetically.
   num_entries = i;
   qsort(entries, num_entries, sizeof(struct entry_st), &alphasort);
+  state->times.crawl_nanos += NowNanos(state) - start;
 
   // Second pass, processing the now-sorted directory metadata.
   for (i = 0; i < num_entries; i++) {
-    if (!entries[i].is_dir) {
-      HandleFile(entries[i].path_name, doc_table, index);
+    if (state->failed) {
+      // A spill failed, so there's no point in indexing any more.
+    } else if (!entries[i].is_dir) {
+      HandleFile(entries[i].path_name, state);
     } else {
       DIR *sub_dir = opendir(entries[i].path_name);
       if (sub_dir != NULL) {
-        HandleDir(entries[i].path_name, sub_dir, doc_table, index);
+        HandleDir(entries[i].path_name, sub_dir, state);
         closedir(sub_dir);
       }
     }
@@ -223,18 +367,24 @@ static void HandleDir(char* dir_path, DIR* d, DocTable** doc_table,
   free(entries);
 }
 
-static void HandleFile(char* file_path, DocTable** doc_table,
-                        MemIndex** index) {
+static void HandleFile(char* file_path, CrawlState* state) {
   int file_len = 0;
   HashTable* tab = NULL;
   DocID_t doc_id;
-  HTIterator* it;
+  char* contents;
+  int64_t start, read, parsed;
 
   // STEP 4.
   // Invoke ParseIntoWordPositionsTable() to build the word hashtable out
   // of the file.
 
-  tab = ParseIntoWordPositionsTable(ReadFileToString(file_path, &file_len));
+  start = NowNanos(state);
+  contents = ReadFileToString(file_path, &file_len);
+  read = NowNanos(state);
+  state->times.read_nanos += read - start;
+  tab = ParseIntoWordPositionsTable(contents);
+  parsed = NowNanos(state);
+  state->times.parse_nanos += parsed - read;
   // skips file if it is string can't be parsed or file can't be read.
   if (tab == NULL) {
     return;
@@ -242,33 +392,57 @@ static void HandleFile(char* file_path, DocTable** doc_table,
   // STEP 5.
   // Invoke DocTable_Add() to register the new file with the doc_table.
 
-  doc_id = DocTable_Add(*doc_table, file_path);
-  // Loop through the newly-built hash table.
-  it = HTIterator_Allocate(tab);
-  Verify333(it != NULL);
-  while (HTIterator_IsValid(it)) {
-    WordPositions* wp;
-    HTKeyValue_t kv;
-
-    // STEP 6.
-    // Use HTIterator_Remove() to extract the next WordPositions structure out
-    // of the hashtable. Then, use MemIndex_AddPostingList() to add the word,
-    // document ID, and positions linked list into the inverted index.
-
-
-    HTIterator_Remove(it, &kv);
-    wp = (WordPositions*) kv.value;
-    // adds word, doc_id, and positions to MemIndex from wp.
-    MemIndex_AddPostingList(*index, wp->word, doc_id, wp->positions);
-    // Since we've transferred ownership of the memory associated with both
-    // the "word" and "positions" field of this WordPositions structure, and
-    // since we've removed it from the table, we can now free the
-    // WordPositions structure!
-    free(wp);
+  doc_id = DocTable_Add(state->doc_table, file_path);
+
+  // STEP 6.
+  // Drain the newly-built hash table, adding each word, document ID, and
+  // positions linked list into the inverted index, then free it.
+  CrawlFileTree_AddDocument(state->index, doc_id, tab, &state->num_postings,
+                            &state->num_positions);
+  state->times.merge_nanos += NowNanos(state) - parsed;
+  state->times.num_files++;
+  state->times.num_bytes += file_len;
+
+  // Spill the index if this file took it over budget.  A document is never
+  // split across spills.
+  if (state->spill_fn != NULL &&
+      MemIndex_EstimateBytes(MemIndex_NumWords(state->index),
+                             state->num_postings, state->num_positions) >
+      state->budget_bytes) {
+    Spill(state);
   }
-  HTIterator_Free(it);
+}
 
-  // We're all done with the word hashtable for this file, since we've added
-  // all of its contents to the inverted index. Free the table and return.
-  FreeWordPositionsTable(tab);
+static void Spill(CrawlState* state) {
+  int64_t start = NowNanos(state);
+
+  if (!state->spill_fn(state->index, state->spill_arg)) {
+    state->failed = true;
+  }
+  state->times.spill_nanos += NowNanos(state) - start;
+  MemIndex_Free(state->index);
+  state->index = MemIndex_Allocate();
+  state->num_postings = 0;
+  state->num_positions = 0;
+}
+
+static void AddWordPositions(HTKeyValue_t kv, void* arg) {
+  AddWordPositionsArg* add_arg = (AddWordPositionsArg*) arg;
+  WordPositions* wp = (WordPositions*) kv.value;
+
+  add_arg->num_postings++;
+  add_arg->num_positions += LinkedList_NumElements(wp->positions);
+
+  // adds word, doc_id, and positions to MemIndex from wp.  The word is
+  // already interned and kv.key is its hash, so the index can use both
+  // as they are.
+  MemIndex_AddInternedPostingList(add_arg->index, kv.key, wp->word,
+                                  add_arg->doc_id, wp->positions);
+
+  // Since we've transferred ownership of the memory associated with the
+  // "positions" field of this WordPositions structure to the MemIndex (its
+  // "word" belongs to the WordPool, so there's nothing to transfer), and
+  // since it's been drained from the table, we can now free the
+  // WordPositions structure!
+  free(wp);
 }
@@ -13,6 +13,8 @@
 #define HW2_CRAWLFILETREE_H_
 
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
 
 #include "./DocTable.h"
 #include "./MemIndex.h"
@@ -38,4 +40,77 @@
 // - Returns false on failure (nothing is allocated), true on success.
 bool CrawlFileTree(char* root_dir, DocTable** doctable, MemIndex** index);
 
+// A function that CrawlFileTree_Spill() calls to write a partial inverted
+// index out (eg, with hw3's WriteIndexRun()).  "arg" is the argument that
+// was passed to CrawlFileTree_Spill().  The MemIndex still belongs to the
+// crawl, which frees it afterwards.  Returns false on failure, which stops
+// the crawl.
+typedef bool (*CrawlSpillFn)(MemIndex* index, void* arg);
+
+// Crawls a directory like CrawlFileTree(), but in bounded memory.
+//
+// Rather than accumulating the whole corpus in a single MemIndex, the
+// crawl passes its MemIndex to "spill_fn" whenever its estimated size (see
+// MemIndex_EstimateBytes()) exceeds "budget_bytes", and carries on with an
+// empty one.  Whatever is left at the end is spilled too, so each indexed
+// file is in exactly one spill, and the files in each spill have larger
+// docIDs than those in the spills before it.  Only the DocTable is kept
+// for the whole crawl.
+//
+// Arguments:
+// - rootdir: the name of the directory which is the root of the crawl.
+// - budget_bytes: the memory budget for the inverted index.  A file is
+//   never split across spills, so one large file can exceed it.
+// - spill_fn: the function to spill partial inverted indices with.
+// - arg: the argument to pass to spill_fn.
+//
+// Returns:
+// - doctable: an output parameter through which a populated DocTable is
+//   returned, as for CrawlFileTree().
+//
+// - Returns false on failure (nothing is allocated), including if a spill
+//   failed, true on success.
+bool CrawlFileTree_Spill(char* root_dir, DocTable** doctable,
+                         size_t budget_bytes, CrawlSpillFn spill_fn,
+                         void* arg);
+
+// Where a crawl's time went, as returned by CrawlFileTree_Timed() and
+// CrawlFileTree_SpillTimed().  The phases interleave, file by file, so
+// each one's time is the sum of its share of every file.  All times are
+// in nanoseconds.
+typedef struct {
+  int64_t num_files;    // the number of files indexed
+  int64_t num_bytes;    // their total length
+  int64_t crawl_nanos;  // listing and stat'ing directories
+  int64_t read_nanos;   // reading files, with ReadFileToString()
+  int64_t parse_nanos;  // parsing them, with ParseIntoWordPositionsTable()
+  int64_t merge_nanos;  // adding their postings to the MemIndex
+  int64_t spill_nanos;  // in spill_fn, for CrawlFileTree_SpillTimed()
+} CrawlTimes;
+
+// Crawls a directory like CrawlFileTree(), also returning the time spent
+// in each phase of the crawl through the output parameter "times".
+bool CrawlFileTree_Timed(char* root_dir, DocTable** doctable,
+                         MemIndex** index, CrawlTimes* times);
+
+// Crawls a directory like CrawlFileTree_Spill(), also returning the time
+// spent in each phase of the crawl through the output parameter "times".
+bool CrawlFileTree_SpillTimed(char* root_dir, DocTable** doctable,
+                              size_t budget_bytes, CrawlSpillFn spill_fn,
+                              void* arg, CrawlTimes* times);
+
+// Adds a document's postings to an inverted index, as the crawl does for
+// each file.
+//
+// Arguments:
+// - index: the inverted index to add the postings to.
+// - doc_id: the document's docID, from DocTable_Add().
+// - tab: the document's word table, from ParseIntoWordPositionsTable().
+//   Its positions lists move into "index", and the table is freed.
+// - num_postings, num_positions: if not NULL, the number of posting lists
+//   and positions added to "index" are added to them.
+void CrawlFileTree_AddDocument(MemIndex* index, DocID_t doc_id,
+                               HashTable* tab, int64_t* num_postings,
+                               int64_t* num_positions);
+
 #endif  // HW2_CRAWLFILETREE_H_
@@ -13,6 +13,7 @@
 
 #include <list>      // for std::list
 #include <cstdio>    // for (FILE*)
+#include <vector>    // for std::vector
 
 #include "./LayoutStructs.h"
 
@@ -21,6 +22,7 @@ extern "C" {
 }
 
 using std::list;
+using std::vector;
 
 namespace hw3 {
 
@@ -28,8 +30,25 @@ namespace hw3 {
 // of HashTableReader(), its base class. The base class takes
 // care of taking ownership of f and using it to extract and
 // cache the number of buckets within the table.
-DocIDTableReader::DocIDTableReader(FILE* f, IndexFileOffset_t offset)
-  : HashTableReader(f, offset) { }
+DocIDTableReader::DocIDTableReader(FILE* f, IndexFileOffset_t offset,
+                                   IndexFormat format,
+                                   std::shared_ptr<const MappedFile> mapping)
+  : HashTableReader(f, offset, format, mapping) { }
+
+DocIDElementHeader
+DocIDTableReader::ReadElementHeader(IndexFileOffset_t offset) const {
+  if (format_ == kIndexFormatNative) {
+    const DocIDElementHeaderNative* header =
+      MappedRecords<DocIDElementHeaderNative>(offset);
+    return DocIDElementHeader(header->doc_id, header->num_positions);
+  }
+
+  DocIDElementHeader header;
+  Verify333(fseek(file_, offset, SEEK_SET) == 0);
+  Verify333(fread(&header, sizeof(DocIDElementHeader), 1, file_) == 1);
+  header.ToHostFormat();
+  return header;
+}
 
 bool DocIDTableReader::LookupDocID(
      const DocID_t& doc_id, list<DocPositionOffset_t>* const ret_val) const {
@@ -46,13 +65,7 @@ bool DocIDTableReader::LookupDocID(
   for (IndexFileOffset_t& curr_element : elements) {
     // STEP 1.
     // Slurp the next docid out of the current element.
-    DocIDElementHeader curr_header;
-    if (fseek(file_, curr_element, SEEK_SET) != 0) {
-      return false;
-    }
-
-    fread(&curr_header, 1, sizeof(DocIDElementHeader), file_);
-    curr_header.ToHostFormat();
+    DocIDElementHeader curr_header = ReadElementHeader(curr_element);
 
     // Is it a match?
     if (curr_header.doc_id == doc_id) {
@@ -61,17 +74,25 @@ bool DocIDTableReader::LookupDocID(
       // std::list<DocPositionOffset_t>.  Be sure to push in the right
       // order, adding to the end of the list as you extract
       // successive positions.
-      list<DocPositionOffset_t> positions;
-      DocPositionOffset_t position;
-      IndexFileOffset_t offset = curr_element + sizeof(DocIDElementHeader);
-      for (int i = 0; i < curr_header.num_positions; i++) {
-        Verify333(fseek(file_, offset, SEEK_SET) == 0);
-        fread(&position, 1, sizeof(DocPositionOffset_t), file_);
-
-        position = ntohl(position);
-        positions.push_back(position);
+      //
+      // The positions are contiguous and immediately follow the header.
+      // In a mapped file, they're already in host order.
+      if (format_ == kIndexFormatNative) {
+        const DocPositionOffset_t* positions =
+          MappedRecords<DocPositionOffset_t>(
+            curr_element + sizeof(DocIDElementHeaderNative),
+            curr_header.num_positions);
+        ret_val->assign(positions, positions + curr_header.num_positions);
+        return true;
+      }
 
-        offset += sizeof(IndexFileOffset_t);
+      // Otherwise, read them all with a single fread().
+      vector<DocPositionOffset_t> buf(curr_header.num_positions);
+      Verify333(fread(buf.data(), sizeof(DocPositionOffset_t), buf.size(),
+                      file_) == buf.size());
+      list<DocPositionOffset_t> positions;
+      for (DocPositionOffset_t position : buf) {
+        positions.push_back(ntohl(position));
       }
 
       // STEP 3.
@@ -86,6 +107,18 @@ bool DocIDTableReader::LookupDocID(
   return false;
 }
 
+bool DocIDTableReader::LookupNumPositions(const DocID_t& doc_id,
+                                          int32_t* const num_positions) const {
+  for (IndexFileOffset_t& curr_element : LookupElementPositions(doc_id)) {
+    DocIDElementHeader curr_header = ReadElementHeader(curr_element);
+    if (curr_header.doc_id == doc_id) {
+      *num_positions = curr_header.num_positions;
+      return true;
+    }
+  }
+  return false;
+}
+
 list<DocIDElementHeader> DocIDTableReader::GetDocIDList() const {
   // This will be our returned list of docIDs within this table.
   list<DocIDElementHeader> doc_id_list;
@@ -94,44 +127,14 @@ list<DocIDElementHeader> DocIDTableReader::GetDocIDList() const {
   // out the docids in each element and the number of word positions
   // for the each docid.
   for (int i = 0; i < header_.num_buckets; i++) {
-    // STEP 4.
-    // Seek to the next BucketRecord.  The "offset_" member
-    // variable stores the offset of this docid table within
-    // the index file.
-    fseek(file_, offset_ + sizeof(BucketListHeader) + sizeof(BucketRecord) * i,
-         SEEK_SET);
-
-    // STEP 5.
-    // Read in the chain length and bucket position fields from
-    // the bucket_rec.
-    BucketRecord bucket_rec;
-    fread(&bucket_rec, 1, sizeof(BucketRecord), file_);
-    bucket_rec.ToHostFormat();
-
-    // Sweep through the next bucket, iterating through each
-    // chain element in the bucket.
-    off_t element_offset;
-    for (int j = 0; j < bucket_rec.chain_num_elements; j++) {
-      // Seek to chain element's position field in the bucket header.
-      element_offset = bucket_rec.position + j * sizeof(ElementPositionRecord);
-      Verify333(fseek(file_, element_offset, SEEK_SET) == 0);
-
-      // STEP 6.
-      // Read the next element position from the bucket header.
-      // and seek to the element itself.
-      ElementPositionRecord element_pos;
-      fread(&element_pos, 1, sizeof(ElementPositionRecord), file_);
-      element_pos.ToHostFormat();
-
+    // STEPS 4-6.
+    // Read the bucket's record, and the positions of the elements in its
+    // chain.
+    for (IndexFileOffset_t element_pos : BucketElementPositions(i)) {
       // STEP 7.
-      // Read in the docid and number of positions from the element.
-      DocIDElementHeader element;
-      Verify333(fseek(file_, element_pos.position, SEEK_SET) == 0);
-      fread(&element, 1, sizeof(DocIDElementHeader), file_);
-      element.ToHostFormat();
-
-      // Append it to our result list.
-      doc_id_list.push_back(element);
+      // Read in the docid and number of positions from the element, and
+      // append them to our result list.
+      doc_id_list.push_back(ReadElementHeader(element_pos));
     }
   }
 
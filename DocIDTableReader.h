@@ -35,7 +35,11 @@ class DocIDTableReader : protected HashTableReader {
   //   constructed object takes ownership of the (FILE*) and will
   //   fclose() it  on destruction.
   // - offset: the `docIDtable`'s byte offset within the file.
-  DocIDTableReader(FILE* f, IndexFileOffset_t offset);
+  // - format: the index file's format (see FileIndexReader::format()).
+  // - mapping: the file's mapping, for kIndexFormatNative.
+  DocIDTableReader(FILE* f, IndexFileOffset_t offset,
+                   IndexFormat format = kIndexFormat32,
+                   std::shared_ptr<const MappedFile> mapping = nullptr);
   ~DocIDTableReader() { }
 
   // Lookup a docID and get back a `std::list<DocPositionOffset_t>`
@@ -52,6 +56,19 @@ class DocIDTableReader : protected HashTableReader {
   bool LookupDocID(const DocID_t& doc_id,
                    list<DocPositionOffset_t>* const ret_val) const;
 
+  // Lookup a docID and get back the number of positions listed for it,
+  // without reading the positions themselves.
+  //
+  // Arguments:
+  // - doc_id:  the docID to look for within the `docIDtable`.
+  // - num_positions: (output parameter) the number of positions.  If docID
+  //   is not found, nothing is saved into `*num_positions`.
+  //
+  // Returns:
+  // - true if the docID is found, false otherwise.
+  bool LookupNumPositions(const DocID_t& doc_id,
+                          int32_t* const num_positions) const;
+
   // Reads all docID's from the docIDtable and builds a `DocIDElementHeader`
   // for each docID and the number of word positions a docID has.
   //
@@ -59,7 +76,17 @@ class DocIDTableReader : protected HashTableReader {
   // - A list<DocIDElementHeader> including all docID's from the table
   list<DocIDElementHeader> GetDocIDList() const;
 
+  // Returns the number of docIDs in the docIDtable, i.e., the document
+  // frequency of the word that owns this table.  This only reads the
+  // bucket records, so it is much cheaper than GetDocIDList().size().
+  int NumDocIDs() const { return NumElements(); }
+
  private:
+  // Reads the header of the element at byte offset "offset", in host
+  // format.  Unless the file is mapped, leaves file_ positioned at the
+  // element's positions.
+  DocIDElementHeader ReadElementHeader(IndexFileOffset_t offset) const;
+
   // This friend declaration is here so that the Test_DocIDTableReader
   // unit test fixture can access protected member variables of
   // DocIDTableReader.  See test_docidtablereader.h for details.
@@ -0,0 +1,54 @@
+/*
+ * Copyright ©2024 Hannah C. Tang.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Washington
+ * CSE 333 for use solely during Spring Quarter 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#include "./DocLengthTableReader.h"
+
+#include <stdint.h>  // for uint32_t, etc.
+#include <cstdio>    // for (FILE*)
+#include <vector>    // for std::vector
+
+extern "C" {
+  #include "libhw1/CSE333.h"
+}
+
+using std::vector;
+
+namespace hw3 {
+
+DocLengthTableReader::DocLengthTableReader(FILE* f, IndexFileOffset_t offset,
+                                           int32_t bytes)
+  : num_docs_(0), average_doc_length_(0.0) {
+  Verify333(bytes % sizeof(DocLengthRecord) == 0);
+  vector<DocLengthRecord> records(bytes / sizeof(DocLengthRecord));
+
+  Verify333(fseek(f, offset, SEEK_SET) == 0);
+  Verify333(fread(records.data(), sizeof(DocLengthRecord), records.size(), f)
+            == records.size());
+  fclose(f);
+
+  // Docs that aren't in the doctable have a length of zero; every indexed
+  // document has at least one word.
+  uint64_t total_words = 0;
+  lengths_.reserve(records.size());
+  for (DocLengthRecord& record : records) {
+    record.ToHostFormat();
+    lengths_.push_back(record.num_words);
+    if (record.num_words > 0) {
+      num_docs_++;
+      total_words += record.num_words;
+    }
+  }
+  if (num_docs_ > 0) {
+    average_doc_length_ = static_cast<double>(total_words) / num_docs_;
+  }
+}
+
+}  // namespace hw3
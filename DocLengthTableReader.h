@@ -0,0 +1,74 @@
+/*
+ * Copyright ©2024 Hannah C. Tang.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Washington
+ * CSE 333 for use solely during Spring Quarter 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#ifndef HW3_DOCLENGTHTABLEREADER_H_
+#define HW3_DOCLENGTHTABLEREADER_H_
+
+#include <stdint.h>  // for uint32_t, etc.
+#include <cstdio>    // for (FILE*)
+#include <vector>    // for std::vector
+
+#include "./LayoutStructs.h"
+#include "./Utils.h"
+
+namespace hw3 {
+
+// A DocLengthTableReader holds the per-document length section of an
+// index file: the number of words indexed from each document.  Unlike the
+// HashTableReaders, the whole table is small (four bytes per document), so
+// it is read into memory once at construction and lookups never touch the
+// file.
+class DocLengthTableReader {
+ public:
+  // Construct a DocLengthTableReader.  Arguments:
+  //
+  // - f: an open (FILE*) for the underlying index file.  The constructed
+  //   object takes ownership of the (FILE*), and fclose()s it as soon as
+  //   the table has been read.
+  //
+  // - offset: the byte offset of the section's payload (i.e., just past
+  //   its SectionHeader) within the file.
+  //
+  // - bytes: the size of the section's payload.
+  DocLengthTableReader(FILE* f, IndexFileOffset_t offset, int32_t bytes);
+  ~DocLengthTableReader() { }
+
+  // Returns the number of words indexed from "doc_id", or 0 if the docID
+  // isn't in the table.
+  uint32_t DocLength(DocID_t doc_id) const {
+    if (doc_id == 0 || doc_id > lengths_.size()) {
+      return 0;
+    }
+    return lengths_[doc_id - 1];
+  }
+
+  // Returns the largest docID covered by the table.
+  int MaxDocID() const { return lengths_.size(); }
+
+  // Returns the number of documents in the table.
+  int NumDocs() const { return num_docs_; }
+
+  // Returns the mean length of the documents in the table, or 0 if the
+  // table is empty.
+  double AverageDocLength() const { return average_doc_length_; }
+
+ private:
+  // lengths_[i] is the length of docID (i + 1).
+  std::vector<uint32_t> lengths_;
+  int num_docs_;
+  double average_doc_length_;
+
+  DISALLOW_COPY_AND_ASSIGN(DocLengthTableReader);
+};
+
+}  // namespace hw3
+
+#endif  // HW3_DOCLENGTHTABLEREADER_H_
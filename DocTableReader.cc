@@ -28,8 +28,10 @@ namespace hw3 {
 // of HashTableReader(), its superclass. The superclass takes
 // care of taking ownership of f and using it to extract and
 // cache the number of buckets within the table.
-DocTableReader::DocTableReader(FILE* f, IndexFileOffset_t offset)
-  : HashTableReader(f, offset) { }
+DocTableReader::DocTableReader(FILE* f, IndexFileOffset_t offset,
+                               IndexFormat format,
+                               std::shared_ptr<const MappedFile> mapping)
+  : HashTableReader(f, offset, format, mapping) { }
 
 bool DocTableReader::LookupDocID(const DocID_t& doc_id,
                                  string* const ret_str) const {
@@ -42,6 +44,21 @@ bool DocTableReader::LookupDocID(const DocID_t& doc_id,
   if (elements.empty())
     return false;
 
+  // In a mapped file, the elements can be read where they are.
+  if (format_ == kIndexFormatNative) {
+    for (IndexFileOffset_t curr_el_offset : elements) {
+      const DoctableElementHeaderNative* header =
+        MappedRecords<DoctableElementHeaderNative>(curr_el_offset);
+      if (header->doc_id == doc_id) {
+        ret_str->assign(MappedRecords<char>(curr_el_offset + sizeof(*header),
+                                            header->file_name_bytes),
+                        header->file_name_bytes);
+        return true;
+      }
+    }
+    return false;
+  }
+
   // Iterate through the elements, looking for our docID.
   for (IndexFileOffset_t& curr_el_offset : elements) {
     // STEP 1.
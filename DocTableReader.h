@@ -33,7 +33,13 @@ class DocTableReader : protected HashTableReader {
   //   fclose() it on destruction.
   //
   // - offset: the "doctable"'s byte offset within the file.
-  DocTableReader(FILE* f, IndexFileOffset_t offset);
+  //
+  // - format: the index file's format (see FileIndexReader::format()).
+  //
+  // - mapping: the file's mapping, for kIndexFormatNative.
+  DocTableReader(FILE* f, IndexFileOffset_t offset,
+                 IndexFormat format = kIndexFormat32,
+                 std::shared_ptr<const MappedFile> mapping = nullptr);
   ~DocTableReader() { }
 
   // Lookup a docID and get back a string containing the filename
@@ -48,6 +54,9 @@ class DocTableReader : protected HashTableReader {
   // - true if the docID is found, false otherwise.
   bool LookupDocID(const DocID_t& doc_id, string* const ret_str) const;
 
+  // Returns the number of documents in the doctable.
+  int NumDocs() const { return NumElements(); }
+
  private:
   // This friend declaration is here so that the Test_DocTableReader
   // unit test fixture can access protected member variables of
@@ -13,7 +13,11 @@
 
 #include <sys/types.h>  // for stat()
 #include <sys/stat.h>   // for stat()
-#include <unistd.h>     // for stat()
+#include <unistd.h>     // for stat(), pread()
+
+#include <map>          // for std::map
+#include <utility>      // for std::pair
+#include <vector>       // for std::vector
 
 extern "C" {
   #include "libhw1/CSE333.h"
@@ -24,6 +28,24 @@ using std::string;
 
 namespace hw3 {
 
+// The (offset, size) of each auxiliary section's payload, keyed by tag.
+typedef std::map<uint32_t, std::pair<IndexFileOffset_t, int32_t>> SectionMap;
+
+// Reads the header of the index file open on "fd", whose magic number
+// says it's in format "format", into *header (widening it if need be), and
+// its size on disk into *header_bytes.  Returns false if the header can't
+// be read, or is for a different byte order.
+static bool ReadHeader(int fd, IndexFormat format,
+                       IndexFileHeader64* const header,
+                       IndexFileOffset_t* const header_bytes);
+
+// Walks the chain of auxiliary sections of the index file open on "fd",
+// which start at byte offset "offset" and run to the end of the file at
+// "file_bytes", adding each one to *sections.  Returns false if the chain
+// doesn't end exactly at the end of the file.
+static bool ReadSections(int fd, IndexFileOffset_t offset, int64_t file_bytes,
+                         SectionMap* const sections);
+
 FileIndexReader::FileIndexReader(const string& file_name,
                                  bool validate) {
   // Stash a copy of the index file's name.
@@ -38,23 +60,39 @@ FileIndexReader::FileIndexReader(const string& file_name,
   setvbuf(file_, nullptr, _IONBF, 0);
 
   // STEP 2.
-  // Read the entire file header and convert to host format.
-  fread(&header_, 1, sizeof(IndexFileHeader), file_);
-  header_.ToHostFormat();
+  // Read the magic number, which tells us the format of the rest of the
+  // header, and then the entire file header, converting to host format.
+  uint32_t magic_number;
+  Verify333(fread(&magic_number, sizeof(magic_number), 1, file_) == 1);
 
   // STEP 3.
-  // Verify that the magic number is correct.  Crash if not.
-  const uint32_t kMagicNumber = 0xCAFEF00D;
-  Verify333(header_.magic_number == kMagicNumber);
+  // Verify that the magic number is correct, and find out which hash
+  // function the words were keyed with and how the file is laid out.
+  // Crash if not.
+  Verify333(HashIDForMagicNumber(ntohl(magic_number), &hash_id_, &format_));
+  Verify333(ReadHeader(fileno(file_), format_, &header_, &header_bytes_));
+  Verify333(fseek(file_, header_bytes_, SEEK_SET) == 0);
 
   // Make sure the index file's length lines up with the header fields.
+  // Anything past the index belongs to the auxiliary sections.
   struct stat f_stat;
   Verify333(stat(file_name_.c_str(), &f_stat) == 0);
-  Verify333(
-    f_stat.st_size == static_cast<unsigned int>(
-      sizeof(IndexFileHeader) + header_.doctable_bytes + header_.index_bytes));
+  IndexFileOffset_t sections_offset =
+    header_bytes_ + header_.doctable_bytes + header_.index_bytes;
+  Verify333(f_stat.st_size >= sections_offset);
 
-  if (validate) {
+  // The readers of a native file read its records in place, and so can
+  // we.
+  if (format_ == kIndexFormatNative) {
+    mapping_ = std::make_shared<const MappedFile>(fileno(file_));
+    Verify333(mapping_->size() == f_stat.st_size);
+    if (validate) {
+      CRC32 crc_obj;
+      crc_obj.FoldBytesIntoCRC(mapping_->data() + header_bytes_,
+                               mapping_->size() - header_bytes_);
+      Verify333(crc_obj.GetFinalCRC() == header_.checksum);
+    }
+  } else if (validate) {
     // Re-calculate the checksum, make sure it matches that in the header.
     // Use fread() and pass the bytes you read into the crcobj.
     // Note you don't need to do any host/network order conversion,
@@ -62,7 +100,7 @@ FileIndexReader::FileIndexReader(const string& file_name,
     CRC32 crc_obj;
     static constexpr int kBufSize = 512;
     uint8_t buf[kBufSize];
-    int left_to_read = header_.doctable_bytes + header_.index_bytes;
+    int64_t left_to_read = f_stat.st_size - header_bytes_;
     while (left_to_read > 0) {
       // STEP 4.
       // You should only need to modify code inside the while loop for
@@ -80,33 +118,165 @@ FileIndexReader::FileIndexReader(const string& file_name,
     Verify333(crc_obj.GetFinalCRC() == header_.checksum);
   }
 
+  // Walk the chain of auxiliary sections, remembering where each one's
+  // payload lives.  Sections we don't recognize are skipped.
+  Verify333(ReadSections(fileno(file_), sections_offset, f_stat.st_size,
+                         &sections_));
+
+  // The Bloom filter is consulted on every word lookup, so read it in now.
+  auto bloom_section = sections_.find(kBloomFilterSectionTag);
+  if (bloom_section != sections_.end()) {
+    bloom_filter_ = std::make_shared<const BloomFilter>(
+      file_, bloom_section->second.first, bloom_section->second.second);
+  }
+
   // Everything looks good; we're done!
 }
 
+bool FileIndexReader::IsValid(int fd) {
+  struct stat f_stat;
+  uint32_t magic_number;
+  HTHashID_t hash_id;
+  IndexFormat format;
+  IndexFileHeader64 header;
+  IndexFileOffset_t header_bytes;
+  if (fstat(fd, &f_stat) != 0 ||
+      pread(fd, &magic_number, sizeof(magic_number), 0) !=
+        sizeof(magic_number) ||
+      !HashIDForMagicNumber(ntohl(magic_number), &hash_id, &format) ||
+      !ReadHeader(fd, format, &header, &header_bytes)) {
+    return false;
+  }
+
+  IndexFileOffset_t sections_offset =
+    header_bytes + header.doctable_bytes + header.index_bytes;
+  SectionMap sections;
+  if (header.doctable_bytes < 0 || header.index_bytes < 0 ||
+      sections_offset > f_stat.st_size ||
+      !ReadSections(fd, sections_offset, f_stat.st_size, &sections)) {
+    return false;
+  }
+
+  // Everything after the header is checksummed.
+  CRC32 crc_obj;
+  std::vector<uint8_t> buf(1 << 16);
+  for (IndexFileOffset_t offset = header_bytes; offset < f_stat.st_size; ) {
+    ssize_t res = pread(fd, buf.data(), buf.size(), offset);
+    if (res <= 0) {
+      return false;
+    }
+    crc_obj.FoldBytesIntoCRC(buf.data(), res);
+    offset += res;
+  }
+  return crc_obj.GetFinalCRC() == header.checksum;
+}
+
 FileIndexReader::~FileIndexReader() {
   // Close the (FILE*).
   Verify333(fclose(file_) == 0);
 }
 
 DocTableReader* FileIndexReader::NewDocTableReader() const {
-  // The docid->name mapping starts at offset sizeof(IndexFileHeader) in
-  // the index file.  Be sure to dup the (FILE*) rather than sharing
+  // The docid->name mapping starts right after the header in the index
+  // file.  Be sure to dup the (FILE*) rather than sharing
   // it across objects, just so that we don't end up with the possibility
   // of threads contending for the (FILE*) and associated with race
   // conditions.
   FILE* fdup = FileDup(file_);
-  IndexFileOffset_t file_offset = sizeof(IndexFileHeader);
-  return new DocTableReader(fdup, file_offset);
+  IndexFileOffset_t file_offset = header_bytes_;
+  return new DocTableReader(fdup, file_offset, format_, mapping_);
 }
 
 IndexTableReader* FileIndexReader::NewIndexTableReader() const {
-  // The index (word-->docid table) mapping starts at offset
-  // (sizeof(IndexFileHeader) + doctable_size_) in the index file.  Be
+  // The index (word-->docid table) mapping starts right after the header
+  // and the doctable in the index file.  Be
   // sure to dup the (FILE*) rather than sharing it across objects,
   // just so that we don't end up with the possibility of threads
   // contending for the (FILE*) and associated race conditions.
   return new IndexTableReader(FileDup(file_),
-                              sizeof(IndexFileHeader) + header_.doctable_bytes);
+                              header_bytes_ + header_.doctable_bytes,
+                              hash_id_, format_, mapping_, bloom_filter_);
+}
+
+DocLengthTableReader* FileIndexReader::NewDocLengthTableReader() const {
+  auto it = sections_.find(kDocLengthsSectionTag);
+  if (it == sections_.end()) {
+    return nullptr;
+  }
+  return new DocLengthTableReader(FileDup(file_), it->second.first,
+                                  it->second.second);
+}
+
+TermBoundTableReader* FileIndexReader::NewTermBoundTableReader() const {
+  auto it = sections_.find(kTermBoundsSectionTag);
+  if (it == sections_.end()) {
+    return nullptr;
+  }
+  return new TermBoundTableReader(FileDup(file_), it->second.first,
+                                  it->second.second, hash_id_);
+}
+
+TermDictReader* FileIndexReader::NewTermDictReader() const {
+  auto it = sections_.find(kTermDictSectionTag);
+  if (it == sections_.end()) {
+    return nullptr;
+  }
+  return new TermDictReader(FileDup(file_), it->second.first,
+                            it->second.second);
+}
+
+static bool ReadHeader(int fd, IndexFormat format,
+                       IndexFileHeader64* const header,
+                       IndexFileOffset_t* const header_bytes) {
+  if (format == kIndexFormatNative) {
+    // The records are in the writer's byte order, which had better be
+    // ours.
+    IndexFileHeaderNative native;
+    if (pread(fd, &native, sizeof(native), 0) != sizeof(native)) {
+      return false;
+    }
+    native.ToHostFormat();
+    if (native.byte_order != kByteOrderMark) {
+      return false;
+    }
+    *header = IndexFileHeader64(native.magic_number, native.checksum,
+                                native.doctable_bytes, native.index_bytes);
+    *header_bytes = sizeof(IndexFileHeaderNative);
+  } else if (format == kIndexFormat64) {
+    if (pread(fd, header, sizeof(*header), 0) != sizeof(*header)) {
+      return false;
+    }
+    header->ToHostFormat();
+    *header_bytes = sizeof(IndexFileHeader64);
+  } else {
+    IndexFileHeader narrow;
+    if (pread(fd, &narrow, sizeof(narrow), 0) != sizeof(narrow)) {
+      return false;
+    }
+    narrow.ToHostFormat();
+    *header = IndexFileHeader64(narrow);
+    *header_bytes = sizeof(IndexFileHeader);
+  }
+  return true;
+}
+
+static bool ReadSections(int fd, IndexFileOffset_t offset, int64_t file_bytes,
+                         SectionMap* const sections) {
+  while (offset < file_bytes) {
+    SectionHeader section;
+    if (pread(fd, &section, sizeof(section), offset) != sizeof(section)) {
+      return false;
+    }
+    section.ToHostFormat();
+    if (section.section_bytes < 0) {
+      return false;
+    }
+
+    offset += sizeof(SectionHeader);
+    (*sections)[section.tag] = std::make_pair(offset, section.section_bytes);
+    offset += section.section_bytes;
+  }
+  return offset == file_bytes;
 }
 
 }  // namespace hw3
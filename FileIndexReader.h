@@ -12,12 +12,18 @@
 #ifndef HW3_FILEINDEXREADER_H_
 #define HW3_FILEINDEXREADER_H_
 
+#include <map>       // for std::map
+#include <memory>    // for std::shared_ptr
 #include <string>    // for std::string
 #include <cstdio>    // for (FILE*)
 
+#include "./BloomFilter.h"
+#include "./DocLengthTableReader.h"
 #include "./DocTableReader.h"
 #include "./IndexTableReader.h"
 #include "./LayoutStructs.h"
+#include "./TermBoundTableReader.h"
+#include "./TermDictReader.h"
 #include "./Utils.h"
 
 using std::string;
@@ -36,6 +42,13 @@ class FileIndexReader {
   explicit FileIndexReader(const string& file_name, bool validate = true);
   ~FileIndexReader();
 
+  // Returns true if the index file open on "fd" is one that a validating
+  // FileIndexReader would accept: its header is intact, its sections
+  // account for the rest of the file, and its checksum matches.  Unlike
+  // the constructor, this returns false on a bad file rather than
+  // crashing, so it can vet a file before it's put into service.
+  static bool IsValid(int fd);
+
   // Manufactures and returns a DocTableReader for this index file.
   // A DocTableReader is a HashTableReader subclass that is
   // specialized to read the docid-->filename hashtable within this
@@ -48,8 +61,34 @@ class FileIndexReader {
   // index file. (See IndexTableReader.h for details.)
   IndexTableReader* NewIndexTableReader() const;
 
-  // Returns a const reference to the file header information.
-  const IndexFileHeader& getHeader() const { return header_; }
+  // Manufactures and returns a DocLengthTableReader for this index file,
+  // or nullptr if the file was written without a document length section.
+  DocLengthTableReader* NewDocLengthTableReader() const;
+
+  // Manufactures and returns a TermBoundTableReader for this index file,
+  // or nullptr if the file was written without a score bound section.
+  TermBoundTableReader* NewTermBoundTableReader() const;
+
+  // Manufactures and returns a TermDictReader for this index file, or
+  // nullptr if the file was written without a term dictionary.
+  TermDictReader* NewTermDictReader() const;
+
+  // Returns a const reference to the file header information.  Headers
+  // of files in the original format are widened.
+  const IndexFileHeader64& getHeader() const { return header_; }
+
+  // Returns the hash function the file's words were keyed with.
+  HTHashID_t hash_id() const { return hash_id_; }
+
+  // Returns the file's format.
+  IndexFormat format() const { return format_; }
+
+  // Returns the Bloom filter of the file's words, which is read in when
+  // the file is opened and shared with the IndexTableReaders we
+  // manufacture, or nullptr if the file was written without one.
+  std::shared_ptr<const BloomFilter> bloom_filter() const {
+    return bloom_filter_;
+  }
 
  protected:
   // The name of the index file we're reading.
@@ -59,7 +98,27 @@ class FileIndexReader {
   FILE* file_;
 
   // A cached copy of file header.
-  IndexFileHeader header_;
+  IndexFileHeader64 header_;
+
+  // The size of the header on disk, which depends on the format.
+  IndexFileOffset_t header_bytes_;
+
+  // The word hash function recorded in the header's magic number.
+  HTHashID_t hash_id_;
+
+  // The file format recorded in the header's magic number.
+  IndexFormat format_;
+
+  // For kIndexFormatNative, a mapping of the file, which the readers we
+  // manufacture share; otherwise nullptr.
+  std::shared_ptr<const MappedFile> mapping_;
+
+  // The auxiliary sections found after the index, keyed by tag.  Each
+  // value is the (offset, size) of the section's payload.
+  std::map<uint32_t, std::pair<IndexFileOffset_t, int32_t>> sections_;
+
+  // The Bloom filter of the file's words; see bloom_filter().
+  std::shared_ptr<const BloomFilter> bloom_filter_;
 
  private:
   // This friend declaration is here so that the Test_FileIndexReader
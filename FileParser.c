@@ -27,6 +27,7 @@
 
 #include "libhw1/CSE333.h"
 #include "./MemIndex.h"
+#include "./WordPool.h"
 
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -38,11 +39,10 @@
 // DocPositionOffset_t.
 static void NoOpFree(LLPayload_t payload) { }
 
-// Frees a WordPositions struct.
+// Frees a WordPositions struct.  Its word belongs to the WordPool.
 static void FreeWordPositions(HTValue_t payload) {
   WordPositions* pos = (WordPositions*) payload;
   LinkedList_Free(pos->positions, &NoOpFree);
-  free(pos->word);
   free(pos);
 }
 
@@ -163,6 +163,7 @@ HashTable* ParseIntoWordPositionsTable(char* file_contents) {
   // number of buckets.
   tab = HashTable_Allocate(32);
   Verify333(tab != NULL);
+  WordPool_Acquire();
 
   // Loop through the file, splitting it into words and inserting a record for
   // each word.
@@ -170,7 +171,7 @@ HashTable* ParseIntoWordPositionsTable(char* file_contents) {
 
   // If we found no words, return NULL instead of a zero-sized hashtable.
   if (HashTable_NumElements(tab) == 0) {
-    HashTable_Free(tab, &FreeWordPositions);
+    FreeWordPositionsTable(tab);
     tab = NULL;
   }
 
@@ -182,6 +183,7 @@ HashTable* ParseIntoWordPositionsTable(char* file_contents) {
 
 void FreeWordPositionsTable(HashTable *table) {
   HashTable_Free(table, &FreeWordPositions);
+  WordPool_Release();
 }
 
 
@@ -264,12 +266,13 @@ static void InsertContent(HashTable* tab, char* content) {
 
 static void AddWordPosition(HashTable* tab, char* word,
                             DocPositionOffset_t pos) {
+  int len = strlen(word);
   HTKey_t hash_key;
   HTKeyValue_t kv;
   WordPositions *wp;
 
   // Hash the string.
-  hash_key = FNVHash64((unsigned char*) word, strlen(word));
+  hash_key = MemIndex_HashWord(word, len);
 
   // Have we already encountered this word within this file?  If so, it's
   // already in the hashtable.
@@ -294,8 +297,9 @@ static void AddWordPosition(HashTable* tab, char* word,
     // allocates memory for WordPositions.
     wp = (WordPositions*) malloc(sizeof(WordPositions));
     Verify333(wp != NULL);
-    // updates word in wp to be given word.
-    wp->word = strdup(word);
+    // points wp at the pooled copy of the word; we reuse its hash, so
+    // this is the only lookup the pool needs.
+    wp->word = WordPool_Intern(word, len, hash_key);
     // allocates LinkedList in wp.
     wp->positions = LinkedList_Allocate();
     // appends pos of word to LinkedList.
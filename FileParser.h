@@ -42,7 +42,7 @@ char* ReadFileToString(const char* file_name, int* size);
 // position as a 64-bit LLPayload_t (ie, a void*); note we're assuming that
 // pointers are 64 bits long in order to do this.
 typedef struct WordPositions {
-  char*       word;        // normalized word.  Owned.
+  const char* word;        // normalized word, interned in the WordPool.
   LinkedList* positions;   // list of DocPositionOffset_t.  Owned.
 } WordPositions;
 
@@ -63,8 +63,10 @@ typedef struct WordPositions {
 // Returns:
 // - NULL, on failure (e.g., empty content, contains non-ASCII characters, no
 //   parseable content).
-// - a HashTable of (FNVHash64(word), WordPositions(word)).  Caller is
+// - a HashTable of (MemIndex_HashWord(word), WordPositions(word)).  Caller is
 //   responsible for freeing this structure using FreeWordPositions(), below.
+//   The table holds a reference on the WordPool (see WordPool.h) until
+//   then, so its words stay valid.
 HashTable *ParseIntoWordPositionsTable(char* file_contents);
 
 // Frees memory allocated by ParseIntoWordPositions.
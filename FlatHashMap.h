@@ -0,0 +1,272 @@
+/*
+ * Copyright ©2024 Hannah C. Tang.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Washington
+ * CSE 333 for use solely during Spring Quarter 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#ifndef HW3_FLATHASHMAP_H_
+#define HW3_FLATHASHMAP_H_
+
+#include <stdint.h>    // for uint8_t, uint64_t.
+#include <cstddef>     // for size_t.
+#include <functional>  // for std::hash, std::equal_to.
+#include <memory>      // for std::allocator, std::allocator_traits.
+#include <utility>     // for std::pair, std::move.
+
+extern "C" {
+  #include "libhw1/CSE333.h"  // for Verify333().
+}
+#include "./Utils.h"          // for DISALLOW_COPY_AND_ASSIGN().
+
+namespace hw3 {
+
+// A FlatHashMap is an open-addressing hash table for use by the C++ layers
+// in place of libhw1's HashTable.  Where a HashTable stores a void* per
+// element in a malloc'ed (key,value) hanging off a linked list node, a
+// FlatHashMap stores its (key,value) pairs by value in a single array,
+// and the hash, equality and value types are all template parameters, so
+// lookups need no casts, no indirect calls and no pointer chasing.
+//
+// Collisions are resolved by linear probing.  The number of slots is
+// always a power of two, kept at most 3/4 full, and the hash is spread
+// over the slots with a multiplicative ("Fibonacci") mix, so even an
+// identity hash like std::hash<uint64_t> is fine.  Removal shifts later
+// elements of the probe sequence back rather than leaving tombstones.
+//
+// Any insertion or removal may move other elements, so pointers returned
+// by Find() and friends are only valid until the map is next modified.
+template <typename K, typename V,
+          typename Hash = std::hash<K>,
+          typename KeyEqual = std::equal_to<K>,
+          typename Allocator = std::allocator<std::pair<K, V>>>
+class FlatHashMap {
+ public:
+  typedef std::pair<K, V> value_type;
+
+  // Construct an empty map with room for "expected_size" elements before
+  // it needs to grow.
+  explicit FlatHashMap(size_t expected_size = 0,
+                       const Hash& hash = Hash(),
+                       const KeyEqual& key_equal = KeyEqual(),
+                       const Allocator& alloc = Allocator())
+    : hash_(hash), key_equal_(key_equal), alloc_(alloc), slots_(nullptr),
+      full_(nullptr), num_slots_(0), shift_(64), size_(0) {
+    Reserve(expected_size);
+  }
+
+  ~FlatHashMap() {
+    Clear();
+    Deallocate(slots_, full_, num_slots_);
+  }
+
+  // Returns the number of elements in the map.
+  size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+
+  // Returns a pointer to the value associated with "key", or nullptr if
+  // there isn't one.
+  V* Find(const K& key) {
+    size_t i;
+    return FindSlot(key, &i) ? &slots_[i].second : nullptr;
+  }
+  const V* Find(const K& key) const {
+    size_t i;
+    return FindSlot(key, &i) ? &slots_[i].second : nullptr;
+  }
+
+  bool Contains(const K& key) const {
+    size_t i;
+    return FindSlot(key, &i);
+  }
+
+  // Inserts (key,value) if "key" isn't already in the map.  Returns a
+  // pointer to the value now associated with "key", and whether it was
+  // newly inserted; an existing value is left alone.
+  std::pair<V*, bool> Insert(const K& key, const V& value) {
+    size_t i;
+    if (FindSlot(key, &i)) {
+      return std::make_pair(&slots_[i].second, false);
+    }
+    return std::make_pair(&EmplaceAt(i, key, value)->second, true);
+  }
+
+  // Returns a reference to the value associated with "key", inserting a
+  // default-constructed value first if there isn't one.
+  V& operator[](const K& key) {
+    size_t i;
+    if (FindSlot(key, &i)) {
+      return slots_[i].second;
+    }
+    return EmplaceAt(i, key, V())->second;
+  }
+
+  // Removes "key" from the map.  Returns false if it wasn't there.
+  bool Erase(const K& key) {
+    size_t i;
+    if (!FindSlot(key, &i)) {
+      return false;
+    }
+
+    // Walk the rest of the probe run, moving back into the hole any
+    // element whose home slot is at or before it (cyclically).
+    size_t mask = num_slots_ - 1;
+    for (size_t j = (i + 1) & mask; full_[j]; j = (j + 1) & mask) {
+      size_t home = HomeSlot(slots_[j].first);
+      if (((j - home) & mask) >= ((j - i) & mask)) {
+        slots_[i] = std::move(slots_[j]);
+        i = j;
+      }
+    }
+    AllocTraits::destroy(alloc_, &slots_[i]);
+    full_[i] = 0;
+    size_--;
+    return true;
+  }
+
+  // Removes every element, keeping the allocated slots.
+  void Clear() {
+    for (size_t i = 0; i < num_slots_ && size_ > 0; i++) {
+      if (full_[i]) {
+        AllocTraits::destroy(alloc_, &slots_[i]);
+        full_[i] = 0;
+        size_--;
+      }
+    }
+  }
+
+  // Makes room for "n" elements, so that inserting up to that many won't
+  // need to grow the map.
+  void Reserve(size_t n) {
+    size_t want = kMinSlots;
+    while (want * 3 / 4 < n) {
+      want *= 2;
+    }
+    if (want > num_slots_) {
+      Rehash(want);
+    }
+  }
+
+  // Invokes fn(key, value) on each element, in no particular order.  "fn"
+  // may modify the value but must not otherwise modify the map.
+  template <typename Fn>
+  void ForEach(Fn fn) {
+    for (size_t i = 0; i < num_slots_; i++) {
+      if (full_[i]) {
+        fn(static_cast<const K&>(slots_[i].first), slots_[i].second);
+      }
+    }
+  }
+
+ private:
+  typedef std::allocator_traits<Allocator> AllocTraits;
+  typedef typename AllocTraits::template rebind_alloc<value_type> SlotAlloc;
+  typedef typename AllocTraits::template rebind_alloc<uint8_t> FullAlloc;
+  typedef std::allocator_traits<SlotAlloc> SlotTraits;
+  typedef std::allocator_traits<FullAlloc> FullTraits;
+
+  static constexpr size_t kMinSlots = 8;
+
+  // Returns the slot where a probe for "key" starts: the top bits of the
+  // hash times 2^64 / phi.
+  size_t HomeSlot(const K& key) const {
+    uint64_t h = static_cast<uint64_t>(hash_(key));
+    return static_cast<size_t>((h * 0x9E3779B97F4A7C15ULL) >> shift_);
+  }
+
+  // Probes for "key".  Returns true and sets *slot to its slot if it's in
+  // the map; otherwise returns false and sets *slot to the empty slot
+  // where it would be inserted.
+  bool FindSlot(const K& key, size_t* slot) const {
+    if (num_slots_ == 0) {
+      *slot = 0;
+      return false;
+    }
+    size_t mask = num_slots_ - 1;
+    size_t i = HomeSlot(key);
+    while (full_[i]) {
+      if (key_equal_(slots_[i].first, key)) {
+        *slot = i;
+        return true;
+      }
+      i = (i + 1) & mask;
+    }
+    *slot = i;
+    return false;
+  }
+
+  // Constructs (key,value) in empty slot "i", as found by FindSlot(),
+  // growing the map first if that would make it too full.
+  value_type* EmplaceAt(size_t i, const K& key, const V& value) {
+    if ((size_ + 1) * 4 > num_slots_ * 3) {
+      Rehash(num_slots_ == 0 ? kMinSlots : num_slots_ * 2);
+      bool found = FindSlot(key, &i);
+      Verify333(!found);
+    }
+    AllocTraits::construct(alloc_, &slots_[i], key, value);
+    full_[i] = 1;
+    size_++;
+    return &slots_[i];
+  }
+
+  // Moves every element into a new array of "new_num_slots" slots.
+  void Rehash(size_t new_num_slots) {
+    value_type* old_slots = slots_;
+    uint8_t* old_full = full_;
+    size_t old_num_slots = num_slots_;
+
+    SlotAlloc slot_alloc(alloc_);
+    FullAlloc full_alloc(alloc_);
+    slots_ = SlotTraits::allocate(slot_alloc, new_num_slots);
+    full_ = FullTraits::allocate(full_alloc, new_num_slots);
+    for (size_t i = 0; i < new_num_slots; i++) {
+      full_[i] = 0;
+    }
+    num_slots_ = new_num_slots;
+    shift_ = 64;
+    for (size_t n = new_num_slots; n > 1; n >>= 1) {
+      shift_--;
+    }
+
+    for (size_t i = 0; i < old_num_slots; i++) {
+      if (old_full[i]) {
+        size_t j;
+        FindSlot(old_slots[i].first, &j);
+        AllocTraits::construct(alloc_, &slots_[j], std::move(old_slots[i]));
+        AllocTraits::destroy(alloc_, &old_slots[i]);
+        full_[j] = 1;
+      }
+    }
+    Deallocate(old_slots, old_full, old_num_slots);
+  }
+
+  void Deallocate(value_type* slots, uint8_t* full, size_t num_slots) {
+    if (num_slots == 0) {
+      return;
+    }
+    SlotAlloc slot_alloc(alloc_);
+    FullAlloc full_alloc(alloc_);
+    SlotTraits::deallocate(slot_alloc, slots, num_slots);
+    FullTraits::deallocate(full_alloc, full, num_slots);
+  }
+
+  Hash hash_;
+  KeyEqual key_equal_;
+  Allocator alloc_;
+
+  value_type* slots_;  // num_slots_ slots; only those marked full_ are live
+  uint8_t* full_;      // whether each slot holds an element
+  size_t num_slots_;   // zero, or a power of two
+  int shift_;          // 64 - log2(num_slots_)
+  size_t size_;        // the number of live elements
+
+  DISALLOW_COPY_AND_ASSIGN(FlatHashMap);
+};
+
+}  // namespace hw3
+
+#endif  // HW3_FLATHASHMAP_H_
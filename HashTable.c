@@ -12,6 +12,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdint.h>
+#include <string.h>
 
 #include "CSE333.h"
 #include "HashTable.h"
@@ -23,6 +24,10 @@
 //
 #define INVALID_IDX -1
 
+// The most buckets a table may have.  Beyond this, the chains just get
+// longer.
+#define HT_MAX_BUCKETS ((int64_t) 1 << 40)
+
 // frees payload.
 // takes payload to remove.
 static void RemovePayload(LLPayload_t toremove);
@@ -44,8 +49,9 @@ static bool FindAndRemove(LinkedList *chain,
 // factor has become too high.
 static void MaybeResize(HashTable *ht);
 
-int HashKeyToBucketNum(HashTable *ht, HTKey_t key) {
-  return key % ht->num_buckets;
+int64_t HashKeyToBucketNum(HashTable *ht, HTKey_t key) {
+  // num_buckets is a power of two, so this is key % num_buckets.
+  return (int64_t) (key & (HTKey_t) (ht->num_buckets - 1));
 }
 
 // Deallocation functions that do nothing.  Useful if we want to deallocate
@@ -78,12 +84,116 @@ HTKey_t FNVHash64(unsigned char *buffer, int len) {
   return hval;
 }
 
-HashTable* HashTable_Allocate(int num_buckets) {
+// wyhash's default secret.
+static const uint64_t kWyP[4] = {
+  0x2d358dccaa6c78a5ULL, 0x8bb84b93962eacc9ULL,
+  0x4b33a62ed433d4a3ULL, 0x4d5a2da51de1aa47ULL
+};
+
+// Computes the full 128-bit product of *a and *b, leaving the low half in
+// *a and the high half in *b.
+static inline void WyMum(uint64_t *a, uint64_t *b) {
+  __uint128_t r = (__uint128_t) *a * *b;
+  *a = (uint64_t) r;
+  *b = (uint64_t) (r >> 64);
+}
+
+static inline uint64_t WyMix(uint64_t a, uint64_t b) {
+  WyMum(&a, &b);
+  return a ^ b;
+}
+
+// Read 8 or 4 bytes as a little-endian integer, whatever the host's byte
+// order, so that hashes (which hw3 writes to disk) are portable.
+static inline uint64_t WyRead8(const unsigned char *p) {
+  uint64_t v;
+  memcpy(&v, p, sizeof(v));
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+  v = __builtin_bswap64(v);
+#endif
+  return v;
+}
+
+static inline uint64_t WyRead4(const unsigned char *p) {
+  uint32_t v;
+  memcpy(&v, p, sizeof(v));
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+  v = __builtin_bswap32(v);
+#endif
+  return v;
+}
+
+HTKey_t WyHash64(unsigned char *buffer, int len) {
+  const unsigned char *p = buffer;
+  uint64_t n = (uint64_t) len;
+  uint64_t seed = WyMix(kWyP[0], kWyP[1]);
+  uint64_t a, b;
+
+  if (n <= 16) {
+    if (n >= 4) {
+      // Two overlapping pairs of 4-byte reads cover the whole key.
+      uint64_t mid = (n >> 3) << 2;
+      a = (WyRead4(p) << 32) | WyRead4(p + mid);
+      b = (WyRead4(p + n - 4) << 32) | WyRead4(p + n - 4 - mid);
+    } else if (n > 0) {
+      a = ((uint64_t) p[0] << 16) | ((uint64_t) p[n >> 1] << 8) | p[n - 1];
+      b = 0;
+    } else {
+      a = b = 0;
+    }
+  } else {
+    uint64_t i = n;
+    if (i >= 48) {
+      uint64_t see1 = seed, see2 = seed;
+      do {
+        seed = WyMix(WyRead8(p) ^ kWyP[1], WyRead8(p + 8) ^ seed);
+        see1 = WyMix(WyRead8(p + 16) ^ kWyP[2], WyRead8(p + 24) ^ see1);
+        see2 = WyMix(WyRead8(p + 32) ^ kWyP[3], WyRead8(p + 40) ^ see2);
+        p += 48;
+        i -= 48;
+      } while (i >= 48);
+      seed ^= see1 ^ see2;
+    }
+    while (i > 16) {
+      seed = WyMix(WyRead8(p) ^ kWyP[1], WyRead8(p + 8) ^ seed);
+      i -= 16;
+      p += 16;
+    }
+    a = WyRead8(p + i - 16);
+    b = WyRead8(p + i - 8);
+  }
+
+  a ^= kWyP[1];
+  b ^= seed;
+  WyMum(&a, &b);
+  return WyMix(a ^ kWyP[0] ^ n, b ^ kWyP[1]);
+}
+
+HTKey_t HashWithID(HTHashID_t hash_id, unsigned char *buffer, int len) {
+  switch (hash_id) {
+    case HT_HASH_FNV1A64:
+      return FNVHash64(buffer, len);
+    case HT_HASH_WYHASH64:
+      return WyHash64(buffer, len);
+  }
+  Verify333(false);  // not a valid HTHashID_t.
+  return 0;
+}
+
+HashTable* HashTable_Allocate(int64_t num_buckets) {
   HashTable *ht;
-  int i;
+  int64_t i;
 
   Verify333(num_buckets > 0);
 
+  // Round the number of buckets up to a power of two.
+  Verify333(num_buckets <= HT_MAX_BUCKETS);
+  int64_t pow2 = 1;
+  while (pow2 < num_buckets) {
+    pow2 <<= 1;
+  }
+  num_buckets = pow2;
+
   // Allocate the hash table record.
   ht = (HashTable *) malloc(sizeof(HashTable));
   Verify333(ht != NULL);
@@ -102,7 +212,7 @@ HashTable* HashTable_Allocate(int num_buckets) {
 
 void HashTable_Free(HashTable *table,
                     ValueFreeFnPtr value_free_function) {
-  int i;
+  int64_t i;
 
   Verify333(table != NULL);
 
@@ -130,7 +240,7 @@ void HashTable_Free(HashTable *table,
   free(table);
 }
 
-int HashTable_NumElements(HashTable *table) {
+int64_t HashTable_NumElements(HashTable *table) {
   Verify333(table != NULL);
   return table->num_elements;
 }
@@ -138,7 +248,7 @@ int HashTable_NumElements(HashTable *table) {
 bool HashTable_Insert(HashTable *table,
                       HTKeyValue_t newkeyvalue,
                       HTKeyValue_t *oldkeyvalue) {
-  int bucket;
+  int64_t bucket;
   LinkedList *chain;
 
   Verify333(table != NULL);
@@ -173,7 +283,7 @@ bool HashTable_Find(HashTable *table,
   Verify333(table != NULL);
 
   // STEP 2: implement HashTable_Find.
-  int bucket = HashKeyToBucketNum(table, key);
+  int64_t bucket = HashKeyToBucketNum(table, key);
   LinkedList* chain = table->buckets[bucket];
 
   bool was_found = FindAndRemove(chain, key, keyvalue, false);
@@ -186,7 +296,7 @@ bool HashTable_Remove(HashTable *table,
   Verify333(table != NULL);
 
   // STEP 3: implement HashTable_Remove.
-  int bucket = HashKeyToBucketNum(table, key);
+  int64_t bucket = HashKeyToBucketNum(table, key);
   LinkedList* chain = table->buckets[bucket];
 
   // was_removed will be true if (key, value) is removed.
@@ -198,30 +308,71 @@ bool HashTable_Remove(HashTable *table,
 }
 
 
+void HashTable_ForEach(HashTable *table, HTForEachFnPtr fn, void *arg) {
+  Verify333(table != NULL);
+  Verify333(fn != NULL);
+
+  for (int64_t i = 0; i < table->num_buckets; i++) {
+    LLIterator it;
+    for (LLIterator_Init(&it, table->buckets[i]);
+         LLIterator_IsValid(&it);
+         LLIterator_Next(&it)) {
+      LLPayload_t payload;
+      LLIterator_Get(&it, &payload);
+      fn((HTKeyValue_t *) payload, arg);
+    }
+  }
+}
+
+void HashTable_Drain(HashTable *table, HTDrainFnPtr fn, void *arg) {
+  Verify333(table != NULL);
+  Verify333(fn != NULL);
+
+  // Pop each chain empty; unlike HTIterator_Remove, there's no need to
+  // look each key back up.
+  for (int64_t i = 0; i < table->num_buckets; i++) {
+    HTKeyValue_t *kv;
+    while (LinkedList_Pop(table->buckets[i], (LLPayload_t *) &kv)) {
+      HTKeyValue_t copy = *kv;
+      free(kv);
+      table->num_elements--;
+      fn(copy, arg);
+    }
+  }
+  Verify333(table->num_elements == 0);
+}
+
+
 ///////////////////////////////////////////////////////////////////////////////
 // HTIterator implementation.
 
 HTIterator* HTIterator_Allocate(HashTable *table) {
   HTIterator *iter;
-  int         i;
 
   Verify333(table != NULL);
 
   iter = (HTIterator *) malloc(sizeof(HTIterator));
   Verify333(iter != NULL);
+  HTIterator_Init(iter, table);
+  return iter;
+}
+
+void HTIterator_Init(HTIterator *iter, HashTable *table) {
+  int64_t i;
+
+  Verify333(iter != NULL);
+  Verify333(table != NULL);
 
   // If the hash table is empty, the iterator is immediately invalid,
   // since it can't point to anything.
+  iter->ht = table;
+  iter->bucket_idx = INVALID_IDX;
   if (table->num_elements == 0) {
-    iter->ht = table;
-    iter->bucket_it = NULL;
-    iter->bucket_idx = INVALID_IDX;
-    return iter;
+    return;
   }
 
-  // Initialize the iterator.  There is at least one element in the
-  // table, so find the first element and point the iterator at it.
-  iter->ht = table;
+  // There is at least one element in the table, so find the first element
+  // and point the iterator at it.
   for (i = 0; i < table->num_buckets; i++) {
     if (LinkedList_NumElements(table->buckets[i]) > 0) {
       iter->bucket_idx = i;
@@ -229,31 +380,21 @@ HTIterator* HTIterator_Allocate(HashTable *table) {
     }
   }
   Verify333(i < table->num_buckets);  // make sure we found it.
-  iter->bucket_it = LLIterator_Allocate(table->buckets[iter->bucket_idx]);
-  return iter;
+  LLIterator_Init(&iter->bucket_it, table->buckets[iter->bucket_idx]);
 }
 
 void HTIterator_Free(HTIterator *iter) {
   Verify333(iter != NULL);
-  if (iter->bucket_it != NULL) {
-    LLIterator_Free(iter->bucket_it);
-    iter->bucket_it = NULL;
-  }
   free(iter);
 }
 
 bool HTIterator_IsValid(HTIterator *iter) {
   Verify333(iter != NULL);
 
-  // STEP 4: implement HTIterator_IsValid.
-  // not valid if table is null or linkedlist iter is null.
-  if (iter->ht != NULL && iter->bucket_it != NULL) {
-    // ensures payloads are valids.
-    if (LLIterator_IsValid(iter->bucket_it)) {
-      return true;  // HTIterator valid.
-    }
-  }
-  return false;  // HTIterator not valid.
+  // not valid if we've run off the end of the buckets, or off the end of
+  // the current bucket's chain.
+  return iter->ht != NULL && iter->bucket_idx != INVALID_IDX &&
+    LLIterator_IsValid(&iter->bucket_it);
 }
 
 bool HTIterator_Next(HTIterator *iter) {
@@ -267,37 +408,28 @@ bool HTIterator_Next(HTIterator *iter) {
   }
 
   // checks if there is (key, value) pair in current bucket to move to.
-  if (LLIterator_Next(iter -> bucket_it)) {
+  if (LLIterator_Next(&iter->bucket_it)) {
     return true;  // successful move to next pair in bucket.
   }
 
-  // free old linkedlist iter.
-  LLIterator_Free(iter->bucket_it);
-  bool is_valid = false;  // true if elements available in different bucket.
-  for (int i = iter->bucket_idx + 1; i < iter->ht->num_buckets; i++) {
-    // checks all buckets in front of current one to find elements.
+  // checks all buckets in front of current one to find elements.
+  for (int64_t i = iter->bucket_idx + 1; i < iter->ht->num_buckets; i++) {
     if (LinkedList_NumElements(iter->ht->buckets[i]) > 0) {
-      iter->bucket_idx = i;  // moving to new bucket.
-      is_valid = true;
-      break;
+      // moving to new bucket.
+      iter->bucket_idx = i;
+      LLIterator_Init(&iter->bucket_it, iter->ht->buckets[i]);
+      return true;
     }
   }
 
-  if (is_valid) {
-    if (iter->bucket_idx < iter->ht->num_buckets) {
-      // creating new iterator for new bucket.
-      iter->bucket_it =
-      LLIterator_Allocate(iter->ht->buckets[iter->bucket_idx]);
-    }
-  } else {
-    iter->bucket_it = NULL;
-    iter->bucket_idx = INVALID_IDX;
-    return false;  // no other bucket was found, no more elements to move to.
-  }
-  return true;
+  // no other bucket was found, no more elements to move to.
+  iter->bucket_idx = INVALID_IDX;
+  return false;
 }
 
 bool HTIterator_Get(HTIterator *iter, HTKeyValue_t *keyvalue) {
+  LLPayload_t payload;
+
   Verify333(iter != NULL);
 
   // STEP 6: implement HTIterator_Get.
@@ -306,12 +438,9 @@ bool HTIterator_Get(HTIterator *iter, HTKeyValue_t *keyvalue) {
     return false;
   }
 
-  // dynamically allocates memory to retrieve (key, value) pair.
-  LLPayload_t* to_copy = (LLPayload_t*) malloc(sizeof(LLPayload_t));
-  LLIterator_Get(iter->bucket_it, to_copy);
   // copies current pair into output argument.
-  *keyvalue = *((HTKeyValue_t*) *to_copy);
-  free(to_copy);
+  LLIterator_Get(&iter->bucket_it, &payload);
+  *keyvalue = *((HTKeyValue_t*) payload);
   return true;  // successfully retrieved pair.
 }
 
@@ -342,37 +471,38 @@ bool HTIterator_Remove(HTIterator *iter, HTKeyValue_t *keyvalue) {
 static void MaybeResize(HashTable *ht) {
   HashTable *newht;
   HashTable tmp;
-  HTIterator *it;
+  int64_t i;
 
-  // Resize if the load factor is > 3.
-  if (ht->num_elements < 3 * ht->num_buckets)
+  // Resize if the load factor is > 3, unless the table is already as big
+  // as it gets.
+  if (ht->num_elements < 3 * ht->num_buckets ||
+      ht->num_buckets * 8 > HT_MAX_BUCKETS)
     return;
 
   // This is the resize case.  Allocate a new hashtable,
-  // iterate over the old hashtable, do the surgery on
+  // move the old hashtable's elements over, do the surgery on
   // the old hashtable record and free up the new hashtable
   // record.
-  newht = HashTable_Allocate(ht->num_buckets * 9);
+  newht = HashTable_Allocate(ht->num_buckets * 8);
 
-  // Loop through the old ht copying its elements over into the new one.
-  for (it = HTIterator_Allocate(ht);
-       HTIterator_IsValid(it);
-       HTIterator_Next(it)) {
-    HTKeyValue_t item, unused;
-
-    Verify333(HTIterator_Get(it, &item));
-    HashTable_Insert(newht, item, &unused);
+  // Move the (key,value)s over chain by chain.  The keys are already
+  // known to be unique, so there's no need to go through
+  // HashTable_Insert, nor to copy the (key,value)s themselves.
+  for (i = 0; i < ht->num_buckets; i++) {
+    HTKeyValue_t *kv;
+    while (LinkedList_Pop(ht->buckets[i], (LLPayload_t *) &kv)) {
+      LinkedList_Append(newht->buckets[HashKeyToBucketNum(newht, kv->key)],
+                        kv);
+    }
   }
+  newht->num_elements = ht->num_elements;
+  ht->num_elements = 0;
 
-  // Swap the new table onto the old, then free the old table (tricky!).  We
-  // use the "no-op free" because we don't actually want to free the elements;
-  // they're owned by the new table.
+  // Swap the new table onto the old, then free the old (now empty) table
+  // (tricky!).
   tmp = *ht;
   *ht = *newht;
   *newht = tmp;
-
-  // Done!  Clean up our iterator and temporary table.
-  HTIterator_Free(it);
   HashTable_Free(newht, &HTNoOpFree);
 }
 
@@ -385,25 +515,21 @@ static bool FindAndRemove(LinkedList *chain,
                           HTKeyValue_t *outkeyvalue,
                           bool willremove) {
   // linkedlist to iterate over.
-  LLIterator* iter = LLIterator_Allocate(chain);
-  // variable for tracking current (key, value) pair during search.
-  LLPayload_t* curr_kv = (LLPayload_t*) malloc(sizeof(LLPayload_t));
-  while (LLIterator_IsValid(iter)) {
-    LLIterator_Get(iter, curr_kv);
+  LLIterator iter;
+  for (LLIterator_Init(&iter, chain);
+       LLIterator_IsValid(&iter);
+       LLIterator_Next(&iter)) {
+    LLPayload_t curr_kv;
+    LLIterator_Get(&iter, &curr_kv);
     // checks to see current pair has matching key.
-    if (((HTKeyValue_t*) *curr_kv)->key == key) {
-      *outkeyvalue = *((HTKeyValue_t*) *curr_kv);
+    if (((HTKeyValue_t*) curr_kv)->key == key) {
+      *outkeyvalue = *((HTKeyValue_t*) curr_kv);
       // optionally decision to remove payload.
       if (willremove) {
-        LLIterator_Remove(iter, &RemovePayload);
+        LLIterator_Remove(&iter, &RemovePayload);
       }
-      free(curr_kv);
-      LLIterator_Free(iter);
       return true;  // pair with matching key found.
     }
-    LLIterator_Next(iter);
   }
-  free(curr_kv);
-  LLIterator_Free(iter);
   return false;  // no pair with matching key found.
 }
@@ -15,6 +15,8 @@
 #include <stdbool.h>    // for bool type (true, false)
 #include <stdint.h>     // for uint64_t, etc.
 
+#include "./LinkedList.h"  // for LLIterator
+
 ///////////////////////////////////////////////////////////////////////////////
 // A HashTable is a automatically-resizing chained hash table.
 //
@@ -24,12 +26,14 @@
 // (via the void*).  However, we require that the caller hash the key before
 // providing it to the table for storage.  It's up to the customer to
 // figure out how to produce an appropriate hash key, but below we provide
-// an implementation of FNV hashing to help them out.
+// implementations of FNV hashing and wyhash to help them out.
 //
-// As the load factor approaches 1, linked lists hanging off of each bucket
-// will start to grow.  This implementation will dynamically resize the
-// hashtable when the load factor exceeds 3.  It will multiple the number
-// of buckets in the hashtable by 9, so that post-resize load factor is 1/3.
+// The number of buckets is always a power of two, so that a key's bucket
+// is just its low-order bits.  As the load factor approaches 1, linked
+// lists hanging off of each bucket will start to grow.  This implementation
+// will dynamically resize the hashtable when the load factor exceeds 3.  It
+// will multiply the number of buckets in the hashtable by 8, so that the
+// post-resize load factor is 3/8.
 //
 // To hide the implementation of HashTable, we declare the "struct ht"
 // structure and its associated typedef here, but we *define* the structure
@@ -76,15 +80,57 @@ typedef void(*ValueFreeFnPtr)(HTValue_t value);
 //   use in a HTKeyValue_t.
 HTKey_t FNVHash64(unsigned char *buffer, int len);
 
+// wyhash implementation.
+//
+// Like FNVHash64, but consumes the buffer eight bytes at a time rather
+// than one, so it is several times faster on anything but the shortest
+// keys.  This is the "final4" version of Wang Yi's public-domain wyhash,
+// with a seed of zero:
+//     https://github.com/wangyi-fudan/wyhash
+// It returns the same value for the same bytes on every platform.
+//
+// Arguments:
+// - buffer: a pointer to a len-size buffer of unsigned chars.
+// - len: how many bytes are in the buffer.
+//
+// Returns:
+// - a nicely distributed 64-bit hash value suitable for
+//   use in a HTKeyValue_t.
+HTKey_t WyHash64(unsigned char *buffer, int len);
+
+// Identifies one of the hash functions above.  Customers that store hash
+// keys somewhere durable (eg, hw3's index files) can record one of these
+// alongside them, so the values must never be renumbered.
+typedef enum {
+  HT_HASH_FNV1A64 = 0,   // FNVHash64()
+  HT_HASH_WYHASH64 = 1,  // WyHash64()
+} HTHashID_t;
+
+// The number of valid HTHashID_t values.
+#define HT_NUM_HASH_IDS 2
+
+// Hashes a buffer with the hash function identified by "hash_id", which
+// must be a valid HTHashID_t.
+//
+// Arguments:
+// - hash_id: which hash function to use.
+// - buffer: a pointer to a len-size buffer of unsigned chars.
+// - len: how many bytes are in the buffer.
+//
+// Returns:
+// - the 64-bit hash value.
+HTKey_t HashWithID(HTHashID_t hash_id, unsigned char *buffer, int len);
+
 
 // Allocate and return a new HashTable.
 //
 // Arguments:
 // - num_buckets: the number of buckets the hash table should
-//   initially contain; MUST be greater than zero.
+//   initially contain; MUST be greater than zero.  It is rounded up to
+//   the next power of two.
 //
 // Returns a pointer to the newly allocated HashTable.
-HashTable* HashTable_Allocate(int num_buckets);
+HashTable* HashTable_Allocate(int64_t num_buckets);
 
 // Free a HashTable and its entries.
 //
@@ -105,7 +151,7 @@ void HashTable_Free(HashTable *table, ValueFreeFnPtr value_free_function);
 // Returns:
 //
 // - table size (>=0)
-int HashTable_NumElements(HashTable *table);
+int64_t HashTable_NumElements(HashTable *table);
 
 // Inserts a (key,value) pair into the HashTable.
 //
@@ -170,6 +216,46 @@ bool HashTable_Remove(HashTable *table,
                       HTKey_t key,
                       HTKeyValue_t *keyvalue);
 
+// A callback invoked by HashTable_ForEach once for each (key,value) in the
+// table.  The callback may change the value through "keyvalue", but not
+// the key, and must not otherwise mutate the table.
+//
+// Arguments:
+// - keyvalue: the (key,value) the callback is invoked on.
+// - arg: the argument passed to HashTable_ForEach.
+typedef void(*HTForEachFnPtr)(HTKeyValue_t *keyvalue, void *arg);
+
+// Invokes "fn" once on each (key,value) in the table, in the same
+// (undefined) order as an iterator would visit them.  Unlike an
+// HTIterator, this doesn't allocate any memory.
+//
+// Arguments:
+// - table: the HashTable to visit.
+// - fn: the callback to invoke.
+// - arg: an argument passed through to each invocation of fn.
+void HashTable_ForEach(HashTable *table, HTForEachFnPtr fn, void *arg);
+
+// A callback invoked by HashTable_Drain once for each (key,value) removed
+// from the table.  The callback takes ownership of any memory pointed to
+// by the value.
+//
+// Arguments:
+// - keyvalue: the (key,value) that was removed.
+// - arg: the argument passed to HashTable_Drain.
+typedef void(*HTDrainFnPtr)(HTKeyValue_t keyvalue, void *arg);
+
+// Removes every (key,value) from the table in a single pass, handing each
+// one to "fn".  This is much cheaper than removing each element with
+// HTIterator_Remove, which has to look every key back up.  Afterwards,
+// the table is empty but still allocated, and can be reused or freed.
+//
+// Arguments:
+// - table: the HashTable to drain.
+// - fn: the callback that takes ownership of each (key,value); it must
+//   not use the table.
+// - arg: an argument passed through to each invocation of fn.
+void HashTable_Drain(HashTable *table, HTDrainFnPtr fn, void *arg);
+
 
 ///////////////////////////////////////////////////////////////////////////////
 // HashTable iterator
@@ -181,7 +267,15 @@ bool HashTable_Remove(HashTable *table,
 // is visited exactly once.  Also, if the customer uses a HashTable function
 // to mutate the hash table, any existing iterators become undefined (ie,
 // dangerous to use; arbitrary memory corruption can occur).
-typedef struct ht_it HTIterator;  // same trick to hide implementation.
+//
+// As with LLIterator, the struct is defined here so that customers can
+// declare an iterator on the stack and set it up with HTIterator_Init();
+// its fields are private.
+typedef struct ht_it {
+  HashTable  *ht;          // the HT we're pointing into
+  int64_t     bucket_idx;  // which bucket are we in, or -1 if past the end
+  LLIterator  bucket_it;   // iterator for the bucket, if bucket_idx >= 0
+} HTIterator;
 
 // Manufacture an iterator for the table.  If there are
 // elements in the hash table, the iterator is initialized
@@ -196,6 +290,15 @@ typedef struct ht_it HTIterator;  // same trick to hide implementation.
 //   if the table cannot be iterated through (eg, empty).
 HTIterator* HTIterator_Allocate(HashTable *table);
 
+// Initializes a caller-allocated iterator for the table, pointing at the
+// "first" element (if any).  An iterator initialized this way must *not*
+// be passed to HTIterator_Free; it owns no memory.
+//
+// Arguments:
+// - iter: the iterator to initialize.
+// - table: the table to iterate through.
+void HTIterator_Init(HTIterator *iter, HashTable *table);
+
 // When you're done with a hash table iterator, you must free it
 // by calling this function.
 //
@@ -14,6 +14,7 @@
 #include <stdint.h>  // for uint32_t, etc.
 #include <cstdio>    // for (FILE *).
 #include <list>      // for std::list.
+#include <vector>    // for std::vector.
 
 #include "./LayoutStructs.h"
 
@@ -24,11 +25,73 @@ extern "C" {
 
 
 using std::list;
+using std::vector;
 
 namespace hw3 {
 
-HashTableReader::HashTableReader(FILE* f, IndexFileOffset_t offset)
-  : file_(f), offset_(offset) {
+// Reads bucket record "bucket_num" of the hash table at byte offset
+// "offset" in "f", laid out as in the format "Offsets", and returns it
+// widened to a BucketRecord64.
+template <typename Offsets>
+static BucketRecord64 ReadBucketRecord(FILE* f, IndexFileOffset_t offset,
+                                       int64_t bucket_num) {
+  typename Offsets::Bucket record;
+  Verify333(fseek(f, offset + sizeof(BucketListHeader) +
+                  sizeof(record) * bucket_num, SEEK_SET) == 0);
+  Verify333(fread(&record, sizeof(record), 1, f) == 1);
+  record.ToHostFormat();
+  return BucketRecord64(record.chain_num_elements, record.position);
+}
+
+// Reads the element positions of the bucket described by "bucket_rec"
+// from "f", laid out as in the format "Offsets", appending them to
+// "positions".
+template <typename Offsets>
+static void ReadElementPositions(FILE* f, const BucketRecord64& bucket_rec,
+                                 list<IndexFileOffset_t>* positions) {
+  vector<typename Offsets::ElementPosition> records(
+    bucket_rec.chain_num_elements);
+  Verify333(fseek(f, bucket_rec.position, SEEK_SET) == 0);
+  Verify333(fread(records.data(), sizeof(records[0]), records.size(), f) ==
+            records.size());
+  for (auto& record : records) {
+    record.ToHostFormat();
+    positions->push_back(record.position);
+  }
+}
+
+// Returns the total length of the chains of the "num_buckets" bucket
+// records of the hash table at byte offset "offset" in "f", laid out as in
+// the format "Offsets".
+template <typename Offsets>
+static int64_t CountElements(FILE* f, IndexFileOffset_t offset,
+                             int32_t num_buckets) {
+  // The bucket records are contiguous, so slurp them all in with a
+  // single fread() rather than seeking to each one.
+  vector<typename Offsets::Bucket> records(num_buckets);
+  Verify333(fseek(f, offset + sizeof(BucketListHeader), SEEK_SET) == 0);
+  Verify333(fread(records.data(), sizeof(records[0]), records.size(), f)
+            == records.size());
+
+  int64_t num_elements = 0;
+  for (auto& record : records) {
+    record.ToHostFormat();
+    num_elements += record.chain_num_elements;
+  }
+  return num_elements;
+}
+
+HashTableReader::HashTableReader(FILE* f, IndexFileOffset_t offset,
+                                 IndexFormat format,
+                                 std::shared_ptr<const MappedFile> mapping)
+  : file_(f), offset_(offset), format_(format), mapping_(mapping) {
+  if (format_ == kIndexFormatNative) {
+    Verify333(mapping_ != nullptr);
+    header_.num_buckets =
+      MappedRecords<BucketListHeaderNative>(offset)->num_buckets;
+    return;
+  }
+
   // STEP 1.
   // fread() the bucket list header in this hashtable from its
   // "num_buckets" field, and convert to host byte order.
@@ -44,40 +107,65 @@ HashTableReader::~HashTableReader() {
 
 list<IndexFileOffset_t>
 HashTableReader::LookupElementPositions(HTKey_t hash_key) const {
-  // Figure out which bucket the hash value is in.  We assume
-  // hash values are mapped to buckets using the modulo (%) operator.
-  int bucket_num = hash_key % header_.num_buckets;
-
-  // Figure out the offset of the "bucket_rec" field for this bucket.
-  IndexFileOffset_t bucket_rec_offset =
-      offset_ + sizeof(BucketListHeader) + sizeof(BucketRecord) * bucket_num;
+  // Figure out which bucket the hash value is in.  Hash values are
+  // mapped to buckets using the modulo (%) operator, which is just a mask
+  // when (as in any index written from a libhw1 HashTable) the number of
+  // buckets is a power of two.
+  HTKey_t num_buckets = header_.num_buckets;
+  int64_t bucket_num = (num_buckets & (num_buckets - 1)) == 0 ?
+    hash_key & (num_buckets - 1) : hash_key % num_buckets;
+  return BucketElementPositions(bucket_num);
+}
 
+list<IndexFileOffset_t>
+HashTableReader::BucketElementPositions(int64_t bucket_num) const {
   // STEP 2.
   // Read the "chain len" and "bucket position" fields from the
   // bucket record, and convert from network to host order.
-  BucketRecord bucket_rec;
-  Verify333(fseek(file_, bucket_rec_offset, SEEK_SET) == 0);
-  Verify333(fread(&bucket_rec, 1, sizeof(BucketRecord), file_) ==
-           sizeof(BucketRecord));
-  bucket_rec.ToHostFormat();
-
-  // This will be our returned list of element positions.
-  list<IndexFileOffset_t> ret_val;
-
+  //
   // STEP 3.
   // Read the "element positions" fields from the "bucket" header into
-  // the returned list.  Be sure to insert into the list in the
-  // correct order (i.e., append to the end of the list).
-  Verify333(fseek(file_, bucket_rec.position, SEEK_SET) == 0);
-  IndexFileOffset_t position;
-  for (int i = 0; i < bucket_rec.chain_num_elements; i++) {
-    Verify333(fread(&position, 1, sizeof(IndexFileOffset_t), file_) ==
-             sizeof(IndexFileOffset_t));
-    position = ntohl(position);
-    ret_val.push_back(position);
+  // the returned list, in order.
+  list<IndexFileOffset_t> ret_val;
+  if (format_ == kIndexFormatNative) {
+    // The records are used where they are, with no copying or swapping.
+    Verify333(bucket_num >= 0 && bucket_num < header_.num_buckets);
+    const BucketRecordNative* bucket_recs = MappedRecords<BucketRecordNative>(
+      offset_ + sizeof(BucketListHeaderNative), header_.num_buckets);
+    const BucketRecordNative& bucket_rec = bucket_recs[bucket_num];
+    const ElementPositionRecordNative* records =
+      MappedRecords<ElementPositionRecordNative>(bucket_rec.position,
+                                                 bucket_rec.chain_num_elements);
+    for (int32_t i = 0; i < bucket_rec.chain_num_elements; i++) {
+      ret_val.push_back(records[i].position);
+    }
+  } else if (format_ == kIndexFormat64) {
+    BucketRecord64 bucket_rec =
+      ReadBucketRecord<Offsets64>(file_, offset_, bucket_num);
+    ReadElementPositions<Offsets64>(file_, bucket_rec, &ret_val);
+  } else {
+    BucketRecord64 bucket_rec =
+      ReadBucketRecord<Offsets32>(file_, offset_, bucket_num);
+    ReadElementPositions<Offsets32>(file_, bucket_rec, &ret_val);
   }
 
   // Return the list.
   return ret_val;
 }
+
+int64_t HashTableReader::NumElements() const {
+  if (format_ == kIndexFormatNative) {
+    const BucketRecordNative* records = MappedRecords<BucketRecordNative>(
+      offset_ + sizeof(BucketListHeaderNative), header_.num_buckets);
+    int64_t num_elements = 0;
+    for (int32_t i = 0; i < header_.num_buckets; i++) {
+      num_elements += records[i].chain_num_elements;
+    }
+    return num_elements;
+  }
+  if (format_ == kIndexFormat64) {
+    return CountElements<Offsets64>(file_, offset_, header_.num_buckets);
+  }
+  return CountElements<Offsets32>(file_, offset_, header_.num_buckets);
+}
 }  // namespace hw3
@@ -14,8 +14,10 @@
 
 #include <cstdio>    // for (FILE*).
 #include <list>      // for std::list.
+#include <memory>    // for std::shared_ptr.
 
 #include "./LayoutStructs.h"
+#include "./Utils.h"
 
 using std::list;
 
@@ -32,7 +34,12 @@ class HashTableReader {
   // - f: an open (FILE*) for the index file to read.  Takes ownership of
   //   the passed-in file's memory, and will also fclose() it on destruction.
   // - offset: the hash table's byte offset within the file.
-  HashTableReader(FILE* f, IndexFileOffset_t offset);
+  // - format: the index file's format (see FileIndexReader::format()).
+  // - mapping: for kIndexFormatNative, a mapping of the whole file, whose
+  //   records are read in place rather than through "f".
+  HashTableReader(FILE* f, IndexFileOffset_t offset,
+                  IndexFormat format = kIndexFormat32,
+                  std::shared_ptr<const MappedFile> mapping = nullptr);
   virtual ~HashTableReader();
 
  protected:
@@ -50,6 +57,26 @@ class HashTableReader {
   //   this returns an empty list.
   list<IndexFileOffset_t> LookupElementPositions(HTKey_t hash_val) const;
 
+  // Returns the file offsets of the "element" fields within bucket
+  // "bucket_num", in chain order.
+  list<IndexFileOffset_t> BucketElementPositions(int64_t bucket_num) const;
+
+  // Returns the total number of elements across all of the hash table's
+  // bucket chains.  Only the bucket records are read, not the elements.
+  int64_t NumElements() const;
+
+  // Returns the "count" contiguous records of type T at byte offset
+  // "offset" of mapping_, in place.  Crashes if they aren't all within the
+  // file, or aren't aligned.
+  template <typename T>
+  const T* MappedRecords(IndexFileOffset_t offset, int64_t count = 1) const {
+    Verify333(offset >= 0 && count >= 0 &&
+              offset + count * static_cast<int64_t>(sizeof(T)) <=
+              mapping_->size());
+    Verify333(offset % alignof(T) == 0);
+    return reinterpret_cast<const T*>(mapping_->data() + offset);
+  }
+
   // The open (FILE*) stream associated with this hash table.
   FILE* file_;
 
@@ -59,6 +86,14 @@ class HashTableReader {
   // A cached copy of the total number of buckets in this hash table.
   BucketListHeader header_;
 
+  // The format of the index file, which determines the layout of the
+  // bucket records and element positions.
+  IndexFormat format_;
+
+  // The mapping of a kIndexFormatNative file, or nullptr.  It's shared by
+  // every reader of the file, and outlives the FileIndexReader.
+  std::shared_ptr<const MappedFile> mapping_;
+
  private:
   // This friend declaration is here so that the Test_HashTableReader
   // unit test fixture can access protected member variables of
@@ -34,20 +34,13 @@
 // A hash table is an array of buckets, where each bucket is a linked list
 // of HTKeyValue structs.
 typedef struct ht {
-  int             num_buckets;   // # of buckets in this HT?
-  int             num_elements;  // # of elements currently in this HT?
+  int64_t         num_buckets;   // # of buckets in this HT?
+  int64_t         num_elements;  // # of elements currently in this HT?
   LinkedList    **buckets;       // the array of buckets
 } HashTable;
 
-// The hash table iterator.
-typedef struct ht_it {
-  HashTable  *ht;          // the HT we're pointing into
-  int         bucket_idx;  // which bucket are we in?
-  LLIterator *bucket_it;   // iterator for the bucket, or NULL
-} HTIterator;
-
 // This is the internal hash function we use to map from HTKey_t keys to a
 // bucket number.
-int HashKeyToBucketNum(HashTable *ht, HTKey_t key);
+int64_t HashKeyToBucketNum(HashTable *ht, HTKey_t key);
 
 #endif  // HW1_HASHTABLE_PRIV_H_
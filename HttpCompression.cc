@@ -0,0 +1,142 @@
+/*
+ * Copyright ©2024 Hannah C. Tang.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Washington
+ * CSE 333 for use solely during Spring Quarter 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#include <stdlib.h>
+#include <zlib.h>
+#include <boost/algorithm/string.hpp>
+#include <string>
+#include <vector>
+
+#include "./HttpCompression.h"
+
+extern "C" {
+  #include "libhw1/CSE333.h"
+}
+
+using std::string;
+using std::vector;
+
+namespace hw4 {
+
+ContentCoding NegotiateContentCoding(const string& accept_encoding) {
+  // Each element is a coding, optionally followed by ";q=value".  -1 marks
+  // a coding the header doesn't mention.
+  double gzip_q = -1, deflate_q = -1, star_q = -1;
+  vector<string> elements;
+  boost::split(elements, accept_encoding, boost::is_any_of(","));
+  for (const string& element : elements) {
+    vector<string> params;
+    boost::split(params, element, boost::is_any_of(";"));
+    string coding = boost::algorithm::to_lower_copy(
+        boost::algorithm::trim_copy(params[0]));
+    double q = 1;
+    for (size_t i = 1; i < params.size(); i++) {
+      string param = boost::algorithm::trim_copy(params[i]);
+      if (param.size() > 2 && (param[0] == 'q' || param[0] == 'Q') &&
+          param[1] == '=') {
+        q = atof(param.c_str() + 2);
+      }
+    }
+    if (coding == "gzip" || coding == "x-gzip") {
+      gzip_q = q;
+    } else if (coding == "deflate") {
+      deflate_q = q;
+    } else if (coding == "*") {
+      star_q = q;
+    }
+  }
+
+  if (gzip_q < 0) {
+    gzip_q = star_q;
+  }
+  if (deflate_q < 0) {
+    deflate_q = star_q;
+  }
+  if (gzip_q <= 0 && deflate_q <= 0) {
+    return kIdentity;
+  }
+  return gzip_q >= deflate_q ? kGzip : kDeflate;
+}
+
+const char* ContentCodingName(ContentCoding coding) {
+  switch (coding) {
+    case kGzip:
+      return "gzip";
+    case kDeflate:
+      return "deflate";
+    default:
+      return "identity";
+  }
+}
+
+bool IsCompressibleType(const string& content_type) {
+  string type = boost::algorithm::to_lower_copy(
+      content_type.substr(0, content_type.find(';')));
+  boost::algorithm::trim(type);
+  return boost::algorithm::starts_with(type, "text/") ||
+         type == "application/json" || type == "application/javascript" ||
+         type == "application/xml" || boost::algorithm::ends_with(type, "+xml");
+}
+
+Compressor::Compressor(ContentCoding coding, int level) : finished_(false) {
+  Verify333(coding == kGzip || coding == kDeflate);
+  Verify333(level >= 1 && level <= 9);
+  stream_.zalloc = Z_NULL;
+  stream_.zfree = Z_NULL;
+  stream_.opaque = Z_NULL;
+
+  // A window of 2^15 bytes, plus 16 for a gzip wrapper rather than a zlib
+  // one.
+  int window_bits = coding == kGzip ? 15 + 16 : 15;
+  Verify333(deflateInit2(&stream_, level, Z_DEFLATED, window_bits, 8,
+                         Z_DEFAULT_STRATEGY) == Z_OK);
+}
+
+Compressor::~Compressor() {
+  deflateEnd(&stream_);
+}
+
+void Compressor::Compress(const string& data, bool finish,
+                          string* const out) {
+  Verify333(!finished_);
+  stream_.next_in =
+    reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+  stream_.avail_in = data.size();
+
+  // deflateBound() is almost always enough room, but a flush adds a few
+  // bytes it doesn't account for, so keep going until deflate() stops
+  // filling the space it's given.
+  int flush = finish ? Z_FINISH : Z_SYNC_FLUSH;
+  int res;
+  do {
+    size_t used = out->size();
+    out->resize(used + deflateBound(&stream_, stream_.avail_in) + 16);
+    stream_.next_out = reinterpret_cast<Bytef*>(&(*out)[used]);
+    stream_.avail_out = out->size() - used;
+    res = deflate(&stream_, flush);
+    Verify333(res != Z_STREAM_ERROR);
+    out->resize(out->size() - stream_.avail_out);
+  } while (stream_.avail_out == 0);
+  Verify333(stream_.avail_in == 0);
+  if (finish) {
+    Verify333(res == Z_STREAM_END);
+    finished_ = true;
+  }
+}
+
+void CompressString(const string& data, ContentCoding coding, int level,
+                    string* const out) {
+  out->clear();
+  Compressor compressor(coding, level);
+  compressor.Compress(data, true, out);
+}
+
+}  // namespace hw4
@@ -0,0 +1,82 @@
+/*
+ * Copyright ©2024 Hannah C. Tang.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Washington
+ * CSE 333 for use solely during Spring Quarter 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#ifndef HW4_HTTPCOMPRESSION_H_
+#define HW4_HTTPCOMPRESSION_H_
+
+#include <zlib.h>  // for z_stream
+
+#include <stddef.h>  // for size_t
+#include <string>
+
+namespace hw4 {
+
+// The content codings a response body can be sent in.
+enum ContentCoding {
+  kIdentity,  // uncompressed.
+  kGzip,      // "gzip": a deflate stream in the gzip format (RFC 1952).
+  kDeflate,   // "deflate": a deflate stream in the zlib format (RFC 1950).
+};
+
+// The compression level used for dynamic responses unless the server is
+// told otherwise: zlib's default, a good trade of CPU for bytes.
+constexpr int kDefaultCompressionLevel = 6;
+
+// Bodies smaller than this aren't worth compressing, since they fit in a
+// packet either way.
+constexpr size_t kMinCompressBytes = 1024;
+
+// Picks the coding to send a response in, given the value of the
+// request's Accept-Encoding header: whichever of gzip and deflate the
+// client gives the highest q-value (preferring gzip on a tie), or
+// kIdentity if it accepts neither.  "*" stands for any coding not named,
+// and an absent or empty header accepts only kIdentity.
+ContentCoding NegotiateContentCoding(const std::string& accept_encoding);
+
+// Returns the name of "coding" as it appears in a Content-Encoding header.
+const char* ContentCodingName(ContentCoding coding);
+
+// Returns whether a body of type "content_type" is worth compressing:
+// text, and JSON, JavaScript and XML.  Images and the like are already
+// compressed.
+bool IsCompressibleType(const std::string& content_type);
+
+// A Compressor compresses a body into "coding", in as many pieces as the
+// caller likes, so that a response can be compressed as it's streamed.
+class Compressor {
+ public:
+  // "coding" must be kGzip or kDeflate, and "level" from 1 (fastest) to 9
+  // (smallest).
+  Compressor(ContentCoding coding, int level);
+  ~Compressor();
+
+  // Compresses "data", appending the output to "out".  Unless "finish",
+  // the output is flushed so the receiver can decode everything compressed
+  // so far, and is never empty; otherwise it ends the stream, after which
+  // the Compressor can't be used again.
+  void Compress(const std::string& data, bool finish, std::string* const out);
+
+  Compressor(const Compressor&) = delete;
+  Compressor& operator=(const Compressor&) = delete;
+
+ private:
+  z_stream stream_;
+  bool finished_;
+};
+
+// Compresses all of "data" into "coding" at "level", replacing the
+// contents of "out".
+void CompressString(const std::string& data, ContentCoding coding, int level,
+                    std::string* const out);
+
+}  // namespace hw4
+
+#endif  // HW4_HTTPCOMPRESSION_H_
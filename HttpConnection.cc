@@ -9,7 +9,10 @@
  * author.
  */
 
+#include <errno.h>
 #include <stdint.h>
+#include <stdio.h>
+#include <sys/uio.h>
 #include <boost/algorithm/string.hpp>
 #include <boost/lexical_cast.hpp>
 #include <map>
@@ -19,6 +22,7 @@
 #include "./HttpRequest.h"
 #include "./HttpUtils.h"
 #include "./HttpConnection.h"
+#include "./Metrics.h"
 
 using std::map;
 using std::string;
@@ -29,7 +33,8 @@ namespace hw4 {
 static const char* kHeaderEnd = "\r\n\r\n";
 static const int kHeaderEndLen = 4;
 
-bool HttpConnection::GetNextRequest(HttpRequest* const request) {
+bool HttpConnection::GetNextRequest(HttpRequest* const request,
+                                    int64_t* const started) {
   // Use WrappedRead from HttpUtils.cc to read bytes from the files into
   // private buffer_ variable. Keep reading until:
   // 1. The connection drops
@@ -49,6 +54,9 @@ bool HttpConnection::GetNextRequest(HttpRequest* const request) {
   // STEP 1:
   // check if buffer_ contains "\r\n\r\n".
   // read until next request end or error.
+  if (started != nullptr && !buffer_.empty()) {
+    *started = Metrics::Now();
+  }
   size_t header_end = buffer_.find(kHeaderEnd);
   if (header_end == string::npos) {
     size_t bytes_read;
@@ -56,6 +64,9 @@ bool HttpConnection::GetNextRequest(HttpRequest* const request) {
     while (1) {
       // read into buffer.
       bytes_read = WrappedRead(fd_, char_buf, 512);
+      if (started != nullptr && buffer_.empty()) {
+        *started = Metrics::Now();
+      }
       buffer_.append(reinterpret_cast<char*>(char_buf), bytes_read);
       // check if end of request string is now in buffer.
       header_end = buffer_.find(kHeaderEnd);
@@ -90,6 +101,48 @@ bool HttpConnection::WriteResponse(const HttpResponse& response) const {
   return true;
 }
 
+bool HttpConnection::WriteChunk(const string& data) const {
+  // Send the chunk's size line, its data and the CRLF that ends it with a
+  // single writev(), rather than as three small writes that Nagle's
+  // algorithm would hold back waiting for ACKs.
+  char size_line[24];
+  int size_len = snprintf(size_line, sizeof(size_line), "%zx\r\n",
+                          data.size());
+  struct iovec iov[3];
+  iov[0].iov_base = size_line;
+  iov[0].iov_len = size_len;
+  iov[1].iov_base = const_cast<char*>(data.data());
+  iov[1].iov_len = data.size();
+  iov[2].iov_base = const_cast<char*>("\r\n");
+  iov[2].iov_len = 2;
+
+  struct iovec* next = iov;
+  int remaining = 3;
+  while (remaining > 0) {
+    ssize_t res = writev(fd_, next, remaining);
+    if (res == -1) {
+      if ((errno == EAGAIN) || (errno == EINTR))
+        continue;
+      return false;
+    }
+    if (res == 0)
+      return false;
+
+    // Skip past whatever was written, which may end part way through an
+    // iovec.
+    while (remaining > 0 && static_cast<size_t>(res) >= next->iov_len) {
+      res -= next->iov_len;
+      next++;
+      remaining--;
+    }
+    if (remaining > 0) {
+      next->iov_base = static_cast<char*>(next->iov_base) + res;
+      next->iov_len -= res;
+    }
+  }
+  return true;
+}
+
 HttpRequest HttpConnection::ParseRequest(const string& request) const {
   HttpRequest req("/");  // by default, get "/".
 
@@ -38,7 +38,13 @@ class HttpConnection {
   //
   // The caller is responsible to close the connection if the function
   // returns false
-  bool GetNextRequest(HttpRequest* const request);
+  //
+  // If "started" is non-null, it receives the time (as from Metrics::Now())
+  // at which the first bytes of the request were at hand, so that the
+  // caller can time the request's parsing without the time spent waiting
+  // for the client to send it.
+  bool GetNextRequest(HttpRequest* const request,
+                      int64_t* const started = nullptr);
 
   // Write the response to the file descriptor fd_.
   //
@@ -49,6 +55,15 @@ class HttpConnection {
   // returns false
   bool WriteResponse(const HttpResponse& response) const;
 
+  // Write the next chunk of the body of a chunked response (see
+  // HttpResponse::set_chunked()) to fd_, once WriteResponse() has written
+  // its headers.  An empty chunk ends the body, so write one when the body
+  // is done, and only then.
+  //
+  // Returns true if the chunk was successfully written, false if the
+  // connection experiences an error and should be closed.
+  bool WriteChunk(const std::string& data) const;
+
  private:
   // A helper function to parse the contents of data read from
   // the HTTP connection.
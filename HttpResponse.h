@@ -17,6 +17,8 @@
 #include <map>
 #include <string>
 #include <sstream>
+#include <utility>
+#include <vector>
 
 namespace hw4 {
 
@@ -43,24 +45,42 @@ namespace hw4 {
 
 class HttpResponse {
  public:
-  HttpResponse() { }
+  HttpResponse() : chunked_(false) { }
   virtual ~HttpResponse() { }
 
   void set_protocol(const std::string& protocol) { protocol_ = protocol; }
   void set_response_code(uint16_t code) { response_code_ = code; }
   void set_message(const std::string& msg) { message_ = msg; }
   void set_content_type(const std::string& type) { content_type_ = type; }
+  const std::string& content_type() const { return content_type_; }
+
+  // Adds a header, which is written after the Content-type header (if
+  // any) in the order headers were added.
+  void AddHeader(const std::string& name, const std::string& value) {
+    headers_.emplace_back(name, value);
+  }
 
   void AppendToBody(const std::string& body_fragment) {
     body_ += body_fragment;
   }
+  const std::string& body() const { return body_; }
+
+  // Replaces the body, e.g. with a compressed copy of it.
+  void set_body(std::string body) { body_ = std::move(body); }
+
+  // Marks the response as one whose body is sent after the headers, in
+  // chunks written with HttpConnection::WriteChunk(), for bodies that are
+  // generated as they're sent.  The protocol must be HTTP/1.1.
+  void set_chunked(bool chunked) { chunked_ = chunked; }
 
   // A method to generate a std::string of the HTTP response, suitable for
   // writing back to the client.
   //
   // The "Content-length:" header is automatically generated, which will be the
   // last header in the block. The value of that Content-length header is the
-  // size of the response body (in bytes).
+  // size of the response body (in bytes).  For a chunked response, a
+  // "Transfer-Encoding: chunked" header takes its place, and only the
+  // headers are generated.
   std::string GenerateResponseString() const {
     std::stringstream resp;
 
@@ -68,6 +88,14 @@ class HttpResponse {
     if (!content_type_.empty()) {
       resp << "Content-type: " << content_type_ << "\r\n";
     }
+    for (const auto& header : headers_) {
+      resp << header.first << ": " << header.second << "\r\n";
+    }
+    if (chunked_) {
+      resp << "Transfer-Encoding: chunked\r\n";
+      resp << "\r\n";
+      return resp.str();
+    }
     resp << "Content-length: " << body_.size() << "\r\n";
     resp << "\r\n";
     resp << body_;
@@ -87,8 +115,14 @@ class HttpResponse {
   // The HTTP content type string to pass back in the header.  Optional.
   std::string content_type_;
 
+  // Any other headers, as (name, value) pairs.
+  std::vector<std::pair<std::string, std::string>> headers_;
+
   // The body of the response.
   std::string body_;
+
+  // Whether the body is sent separately, in chunks.
+  bool chunked_;
 };
 
 }  // namespace hw4
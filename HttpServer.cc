@@ -9,7 +9,13 @@
  * author.
  */
 
-#include <boost/algorithm/string.hpp>
+#include <ctype.h>
+#include <errno.h>
+#include <limits.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <algorithm>
 #include <iostream>
 #include <map>
 #include <memory>
@@ -18,20 +24,29 @@
 #include <sstream>
 
 #include "./FileReader.h"
+#include "./HttpCompression.h"
 #include "./HttpConnection.h"
 #include "./HttpRequest.h"
 #include "./HttpUtils.h"
 #include "./HttpServer.h"
+#include "./JsonWriter.h"
+#include "./libhw3/IndexTableReader.h"
 #include "./libhw3/QueryProcessor.h"
 
+extern "C" {
+  #include "libhw1/CSE333.h"
+}
+
 using std::cerr;
 using std::cout;
 using std::endl;
 using std::list;
 using std::map;
+using std::shared_ptr;
 using std::string;
 using std::stringstream;
 using std::unique_ptr;
+using std::vector;
 
 namespace hw4 {
 ///////////////////////////////////////////////////////////////////////////////
@@ -57,25 +72,98 @@ static const char* kThreegleStr =
   "</form>\n"
   "</center><p>\n";
 
+// The number of results a search API request gets when it doesn't say,
+// and the most it can ask for.
+static const int kSearchApiDefaultLimit = 10;
+static const int kSearchApiMaxLimit = 1000;
+
+// A search API response is sent in chunks of about this many bytes.
+static const size_t kSearchApiChunkBytes = 16 * 1024;
+
+// Static files are compressed once and cached, so they may as well be
+// compressed as small as they'll go.
+static const int kStaticCompressionLevel = 9;
+
 // static
 const int HttpServer::kNumThreads = 100;
+const size_t HttpServer::kQueryCacheBytes = 64 * 1024 * 1024;
+const int HttpServer::kQueryCacheShards = 16;
+const size_t HttpServer::kCompressedFileCacheBytes = 32 * 1024 * 1024;
 
 // This is the function that threads are dispatched into
 // in order to process new client connections.
 static void HttpServer_ThrFn(ThreadPool::Task* t);
 
-// Given a request, produce a response.
+// Given a request from the client at c_addr, produce a response, whose
+// body is compressed into "coding" if it's worth it.
 static HttpResponse ProcessRequest(const HttpRequest& req,
+                            const string& c_addr,
                             const string& base_dir,
-                            const list<string>& indices);
-
-// Process a file request.
+                            ContentCoding coding,
+                            HttpServer* server,
+                            QueryCache* query_cache);
+
+// Compresses a dynamic response's body into "coding" at the server's
+// compression level, if the body is worth compressing.  Unless "measured",
+// the time it takes is left out of the latency metrics.
+static void CompressResponse(ContentCoding coding, bool measured,
+                             HttpServer* server,
+                             HttpResponse* const response);
+
+// Process a request for the server's metrics.
+static HttpResponse ProcessMetricsRequest(HttpServer* server,
+                                   QueryCache* query_cache);
+
+// Process a request to reload the server's indices, which is only
+// honored for clients on the loopback interface.
+static HttpResponse ProcessReloadRequest(const string& c_addr,
+                                  HttpServer* server);
+
+// Process a file request.  Files worth compressing are sent in "coding",
+// out of the server's compressed file cache when possible.
 static HttpResponse ProcessFileRequest(const string& uri,
-                                const string& base_dir);
+                                const string& base_dir,
+                                ContentCoding coding,
+                                HttpServer* server);
 
-// Process a query request.
+// Process a query request.  Results (and the rendered HTML for them) are
+// served out of query_cache when possible.
 static HttpResponse ProcessQueryRequest(const string& uri,
-                                 const list<string>& indices);
+                                 HttpServer* server,
+                                 QueryCache* query_cache);
+
+// Process a search API request, writing the JSON response to "conn" as
+// it's generated, in chunks of about kSearchApiChunkBytes built up in
+// "buffer", which is reused from request to request.  If "coding" isn't
+// kIdentity, the response is compressed as it goes, with each chunk
+// compressed into "compressed" (also reused) before it's sent.  Results
+// aren't cached.  Returns false if the connection failed.
+static bool ProcessSearchApiRequest(const URLParser& url,
+                                    ContentCoding coding,
+                                    HttpConnection* const conn,
+                                    HttpServer* server,
+                                    string* const buffer,
+                                    string* const compressed);
+
+// Appends the words "query" looks for to "words", once each: those of its
+// terms, phrases and NEAR/k clauses, but not its patterns or anything
+// under a NOT.
+static void CollectQueryWords(const hw3::QueryNode& query,
+                              vector<string>* const words);
+
+// Parses a non-negative decimal integer no bigger than INT_MAX into
+// "count", returning false if "str" isn't one.
+static bool ParseCount(const string& str, int* const count);
+
+// Returns whether "url" asks for a query to be explained ("explain=1").
+// Measuring a query slows every stage of its request down, so explained
+// requests are left out of the latency metrics altogether.
+static bool IsExplainRequest(const URLParser& url);
+
+// gets HTML string of the <ul> list of matching documents, or an empty
+// string if there are no matches.
+static string GetMatchListHTML(
+    const vector<hw3::QueryProcessor::QueryResult>& matches);
 
 // gets HTML string of <li> element for document matching queries.
 // name links to file contents or website if it's a web link,
@@ -89,6 +177,14 @@ static void EndHTMLReponse(HttpResponse* ret);
 // HttpServer
 ///////////////////////////////////////////////////////////////////////////////
 bool HttpServer::Run(void) {
+  // Open the indices.
+  string error;
+  cout << "  loading the indices..." << endl;
+  if (!Reload(&error)) {
+    cerr << endl << "Couldn't load the indices: " << error << endl;
+    return false;
+  }
+
   // Create the server listening socket.
   int listen_fd;
   cout << "  creating and binding the listening socket..." << endl;
@@ -100,11 +196,23 @@ bool HttpServer::Run(void) {
   // Spin, accepting connections and dispatching them.  Use a
   // threadpool to dispatch connections into their own thread.
   cout << "  accepting connections..." << endl << endl;
+
+  // Block SIGHUP before creating any threads, so that they all inherit
+  // the mask and the signal is only ever picked up by the reloader.
+  sigset_t sighup;
+  sigemptyset(&sighup);
+  sigaddset(&sighup, SIGHUP);
+  Verify333(pthread_sigmask(SIG_BLOCK, &sighup, nullptr) == 0);
+  pthread_t reloader;
+  Verify333(pthread_create(&reloader, nullptr, &ReloadThread, this) == 0);
+  Verify333(pthread_detach(reloader) == 0);
+
   ThreadPool tp(kNumThreads);
   while (1) {
     HttpServerTask* hst = new HttpServerTask(HttpServer_ThrFn);
     hst->base_dir = static_file_dir_path_;
-    hst->indices = &indices_;
+    hst->server = this;
+    hst->query_cache = &query_cache_;
     if (!socket_.Accept(&hst->client_fd,
                     &hst->c_addr,
                     &hst->c_port,
@@ -116,11 +224,48 @@ bool HttpServer::Run(void) {
       break;
     }
     // The accept succeeded; dispatch it.
+    hst->accepted = Metrics::Now();
+    metrics_.Increment(Metrics::kTasksQueued);
     tp.Dispatch(hst);
   }
   return true;
 }
 
+bool HttpServer::Reload(string* const error) {
+  Verify333(pthread_mutex_lock(&reload_lock_) == 0);
+  shared_ptr<const IndexSet> index_set = IndexSet::Load(indices_, error);
+  if (index_set != nullptr) {
+    // Publish the new indices before moving the cache on to them.  A query
+    // notes the cache's generation before picking up the indices, so any
+    // query that caches its results under the new generation is sure to
+    // have computed them against the new indices.
+    std::atomic_store(&index_set_, index_set);
+    query_cache_.SetIndexFingerprint(index_set->fingerprint());
+  }
+  Verify333(pthread_mutex_unlock(&reload_lock_) == 0);
+  return index_set != nullptr;
+}
+
+void* HttpServer::ReloadThread(void* arg) {
+  HttpServer* server = static_cast<HttpServer*>(arg);
+  sigset_t sighup;
+  sigemptyset(&sighup);
+  sigaddset(&sighup, SIGHUP);
+  while (1) {
+    int sig;
+    if (sigwait(&sighup, &sig) != 0) {
+      continue;
+    }
+    string error;
+    if (server->Reload(&error)) {
+      cout << "  reloaded the indices on SIGHUP." << endl;
+    } else {
+      cerr << "  couldn't reload the indices on SIGHUP: " << error << endl;
+    }
+  }
+  return nullptr;
+}
+
 static void HttpServer_ThrFn(ThreadPool::Task* t) {
   // Cast back our HttpServerTask structure with all of our new
   // client's information in it.
@@ -142,42 +287,217 @@ static void HttpServer_ThrFn(ThreadPool::Task* t) {
   // STEP 1:
   // establish connection with client fd.
   HttpConnection htpc(hst->client_fd);
+  Metrics* metrics = hst->server->metrics();
+  metrics->Increment(Metrics::kConnectionsOpened);
+  metrics->Record(Metrics::kDispatch, Metrics::Now() - hst->accepted);
 
   // continuously process requests until "Connection: close" header or error.
+  // search API responses are generated into json_buffer (and compressed
+  // into compressed_buffer), which keep their memory from one request to
+  // the next.
   bool done = false;
+  string json_buffer, compressed_buffer;
+  json_buffer.reserve(2 * kSearchApiChunkBytes);
   while (!done) {
     // get next request.
     HttpRequest request;
-    if (!htpc.GetNextRequest(&request)) {
+    int64_t started;
+    if (!htpc.GetNextRequest(&request, &started)) {
       break;
     }
+    int64_t parsed = Metrics::Now();
+    metrics->Increment(Metrics::kRequests);
 
     // check if request specifies to close connection.
     if (request.GetHeaderValue("connection") == "close") {
       done = true;
     }
 
+    // pick the coding to send the response in.
+    ContentCoding coding =
+      NegotiateContentCoding(request.GetHeaderValue("accept-encoding"));
+
+    URLParser url;
+    url.Parse(request.uri());
+    bool measured = !IsExplainRequest(url);
+    if (measured) {
+      metrics->Record(Metrics::kParse, parsed - started);
+    }
+
+    // a search API request writes its response out itself, as it goes.
+    if (url.path() == "/api/search") {
+      bool written = ProcessSearchApiRequest(url, coding, &htpc, hst->server,
+                                             &json_buffer,
+                                             &compressed_buffer);
+      metrics->Record(Metrics::kRequest, Metrics::Now() - started);
+      if (!written) {
+        break;
+      }
+      continue;
+    }
+
     // process request and write response.
-    HttpResponse response = ProcessRequest(request, hst->base_dir,
-                                           *hst->indices);
+    HttpResponse response = ProcessRequest(request, hst->c_addr,
+                                           hst->base_dir, coding,
+                                           hst->server, hst->query_cache);
+    int64_t write_started = Metrics::Now();
     htpc.WriteResponse(response);
+    int64_t finished = Metrics::Now();
+    if (measured) {
+      metrics->Record(Metrics::kWrite, finished - write_started);
+      metrics->Record(Metrics::kRequest, finished - started);
+    }
   }
+  metrics->Increment(Metrics::kConnectionsClosed);
 }
 
 static HttpResponse ProcessRequest(const HttpRequest& req,
+                            const string& c_addr,
                             const string& base_dir,
-                            const list<string>& indices) {
+                            ContentCoding coding,
+                            HttpServer* server,
+                            QueryCache* query_cache) {
   // Is the user asking for a static file?
   if (req.uri().substr(0, 8) == "/static/") {
-    return ProcessFileRequest(req.uri(), base_dir);
+    return ProcessFileRequest(req.uri(), base_dir, coding, server);
+  }
+
+  // Is the user asking us to reload the indices?
+  URLParser p;
+  p.Parse(req.uri());
+  HttpResponse ret;
+  if (p.path() == "/admin/reload") {
+    ret = ProcessReloadRequest(c_addr, server);
+  } else if (p.path() == "/metrics") {
+    // Or for our metrics?
+    ret = ProcessMetricsRequest(server, query_cache);
+  } else {
+    // The user must be asking for a query.
+    ret = ProcessQueryRequest(req.uri(), server, query_cache);
+  }
+  CompressResponse(coding, !IsExplainRequest(p), server, &ret);
+  return ret;
+}
+
+static void CompressResponse(ContentCoding coding, bool measured,
+                             HttpServer* server,
+                             HttpResponse* const response) {
+  if (!IsCompressibleType(response->content_type())) {
+    return;
+  }
+
+  // The response depends on what the client accepts, whether or not it's
+  // compressed this time; caches need to know that.
+  response->AddHeader("Vary", "Accept-Encoding");
+  if (coding == kIdentity || server->compression_level() == 0 ||
+      response->body().size() < kMinCompressBytes) {
+    return;
+  }
+
+  Metrics* metrics = server->metrics();
+  int64_t compress_started = Metrics::Now();
+  string compressed;
+  CompressString(response->body(), coding, server->compression_level(),
+                 &compressed);
+  if (measured) {
+    metrics->Record(Metrics::kCompress, Metrics::Now() - compress_started);
+  }
+  metrics->Increment(Metrics::kBodyBytesCompressed, response->body().size());
+  metrics->Increment(Metrics::kBodyBytesSent, compressed.size());
+  response->AddHeader("Content-Encoding", ContentCodingName(coding));
+  response->set_body(std::move(compressed));
+}
+
+static HttpResponse ProcessMetricsRequest(HttpServer* server,
+                                   QueryCache* query_cache) {
+  string body = server->metrics()->Expose();
+
+  // Add in the statistics the query cache and the index readers keep.
+  uint64_t hits = query_cache->hits(), misses = query_cache->misses();
+  Metrics::AppendMetric("http333d_query_cache_hits_total", "counter",
+                        "Queries answered from the query cache.", hits,
+                        &body);
+  Metrics::AppendMetric("http333d_query_cache_misses_total", "counter",
+                        "Queries the query cache couldn't answer.", misses,
+                        &body);
+  Metrics::AppendMetric("http333d_query_cache_hit_ratio", "gauge",
+                        "Fraction of queries answered from the query cache.",
+                        hits + misses == 0 ? 0.0 :
+                        static_cast<double>(hits) / (hits + misses), &body);
+
+  hw3::IndexTableReader::BloomFilterStats bloom =
+    hw3::IndexTableReader::GetBloomFilterStats();
+  Metrics::AppendMetric("http333d_bloom_filter_lookups_total", "counter",
+                        "Words checked against an index's Bloom filter.",
+                        bloom.lookups, &body);
+  Metrics::AppendMetric("http333d_bloom_filter_skipped_total", "counter",
+                        "Words a Bloom filter ruled out of an index.",
+                        bloom.skipped, &body);
+  Metrics::AppendMetric("http333d_bloom_filter_false_positives_total",
+                        "counter",
+                        "Words a Bloom filter let through that weren't in"
+                        " the index.", bloom.false_positives, &body);
+  Metrics::AppendMetric("http333d_bloom_filter_skip_ratio", "gauge",
+                        "Fraction of words a Bloom filter ruled out.",
+                        bloom.lookups == 0 ? 0.0 :
+                        static_cast<double>(bloom.skipped) / bloom.lookups,
+                        &body);
+
+  CompressedFileCache* file_cache = server->compressed_file_cache();
+  Metrics::AppendMetric("http333d_compressed_file_cache_hits_total",
+                        "counter",
+                        "Static files served from the compressed file cache.",
+                        file_cache->hits(), &body);
+  Metrics::AppendMetric("http333d_compressed_file_cache_misses_total",
+                        "counter",
+                        "Static files compressed because they weren't in the"
+                        " compressed file cache.", file_cache->misses(),
+                        &body);
+  Metrics::AppendMetric("http333d_compressed_file_cache_bytes", "gauge",
+                        "Bytes of compressed files cached.",
+                        file_cache->bytes_used(), &body);
+
+  HttpResponse ret;
+  ret.set_protocol("HTTP/1.1");
+  ret.set_response_code(200);
+  ret.set_message("OK");
+  ret.set_content_type("text/plain; version=0.0.4");
+  ret.AppendToBody(body);
+  return ret;
+}
+
+static HttpResponse ProcessReloadRequest(const string& c_addr,
+                                  HttpServer* server) {
+  HttpResponse ret;
+  ret.set_protocol("HTTP/1.1");
+  ret.set_content_type("text/plain");
+  if (c_addr != "127.0.0.1" && c_addr != "::1" &&
+      c_addr != "::ffff:127.0.0.1") {
+    ret.set_response_code(403);
+    ret.set_message("Forbidden");
+    ret.AppendToBody("reloads are only accepted from localhost\n");
+    return ret;
   }
 
-  // The user must be asking for a query.
-  return ProcessQueryRequest(req.uri(), indices);
+  string error;
+  if (!server->Reload(&error)) {
+    cerr << "  couldn't reload the indices: " << error << endl;
+    ret.set_response_code(500);
+    ret.set_message("Internal Server Error");
+    ret.AppendToBody("reload failed: " + error + "\n");
+    return ret;
+  }
+  cout << "  reloaded the indices." << endl;
+  ret.set_response_code(200);
+  ret.set_message("OK");
+  ret.AppendToBody("reloaded\n");
+  return ret;
 }
 
 static HttpResponse ProcessFileRequest(const string& uri,
-                                const string& base_dir) {
+                                const string& base_dir,
+                                ContentCoding coding,
+                                HttpServer* server) {
   // The response we'll build up.
   HttpResponse ret;
 
@@ -212,27 +532,9 @@ static HttpResponse ProcessFileRequest(const string& uri,
   p.Parse(uri.substr(front.length()));
   file_name = p.path();
 
-  // initialize FileReader for base_dir and file_name, then read contents.
-  FileReader fr(base_dir, file_name);
-  string file_contents;
-  if (!fr.ReadFile(&file_contents) || !IsPathSafe(base_dir, base_dir + "/"
-      + file_name)) {
-    // handle file not found or outside directory with HTTP 404.
-    ret.set_protocol("HTTP/1.1");
-    ret.set_response_code(404);
-    ret.set_message("Not Found");
-    ret.AppendToBody("<html><body>Couldn't find file \"" + EscapeHtml(file_name)
-                     + "\"</body></html>\n");
-    return ret;
-  }
-
-  // append file_contents to response body.
-
-  // determine file suffix and set appropriate content type.
+  // determine file suffix and the content type that goes with it.
   size_t suffix_pos = file_name.find_last_of(".");
   string suffix = file_name.substr(suffix_pos + 1);
-
-  // set response details, including content type based on file suffix.
   map<string, string> file_types {
     {"html", "text/html"},
     {"htm", "text/html"},
@@ -245,10 +547,69 @@ static HttpResponse ProcessFileRequest(const string& uri,
     {"png", "image/png"},
     {"gif", "image/gif"}
   };
-
-  // set content type if suffix is defined in file_types.
+  string content_type;
   if (file_types.find(suffix) != file_types.end()) {
-    ret.set_content_type(file_types[suffix]);
+    content_type = file_types[suffix];
+  }
+
+  // a file worth compressing is looked for in the compressed file cache
+  // first, under the version of it that's on disk now; a hit doesn't even
+  // need to read the file.
+  string full_path = base_dir + "/" + file_name;
+  CompressedFileCache* file_cache = server->compressed_file_cache();
+  struct stat st;
+  bool compress = IsCompressibleType(content_type) &&
+                  coding != kIdentity && IsPathSafe(base_dir, full_path) &&
+                  stat(full_path.c_str(), &st) == 0 && S_ISREG(st.st_mode) &&
+                  static_cast<size_t>(st.st_size) >= kMinCompressBytes;
+  shared_ptr<const string> compressed;
+  if (compress) {
+    compressed = file_cache->Lookup(full_path, coding, st);
+  }
+
+  // otherwise, initialize FileReader for base_dir and file_name, then read
+  // contents.
+  string file_contents;
+  if (compressed == nullptr) {
+    FileReader fr(base_dir, file_name);
+    if (!fr.ReadFile(&file_contents) || !IsPathSafe(base_dir, full_path)) {
+      // handle file not found or outside directory with HTTP 404.
+      ret.set_protocol("HTTP/1.1");
+      ret.set_response_code(404);
+      ret.set_message("Not Found");
+      ret.AppendToBody("<html><body>Couldn't find file \"" +
+                       EscapeHtml(file_name) + "\"</body></html>\n");
+      return ret;
+    }
+    if (compress) {
+      Metrics* metrics = server->metrics();
+      int64_t compress_started = Metrics::Now();
+      std::shared_ptr<string> compressed_contents =
+        std::make_shared<string>();
+      CompressString(file_contents, coding, kStaticCompressionLevel,
+                     compressed_contents.get());
+      compressed = compressed_contents;
+      metrics->Record(Metrics::kCompress, Metrics::Now() - compress_started);
+      file_cache->Insert(full_path, coding, st, compressed);
+    }
+  }
+
+  // append the file's contents (or their compressed copy) to the response
+  // body, and set the content type.
+  if (compressed != nullptr) {
+    Metrics* metrics = server->metrics();
+    metrics->Increment(Metrics::kBodyBytesCompressed, st.st_size);
+    metrics->Increment(Metrics::kBodyBytesSent, compressed->size());
+    ret.AddHeader("Content-Encoding", ContentCodingName(coding));
+    ret.AppendToBody(*compressed);
+  } else {
+    ret.AppendToBody(file_contents);
+  }
+  if (!content_type.empty()) {
+    ret.set_content_type(content_type);
+  }
+  if (IsCompressibleType(content_type)) {
+    ret.AddHeader("Vary", "Accept-Encoding");
   }
   ret.set_protocol("HTTP/1.1");
   ret.set_response_code(200);
@@ -258,7 +619,8 @@ static HttpResponse ProcessFileRequest(const string& uri,
 }
 
 static HttpResponse ProcessQueryRequest(const string& uri,
-                                 const list<string>& indices) {
+                                 HttpServer* server,
+                                 QueryCache* query_cache) {
   // The response we're building up.
   HttpResponse ret;
 
@@ -290,32 +652,71 @@ static HttpResponse ProcessQueryRequest(const string& uri,
   URLParser p;
   p.Parse(uri);
 
-  // extract and sanitize search queries.
-  vector<string> queries;
+  // extract the search query, parsing (and lowercasing) the raw text;
+  // only the copy we echo back to the user is escaped.  "explain=1" asks
+  // for a breakdown of where the query's time went.
+  hw3::QueryNode query;
   string q_str;
+  bool explain = IsExplainRequest(p);
   for (const auto& arg : p.args()) {
     if (arg.first == "terms") {
       q_str = EscapeHtml(arg.second);
-      boost::split(queries, q_str, boost::is_any_of(" "),
-                   boost::token_compress_on);
-      break;
+      query = hw3::ParseQuery(arg.second);
     }
   }
 
   // handle empty queries by ending response.
-  if (queries.empty()) {
+  if (query.children.empty()) {
     EndHTMLReponse(&ret);
     return ret;
   }
 
-  // convert queries to lowercase for processing.
-  for (auto& query : queries) {
-    boost::to_lower(query);
+  // look for the results (and their rendered HTML) in the cache.  we
+  // remember the index generation before evaluating the query, so that
+  // a concurrent index change can't leave stale results in the cache.
+  // a query being explained is always evaluated, and left out of the
+  // latency metrics.
+  Metrics* metrics = server->metrics();
+  int64_t render_nanos = 0;
+  uint64_t generation = query_cache->generation();
+  string cache_key = query.ToString();
+  QueryCache::Entry entry;
+  hw3::QueryProcessor::QueryExplain query_explain;
+  if (explain || !query_cache->Lookup(cache_key, generation, &entry)) {
+    // process queries to find matching documents, holding on to the
+    // current indices until we're done even if they're reloaded.  they
+    // were validated when they were loaded, so don't do it again here.
+    int64_t lookup_started = Metrics::Now();
+    shared_ptr<const IndexSet> index_set = server->index_set();
+    hw3::QueryProcessor qp(index_set->paths(), false);
+    qp.set_index_names(index_set->names());
+    hw3::QueryProcessor::QueryTimings timings;
+    vector<string> truncated;
+    entry.results = qp.ProcessQuery(query, &timings,
+                                    explain ? &query_explain : nullptr,
+                                    &truncated);
+    int64_t render_started = Metrics::Now();
+    if (!explain) {
+      metrics->Record(Metrics::kLookup,
+                      render_started - lookup_started -
+                      timings.resolve_nanos);
+      metrics->Record(Metrics::kDocTable, timings.resolve_nanos);
+    }
+    // warn about wildcards that matched too many words to search for
+    // them all, so the results may be missing documents.
+    entry.html.clear();
+    for (const string& pattern : truncated) {
+      entry.html += "<p>Only the first " +
+        std::to_string(hw3::QueryProcessor::kMaxWildcardTerms) +
+        " words matching <b>" + EscapeHtml(pattern) +
+        "</b> were searched for.</p>";
+    }
+    entry.html += GetMatchListHTML(entry.results);
+    render_nanos = Metrics::Now() - render_started;
+    query_cache->Insert(cache_key, generation, entry);
   }
-
-  // process queries to find matching documents.
-  hw3::QueryProcessor qp(indices);
-  auto matches = qp.ProcessQuery(queries);
+  int64_t render_started = Metrics::Now();
+  const auto& matches = entry.results;
 
   // build results section header.
   string result_count = matches.empty() ? "No" : std::to_string(matches.size());
@@ -323,16 +724,237 @@ static HttpResponse ProcessQueryRequest(const string& uri,
                    + "</b></p><p> </p>");
 
   // append matched documents as HTML list items.
-  if (!matches.empty())  {
-    ret.AppendToBody("<ul>");
-    for (auto& match : matches) {
-      ret.AppendToBody(GetMatchHTML(match.document_name, match.rank));
-    }
-    ret.AppendToBody("</ul>");
+  ret.AppendToBody(entry.html);
+  if (explain) {
+    ret.AppendToBody("<pre>" + EscapeHtml(query_explain.ToString()) +
+                     "</pre>");
   }
 
   // finalize HTML response and return.
   EndHTMLReponse(&ret);
+  if (!explain) {
+    metrics->Record(Metrics::kRender,
+                    render_nanos + Metrics::Now() - render_started);
+  }
+  return ret;
+}
+
+static bool ProcessSearchApiRequest(const URLParser& url,
+                                    ContentCoding coding,
+                                    HttpConnection* const conn,
+                                    HttpServer* server,
+                                    string* const buffer,
+                                    string* const compressed) {
+  // "terms" is the query, in the same syntax as the search box; "offset"
+  // and "limit" pick the page of results to return; and "positions=1"
+  // asks for where in each document the query's words are.
+  string terms, error;
+  int offset = 0, limit = kSearchApiDefaultLimit;
+  bool positions = false;
+  for (const auto& arg : url.args()) {
+    if (arg.first == "terms") {
+      terms = arg.second;
+    } else if (arg.first == "offset") {
+      if (!ParseCount(arg.second, &offset)) {
+        error = "offset must be a non-negative integer";
+      }
+    } else if (arg.first == "limit") {
+      if (!ParseCount(arg.second, &limit)) {
+        error = "limit must be a non-negative integer";
+      }
+    } else if (arg.first == "positions") {
+      positions = arg.second == "1";
+    }
+  }
+  limit = std::min(limit, kSearchApiMaxLimit);
+  hw3::QueryNode query = hw3::ParseQuery(terms);
+  if (error.empty() && query.children.empty()) {
+    error = "terms must contain at least one word";
+  }
+
+  buffer->clear();
+  JsonWriter json(buffer);
+  HttpResponse ret;
+  ret.set_protocol("HTTP/1.1");
+  ret.set_content_type("application/json");
+  if (!error.empty()) {
+    ret.set_response_code(400);
+    ret.set_message("Bad Request");
+    json.BeginObject();
+    json.Key("error");
+    json.String(error);
+    json.EndObject();
+    ret.AppendToBody(*buffer);
+    return conn->WriteResponse(ret);
+  }
+
+  // find every match, but only look up the documents on the page asked
+  // for.  the indices were validated when they were loaded.
+  Metrics* metrics = server->metrics();
+  int64_t lookup_started = Metrics::Now();
+  shared_ptr<const IndexSet> index_set = server->index_set();
+  hw3::QueryProcessor qp(index_set->paths(), false);
+  vector<string> truncated;
+  vector<hw3::QueryProcessor::QueryMatch> matches =
+    qp.MatchQuery(query, &truncated);
+  metrics->Record(Metrics::kLookup, Metrics::Now() - lookup_started);
+
+  ret.set_response_code(200);
+  ret.set_message("OK");
+  ret.set_chunked(true);
+  ret.AddHeader("Vary", "Accept-Encoding");
+  std::unique_ptr<Compressor> compressor;
+  if (coding != kIdentity && server->compression_level() > 0) {
+    ret.AddHeader("Content-Encoding", ContentCodingName(coding));
+    compressor.reset(new Compressor(coding, server->compression_level()));
+  }
+  if (!conn->WriteResponse(ret)) {
+    return false;
+  }
+
+  // sends what's in the buffer as the next chunk, compressing it first if
+  // need be, and empties it.  "finish" ends the compressed stream.
+  auto send_buffer = [&](bool finish) {
+    const string* chunk = buffer;
+    if (compressor != nullptr) {
+      int64_t compress_started = Metrics::Now();
+      compressed->clear();
+      compressor->Compress(*buffer, finish, compressed);
+      metrics->Record(Metrics::kCompress,
+                      Metrics::Now() - compress_started);
+      metrics->Increment(Metrics::kBodyBytesCompressed, buffer->size());
+      metrics->Increment(Metrics::kBodyBytesSent, compressed->size());
+      chunk = compressed;
+    }
+    bool written = chunk->empty() || conn->WriteChunk(*chunk);
+    buffer->clear();
+    return written;
+  };
+
+  vector<string> words;
+  if (positions) {
+    CollectQueryWords(query, &words);
+  }
+  json.BeginObject();
+  json.Key("query");
+  json.String(terms);
+  json.Key("total");
+  json.Int(matches.size());
+  json.Key("offset");
+  json.Int(offset);
+  json.Key("limit");
+  json.Int(limit);
+  json.Key("truncated_wildcards");
+  json.BeginArray();
+  for (const string& pattern : truncated) {
+    json.String(pattern);
+  }
+  json.EndArray();
+  json.Key("results");
+  json.BeginArray();
+
+  // send each chunk as soon as it fills up, so the client can start on
+  // the first results while we look up the rest.
+  int64_t resolve_nanos = 0;
+  size_t end = std::min(matches.size(), static_cast<size_t>(offset) + limit);
+  vector<DocPositionOffset_t> word_positions;
+  for (size_t i = offset; i < end; i++) {
+    const hw3::QueryProcessor::QueryMatch& match = matches[i];
+    int64_t resolve_started = Metrics::Now();
+    json.BeginObject();
+    json.Key("document");
+    json.String(qp.LookupDocName(match));
+    json.Key("score");
+    if (qp.ranking_mode() == hw3::QueryProcessor::kRankByBM25) {
+      json.Double(match.score, 7);
+    } else {
+      json.Int(match.rank);
+    }
+    if (positions) {
+      json.Key("positions");
+      json.BeginObject();
+      for (const string& word : words) {
+        if (qp.LookupPositions(match, word, &word_positions)) {
+          json.Key(word);
+          json.BeginArray();
+          for (DocPositionOffset_t position : word_positions) {
+            json.Int(position);
+          }
+          json.EndArray();
+        }
+      }
+      json.EndObject();
+    }
+    json.EndObject();
+    resolve_nanos += Metrics::Now() - resolve_started;
+
+    if (buffer->size() >= kSearchApiChunkBytes && !send_buffer(false)) {
+      return false;
+    }
+  }
+  json.EndArray();
+  json.EndObject();
+  metrics->Record(Metrics::kDocTable, resolve_nanos);
+  return send_buffer(true) && conn->WriteChunk("");
+}
+
+static void CollectQueryWords(const hw3::QueryNode& query,
+                              vector<string>* const words) {
+  switch (query.kind) {
+    case hw3::QueryNode::kTerm:
+    case hw3::QueryNode::kPhrase:
+    case hw3::QueryNode::kNear:
+      for (const string& word : query.words) {
+        if (std::find(words->begin(), words->end(), word) == words->end()) {
+          words->push_back(word);
+        }
+      }
+      return;
+
+    case hw3::QueryNode::kAnd:
+    case hw3::QueryNode::kOr:
+      for (const hw3::QueryNode& child : query.children) {
+        CollectQueryWords(child, words);
+      }
+      return;
+
+    case hw3::QueryNode::kWildcard:
+    case hw3::QueryNode::kNot:
+      return;
+  }
+}
+
+static bool ParseCount(const string& str, int* const count) {
+  if (str.empty() || !isdigit(static_cast<unsigned char>(str[0]))) {
+    return false;
+  }
+  char* end;
+  errno = 0;
+  long value = strtol(str.c_str(), &end, 10);  // NOLINT(runtime/int)
+  if (*end != '\0' || errno != 0 || value > INT_MAX) {
+    return false;
+  }
+  *count = static_cast<int>(value);
+  return true;
+}
+
+static bool IsExplainRequest(const URLParser& url) {
+  std::map<string, string> args = url.args();
+  auto it = args.find("explain");
+  return it != args.end() && it->second == "1";
+}
+
+// generate the HTML list of matched documents.
+static string GetMatchListHTML(
+    const vector<hw3::QueryProcessor::QueryResult>& matches) {
+  if (matches.empty()) {
+    return "";
+  }
+  string ret = "<ul>";
+  for (auto& match : matches) {
+    ret.append(GetMatchHTML(match.document_name, match.rank));
+  }
+  ret.append("</ul>");
   return ret;
 }
 
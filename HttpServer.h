@@ -12,10 +12,21 @@
 #ifndef HW4_HTTPSERVER_H_
 #define HW4_HTTPSERVER_H_
 
+extern "C" {
+#include <pthread.h>  // for pthread_mutex_t, pthread_t
+}
+
 #include <stdint.h>
 #include <string>
+#include <atomic>
 #include <list>
+#include <memory>
 
+#include "./CompressedFileCache.h"
+#include "./HttpCompression.h"
+#include "./IndexSet.h"
+#include "./Metrics.h"
+#include "./QueryCache.h"
 #include "./ThreadPool.h"
 #include "./ServerSocket.h"
 
@@ -26,17 +37,25 @@ class HttpServer {
  public:
   // Creates a new HttpServer object for port "port" and serving
   // files out of path "static_file_dir_path".  The indices for
-  // query processing are located in the "indices" list. The constructor
-  // does not do anything except memorize these variables.
+  // query processing are located in the "indices" list.  Dynamic
+  // responses are compressed at "compression_level", from 1 to 9, for
+  // clients that accept it; 0 sends them uncompressed.  (Static files are
+  // always compressed at the highest level, once, and cached.)  The
+  // constructor does not do anything except memorize these variables.
   explicit HttpServer(uint16_t port,
                       const std::string& static_file_dir_path,
-                      const std::list<std::string>& indices)
+                      const std::list<std::string>& indices,
+                      int compression_level = kDefaultCompressionLevel)
     : socket_(port), static_file_dir_path_(static_file_dir_path),
-      indices_(indices) { }
+      indices_(indices), compression_level_(compression_level),
+      query_cache_(kQueryCacheBytes, kQueryCacheShards),
+      compressed_file_cache_(kCompressedFileCacheBytes) {
+    pthread_mutex_init(&reload_lock_, nullptr);
+  }
 
   // The destructor closes the listening socket if it is open and
   // also terminates any threads in the threadpool.
-  virtual ~HttpServer() { }
+  virtual ~HttpServer() { pthread_mutex_destroy(&reload_lock_); }
 
   // Creates a listening socket for the server and launches it, accepting
   // connections and dispatching them to worker threads.
@@ -45,13 +64,63 @@ class HttpServer {
   //
   // The server continues to run until a kill command is used to send
   // a SIGTERM signal to the server process (i.e., kill pid, ctrl+C).
+  //
+  // While it runs, sending the server a SIGHUP reloads its indices; see
+  // Reload().
   bool Run();
 
+  // Reopens and revalidates the index files named at construction, which
+  // may since have been rebuilt, and swaps them in for the current ones.
+  // Queries that are already running finish against the old files; the
+  // swap itself never makes a query wait.  If any of the files is
+  // missing or invalid, the current indices stay in service and false is
+  // returned, with *error saying why.
+  bool Reload(std::string* const error);
+
+  // Returns the current generation of indices, for a query to hold on to
+  // while it runs.
+  std::shared_ptr<const IndexSet> index_set() const {
+    return std::atomic_load(&index_set_);
+  }
+
+  // Returns the server's latency histograms and counters, served from
+  // /metrics.
+  Metrics* metrics() { return &metrics_; }
+
+  // Returns the level dynamic responses are compressed at, or 0 if they
+  // aren't.
+  int compression_level() const { return compression_level_; }
+
+  // Returns the cache of compressed static files.
+  CompressedFileCache* compressed_file_cache() {
+    return &compressed_file_cache_;
+  }
+
  private:
+  // The body of the thread that calls Reload() whenever the server gets a
+  // SIGHUP; "arg" is the HttpServer.
+  static void* ReloadThread(void* arg);
+
   ServerSocket socket_;
   std::string static_file_dir_path_;
   std::list<std::string> indices_;
+  int compression_level_;
+  QueryCache query_cache_;
+  CompressedFileCache compressed_file_cache_;
+  Metrics metrics_;
+
+  // The current generation of indices.  It's only ever accessed with
+  // std::atomic_load() and std::atomic_store(), so queries can pick it up
+  // while Reload() replaces it.
+  std::shared_ptr<const IndexSet> index_set_;
+
+  // Serializes Reload()s.
+  pthread_mutex_t reload_lock_;
+
   static const int kNumThreads;
+  static const size_t kQueryCacheBytes;
+  static const int kQueryCacheShards;
+  static const size_t kCompressedFileCacheBytes;
 };
 
 class HttpServerTask : public ThreadPool::Task {
@@ -63,7 +132,9 @@ class HttpServerTask : public ThreadPool::Task {
   uint16_t c_port;
   std::string c_addr, c_dns, s_addr, s_dns;
   std::string base_dir;
-  std::list<std::string>* indices;
+  HttpServer* server;
+  QueryCache* query_cache;
+  int64_t accepted;  // when the connection was accepted.
 };
 
 }  // namespace hw4
@@ -0,0 +1,67 @@
+/*
+ * Copyright ©2024 Hannah C. Tang.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Washington
+ * CSE 333 for use solely during Spring Quarter 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#include "./IndexSet.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cstring>
+#include <list>
+#include <memory>
+#include <string>
+
+#include "./QueryCache.h"
+#include "./libhw3/FileIndexReader.h"
+
+using std::list;
+using std::shared_ptr;
+using std::string;
+
+namespace hw4 {
+
+std::shared_ptr<const IndexSet> IndexSet::Load(const list<string>& indices,
+                                               string* const error) {
+  // Fingerprint the files by name both before and after opening them.  If
+  // the two agree, the files we opened are the ones fingerprinted.
+  shared_ptr<IndexSet> set(new IndexSet());
+  set->fingerprint_ = QueryCache::ComputeIndexFingerprint(indices);
+  for (const string& index : indices) {
+    int fd = open(index.c_str(), O_RDONLY);
+    if (fd == -1) {
+      *error = index + ": " + strerror(errno);
+      return nullptr;
+    }
+    set->fds_.push_back(fd);
+    if (!hw3::FileIndexReader::IsValid(fd)) {
+      *error = index + ": not a valid index file";
+      return nullptr;
+    }
+
+    // Opening /proc/self/fd/N opens the file that descriptor N refers to,
+    // with its own file offset, whatever has happened to its name since.
+    set->paths_.push_back("/proc/self/fd/" + std::to_string(fd));
+    set->names_.push_back(index);
+  }
+  if (QueryCache::ComputeIndexFingerprint(indices) != set->fingerprint_) {
+    *error = "an index file changed while it was being loaded";
+    return nullptr;
+  }
+  return set;
+}
+
+IndexSet::~IndexSet() {
+  for (int fd : fds_) {
+    close(fd);
+  }
+}
+
+}  // namespace hw4
@@ -0,0 +1,71 @@
+/*
+ * Copyright ©2024 Hannah C. Tang.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Washington
+ * CSE 333 for use solely during Spring Quarter 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#ifndef HW4_INDEXSET_H_
+#define HW4_INDEXSET_H_
+
+#include <stdint.h>  // for uint64_t, etc.
+#include <list>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace hw4 {
+
+// An IndexSet is one generation of the index files an HttpServer
+// searches.  Loading a set opens and validates every file up front; from
+// then on, the set holds the files open, so that they stay exactly as
+// they were validated for as long as the set is in use, even if the files
+// are replaced (e.g., by rename()ing a rebuilt index over them).
+//
+// Sets are immutable and handed around by std::shared_ptr: to reload its
+// indices, the server loads a new set alongside the old one and swaps
+// the pointer.  Queries already running hold on to the old set and
+// finish against it, and the old set closes its files when the last of
+// them is done.
+class IndexSet {
+ public:
+  // Opens and validates each of the index files in "indices".  Returns
+  // the new set, or nullptr if any of the files can't be opened or isn't
+  // a valid index file, in which case *error says which and why.
+  static std::shared_ptr<const IndexSet> Load(
+      const std::list<std::string>& indices, std::string* const error);
+
+  ~IndexSet();
+
+  // Returns the paths a query should open the indices through, in the
+  // same order as the files passed to Load().  They refer to the files
+  // the set holds open, not to whatever files now have their names.  The
+  // files have already been validated, so there's no need for the
+  // query's hw3::QueryProcessor to validate them again.
+  const std::list<std::string>& paths() const { return paths_; }
+
+  // Returns the names the index files were loaded under, in the same
+  // order as paths(), for telling the files apart in query explanations
+  // (see hw3::QueryProcessor::set_index_names()).
+  const std::list<std::string>& names() const { return names_; }
+
+  // Returns the fingerprint of the files the set holds open, by the names
+  // they were loaded under (see QueryCache::ComputeIndexFingerprint()).
+  uint64_t fingerprint() const { return fingerprint_; }
+
+ private:
+  IndexSet() : fingerprint_(0) { }
+
+  std::vector<int>        fds_;
+  std::list<std::string>  paths_;
+  std::list<std::string>  names_;
+  uint64_t                fingerprint_;
+};
+
+}  // namespace hw4
+
+#endif  // HW4_INDEXSET_H_
@@ -12,13 +12,15 @@
 #include "./IndexTableReader.h"
 
 #include <stdint.h>     // for uint32_t, etc.
+#include <atomic>       // for std::atomic.
+#include <cstring>      // for memcmp().
 #include <string>       // for std::string.
 #include <sstream>      // for std::stringstream.
 
 #include "./LayoutStructs.h"
 
 extern "C" {
-  #include "libhw1/HashTable.h"  // for libhw1/hashtable.h's FNVHash64().
+  #include "libhw1/HashTable.h"  // for HashWithID().
   #include "libhw1/CSE333.h"
 }
 #include "./Utils.h"   // for FileDup().
@@ -28,21 +30,70 @@ using std::stringstream;
 
 namespace hw3 {
 
+// The counters behind GetBloomFilterStats().
+static std::atomic<uint64_t> bloom_lookups(0);
+static std::atomic<uint64_t> bloom_skipped(0);
+static std::atomic<uint64_t> bloom_false_positives(0);
+
 // The constructor for IndexTableReader calls the constructor of
 // HashTableReader(), its superclass. The superclass takes care of
 // taking ownership of f and using it to extract and cache the number
 // of buckets within the table.
-IndexTableReader::IndexTableReader(FILE* f, IndexFileOffset_t offset)
-  : HashTableReader(f, offset) { }
+IndexTableReader::IndexTableReader(FILE* f, IndexFileOffset_t offset,
+                                   HTHashID_t hash_id, IndexFormat format,
+                                   std::shared_ptr<const MappedFile> mapping,
+                                   std::shared_ptr<const BloomFilter>
+                                     bloom_filter)
+  : HashTableReader(f, offset, format, mapping), hash_id_(hash_id),
+    bloom_filter_(bloom_filter) { }
+
+// Reads the header of the element at byte offset "offset" in "f", laid out
+// as in the format "Offsets", returning the word's length and leaving "f"
+// positioned at the word.  Sets *header_bytes to the size of the header.
+template <typename Offsets>
+static int16_t ReadWordBytes(FILE* f, IndexFileOffset_t offset,
+                             int* header_bytes) {
+  typename Offsets::WordHeader header;
+  Verify333(fseek(f, offset, SEEK_SET) == 0);
+  Verify333(fread(&header, sizeof(header), 1, f) == 1);
+  header.ToHostFormat();
+  *header_bytes = sizeof(header);
+  return header.word_bytes;
+}
 
 DocIDTableReader* IndexTableReader::LookupWord(const string& word) const {
-  // Calculate the FNVHash64 of the word.  Use word.c_str() to get a
-  // C-style (char*) to pass to FNVHash64, and word.lengt() to figure
-  // out how many characters are in the string.
+  // Hash the word with the same function the index was written with.  Use
+  // word.c_str() to get a C-style (char*) to pass to HashWithID, and
+  // word.length() to figure out how many characters are in the string.
   char* word_c_str = const_cast<char*>(word.c_str());
-  HTKey_t word_hash = FNVHash64(reinterpret_cast<unsigned char*>(word_c_str),
-                                word.length());
+  HTKey_t word_hash =
+    HashWithID(hash_id_, reinterpret_cast<unsigned char*>(word_c_str),
+               word.length());
+
+  // Most words aren't in most indices; the filter usually knows that
+  // without our having to read anything.
+  if (bloom_filter_ != nullptr) {
+    bloom_lookups.fetch_add(1, std::memory_order_relaxed);
+    if (!bloom_filter_->MayContain(word_hash)) {
+      bloom_skipped.fetch_add(1, std::memory_order_relaxed);
+      return nullptr;
+    }
+  }
+
+  DocIDTableReader* ditr = LookupWordWithHash(word, word_hash);
+  if (ditr == nullptr && bloom_filter_ != nullptr) {
+    bloom_false_positives.fetch_add(1, std::memory_order_relaxed);
+  }
+  return ditr;
+}
 
+IndexTableReader::BloomFilterStats IndexTableReader::GetBloomFilterStats() {
+  return {bloom_lookups.load(), bloom_skipped.load(),
+          bloom_false_positives.load()};
+}
+
+DocIDTableReader* IndexTableReader::LookupWordWithHash(
+    const string& word, HTKey_t word_hash) const {
   // Get back the list of "element" offsets for this word hash.
   auto elements = LookupElementPositions(word_hash);
 
@@ -51,20 +102,40 @@ DocIDTableReader* IndexTableReader::LookupWord(const string& word) const {
     return nullptr;
   }
 
+  // In a mapped file, compare the words where they are.  The docID table
+  // starts at the next aligned offset after the word.
+  if (format_ == kIndexFormatNative) {
+    for (IndexFileOffset_t offset : elements) {
+      const WordPostingsHeaderNative* header =
+        MappedRecords<WordPostingsHeaderNative>(offset);
+      if (header->word_bytes != static_cast<signed>(word.length()) ||
+          memcmp(MappedRecords<char>(offset + sizeof(*header),
+                                     header->word_bytes),
+                 word.data(), word.length()) != 0) {
+        continue;
+      }
+      IndexFileOffset_t docID_table_offset = offset +
+        AlignedBytes<OffsetsNative>(sizeof(*header) + header->word_bytes);
+      return new DocIDTableReader(FileDup(file_), docID_table_offset,
+                                  format_, mapping_);
+    }
+    return nullptr;
+  }
+
   // Iterate through the elements.
   for (IndexFileOffset_t& offset : elements) {
     // STEP 1.
     // Slurp the header information out of the "element" field;
-    // specifically, extract the "word length" field and the "docID
-    // table length" fields, converting from network to host order.
-    WordPostingsHeader header;
-    Verify333(fseek(file_, offset, SEEK_SET) == 0);
-    Verify333(fread(&header, sizeof(header), 1, file_) == 1);
-    header.ToHostFormat();
+    // specifically, extract the "word length" field, converting from
+    // network to host order.
+    int header_bytes;
+    int16_t word_bytes = format_ == kIndexFormat64 ?
+      ReadWordBytes<Offsets64>(file_, offset, &header_bytes) :
+      ReadWordBytes<Offsets32>(file_, offset, &header_bytes);
 
     // If the "word length" field doesn't match the length of the word
     // we're looking up, use continue to skip to the next element.
-    if (header.word_bytes != static_cast<signed>(word.length())) {
+    if (word_bytes != static_cast<signed>(word.length())) {
       continue;
     }
 
@@ -72,7 +143,7 @@ DocIDTableReader* IndexTableReader::LookupWord(const string& word) const {
     // the "<<" operator to feed a std::stringstream characters read
     // using fread().
     stringstream ss;
-    for (int i = 0; i < header.word_bytes; i++) {
+    for (int i = 0; i < word_bytes; i++) {
       // STEP 2.
       uint8_t next_char;
       Verify333(fread(&next_char, 1, 1, file_) == 1);
@@ -91,9 +162,9 @@ DocIDTableReader* IndexTableReader::LookupWord(const string& word) const {
       //
       // return the new'd (DocIDTableReader*) to the caller.
       IndexFileOffset_t docID_table_offset =
-          offset + sizeof(WordPostingsHeader) + header.word_bytes;
+          offset + header_bytes + word_bytes;
       DocIDTableReader* ditr =
-          new DocIDTableReader(FileDup(file_), docID_table_offset);
+          new DocIDTableReader(FileDup(file_), docID_table_offset, format_);
 
       return ditr;
     }
@@ -101,4 +172,35 @@ DocIDTableReader* IndexTableReader::LookupWord(const string& word) const {
   return nullptr;
 }
 
+DocIDTableReader* IndexTableReader::LookupElement(
+    IndexFileOffset_t element) const {
+  // The docID table follows the word, at the next aligned offset in a
+  // mapped file.
+  if (format_ == kIndexFormatNative) {
+    const WordPostingsHeaderNative* header =
+      MappedRecords<WordPostingsHeaderNative>(element);
+    IndexFileOffset_t docID_table_offset = element +
+      AlignedBytes<OffsetsNative>(sizeof(*header) + header->word_bytes);
+    return new DocIDTableReader(FileDup(file_), docID_table_offset,
+                                format_, mapping_);
+  }
+
+  int header_bytes;
+  int16_t word_bytes = format_ == kIndexFormat64 ?
+    ReadWordBytes<Offsets64>(file_, element, &header_bytes) :
+    ReadWordBytes<Offsets32>(file_, element, &header_bytes);
+  return new DocIDTableReader(FileDup(file_),
+                              element + header_bytes + word_bytes, format_);
+}
+
+int IndexTableReader::LookupDocumentFrequency(const string& word) const {
+  DocIDTableReader* ditr = LookupWord(word);
+  if (ditr == nullptr) {
+    return 0;
+  }
+  int doc_freq = ditr->NumDocIDs();
+  delete ditr;
+  return doc_freq;
+}
+
 }  // namespace hw3
@@ -12,9 +12,12 @@
 #ifndef HW3_INDEXTABLEREADER_H_
 #define HW3_INDEXTABLEREADER_H_
 
+#include <stdint.h>  // for uint64_t.
 #include <cstdio>    // for (FILE*)
+#include <memory>    // for std::shared_ptr.
 #include <string>    // for std::string.
 
+#include "./BloomFilter.h"
 #include "./HashTableReader.h"
 #include "./DocIDTableReader.h"
 
@@ -31,12 +34,27 @@ class IndexTableReader : protected HashTableReader {
   //   on destruction.
   //
   // - offset: the file offset of the first byte of the doctable
-  IndexTableReader(FILE* f, IndexFileOffset_t offset);
+  //
+  // - hash_id: the hash function the index's words were keyed with (see
+  //   FileIndexReader::hash_id()).
+  //
+  // - format: the index file's format (see FileIndexReader::format()).
+  //
+  // - mapping: the file's mapping, for kIndexFormatNative.
+  //
+  // - bloom_filter: the index's Bloom filter, if it has one (see
+  //   FileIndexReader::bloom_filter()).
+  IndexTableReader(FILE* f, IndexFileOffset_t offset,
+                   HTHashID_t hash_id = HT_HASH_FNV1A64,
+                   IndexFormat format = kIndexFormat32,
+                   std::shared_ptr<const MappedFile> mapping = nullptr,
+                   std::shared_ptr<const BloomFilter> bloom_filter = nullptr);
 
   ~IndexTableReader() { }
 
   // Lookup a word and get back a DocIDTableReader containing the
-  // docID-->positions mapping associated with the docID.
+  // docID-->positions mapping associated with the docID.  If the index has
+  // a Bloom filter, words it rules out aren't looked for in the table.
   //
   // Arguments:
   // - word: the word to look for
@@ -48,12 +66,40 @@ class IndexTableReader : protected HashTableReader {
   // - `nullptr` if the word is not found.
   DocIDTableReader* LookupWord(const std::string& word) const;
 
+  // Like LookupWord(), but for the word whose element is at byte offset
+  // "element", as found in the index's term dictionary (see
+  // TermDictReader), which saves hashing the word and searching its
+  // bucket.  The caller takes ownership of the returned pointer.
+  DocIDTableReader* LookupElement(IndexFileOffset_t element) const;
+
+  // Returns the number of documents containing "word", or 0 if the word
+  // isn't in the index.
+  int LookupDocumentFrequency(const std::string& word) const;
+
+  // Counters describing how LookupWord() has fared against the indices'
+  // Bloom filters, across every IndexTableReader in the process.  Only
+  // lookups in indices with a filter are counted.
+  struct BloomFilterStats {
+    uint64_t lookups;          // words looked up.
+    uint64_t skipped;          // words the filter ruled out.
+    uint64_t false_positives;  // words the filter let through in vain.
+  };
+  static BloomFilterStats GetBloomFilterStats();
+
  private:
   // This is here so that the Test_IndexTableReader unit test fixture can
   // access protected member variables of IndexTableReader.  See
   // test_indextablereader.h for details.
   friend class Test_IndexTableReader;
 
+  // LookupWord(), once the word has been hashed and has gotten past the
+  // Bloom filter.
+  DocIDTableReader* LookupWordWithHash(const std::string& word,
+                                       HTKey_t word_hash) const;
+
+  HTHashID_t hash_id_;
+  std::shared_ptr<const BloomFilter> bloom_filter_;
+
   DISALLOW_COPY_AND_ASSIGN(IndexTableReader);
 };
 
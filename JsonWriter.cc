@@ -0,0 +1,121 @@
+/*
+ * Copyright ©2024 Hannah C. Tang.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Washington
+ * CSE 333 for use solely during Spring Quarter 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <cmath>
+#include <string>
+
+#include "./JsonWriter.h"
+
+using std::string;
+
+namespace hw4 {
+
+void JsonWriter::BeginObject() {
+  BeginValue();
+  out_->push_back('{');
+  need_comma_ = false;
+}
+
+void JsonWriter::EndObject() {
+  out_->push_back('}');
+  need_comma_ = true;
+}
+
+void JsonWriter::BeginArray() {
+  BeginValue();
+  out_->push_back('[');
+  need_comma_ = false;
+}
+
+void JsonWriter::EndArray() {
+  out_->push_back(']');
+  need_comma_ = true;
+}
+
+void JsonWriter::Key(const string& key) {
+  BeginValue();
+  AppendString(key, out_);
+  out_->push_back(':');
+  need_comma_ = false;
+}
+
+void JsonWriter::String(const string& value) {
+  BeginValue();
+  AppendString(value, out_);
+  need_comma_ = true;
+}
+
+void JsonWriter::Int(int64_t value) {
+  BeginValue();
+  char buf[24];
+  int len = snprintf(buf, sizeof(buf), "%" PRId64, value);
+  out_->append(buf, len);
+  need_comma_ = true;
+}
+
+void JsonWriter::Bool(bool value) {
+  BeginValue();
+  out_->append(value ? "true" : "false");
+  need_comma_ = true;
+}
+
+void JsonWriter::Null() {
+  BeginValue();
+  out_->append("null");
+  need_comma_ = true;
+}
+
+void JsonWriter::Double(double value, int digits) {
+  if (!std::isfinite(value)) {
+    Null();
+    return;
+  }
+  BeginValue();
+  char buf[32];
+  int len = snprintf(buf, sizeof(buf), "%.*g", digits, value);
+  out_->append(buf, len);
+  need_comma_ = true;
+}
+
+void JsonWriter::AppendString(const string& value, string* out) {
+  static const char kHexDigits[] = "0123456789abcdef";
+  out->push_back('"');
+  for (char c : value) {
+    switch (c) {
+      case '"':  out->append("\\\""); break;
+      case '\\': out->append("\\\\"); break;
+      case '\b': out->append("\\b"); break;
+      case '\f': out->append("\\f"); break;
+      case '\n': out->append("\\n"); break;
+      case '\r': out->append("\\r"); break;
+      case '\t': out->append("\\t"); break;
+      default:
+        if (static_cast<unsigned char>(c) < 0x20) {
+          out->append("\\u00");
+          out->push_back(kHexDigits[c >> 4]);
+          out->push_back(kHexDigits[c & 0xf]);
+        } else {
+          out->push_back(c);
+        }
+    }
+  }
+  out->push_back('"');
+}
+
+void JsonWriter::BeginValue() {
+  if (need_comma_) {
+    out_->push_back(',');
+  }
+}
+
+}  // namespace hw4
@@ -0,0 +1,77 @@
+/*
+ * Copyright ©2024 Hannah C. Tang.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Washington
+ * CSE 333 for use solely during Spring Quarter 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#ifndef HW4_JSONWRITER_H_
+#define HW4_JSONWRITER_H_
+
+#include <stdint.h>  // for int64_t
+#include <string>
+
+namespace hw4 {
+
+// A JsonWriter appends JSON text to a caller-owned string as values are
+// handed to it, so a large document can be written out in pieces: the
+// caller can send what's in the string so far and clear() it at any
+// point, and keeps reusing the string's buffer rather than building the
+// whole document up in memory.
+//
+// A writer writes a single document.  It only takes care of commas and
+// escaping; it's up to the caller to nest Begin/End calls properly and to
+// put a Key() before each value in an object.  For example,
+//
+//   w.BeginObject(); w.Key("hits"); w.BeginArray(); w.Int(1); w.Int(2);
+//   w.EndArray(); w.EndObject();
+//
+// appends {"hits":[1,2]}.
+class JsonWriter {
+ public:
+  explicit JsonWriter(std::string* out) : out_(out), need_comma_(false) { }
+
+  void BeginObject();
+  void EndObject();
+  void BeginArray();
+  void EndArray();
+
+  // Writes the name of the next member of an object.
+  void Key(const std::string& key);
+
+  void String(const std::string& value);
+  void Int(int64_t value);
+  void Bool(bool value);
+  void Null();
+
+  // Writes "value" with up to "digits" significant digits; 17 is enough
+  // to read back any double exactly.  JSON has no infinities or NaNs, so
+  // they're written as null.
+  void Double(double value, int digits = 17);
+
+  // Appends "value" to "out" as a quoted JSON string, escaping quotes,
+  // backslashes and control characters.  Other bytes are copied as they
+  // are, so UTF-8 text stays UTF-8.
+  static void AppendString(const std::string& value, std::string* out);
+
+  JsonWriter(const JsonWriter&) = delete;
+  JsonWriter& operator=(const JsonWriter&) = delete;
+
+ private:
+  // Writes the comma separating a value from the one before it, if any.
+  void BeginValue();
+
+  std::string* out_;
+
+  // Whether a value has been written at the current level of nesting,
+  // so the next one needs a comma in front of it.
+  bool need_comma_;
+};
+
+}  // namespace hw4
+
+#endif  // HW4_JSONWRITER_H_
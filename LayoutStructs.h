@@ -14,6 +14,7 @@
 
 #include <stdint.h>
 #include <cstddef>
+#include <cstring>
 
 extern "C" {
   #include "./libhw1/CSE333.h"
@@ -26,6 +27,19 @@ extern "C" {
 // transformations; they can be written and read directly from disk.  For
 // that reason, the field ordering and each field's types must correspond
 // exactly to the file format described in the HW3 spec.
+//
+// Files in kIndexFormat64 (see Utils.h) are laid out exactly like those in
+// the original format, except that the records holding byte offsets or
+// sizes have 64-bit versions: IndexFileHeader64, BucketRecord64,
+// ElementPositionRecord64, and WordPostingsHeader64.  Per-table counts and
+// the trailing SectionHeaders stay 32-bit in both.
+//
+// Files in kIndexFormatNative are laid out like those in kIndexFormat64,
+// but with the naturally-aligned, host-order records at the bottom of this
+// file instead, so that they can be used in place.
+//
+// Offsets32, Offsets64 and OffsetsNative, at the very bottom of this file,
+// name the set of records each format uses.
 
 
 // C/C++ will add padding to structures to place the individual
@@ -41,8 +55,9 @@ namespace hw3 {
 // General types for encoded data on disk
 //---------------------------------------------
 
-// An offset within an index file.
-typedef int32_t IndexFileOffset_t;
+// An offset within an index file.  Files in the original format store
+// offsets as 32-bit quantities, so they must be smaller than 2GB.
+typedef int64_t IndexFileOffset_t;
 
 
 //---------------------------------------------
@@ -82,14 +97,103 @@ struct IndexFileHeader {
   }
 };
 
+struct IndexFileHeader64 {
+  uint32_t  magic_number;    // the indicator of a well-formed header.
+  uint32_t  checksum;        // the checksum for the entire file.
+  int64_t   doctable_bytes;  // number of bytes in the contained doctable.
+  int64_t   index_bytes;     // number of bytes in the contained index.
+
+  IndexFileHeader64() { }  // this constructor yields uninitialized fields!
+
+  IndexFileHeader64(uint32_t magic_number_arg,
+                    uint32_t checksum_arg,
+                    int64_t doctable_bytes_arg,
+                    int64_t index_bytes_arg)
+    : magic_number(magic_number_arg),
+      checksum(checksum_arg),
+      doctable_bytes(doctable_bytes_arg),
+      index_bytes(index_bytes_arg) {
+  }
+
+  // Widens an original-format header.
+  explicit IndexFileHeader64(const IndexFileHeader& header)
+    : IndexFileHeader64(header.magic_number, header.checksum,
+                        header.doctable_bytes, header.index_bytes) {
+  }
+
+  void ToDiskFormat() {
+    magic_number = htonl(magic_number);
+    checksum = htonl(checksum);
+    doctable_bytes = htonll(doctable_bytes);
+    index_bytes = htonll(index_bytes);
+  }
+
+  void ToHostFormat() {
+    magic_number = ntohl(magic_number);
+    checksum = ntohl(checksum);
+    doctable_bytes = ntohll(doctable_bytes);
+    index_bytes = ntohll(index_bytes);
+  }
+};
+
 // Offset of magic number within an IndexFileHeader struct, and also within
-// the file itself.
+// the file itself.  It's the same in both formats, so the magic number can
+// be read before the format is known.
 #define MAGIC_NUMBER_OFFSET offsetof(IndexFileHeader, magic_number)
 
 // Offset of the doctable size field within an IndexFileHeader struct
 #define DT_BYTES_OFFSET offsetof(IndexFileHeader, doctable_bytes)
 
 
+//---------------------------------------------
+// Auxiliary sections
+//
+// An index file may carry optional tables after the index, each one a
+// SectionHeader followed by "section_bytes" bytes of payload.  They are
+// covered by the header's checksum, but not by doctable_bytes or
+// index_bytes, so readers that predate a section simply never see it.
+//---------------------------------------------
+
+struct SectionHeader {
+  uint32_t  tag;            // which kind of section this is; see below.
+  int32_t   section_bytes;  // number of payload bytes after this header.
+
+  SectionHeader() { }  // this constructor doesn't initialize any fields!
+  SectionHeader(uint32_t tag_arg, int32_t section_bytes_arg)
+    : tag(tag_arg), section_bytes(section_bytes_arg) { }
+
+  void ToDiskFormat() {
+    tag = htonl(tag);
+    section_bytes = htonl(section_bytes);
+  }
+
+  void ToHostFormat() {
+    tag = ntohl(tag);
+    section_bytes = ntohl(section_bytes);
+  }
+};
+
+// The per-document length table: a DocLengthRecord for every docID from
+// 1 through the largest docID in the doctable, in docID order.
+static constexpr uint32_t kDocLengthsSectionTag = 0x444C454E;  // "DLEN"
+
+// The per-word score bound table: a TermBoundRecord for every word in the
+// index, sorted by ascending word hash.
+static constexpr uint32_t kTermBoundsSectionTag = 0x4D415853;  // "MAXS"
+
+// The sorted term dictionary: a TermDictHeader, then a TermDictBlockRecord
+// for each block of terms, then the blocks themselves.  See
+// TermDictReader.h for the layout of a block.
+static constexpr uint32_t kTermDictSectionTag = 0x54444943;  // "TDIC"
+
+// The number of terms in each block of the term dictionary but the last.
+static constexpr int kTermDictBlockTerms = 16;
+
+// A blocked Bloom filter of the hashes of every word in the index: an
+// array of 32-byte blocks, each eight 32-bit words.  See BloomFilter.h.
+static constexpr uint32_t kBloomFilterSectionTag = 0x424C4F4D;  // "BLOM"
+
+
 //---------------------------------------------
 // Bucket lists
 //  (Used by doctable, index, and docID table)
@@ -109,11 +213,10 @@ struct BucketListHeader {
 };
 
 struct BucketRecord {
-  int32_t            chain_num_elements;  // number of elements in this
-                                          // bucket's chain.
-  IndexFileOffset_t  position;            // byte offset from the start of the
-                                          // index file, indicating where the
-                                          // bucket's chain begins.
+  int32_t  chain_num_elements;  // number of elements in this bucket's chain.
+  int32_t  position;            // byte offset from the start of the index
+                                // file, indicating where the bucket's
+                                // chain begins.
 
   BucketRecord() { }  // this constructor doesn't initialize any fields!
 
@@ -133,8 +236,8 @@ struct BucketRecord {
 };
 
 struct ElementPositionRecord {
-  IndexFileOffset_t  position;  // byte offset from the start of the index file,
-                                // indicating where the element begins.
+  int32_t  position;  // byte offset from the start of the index file,
+                      // indicating where the element begins.
 
   ElementPositionRecord() { }
   explicit ElementPositionRecord(IndexFileOffset_t pos)
@@ -145,6 +248,39 @@ struct ElementPositionRecord {
   void ToHostFormat() { position = ntohl(position); }
 };
 
+struct BucketRecord64 {
+  int32_t  chain_num_elements;  // as for BucketRecord.
+  int64_t  position;
+
+  BucketRecord64() { }  // this constructor doesn't initialize any fields!
+
+  BucketRecord64(int32_t num_elts, IndexFileOffset_t pos)
+    : chain_num_elements(num_elts), position(pos) {
+  }
+
+  void ToDiskFormat() {
+    chain_num_elements = htonl(chain_num_elements);
+    position = htonll(position);
+  }
+
+  void ToHostFormat() {
+    chain_num_elements = ntohl(chain_num_elements);
+    position = ntohll(position);
+  }
+};
+
+struct ElementPositionRecord64 {
+  int64_t  position;  // as for ElementPositionRecord.
+
+  ElementPositionRecord64() { }
+  explicit ElementPositionRecord64(IndexFileOffset_t pos)
+    : position(pos) {
+  }
+
+  void ToDiskFormat() { position = htonll(position); }
+  void ToHostFormat() { position = ntohll(position); }
+};
+
 //---------------------------------------------
 // DocTable
 //---------------------------------------------
@@ -170,6 +306,77 @@ struct DoctableElementHeader {
   }
 };
 
+struct DocLengthRecord {
+  uint32_t  num_words;  // number of words indexed from the document, or 0
+                        // if the docID isn't in the doctable.
+
+  DocLengthRecord() { }  // this constructor doesn't initialize any fields!
+  explicit DocLengthRecord(uint32_t num_words_arg)
+    : num_words(num_words_arg) { }
+
+  void ToDiskFormat() { num_words = htonl(num_words); }
+  void ToHostFormat() { num_words = ntohl(num_words); }
+};
+
+struct TermBoundRecord {
+  HTKey_t  word_hash;  // the word's hash; see MagicNumberForHashID().
+  float    max_score;  // an upper bound on the word's BM25 score in any
+                       // single document.  If two words share a hash, this
+                       // bounds both of them.
+
+  TermBoundRecord() { }  // this constructor doesn't initialize any fields!
+  TermBoundRecord(HTKey_t word_hash_arg, float max_score_arg)
+    : word_hash(word_hash_arg), max_score(max_score_arg) { }
+
+  // There's no htonf(), so swap the float's bits as a 32-bit integer.
+  void ToDiskFormat() {
+    word_hash = htonll(word_hash);
+    uint32_t bits;
+    memcpy(&bits, &max_score, sizeof(bits));
+    bits = htonl(bits);
+    memcpy(&max_score, &bits, sizeof(bits));
+  }
+
+  void ToHostFormat() {
+    word_hash = ntohll(word_hash);
+    uint32_t bits;
+    memcpy(&bits, &max_score, sizeof(bits));
+    bits = ntohl(bits);
+    memcpy(&max_score, &bits, sizeof(bits));
+  }
+};
+
+struct TermDictHeader {
+  int32_t  num_terms;   // number of terms in the dictionary.
+  int32_t  num_blocks;  // number of blocks the terms are grouped into.
+
+  TermDictHeader() { }  // this constructor doesn't initialize any fields!
+  TermDictHeader(int32_t num_terms_arg, int32_t num_blocks_arg)
+    : num_terms(num_terms_arg), num_blocks(num_blocks_arg) { }
+
+  void ToDiskFormat() {
+    num_terms = htonl(num_terms);
+    num_blocks = htonl(num_blocks);
+  }
+
+  void ToHostFormat() {
+    num_terms = ntohl(num_terms);
+    num_blocks = ntohl(num_blocks);
+  }
+};
+
+struct TermDictBlockRecord {
+  int32_t  position;  // byte offset of the block from the start of the
+                      // section's payload.
+
+  TermDictBlockRecord() { }  // this constructor doesn't initialize any fields!
+  explicit TermDictBlockRecord(int32_t position_arg)
+    : position(position_arg) { }
+
+  void ToDiskFormat() { position = htonl(position); }
+  void ToHostFormat() { position = ntohl(position); }
+};
+
 //---------------------------------------------
 // IndexTable
 //
@@ -196,6 +403,25 @@ struct WordPostingsHeader {
   }
 };
 
+struct WordPostingsHeader64 {
+  int16_t  word_bytes;      // as for WordPostingsHeader.
+  int64_t  postings_bytes;
+
+  WordPostingsHeader64() { }  // this constructor doesn't initialize any fields!
+  WordPostingsHeader64(int16_t word_bytes_arg, int64_t postings_bytes_arg)
+    : word_bytes(word_bytes_arg), postings_bytes(postings_bytes_arg) { }
+
+  void ToDiskFormat() {
+    word_bytes = htons(word_bytes);
+    postings_bytes = htonll(postings_bytes);
+  }
+
+  void ToHostFormat() {
+    word_bytes = ntohs(word_bytes);
+    postings_bytes = ntohll(postings_bytes);
+  }
+};
+
 //---------------------------------------------
 // DocIDTable
 //---------------------------------------------
@@ -234,4 +460,213 @@ struct DocIDElementPosition {
 
 #pragma pack(pop)
 
+namespace hw3 {
+
+//---------------------------------------------
+// The native format
+//
+// A kIndexFormatNative file is meant to be mmap()'ed and read in place,
+// so its records are stored in the writer's byte order, and have their
+// natural alignment: they're declared outside of the #pragma pack above,
+// with explicit (zeroed) padding fields so that nothing is left to the
+// compiler.  Every hash table element -- a doctable element, a
+// WordPostings, or a docID table element -- and every docID table starts
+// on a kNativeAlignment boundary, with zeros in the gaps.
+//
+// The header's byte_order field is kByteOrderMark in the writer's byte
+// order, so a reader of the other endianness can refuse the file.  The
+// magic number alone stays big-endian, so that it can be read before the
+// format is known, and the auxiliary sections are the same as in the
+// other formats.
+//---------------------------------------------
+
+static constexpr int kNativeAlignment = 8;
+static constexpr uint32_t kByteOrderMark = 0x01020304;
+
+struct IndexFileHeaderNative {
+  uint32_t  magic_number;    // as for IndexFileHeader, and big-endian.
+  uint32_t  checksum;
+  uint32_t  byte_order;      // kByteOrderMark.
+  uint32_t  reserved;
+  int64_t   doctable_bytes;
+  int64_t   index_bytes;
+
+  IndexFileHeaderNative() { }  // this constructor yields uninitialized fields!
+
+  IndexFileHeaderNative(uint32_t magic_number_arg,
+                        uint32_t checksum_arg,
+                        int64_t doctable_bytes_arg,
+                        int64_t index_bytes_arg)
+    : magic_number(magic_number_arg),
+      checksum(checksum_arg),
+      byte_order(kByteOrderMark),
+      reserved(0),
+      doctable_bytes(doctable_bytes_arg),
+      index_bytes(index_bytes_arg) {
+  }
+
+  void ToDiskFormat() { magic_number = htonl(magic_number); }
+  void ToHostFormat() { magic_number = ntohl(magic_number); }
+};
+
+// The remaining records are already in disk format.
+
+struct BucketListHeaderNative {
+  int32_t  num_buckets;
+  int32_t  reserved;
+
+  BucketListHeaderNative() { }  // this constructor doesn't initialize any
+                                // fields!
+  explicit BucketListHeaderNative(int32_t num_buckets_arg)
+    : num_buckets(num_buckets_arg), reserved(0) { }
+
+  void ToDiskFormat() { }
+  void ToHostFormat() { }
+};
+
+struct BucketRecordNative {
+  int32_t  chain_num_elements;
+  int32_t  reserved;
+  int64_t  position;
+
+  BucketRecordNative() { }  // this constructor doesn't initialize any fields!
+  BucketRecordNative(int32_t num_elts, IndexFileOffset_t pos)
+    : chain_num_elements(num_elts), reserved(0), position(pos) { }
+
+  void ToDiskFormat() { }
+  void ToHostFormat() { }
+};
+
+struct ElementPositionRecordNative {
+  int64_t  position;
+
+  ElementPositionRecordNative() { }
+  explicit ElementPositionRecordNative(IndexFileOffset_t pos)
+    : position(pos) { }
+
+  void ToDiskFormat() { }
+  void ToHostFormat() { }
+};
+
+struct DoctableElementHeaderNative {
+  DocID_t  doc_id;
+  int16_t  file_name_bytes;
+  int16_t  reserved[3];
+
+  DoctableElementHeaderNative() { }  // this constructor doesn't initialize
+                                     // any fields!
+  DoctableElementHeaderNative(DocID_t id, int32_t num_bytes)
+    : doc_id(id), file_name_bytes(num_bytes), reserved{0, 0, 0} { }
+
+  void ToDiskFormat() { }
+  void ToHostFormat() { }
+};
+
+struct WordPostingsHeaderNative {
+  int64_t  postings_bytes;
+  int16_t  word_bytes;
+  int16_t  reserved[3];
+
+  WordPostingsHeaderNative() { }  // this constructor doesn't initialize any
+                                  // fields!
+  WordPostingsHeaderNative(int16_t word_bytes_arg, int64_t postings_bytes_arg)
+    : postings_bytes(postings_bytes_arg), word_bytes(word_bytes_arg),
+      reserved{0, 0, 0} { }
+
+  void ToDiskFormat() { }
+  void ToHostFormat() { }
+};
+
+struct DocIDElementHeaderNative {
+  DocID_t  doc_id;
+  int32_t  num_positions;
+  int32_t  reserved;
+
+  DocIDElementHeaderNative() { }  // this constructor doesn't initialize any
+                                  // fields!
+  DocIDElementHeaderNative(DocID_t id, int32_t num_pos)
+    : doc_id(id), num_positions(num_pos), reserved(0) { }
+
+  void ToDiskFormat() { }
+  void ToHostFormat() { }
+};
+
+struct DocIDElementPositionNative {
+  DocPositionOffset_t position;
+
+  DocIDElementPositionNative() { }  // this constructor doesn't initialize
+                                    // any fields
+  explicit DocIDElementPositionNative(DocPositionOffset_t position_arg)
+    : position(position_arg) { }
+
+  void ToDiskFormat() { }
+  void ToHostFormat() { }
+};
+
+// Padding would make these differ between compilers, so there mustn't be
+// any beyond the explicit fields.
+static_assert(sizeof(IndexFileHeaderNative) == 32, "unexpected padding");
+static_assert(sizeof(BucketRecordNative) == 16, "unexpected padding");
+static_assert(sizeof(DoctableElementHeaderNative) == 16, "unexpected padding");
+static_assert(sizeof(WordPostingsHeaderNative) == 16, "unexpected padding");
+static_assert(sizeof(DocIDElementHeaderNative) == 16, "unexpected padding");
+
+
+//---------------------------------------------
+// Formats
+//
+// The records each format uses, for code that handles any of them.
+// Elements are padded out to a multiple of kAlignment bytes.
+//---------------------------------------------
+
+struct Offsets32 {
+  static constexpr IndexFormat kFormat = kIndexFormat32;
+  static constexpr IndexFileOffset_t kMaxOffset = INT32_MAX;
+  static constexpr int kAlignment = 1;
+  typedef IndexFileHeader        Header;
+  typedef BucketListHeader       ListHeader;
+  typedef BucketRecord           Bucket;
+  typedef ElementPositionRecord  ElementPosition;
+  typedef DoctableElementHeader  DocHeader;
+  typedef WordPostingsHeader     WordHeader;
+  typedef DocIDElementHeader     DocIDHeader;
+  typedef DocIDElementPosition   Position;
+};
+
+struct Offsets64 {
+  static constexpr IndexFormat kFormat = kIndexFormat64;
+  static constexpr IndexFileOffset_t kMaxOffset = INT64_MAX;
+  static constexpr int kAlignment = 1;
+  typedef IndexFileHeader64        Header;
+  typedef BucketListHeader         ListHeader;
+  typedef BucketRecord64           Bucket;
+  typedef ElementPositionRecord64  ElementPosition;
+  typedef DoctableElementHeader    DocHeader;
+  typedef WordPostingsHeader64     WordHeader;
+  typedef DocIDElementHeader       DocIDHeader;
+  typedef DocIDElementPosition     Position;
+};
+
+struct OffsetsNative {
+  static constexpr IndexFormat kFormat = kIndexFormatNative;
+  static constexpr IndexFileOffset_t kMaxOffset = INT64_MAX;
+  static constexpr int kAlignment = kNativeAlignment;
+  typedef IndexFileHeaderNative        Header;
+  typedef BucketListHeaderNative       ListHeader;
+  typedef BucketRecordNative           Bucket;
+  typedef ElementPositionRecordNative  ElementPosition;
+  typedef DoctableElementHeaderNative  DocHeader;
+  typedef WordPostingsHeaderNative     WordHeader;
+  typedef DocIDElementHeaderNative     DocIDHeader;
+  typedef DocIDElementPositionNative   Position;
+};
+
+// Returns "bytes" rounded up to a multiple of the format's alignment.
+template <typename Offsets>
+inline int64_t AlignedBytes(int64_t bytes) {
+  return (bytes + Offsets::kAlignment - 1) & -Offsets::kAlignment;
+}
+
+}  // namespace hw3
+
 #endif  // HW3_LAYOUTSTRUCTS_H_
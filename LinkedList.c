@@ -151,37 +151,77 @@ void LinkedList_Append(LinkedList *list, LLPayload_t payload) {
 void LinkedList_Sort(LinkedList *list, bool ascending,
                      LLPayloadComparatorFnPtr comparator_function) {
   Verify333(list != NULL);
-  if (list->num_elements < 2) {
+  LinkedList_SortTopK(list, ascending, comparator_function,
+                      list->num_elements);
+}
+
+void LinkedList_SortTopK(LinkedList *list, bool ascending,
+                         LLPayloadComparatorFnPtr comparator_function,
+                         int k) {
+  Verify333(list != NULL);
+  Verify333(k >= 0);
+  if (list->num_elements < 2 || k == 0) {
     // No sorting needed.
     return;
   }
 
-  // We'll implement bubblesort! Nnice and easy, and nice and slow :)
-  int swapped;
-  do {
-    LinkedListNode *curnode;
-
-    swapped = 0;
-    curnode = list->head;
-    while (curnode->next != NULL) {
-      int compare_result = comparator_function(curnode->payload,
-                                               curnode->next->payload);
-      if (ascending) {
-        compare_result *= -1;
-      }
-      if (compare_result < 0) {
-        // Bubble-swap the payloads.
-        LLPayload_t tmp;
-        tmp = curnode->payload;
-        curnode->payload = curnode->next->payload;
-        curnode->next->payload = tmp;
-        swapped = 1;
-      }
-      curnode = curnode->next;
+  // We'll implement a bottom-up mergesort on the "next" links, keeping
+  // the sorted runs in a binary counter: runs[i] is either NULL or a run
+  // made from 2^i of the list's nodes.  Each node is added as a run of
+  // one and carried up through the counter, merging with the (earlier,
+  // so stability wins ties for it) run already in each occupied slot.
+  // No run is ever allowed to grow past k nodes; the nodes cut off the
+  // end of a run can't be among the first k, so they're set aside on
+  // "discards" and tacked back onto the end of the list when we're done.
+  // 64 slots is enough to count to far more nodes than we can allocate.
+  LinkedListNode *runs[64] = { NULL };
+  LinkedListNode *discards = NULL;
+  int num_runs = 0;
+
+  LinkedListNode *node = list->head;
+  while (node != NULL) {
+    LinkedListNode *carry = node;
+    node = node->next;
+    carry->next = NULL;
+
+    int i;
+    for (i = 0; i < num_runs && runs[i] != NULL; i++) {
+      carry = LLMergeRuns(runs[i], carry, ascending, comparator_function,
+                          k, &discards);
+      runs[i] = NULL;
     }
-  } while (swapped);
-}
+    Verify333(i < 64);
+    runs[i] = carry;
+    if (i == num_runs) {
+      num_runs++;
+    }
+  }
 
+  // Merge whatever is left in the counter, from the latest (and
+  // smallest) run to the earliest.
+  LinkedListNode *sorted = NULL;
+  for (int i = 0; i < num_runs; i++) {
+    if (runs[i] != NULL) {
+      sorted = LLMergeRuns(runs[i], sorted, ascending, comparator_function,
+                           k, &discards);
+    }
+  }
+
+  // Finally, re-thread the "prev" links and the tail, appending the
+  // discards after the sorted nodes.
+  LinkedListNode *prev = NULL;
+  list->head = sorted;
+  for (LinkedListNode *curr = sorted; curr != NULL; curr = curr->next) {
+    curr->prev = prev;
+    prev = curr;
+  }
+  prev->next = discards;
+  for (LinkedListNode *curr = discards; curr != NULL; curr = curr->next) {
+    curr->prev = prev;
+    prev = curr;
+  }
+  list->tail = prev;
+}
 
 ///////////////////////////////////////////////////////////////////////////////
 // LLIterator implementation.
@@ -194,12 +234,17 @@ LLIterator* LLIterator_Allocate(LinkedList *list) {
   Verify333(li != NULL);
 
   // Set up the iterator.
-  li->list = list;
-  li->node = list->head;
-
+  LLIterator_Init(li, list);
   return li;
 }
 
+void LLIterator_Init(LLIterator *iter, LinkedList *list) {
+  Verify333(iter != NULL);
+  Verify333(list != NULL);
+  iter->list = list;
+  iter->node = list->head;
+}
+
 void LLIterator_Free(LLIterator *iter) {
   Verify333(iter != NULL);
   free(iter);
@@ -333,3 +378,57 @@ bool LLSlice(LinkedList *list, LLPayload_t *payload_ptr) {
 void LLIteratorRewind(LLIterator *iter) {
   iter->node = iter->list->head;
 }
+
+LinkedListNode *LLMergeRuns(LinkedListNode *a, LinkedListNode *b,
+                            bool ascending,
+                            LLPayloadComparatorFnPtr comparator_function,
+                            int limit, LinkedListNode **discards) {
+  LinkedListNode *head = NULL;
+  LinkedListNode **tail = &head;
+  int num_merged = 0;
+
+  while (a != NULL && b != NULL && num_merged < limit) {
+    int compare_result = comparator_function(a->payload, b->payload);
+    if (!ascending) {
+      compare_result *= -1;
+    }
+    // Take from "a" on ties, since its nodes came first.
+    if (compare_result <= 0) {
+      *tail = a;
+      a = a->next;
+    } else {
+      *tail = b;
+      b = b->next;
+    }
+    tail = &(*tail)->next;
+    num_merged++;
+  }
+
+  // Whatever remains of one run follows the merged nodes, up to the limit.
+  LinkedListNode *rest = (a != NULL) ? a : b;
+  LinkedListNode *other = (a != NULL) ? b : NULL;
+  *tail = rest;
+  while (*tail != NULL && num_merged < limit) {
+    tail = &(*tail)->next;
+    num_merged++;
+  }
+
+  // Everything past the limit is set aside.
+  LinkedListNode *cut = *tail;
+  *tail = NULL;
+  LLPushDiscards(cut, discards);
+  LLPushDiscards(other, discards);
+  return head;
+}
+
+void LLPushDiscards(LinkedListNode *nodes, LinkedListNode **discards) {
+  if (nodes == NULL) {
+    return;
+  }
+  LinkedListNode *last = nodes;
+  while (last->next != NULL) {
+    last = last->next;
+  }
+  last->next = *discards;
+  *discards = nodes;
+}
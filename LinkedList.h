@@ -118,7 +118,9 @@ void LinkedList_Append(LinkedList *list, LLPayload_t payload);
 typedef int(*LLPayloadComparatorFnPtr)(LLPayload_t payload_a,
                                        LLPayload_t payload_b);
 
-// Sorts a LinkedList in place.
+// Sorts a LinkedList in place.  The sort is stable (elements that compare
+// equal keep their relative order), takes O(n log n) comparisons, and
+// doesn't allocate memory.
 //
 // Arguments:
 // - list: the list to sort.
@@ -128,6 +130,22 @@ typedef int(*LLPayloadComparatorFnPtr)(LLPayload_t payload_a,
 void LinkedList_Sort(LinkedList *list, bool ascending,
                      LLPayloadComparatorFnPtr comparator_function);
 
+// Partially sorts a LinkedList in place: afterwards, the first k elements
+// of the list are the first k elements that LinkedList_Sort() would have
+// produced, in the same order, and the rest of the elements follow in an
+// unspecified order.  Takes O(n log k) comparisons, and doesn't allocate
+// memory.
+//
+// Arguments:
+// - list: the list to sort.
+// - ascending: if false, sorts descending; else sorts ascending.
+// - comparator_function: a pointer to a payload comparator function.
+// - k: the number of elements to order; must be >= 0.  If k is at least
+//   the length of the list, the whole list is sorted.
+void LinkedList_SortTopK(LinkedList *list, bool ascending,
+                         LLPayloadComparatorFnPtr comparator_function,
+                         int k);
+
 
 ///////////////////////////////////////////////////////////////////////////////
 // Linked list iterator.
@@ -141,7 +159,16 @@ void LinkedList_Sort(LinkedList *list, bool ascending,
 // you have on that list become undefined (ie, dangerous to use; arbitrary
 // memory corruption can occur). Thus, you should only use LLIterator*()
 // functions in between the manufacturing and freeing of an iterator.
-typedef struct ll_iter LLIterator;  // same trick to hide implementation.
+//
+// Unlike LinkedList, the iterator's struct is defined here rather than in
+// LinkedList_priv.h, so that customers can also declare an iterator on the
+// stack (or embed one in another struct) and set it up with
+// LLIterator_Init(), avoiding a malloc() per iteration.  Customers must
+// still treat its fields as private.
+typedef struct ll_iter {
+  LinkedList       *list;  // the list we're for
+  struct ll_node   *node;  // the node we are at, or NULL if broken
+} LLIterator;
 
 // Manufacture an iterator for the list.  Caller is responsible for
 // eventually calling LLIterator_Free to free memory associated with
@@ -155,6 +182,15 @@ typedef struct ll_iter LLIterator;  // same trick to hide implementation.
 //   the list cannot be iterated through (eg, empty).
 LLIterator* LLIterator_Allocate(LinkedList *list);
 
+// Initializes a caller-allocated iterator for the list, pointing at its
+// first element (if any).  An iterator initialized this way must *not* be
+// passed to LLIterator_Free; it owns no memory.
+//
+// Arguments:
+// - iter: the iterator to initialize.
+// - list: the list to iterate through.
+void LLIterator_Init(LLIterator *iter, LinkedList *list);
+
 // When you're done with an iterator, you must free it by calling this
 // function.
 //
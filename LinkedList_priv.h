@@ -47,15 +47,6 @@ typedef struct ll {
   LinkedListNode   *tail;  // tail of linked list, or NULL if empty
 } LinkedList;
 
-// A linked list iterator.
-//
-// We expose the struct declaration in LinkedList.h, but not the definition,
-// similar to what we did above for the linked list itself.
-typedef struct ll_iter {
-  LinkedList       *list;  // the list we're for
-  LinkedListNode   *node;  // the node we are at, or NULL if broken
-} LLIterator;
-
 
 // Remove an element from the tail of the linked list.
 //
@@ -78,5 +69,30 @@ bool LLSlice(LinkedList *list, LLPayload_t *payload_ptr);
 // - iter: the iterator to rewind.
 void LLIteratorRewind(LLIterator *iter);
 
+// Merges the sorted runs "a" and "b", each a NULL-terminated chain of
+// "next" links, keeping only the first "limit" nodes of the result; the
+// rest are pushed onto "discards".  Ties go to "a".  "prev" links are
+// neither used nor updated.
+//
+// Arguments:
+// - a, b: the runs to merge; either may be NULL.
+// - ascending, comparator_function: as in LinkedList_Sort().
+// - limit: the maximum number of nodes to return.
+// - discards: a chain of nodes that didn't make the cut.
+//
+// Returns:
+// - the head of the merged run.
+LinkedListNode *LLMergeRuns(LinkedListNode *a, LinkedListNode *b,
+                            bool ascending,
+                            LLPayloadComparatorFnPtr comparator_function,
+                            int limit, LinkedListNode **discards);
+
+// Pushes a NULL-terminated chain of nodes onto the front of "discards".
+//
+// Arguments:
+// - nodes: the chain to push; may be NULL.
+// - discards: the chain to push onto.
+void LLPushDiscards(LinkedListNode *nodes, LinkedListNode **discards);
+
 
 #endif  // HW1_LINKEDLIST_PRIV_H_
@@ -20,6 +20,9 @@
 #include "libhw1/CSE333.h"
 #include "libhw1/HashTable.h"
 #include "libhw1/LinkedList.h"
+#include "libhw1/HashTable_priv.h"
+#include "libhw1/LinkedList_priv.h"
+#include "./WordPool.h"
 
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -29,22 +32,29 @@
 // to indicate that they should not be considered part of the MemIndex's
 // public API.
 
-// Comparator usable by LinkedList_Sort(), which implements an increasing
-// order by rank over SearchResult's.  If the caller is interested in a
-// decreasing sort order, they should invert the return value.
-static int MI_SearchResultComparator(LLPayload_t e1, LLPayload_t e2) {
-  SearchResult* sr1 = (SearchResult*) e1;
-  SearchResult* sr2 = (SearchResult*) e2;
-
-  if (sr1->rank > sr2->rank) {
-    return 1;
-  } else if (sr1->rank < sr2->rank) {
-    return -1;
+// Comparator usable by qsort(), which orders an array of SearchResult's by
+// decreasing rank, breaking ties by increasing docID so that the order
+// doesn't depend on the order of the evaluation.
+static int MI_SearchResultArrayComparator(const void* e1, const void* e2) {
+  const SearchResult* sr1 = (const SearchResult*) e1;
+  const SearchResult* sr2 = (const SearchResult*) e2;
+
+  if (sr1->rank != sr2->rank) {
+    return (sr1->rank > sr2->rank) ? -1 : 1;
+  } else if (sr1->doc_id != sr2->doc_id) {
+    return (sr1->doc_id < sr2->doc_id) ? -1 : 1;
   } else {
     return 0;
   }
 }
 
+// Returns the number of bytes that malloc() really uses for an "n"-byte
+// block: glibc adds a word of bookkeeping and rounds up to 16 bytes.
+static size_t MI_BlockBytes(size_t n) {
+  size_t bytes = (n + sizeof(size_t) + 15) & ~((size_t) 15);
+  return bytes < 32 ? 32 : bytes;
+}
+
 // Deallocator usable by LinkedList_Free(), which frees a list of
 // of DocPositionOffset_t.  Since these offsets are stored inline (ie, not
 // malloc'ed), there is nothing to do in this function.
@@ -64,7 +74,7 @@ static void MI_PostingsFree(HTValue_t ptr) {
 static void MI_ValueFree(HTValue_t ptr) {
   WordPostings* wp = (WordPostings*) ptr;
 
-  free(wp->word);
+  // The word belongs to the WordPool.
   HashTable_Free(wp->postings, &MI_PostingsFree);
 
   free(wp);
@@ -73,16 +83,57 @@ static void MI_ValueFree(HTValue_t ptr) {
 ///////////////////////////////////////////////////////////////////////////////
 // MemIndex implementation
 
+static HTHashID_t word_hash_id = HT_HASH_FNV1A64;
+
+HTHashID_t MemIndex_WordHashID(void) {
+  return word_hash_id;
+}
+
+void MemIndex_SetWordHashID(HTHashID_t hash_id) {
+  Verify333(hash_id >= 0 && hash_id < HT_NUM_HASH_IDS);
+
+  // Every interned word was hashed, so an empty pool means no word has
+  // been keyed with the old function.
+  Verify333(hash_id == word_hash_id || WordPool_NumWords() == 0);
+  word_hash_id = hash_id;
+}
+
+HTKey_t MemIndex_HashWord(const char* word, int len) {
+  return HashWithID(word_hash_id, (unsigned char*) word, len);
+}
+
 MemIndex* MemIndex_Allocate(void) {
   // Happily, HashTables dynamically resize themselves, so we can start by
   // allocating a small hashtable.
   HashTable* index = HashTable_Allocate(16);
   Verify333(index != NULL);
+  WordPool_Acquire();
   return index;
 }
 
 void MemIndex_Free(MemIndex* index) {
   HashTable_Free(index, &MI_ValueFree);
+  WordPool_Release();
+}
+
+size_t MemIndex_EstimateBytes(int num_words, int64_t num_postings,
+                              int64_t num_positions) {
+  // Each word has a WordPostings, and a docID->postings HashTable whose
+  // 16 buckets are all allocated up front, and is chained into a bucket of
+  // the index.  Each posting list is a LinkedList, chained into a bucket of
+  // its word's table.  Each position is a LinkedListNode.  We don't count
+  // the index's own bucket arrays, nor the growth of the docID tables.
+  size_t chained = MI_BlockBytes(sizeof(HTKeyValue_t)) +
+    MI_BlockBytes(sizeof(LinkedListNode));
+  size_t per_word = MI_BlockBytes(sizeof(WordPostings)) +
+    MI_BlockBytes(sizeof(HashTable)) +
+    MI_BlockBytes(16 * sizeof(LinkedList*)) +
+    16 * MI_BlockBytes(sizeof(LinkedList)) + chained;
+  size_t per_posting = MI_BlockBytes(sizeof(LinkedList)) + chained;
+  size_t per_position = MI_BlockBytes(sizeof(LinkedListNode));
+
+  return num_words * per_word + num_postings * per_posting +
+    num_positions * per_position;
 }
 
 int MemIndex_NumWords(MemIndex* index) {
@@ -91,7 +142,19 @@ int MemIndex_NumWords(MemIndex* index) {
 
 void MemIndex_AddPostingList(MemIndex* index, char* word, DocID_t doc_id,
                              LinkedList* postings) {
-  HTKey_t key = FNVHash64((unsigned char*) word, strlen(word));
+  int len = strlen(word);
+  HTKey_t key = MemIndex_HashWord(word, len);
+  const char* interned = WordPool_Intern(word, len, key);
+
+  // The pool has its own copy, so we can free the word (since the caller
+  // gave us ownership of it).
+  free(word);
+  MemIndex_AddInternedPostingList(index, key, interned, doc_id, postings);
+}
+
+void MemIndex_AddInternedPostingList(MemIndex* index, HTKey_t key,
+                                     const char* word, DocID_t doc_id,
+                                     LinkedList* postings) {
   HTKeyValue_t mi_kv, postings_kv, unused;
   WordPostings* wp;
 
@@ -106,9 +169,7 @@ void MemIndex_AddPostingList(MemIndex* index, char* word, DocID_t doc_id,
     // No, this is the first time the inverted index has seen this word.  We
     // need to prepare and insert a new WordPostings structure.  After
     // malloc'ing it, we need to:
-    //   (1) find existing memory or allocate new memory for the WordPostings'
-    //       word field (hint: remember that this function takes ownership
-    //       of the passed-in word).
+    //   (1) point the WordPostings' word field at the interned word.
     //   (2) allocate a new hashtable for the WordPostings' docID->postings
     //       mapping.
     //   (3) insert the the new WordPostings into the inverted index (ie, into
@@ -138,11 +199,9 @@ void MemIndex_AddPostingList(MemIndex* index, char* word, DocID_t doc_id,
     wp = (WordPostings*) mi_kv.value;
 
     // Ensure we don't have hash collisions (two different words that hash to
-    // the same key, which is very unlikely).
-    Verify333(strcmp(wp->word, word) == 0);
-
-    // Now we can free the word (since the caller gave us ownership of it).
-    free(word);
+    // the same key, which is very unlikely).  Interned words are equal
+    // exactly when their pointers are.
+    Verify333(wp->word == word);
   }
 
   // At this point, we have a WordPostings struct which represents the posting
@@ -166,10 +225,8 @@ void MemIndex_AddPostingList(MemIndex* index, char* word, DocID_t doc_id,
 }
 
 LinkedList* MemIndex_Search(MemIndex* index, char* query[], int query_len) {
+  SearchResultArray results;
   LinkedList* ret_list;
-  HTKeyValue_t kv;
-  WordPostings* wp;
-  HTKey_t key;
   int i;
 
   // If the user provided us with an empty search query, return NULL
@@ -178,113 +235,116 @@ LinkedList* MemIndex_Search(MemIndex* index, char* query[], int query_len) {
     return NULL;
   }
 
-  // STEP 4.
-  // The most interesting part of Part C starts here...!
-  //
-  // Look up the first query word (ie, query[0]) in the inverted index.  For
-  // each document that matches, allocate and initialize a SearchResult
-  // structure (the initial computed rank is the number of times the word
-  // appears in that document).  Finally, append the SearchResult onto ret_list.
-
-  // if hashed query exists in index, search through docs and allocate
-  // SearchResult to LinkedList for all HashTables the doc was in.
-  if (HashTable_Find(index, FNVHash64((unsigned char*) query[0],
-                     strlen(query[0])), &kv)) {
-
-    ret_list = LinkedList_Allocate();
-    wp = (WordPostings*) kv.value;
-
-    HTIterator* iter = HTIterator_Allocate(wp->postings);
-
-    Verify333(iter != NULL);
-    while (HTIterator_IsValid(iter)) {
-      HTIterator_Get(iter, &kv);
-      SearchResult* sr = (SearchResult*) malloc(sizeof(SearchResult));
-      Verify333(sr != NULL);
-
-      // sr doc_id assigned to doc_id
-      // sr rank assigned to amount of doc appearances.
-      sr->doc_id = kv.key;
-      sr->rank = LinkedList_NumElements(kv.value);
-      LinkedList_Append(ret_list, sr);
-      HTIterator_Next(iter);
-    }
-
-    HTIterator_Free(iter);
-  } else {
-    // hashed query didn't exist, return NULL.
+  // Run the query through the array-based evaluator, and copy its
+  // (already sorted) results into a list.
+  SearchResultArray_Init(&results);
+  if (MemIndex_SearchArray(index, query, query_len, &results) == 0) {
+    SearchResultArray_Free(&results);
     return NULL;
   }
-  // Great; we have our search results for the first query
-  // word.  If there is only one query word, we're done!
-  // Sort the result list and return it to the caller.
-  if (query_len == 1) {
-    LinkedList_Sort(ret_list, false, &MI_SearchResultComparator);
-    return ret_list;
+
+  ret_list = LinkedList_Allocate();
+  for (i = 0; i < results.num_results; i++) {
+    SearchResult* sr = (SearchResult*) malloc(sizeof(SearchResult));
+    Verify333(sr != NULL);
+    *sr = results.results[i];
+    LinkedList_Append(ret_list, sr);
+  }
+  SearchResultArray_Free(&results);
+  return ret_list;
+}
+
+void SearchResultArray_Init(SearchResultArray* array) {
+  array->results = NULL;
+  array->num_results = 0;
+  array->capacity = 0;
+}
+
+void SearchResultArray_Free(SearchResultArray* array) {
+  free(array->results);
+  SearchResultArray_Init(array);
+}
+
+int MemIndex_SearchArray(MemIndex* index, char* query[], int query_len,
+                         SearchResultArray* results) {
+  WordPostings** terms;
+  HTKeyValue_t kv;
+  int i, j;
+
+  Verify333(results != NULL);
+  results->num_results = 0;
+  if (query_len == 0) {
+    return 0;
   }
 
-  // OK, there are additional query words.  Handle them one
-  // at a time.
+  // Look up every query word before doing any other work: if any of them
+  // is missing, nothing can match.
+  terms = (WordPostings**) malloc(query_len * sizeof(WordPostings*));
+  Verify333(terms != NULL);
+  for (i = 0; i < query_len; i++) {
+    if (!HashTable_Find(index, MemIndex_HashWord(query[i], strlen(query[i])),
+                        &kv)) {
+      free(terms);
+      return 0;
+    }
+    terms[i] = (WordPostings*) kv.value;
+  }
+
+  // Order the words by the number of documents they appear in, so that
+  // the candidate set starts (and stays) as small as possible.  Queries
+  // are short, so an insertion sort will do.
   for (i = 1; i < query_len; i++) {
-    LLIterator *ll_it;
-    int j, num_docs;
-
-    // STEP 5.
-    // Look up the next query word (query[i]) in the inverted index.
-    // If there are no matches, it means the overall query
-    // should return no documents, so free retlist and return NULL.
-
-    if (!HashTable_Find(index, FNVHash64((unsigned char*) query[i],
-                      strlen(query[i])), &kv)) {
-      LinkedList_Free(ret_list, free);
-      return NULL;
+    WordPostings* term = terms[i];
+    int num_docs = HashTable_NumElements(term->postings);
+    for (j = i; j > 0 &&
+           HashTable_NumElements(terms[j - 1]->postings) > num_docs; j--) {
+      terms[j] = terms[j - 1];
     }
-    // STEP 6.
-    // There are matches.  We're going to iterate through
-    // the docIDs in our current search result list, testing each
-    // to see whether it is also in the set of matches for
-    // the query[i].
-    //
-    // If it is, we leave it in the search
-    // result list and we update its rank by adding in the
-    // number of matches for the current word.
-    //
-    // If it isn't, we delete that docID from the search result list.
-    ll_it = LLIterator_Allocate(ret_list);
-    Verify333(ll_it != NULL);
-    num_docs = LinkedList_NumElements(ret_list);
-    wp = (WordPostings*) kv.value;
-    for (j = 0; j < num_docs; j++) {
-      // gets current element of ret_list.
-      // the payload is cast to SearchResult pointer.
-      LLPayload_t res;
-      LLIterator_Get(ll_it, &res);
-      SearchResult* sr = (SearchResult*) res;
-
-      // key is assigned to sr doc_id.
-      key = sr->doc_id;
-      HTKeyValue_t kv_doc;
-      // if doc_id exists in wp, the number of elements in
-      // postings list is added rank.
-      if (HashTable_Find(wp->postings, key, &kv_doc)) {
-        sr->rank += LinkedList_NumElements(kv_doc.value);
-        LLIterator_Next(ll_it);
-      } else {
-        // if doc_id doesn't exist in wp, it is removed from ret_list.
-        LLIterator_Remove(ll_it, free);
-      }
+    terms[j] = term;
+  }
+
+  // Seed the candidates with the rarest word's documents, growing the
+  // array (if need be) once up front.
+  int num_docs = HashTable_NumElements(terms[0]->postings);
+  if (num_docs > results->capacity) {
+    int capacity = results->capacity * 2;
+    if (capacity < num_docs) {
+      capacity = num_docs;
     }
-    LLIterator_Free(ll_it);
+    results->results = (SearchResult*) realloc(results->results,
+                                               capacity *
+                                               sizeof(SearchResult));
+    Verify333(results->results != NULL);
+    results->capacity = capacity;
+  }
+
+  HTIterator iter;
+  for (HTIterator_Init(&iter, terms[0]->postings);
+       HTIterator_IsValid(&iter);
+       HTIterator_Next(&iter)) {
+    SearchResult* sr = &results->results[results->num_results++];
+    HTIterator_Get(&iter, &kv);
+    sr->doc_id = kv.key;
+    sr->rank = LinkedList_NumElements((LinkedList*) kv.value);
+  }
 
-    // We've finished processing this current query word.  If there are no
-    // documents left in our result list, free retlist and return NULL.
-    if (LinkedList_NumElements(ret_list) == 0) {
-      LinkedList_Free(ret_list, (LLPayloadFreeFnPtr)free);
-      return NULL;
+  // Narrow the candidates down by each of the remaining words in turn,
+  // compacting the array in place.
+  for (i = 1; i < query_len && results->num_results > 0; i++) {
+    int num_kept = 0;
+    for (j = 0; j < results->num_results; j++) {
+      SearchResult sr = results->results[j];
+      if (HashTable_Find(terms[i]->postings, sr.doc_id, &kv)) {
+        sr.rank += LinkedList_NumElements((LinkedList*) kv.value);
+        results->results[num_kept++] = sr;
+      }
     }
+    results->num_results = num_kept;
   }
+  free(terms);
 
-  // Sort the result list by rank and return it to the caller.
-  LinkedList_Sort(ret_list, false, &MI_SearchResultComparator);
-  return ret_list;
+  // Sort the results by rank.
+  qsort(results->results, results->num_results, sizeof(SearchResult),
+        &MI_SearchResultArrayComparator);
+  return results->num_results;
 }
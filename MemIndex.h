@@ -13,6 +13,8 @@
 #define HW2_MEMINDEX_H_
 
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
 
 #include "libhw1/HashTable.h"
 #include "libhw1/LinkedList.h"
@@ -41,6 +43,32 @@ typedef uint32_t DocPositionOffset_t;
 // vtable.  See also DocTable for an example of class composition.
 typedef HashTable MemIndex;
 
+// Returns the hash function used to key words in a MemIndex, and in
+// FileParser's word tables.  The default is FNV-1a, which older readers
+// (and hw3fsck) understand; HT_HASH_WYHASH64 is faster.  Index files
+// written from a MemIndex record it in their header, so readers can load
+// indices built with either function.
+HTHashID_t MemIndex_WordHashID(void);
+
+// Chooses the hash function used to key words from now on.  Since every
+// word already in a MemIndex or word table was keyed with the old
+// function, this must be called before any words are hashed: typically
+// before crawling.
+//
+// Arguments:
+// - hash_id: the hash function to use; it must be a valid HTHashID_t.
+void MemIndex_SetWordHashID(HTHashID_t hash_id);
+
+// Hashes a word with MemIndex_WordHashID().
+//
+// Arguments:
+// - word: the word to hash; it needn't be null-terminated.
+// - len: the number of bytes in the word.
+//
+// Returns:
+// - the word's hash key.
+HTKey_t MemIndex_HashWord(const char* word, int len);
+
 // Allocate and return a new MemIndex.  The caller takes responsibility for
 // eventually calling MemIndex_Free to free memory associated with the table.
 //
@@ -66,6 +94,13 @@ void MemIndex_Free(MemIndex* index);
 // - the number of unique words in the index.
 int MemIndex_NumWords(MemIndex* index);
 
+// Returns an estimate of the heap memory used by a MemIndex with the given
+// numbers of distinct words, posting lists (ie, (word, document) pairs) and
+// positions, including the allocator's per-block overhead.  The words
+// themselves live in the WordPool and aren't counted.
+size_t MemIndex_EstimateBytes(int num_words, int64_t num_postings,
+                              int64_t num_positions);
+
 // Adds a "posting list" to the MemIndex.
 //
 // A "posting list" is the list of positions within a specific document where
@@ -84,6 +119,21 @@ int MemIndex_NumWords(MemIndex* index);
 void MemIndex_AddPostingList(MemIndex* index, char* word, DocID_t doc_id,
                              LinkedList* postings);
 
+// The same, for a word that has already been interned in the WordPool (see
+// WordPool.h), such as a word from FileParser's word positions table.  The
+// index stores the interned pointer itself, so nothing is copied or freed.
+//
+// Arguments:
+// - index: the MemIndex to add these postings to
+// - key: the word's MemIndex_HashWord() hash.
+// - word: the interned word that these postings refer to.
+// - docid: the document containing these postings
+// - postings: a non-empty list of byte offsets, in ascending order.
+//   MemIndex takes ownership of this list.
+void MemIndex_AddInternedPostingList(MemIndex* index, HTKey_t key,
+                                     const char* word, DocID_t doc_id,
+                                     LinkedList* postings);
+
 // A document that matches a search query.
 typedef struct {
   DocID_t doc_id;  // a document that matches a search query
@@ -110,6 +160,51 @@ typedef struct {
 // - a non-NULL LinkedList of SearchResult's
 LinkedList* MemIndex_Search(MemIndex* index, char* query[], int query_len);
 
+// A growable array of SearchResults, which can be reused across calls to
+// MemIndex_SearchArray() so that its storage is only allocated once.
+typedef struct {
+  SearchResult* results;      // the results, or NULL if never grown
+  int           num_results;  // the number of valid entries in "results"
+  int           capacity;     // the number of entries "results" can hold
+} SearchResultArray;
+
+// Initializes an empty SearchResultArray.
+//
+// Arguments:
+// - array: the SearchResultArray to initialize.
+void SearchResultArray_Init(SearchResultArray* array);
+
+// Frees the storage of a SearchResultArray, leaving it empty (and ready
+// to be reused).
+//
+// Arguments:
+// - array: the SearchResultArray to free.
+void SearchResultArray_Free(SearchResultArray* array);
+
+// Processes a query against the MemIndex, like MemIndex_Search(), but
+// stores the results in a flat array instead of a list.  Ties in rank are
+// broken by increasing docID.
+//
+// All of the query words are looked up first, and the candidates are
+// seeded from the word that appears in the fewest documents and narrowed
+// down by the others, in increasing order of their document counts.  The
+// only memory allocated is a small array for the query words and, if the
+// results don't fit, the growth of "results".
+//
+// Arguments:
+// - index: the MemIndex to query
+// - query: an array of strings; each string is a single null-terminated
+//          query word, all lower-case.
+// - query_len: the number of words in the query array.
+// - results: (output parameter) an initialized SearchResultArray, whose
+//   previous contents are replaced by the results.
+//
+// Returns:
+// - the number of matching documents (also results->num_results), which
+//   is 0 if the query is empty or nothing matched.
+int MemIndex_SearchArray(MemIndex* index, char* query[], int query_len,
+                         SearchResultArray* results);
+
 
 //////////////////////////////////////////////////////////////////////////////
 
@@ -122,10 +217,11 @@ LinkedList* MemIndex_Search(MemIndex* index, char* query[], int query_len);
 // key to the inverted index and the 'postings' is its associated value,
 // represented as a mapping from DocID_t -> LinkedList(DocPositionOffset_t).
 //
-// The WordPostings struct owns the _memory allocated_ to both the word and
-// postings fields.
+// The WordPostings struct owns the _memory allocated_ to the postings field;
+// the word is interned in the WordPool, which the MemIndex holds a reference
+// on.
 typedef struct {
-  char*       word;
+  const char* word;
   HashTable*  postings;
 } WordPostings;
 
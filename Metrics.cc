@@ -0,0 +1,264 @@
+/*
+ * Copyright ©2024 Hannah C. Tang.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Washington
+ * CSE 333 for use solely during Spring Quarter 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#include <time.h>
+#include <cstdio>
+#include <cstdlib>
+#include <list>
+#include <string>
+#include <unordered_map>
+
+#include "./Metrics.h"
+
+extern "C" {
+  #include "libhw1/CSE333.h"
+}
+
+using std::string;
+
+namespace hw4 {
+
+// The names the stages are exposed under, indexed by Metrics::Stage.
+static const char* kStageNames[Metrics::kNumStages] = {
+  "dispatch", "parse", "lookup", "doctable", "render", "compress", "write",
+  "request"
+};
+
+// The quantiles each stage's summary reports.
+static const char* kQuantiles[] = { "0.5", "0.9", "0.99", "0.999" };
+
+// Hands out Metrics::id_s.  Zero is never handed out, so that it can mean
+// "no Metrics" to a thread that hasn't recorded anything yet.
+static std::atomic<uint64_t> next_metrics_id(1);
+
+// Adds "n" to "counter", which only the calling thread ever writes to.
+// With no other writers, a load and a store do the job of the much more
+// expensive fetch_add().
+static inline void Bump(std::atomic<uint64_t>* const counter, uint64_t n) {
+  counter->store(counter->load(std::memory_order_relaxed) + n,
+                 std::memory_order_relaxed);
+}
+
+// Formats "value" for the exposition format.
+static string FormatValue(double value) {
+  char buf[64];
+  snprintf(buf, sizeof(buf), "%.9g", value);
+  return buf;
+}
+
+Metrics::ThreadBlock::ThreadBlock() {
+  for (int stage = 0; stage < kNumStages; stage++) {
+    for (int bucket = 0; bucket < kNumBuckets; bucket++) {
+      counts[stage][bucket].store(0, std::memory_order_relaxed);
+    }
+    sums[stage].store(0, std::memory_order_relaxed);
+  }
+  for (int counter = 0; counter < kNumCounters; counter++) {
+    counters[counter].store(0, std::memory_order_relaxed);
+  }
+}
+
+Metrics::Metrics() : id_(next_metrics_id++) {
+  Verify333(pthread_mutex_init(&blocks_lock_, nullptr) == 0);
+}
+
+Metrics::~Metrics() {
+  for (ThreadBlock* block : blocks_) {
+    delete block;
+  }
+  Verify333(pthread_mutex_destroy(&blocks_lock_) == 0);
+}
+
+int64_t Metrics::Now() {
+  struct timespec ts;
+  Verify333(clock_gettime(CLOCK_MONOTONIC, &ts) == 0);
+  return static_cast<int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+void Metrics::Record(Stage stage, int64_t nanos) {
+  if (nanos < 0) {
+    nanos = 0;
+  } else if (nanos > kMaxNanos) {
+    nanos = kMaxNanos;
+  }
+  ThreadBlock* block = ThisThreadBlock();
+  Bump(&block->counts[stage][BucketFor(nanos)], 1);
+  Bump(&block->sums[stage], nanos);
+}
+
+void Metrics::Increment(Counter counter, uint64_t n) {
+  Bump(&ThisThreadBlock()->counters[counter], n);
+}
+
+Metrics::ThreadBlock* Metrics::ThisThreadBlock() {
+  // Each thread remembers the block it last used, and which Metrics it
+  // belongs to; there's normally only the one Metrics, so that's the block
+  // it wants.  A thread that records into several Metrics keeps the block
+  // it has in each, keyed by id_, so switching between them reuses it, and
+  // only a thread's first record into a Metrics takes the lock.  ids are
+  // never reused, so a destroyed Metrics' entry is never looked up again.
+  static thread_local uint64_t last_owner = 0;
+  static thread_local ThreadBlock* last_block = nullptr;
+  static thread_local std::unordered_map<uint64_t, ThreadBlock*> blocks;
+  if (last_owner != id_) {
+    ThreadBlock*& block = blocks[id_];
+    if (block == nullptr) {
+      block = new ThreadBlock();
+      Verify333(pthread_mutex_lock(&blocks_lock_) == 0);
+      blocks_.push_back(block);
+      Verify333(pthread_mutex_unlock(&blocks_lock_) == 0);
+    }
+    last_owner = id_;
+    last_block = block;
+  }
+  return last_block;
+}
+
+void Metrics::GetHistogram(Stage stage, Histogram* const histogram) const {
+  histogram->count = 0;
+  histogram->sum = 0;
+  histogram->max = 0;
+  for (int bucket = 0; bucket < kNumBuckets; bucket++) {
+    histogram->buckets[bucket] = 0;
+  }
+
+  Verify333(pthread_mutex_lock(&blocks_lock_) == 0);
+  for (const ThreadBlock* block : blocks_) {
+    for (int bucket = 0; bucket < kNumBuckets; bucket++) {
+      histogram->buckets[bucket] +=
+        block->counts[stage][bucket].load(std::memory_order_relaxed);
+    }
+    histogram->sum += block->sums[stage].load(std::memory_order_relaxed);
+  }
+  Verify333(pthread_mutex_unlock(&blocks_lock_) == 0);
+
+  for (int bucket = 0; bucket < kNumBuckets; bucket++) {
+    if (histogram->buckets[bucket] > 0) {
+      histogram->count += histogram->buckets[bucket];
+      histogram->max = BucketMax(bucket);
+    }
+  }
+}
+
+uint64_t Metrics::GetCounter(Counter counter) const {
+  uint64_t total = 0;
+  Verify333(pthread_mutex_lock(&blocks_lock_) == 0);
+  for (const ThreadBlock* block : blocks_) {
+    total += block->counters[counter].load(std::memory_order_relaxed);
+  }
+  Verify333(pthread_mutex_unlock(&blocks_lock_) == 0);
+  return total;
+}
+
+uint64_t Metrics::queue_depth() const {
+  // The counters are summed one after the other, so the difference can
+  // briefly come out negative if connections are picked up in between.
+  uint64_t opened = GetCounter(kConnectionsOpened);
+  uint64_t queued = GetCounter(kTasksQueued);
+  return queued > opened ? queued - opened : 0;
+}
+
+uint64_t Metrics::active_connections() const {
+  uint64_t closed = GetCounter(kConnectionsClosed);
+  uint64_t opened = GetCounter(kConnectionsOpened);
+  return opened > closed ? opened - closed : 0;
+}
+
+uint64_t Metrics::Histogram::ValueAtQuantile(double quantile) const {
+  if (count == 0) {
+    return 0;
+  }
+  uint64_t rank = static_cast<uint64_t>(quantile * count + 0.5);
+  if (rank < 1) {
+    rank = 1;
+  }
+  uint64_t seen = 0;
+  for (int bucket = 0; bucket < kNumBuckets; bucket++) {
+    seen += buckets[bucket];
+    if (seen >= rank) {
+      return BucketMax(bucket);
+    }
+  }
+  return max;
+}
+
+string Metrics::Expose() const {
+  string out;
+  out += "# HELP http333d_stage_duration_seconds Time spent in each stage of"
+         " serving a request.\n";
+  out += "# TYPE http333d_stage_duration_seconds summary\n";
+  Histogram histogram;
+  for (int stage = 0; stage < kNumStages; stage++) {
+    GetHistogram(static_cast<Stage>(stage), &histogram);
+    string labels = string("stage=\"") + kStageNames[stage] + "\"";
+    for (const char* quantile : kQuantiles) {
+      out += "http333d_stage_duration_seconds{" + labels + ",quantile=\"" +
+             quantile + "\"} " +
+             FormatValue(histogram.ValueAtQuantile(atof(quantile)) / 1e9) +
+             "\n";
+    }
+    out += "http333d_stage_duration_seconds_sum{" + labels + "} " +
+           FormatValue(histogram.sum / 1e9) + "\n";
+    out += "http333d_stage_duration_seconds_count{" + labels + "} " +
+           FormatValue(histogram.count) + "\n";
+  }
+
+  AppendMetric("http333d_connections_total", "counter",
+               "Connections picked up by a worker thread.",
+               GetCounter(kConnectionsOpened), &out);
+  AppendMetric("http333d_requests_total", "counter",
+               "Requests parsed.", GetCounter(kRequests), &out);
+  AppendMetric("http333d_compressed_body_bytes_total", "counter",
+               "Response body bytes that were sent compressed.",
+               GetCounter(kBodyBytesCompressed), &out);
+  AppendMetric("http333d_compressed_body_sent_bytes_total", "counter",
+               "Bytes those response bodies were compressed to.",
+               GetCounter(kBodyBytesSent), &out);
+  AppendMetric("http333d_active_connections", "gauge",
+               "Connections being served by a worker thread.",
+               active_connections(), &out);
+  AppendMetric("http333d_queue_depth", "gauge",
+               "Connections waiting for a worker thread.",
+               queue_depth(), &out);
+  return out;
+}
+
+void Metrics::AppendMetric(const string& name, const string& type,
+                           const string& help, double value,
+                           string* const out) {
+  *out += "# HELP " + name + " " + help + "\n";
+  *out += "# TYPE " + name + " " + type + "\n";
+  *out += name + " " + FormatValue(value) + "\n";
+}
+
+int Metrics::BucketFor(int64_t nanos) {
+  uint64_t value = static_cast<uint64_t>(nanos);
+  if (value < kSubBuckets) {
+    return value;
+  }
+
+  // The top kSubBucketBits + 1 bits of the value pick the bucket within
+  // its power of two (the top bit is always set, so it's subtracted out).
+  int shift = 63 - __builtin_clzll(value) - kSubBucketBits;
+  return (shift + 1) * kSubBuckets +
+         static_cast<int>(value >> shift) - kSubBuckets;
+}
+
+uint64_t Metrics::BucketMax(int bucket) {
+  if (bucket < kSubBuckets) {
+    return bucket;
+  }
+  int shift = bucket / kSubBuckets - 1;
+  uint64_t top = bucket % kSubBuckets + kSubBuckets;
+  return ((top + 1) << shift) - 1;
+}
+
+}  // namespace hw4
@@ -0,0 +1,157 @@
+/*
+ * Copyright ©2024 Hannah C. Tang.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Washington
+ * CSE 333 for use solely during Spring Quarter 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#ifndef HW4_METRICS_H_
+#define HW4_METRICS_H_
+
+extern "C" {
+#include <pthread.h>  // for pthread_mutex_t
+}
+
+#include <stdint.h>   // for uint64_t, etc.
+#include <atomic>
+#include <list>
+#include <string>
+
+namespace hw4 {
+
+// Metrics collects the server's latency histograms and counters, and
+// renders them in the Prometheus text exposition format for /metrics.
+//
+// Recording is lock-free and never contended: every thread records into
+// its own block of counters, which only that thread ever writes, so
+// recording a value is a couple of plain loads and stores rather than
+// atomic read-modify-writes on cache lines shared with other threads.
+// The blocks are only summed up when the metrics are rendered.
+//
+// Latencies are kept in HDR-style histograms: values below
+// kSubBuckets nanoseconds each get their own bucket, and every power of
+// two above that is split into kSubBuckets equal buckets, so every
+// recorded value is known to within 1/kSubBuckets (about 6%) however
+// large it is.  Values above kMaxNanos are recorded as kMaxNanos.
+class Metrics {
+ public:
+  // The stages a request passes through.
+  enum Stage {
+    kDispatch,   // from accepting a connection to a worker picking it up.
+    kParse,      // from the first bytes of a request to having parsed it.
+    kLookup,     // evaluating a query against the indices.
+    kDocTable,   // resolving matching docIDs to document names.
+    kRender,     // rendering a response's HTML.
+    kCompress,   // compressing a response's body.
+    kWrite,      // writing a response to the client.
+    kRequest,    // the whole of a request, from parsing to writing.
+    kNumStages
+  };
+
+  // The monotonically increasing counts the server keeps.
+  enum Counter {
+    kConnectionsOpened,    // connections a worker has picked up.
+    kConnectionsClosed,    // connections a worker is done with.
+    kTasksQueued,          // connections dispatched to the thread pool.
+    kRequests,             // requests parsed.
+    kBodyBytesCompressed,  // response body bytes sent compressed...
+    kBodyBytesSent,        // ...and the bytes they were sent as.
+    kNumCounters
+  };
+
+  static constexpr int kSubBucketBits = 4;
+  static constexpr int kSubBuckets = 1 << kSubBucketBits;
+  static constexpr int kMaxNanosBits = 36;  // about 69 seconds.
+  static constexpr int64_t kMaxNanos = (INT64_C(1) << kMaxNanosBits) - 1;
+  static constexpr int kNumBuckets =
+    (kMaxNanosBits - kSubBucketBits + 1) * kSubBuckets;
+
+  Metrics();
+  ~Metrics();
+  Metrics(const Metrics&) = delete;
+  Metrics& operator=(const Metrics&) = delete;
+
+  // Returns the current time, in nanoseconds, for timing stages with.
+  // The time is monotonic and unrelated to the time of day.
+  static int64_t Now();
+
+  // Records that a stage took "nanos" nanoseconds.
+  void Record(Stage stage, int64_t nanos);
+
+  // Adds "n" to a counter.
+  void Increment(Counter counter, uint64_t n = 1);
+
+  // A histogram summed up across all threads.
+  struct Histogram {
+    uint64_t count;              // values recorded.
+    uint64_t sum;                // their total, in nanoseconds.
+    uint64_t max;                // the largest, to within a bucket.
+    uint64_t buckets[kNumBuckets];
+
+    // Returns the smallest value (to within a bucket) that at least a
+    // fraction "quantile" of the recorded values are at or below, or 0 if
+    // nothing has been recorded.
+    uint64_t ValueAtQuantile(double quantile) const;
+  };
+
+  // Sums up a stage's histogram, or a counter, across all threads.
+  void GetHistogram(Stage stage, Histogram* const histogram) const;
+  uint64_t GetCounter(Counter counter) const;
+
+  // Returns the number of connections accepted but not yet picked up by
+  // a worker, and the number being served by one.
+  uint64_t queue_depth() const;
+  uint64_t active_connections() const;
+
+  // Renders the stage histograms (as summaries, with their 50th, 90th,
+  // 99th and 99.9th percentiles), the counters, and the queue depth and
+  // active connections in the text exposition format.  Every metric's
+  // name is prefixed with "http333d_".
+  std::string Expose() const;
+
+  // Appends a metric with a single, unlabelled sample to "out", in the
+  // text exposition format; "type" is "counter" or "gauge".  Used to
+  // expose statistics kept elsewhere alongside Expose().
+  static void AppendMetric(const std::string& name, const std::string& type,
+                           const std::string& help, double value,
+                           std::string* const out);
+
+  // Returns the histogram bucket that holds "nanos", and the largest value
+  // that bucket holds.
+  static int BucketFor(int64_t nanos);
+  static uint64_t BucketMax(int bucket);
+
+ private:
+  // The counters a single thread records into.  Only the owning thread
+  // writes to them; they're atomic so that Expose() can read them while
+  // it does.
+  struct ThreadBlock {
+    ThreadBlock();
+
+    std::atomic<uint64_t> counts[kNumStages][kNumBuckets];
+    std::atomic<uint64_t> sums[kNumStages];
+    std::atomic<uint64_t> counters[kNumCounters];
+  };
+
+  // Returns the calling thread's block, creating it the first time the
+  // thread records anything.
+  ThreadBlock* ThisThreadBlock();
+
+  // Distinguishes this Metrics from any other, past or present, so that a
+  // thread can tell whether the block it remembers is one of ours.
+  uint64_t id_;
+
+  // Every thread's block, guarded by blocks_lock_.  Blocks live as long
+  // as the Metrics does, so nothing a thread recorded is lost when it
+  // exits.
+  std::list<ThreadBlock*> blocks_;
+  mutable pthread_mutex_t blocks_lock_;
+};
+
+}  // namespace hw4
+
+#endif  // HW4_METRICS_H_
@@ -0,0 +1,217 @@
+/*
+ * Copyright ©2024 Hannah C. Tang.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Washington
+ * CSE 333 for use solely during Spring Quarter 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <algorithm>
+#include <functional>
+#include <list>
+#include <string>
+#include <vector>
+
+#include "./QueryCache.h"
+
+extern "C" {
+  #include "libhw1/CSE333.h"
+  #include "libhw1/HashTable.h"  // for FNVHash64().
+}
+
+using std::list;
+using std::string;
+using std::vector;
+
+namespace hw4 {
+
+// A rough estimate of the bookkeeping overhead of a single entry: the LRU
+// list node, the unordered_map node, and the std::string/std::vector
+// headers.  It doesn't need to be exact, it just needs to keep lots of tiny
+// entries from being treated as free.
+static constexpr size_t kEntryOverheadBytes = 128;
+
+QueryCache::QueryCache(size_t byte_budget, int num_shards)
+  : num_shards_(num_shards), fingerprint_(0), generation_(0),
+    hits_(0), misses_(0), evictions_(0) {
+  Verify333(num_shards_ > 0);
+  shard_budget_ = byte_budget / num_shards_;
+
+  shards_ = new Shard[num_shards_];
+  for (int i = 0; i < num_shards_; i++) {
+    Verify333(pthread_mutex_init(&shards_[i].lock, nullptr) == 0);
+    shards_[i].generation = 0;
+    shards_[i].bytes = 0;
+  }
+  Verify333(pthread_mutex_init(&fingerprint_lock_, nullptr) == 0);
+}
+
+QueryCache::~QueryCache() {
+  for (int i = 0; i < num_shards_; i++) {
+    Verify333(pthread_mutex_destroy(&shards_[i].lock) == 0);
+  }
+  Verify333(pthread_mutex_destroy(&fingerprint_lock_) == 0);
+  delete[] shards_;
+}
+
+string QueryCache::NormalizeKey(const vector<string>& terms) {
+  vector<string> sorted(terms);
+  std::sort(sorted.begin(), sorted.end());
+
+  string key;
+  for (const string& term : sorted) {
+    if (!key.empty()) {
+      key.push_back(' ');
+    }
+    key.append(term);
+  }
+  return key;
+}
+
+uint64_t QueryCache::ComputeIndexFingerprint(const list<string>& indices) {
+  // Feed each file's name, size and mtime into a single FNV hash.  The
+  // order of the list matters, since it determines the order in which
+  // QueryProcessor reports ties.
+  string buf;
+  for (const string& index : indices) {
+    struct stat st;
+    buf.append(index);
+    buf.push_back('\0');
+    if (stat(index.c_str(), &st) == 0) {
+      buf.append(std::to_string(st.st_size));
+      buf.push_back(':');
+      buf.append(std::to_string(st.st_mtim.tv_sec));
+      buf.push_back('.');
+      buf.append(std::to_string(st.st_mtim.tv_nsec));
+    }
+    buf.push_back('\0');
+  }
+  return FNVHash64(reinterpret_cast<unsigned char*>(&buf[0]), buf.size());
+}
+
+void QueryCache::SetIndexFingerprint(uint64_t fingerprint) {
+  Verify333(pthread_mutex_lock(&fingerprint_lock_) == 0);
+  if (fingerprint != fingerprint_) {
+    fingerprint_ = fingerprint;
+    generation_++;
+  }
+  Verify333(pthread_mutex_unlock(&fingerprint_lock_) == 0);
+}
+
+bool QueryCache::Lookup(const string& key, uint64_t generation,
+                        Entry* const entry) {
+  Shard* shard = ShardFor(key);
+  bool found = false;
+
+  Verify333(pthread_mutex_lock(&shard->lock) == 0);
+  if (SyncGeneration(shard, generation)) {
+    auto it = shard->map.find(key);
+    if (it != shard->map.end()) {
+      // Move the entry to the front of the LRU list.
+      shard->lru.splice(shard->lru.begin(), shard->lru, it->second);
+      *entry = it->second->second;
+      found = true;
+    }
+  }
+  Verify333(pthread_mutex_unlock(&shard->lock) == 0);
+
+  if (found) {
+    hits_++;
+  } else {
+    misses_++;
+  }
+  return found;
+}
+
+void QueryCache::Insert(const string& key, uint64_t generation,
+                        const Entry& entry) {
+  size_t bytes = EntryBytes(key, entry);
+  if (bytes > shard_budget_) {
+    return;
+  }
+
+  Shard* shard = ShardFor(key);
+  Verify333(pthread_mutex_lock(&shard->lock) == 0);
+  if (!SyncGeneration(shard, generation)) {
+    // These results were computed against an older set of indices.
+    Verify333(pthread_mutex_unlock(&shard->lock) == 0);
+    return;
+  }
+
+  // Replace any existing entry for this key.
+  auto it = shard->map.find(key);
+  if (it != shard->map.end()) {
+    shard->bytes -= EntryBytes(key, it->second->second);
+    shard->lru.erase(it->second);
+    shard->map.erase(it);
+  }
+
+  // Evict from the back of the LRU list until the new entry fits.
+  while (!shard->lru.empty() && shard->bytes + bytes > shard_budget_) {
+    auto& victim = shard->lru.back();
+    shard->bytes -= EntryBytes(victim.first, victim.second);
+    shard->map.erase(victim.first);
+    shard->lru.pop_back();
+    evictions_++;
+  }
+
+  shard->lru.emplace_front(key, entry);
+  shard->map[key] = shard->lru.begin();
+  shard->bytes += bytes;
+  Verify333(pthread_mutex_unlock(&shard->lock) == 0);
+}
+
+void QueryCache::Clear() {
+  for (int i = 0; i < num_shards_; i++) {
+    Verify333(pthread_mutex_lock(&shards_[i].lock) == 0);
+    ClearShard(&shards_[i]);
+    Verify333(pthread_mutex_unlock(&shards_[i].lock) == 0);
+  }
+}
+
+size_t QueryCache::bytes_used() const {
+  size_t total = 0;
+  for (int i = 0; i < num_shards_; i++) {
+    Verify333(pthread_mutex_lock(&shards_[i].lock) == 0);
+    total += shards_[i].bytes;
+    Verify333(pthread_mutex_unlock(&shards_[i].lock) == 0);
+  }
+  return total;
+}
+
+size_t QueryCache::EntryBytes(const string& key, const Entry& entry) {
+  size_t bytes = kEntryOverheadBytes + key.size() + entry.html.size();
+  for (const auto& result : entry.results) {
+    bytes += sizeof(result) + result.document_name.size();
+  }
+  return bytes;
+}
+
+QueryCache::Shard* QueryCache::ShardFor(const string& key) {
+  size_t hash = std::hash<string>()(key);
+  return &shards_[hash % num_shards_];
+}
+
+bool QueryCache::SyncGeneration(Shard* shard, uint64_t generation) {
+  if (generation < shard->generation) {
+    return false;
+  }
+  if (generation > shard->generation) {
+    ClearShard(shard);
+    shard->generation = generation;
+  }
+  return true;
+}
+
+void QueryCache::ClearShard(Shard* shard) {
+  shard->lru.clear();
+  shard->map.clear();
+  shard->bytes = 0;
+}
+
+}  // namespace hw4
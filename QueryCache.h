@@ -0,0 +1,147 @@
+/*
+ * Copyright ©2024 Hannah C. Tang.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Washington
+ * CSE 333 for use solely during Spring Quarter 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#ifndef HW4_QUERYCACHE_H_
+#define HW4_QUERYCACHE_H_
+
+extern "C" {
+#include <pthread.h>  // for pthread_mutex_t
+}
+
+#include <stdint.h>   // for uint64_t, etc.
+#include <atomic>
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "./libhw3/QueryProcessor.h"
+
+namespace hw4 {
+
+// A QueryCache is an in-memory cache of query results, sitting in front
+// of hw3::QueryProcessor so that popular queries don't re-run the full
+// index evaluation on every request.
+//
+// The cache is split into a fixed number of independently-locked shards,
+// each of which is an LRU list bounded by its share of the overall byte
+// budget.  Entries are keyed on a normalized form of the query (see
+// NormalizeKey() and hw3::QueryNode::ToString()) and hold both the
+// QueryResults and, optionally, the rendered HTML fragment for the first
+// page of results.
+//
+// Every entry belongs to an "index generation".  Whenever the set of loaded
+// index files changes, SetIndexFingerprint() advances the generation; shards
+// notice the new generation the next time they are touched and drop all of
+// their older entries.  Callers pass the generation they observed *before*
+// evaluating a query into Insert(), so results computed against an old set
+// of indices are never stored under the new generation.
+class QueryCache {
+ public:
+  // The cached value for a single query.
+  struct Entry {
+    std::vector<hw3::QueryProcessor::QueryResult> results;
+
+    // The rendered HTML for the top page of results, or empty if the
+    // caller didn't render one.
+    std::string html;
+  };
+
+  // Construct a QueryCache.  Arguments:
+  //
+  //  - byte_budget: the approximate upper bound on the memory consumed by
+  //    cached entries, split evenly across the shards.
+  //  - num_shards: the number of independently-locked shards; must be > 0.
+  QueryCache(size_t byte_budget, int num_shards);
+  virtual ~QueryCache();
+
+  // Builds the cache key for a query.  The terms are sorted so that
+  // "foo bar" and "bar foo" share an entry; ranks are sums over terms, so
+  // the order of the terms doesn't affect the results.
+  static std::string NormalizeKey(const std::vector<std::string>& terms);
+
+  // Fingerprints a set of index files by name, size and modification time,
+  // so that rebuilding an index in place is noticed as a change.
+  static uint64_t ComputeIndexFingerprint(
+      const std::list<std::string>& indices);
+
+  // Records the fingerprint of the currently-loaded index files.  If it
+  // differs from the previous fingerprint, the generation is advanced and
+  // all existing entries become stale.
+  void SetIndexFingerprint(uint64_t fingerprint);
+
+  // Returns the current index generation.
+  uint64_t generation() const { return generation_.load(); }
+
+  // Looks up "key" in the cache.  Returns true and copies the entry into
+  // the output parameter "entry" on a hit; returns false on a miss.  A hit
+  // moves the entry to the front of its shard's LRU list.
+  bool Lookup(const std::string& key, uint64_t generation,
+              Entry* const entry);
+
+  // Inserts (or replaces) the entry for "key", evicting least-recently-used
+  // entries from the shard until it is back under budget.  The insert is
+  // silently dropped if "generation" is older than the current generation,
+  // or if the entry alone is larger than a shard's budget.
+  void Insert(const std::string& key, uint64_t generation,
+              const Entry& entry);
+
+  // Drops every entry in the cache.
+  void Clear();
+
+  // Counters, for monitoring.
+  uint64_t hits() const { return hits_.load(); }
+  uint64_t misses() const { return misses_.load(); }
+  uint64_t evictions() const { return evictions_.load(); }
+  size_t bytes_used() const;
+
+ private:
+  struct Shard {
+    typedef std::list<std::pair<std::string, Entry>> LruList;
+
+    pthread_mutex_t lock;
+    uint64_t        generation;
+    size_t          bytes;
+    LruList         lru;  // most recently used at the front
+    std::unordered_map<std::string, LruList::iterator> map;
+  };
+
+  // Returns the number of bytes we charge against the budget for an entry.
+  static size_t EntryBytes(const std::string& key, const Entry& entry);
+
+  // Returns the shard responsible for "key".
+  Shard* ShardFor(const std::string& key);
+
+  // Brings a locked shard up to "generation", discarding older entries.
+  // Returns false if "generation" is older than the shard's.
+  bool SyncGeneration(Shard* shard, uint64_t generation);
+
+  // Empties a locked shard.
+  void ClearShard(Shard* shard);
+
+  size_t shard_budget_;
+  int num_shards_;
+  Shard* shards_;
+
+  pthread_mutex_t fingerprint_lock_;
+  uint64_t fingerprint_;
+  std::atomic<uint64_t> generation_;
+
+  std::atomic<uint64_t> hits_;
+  std::atomic<uint64_t> misses_;
+  std::atomic<uint64_t> evictions_;
+
+  DISALLOW_COPY_AND_ASSIGN(QueryCache);
+};
+
+}  // namespace hw4
+
+#endif  // HW4_QUERYCACHE_H_
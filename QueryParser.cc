@@ -0,0 +1,419 @@
+/*
+ * Copyright ©2024 Hannah C. Tang.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Washington
+ * CSE 333 for use solely during Spring Quarter 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+
+#include "./QueryParser.h"
+
+#include <ctype.h>   // for isalpha(), isspace(), etc.
+#include <algorithm>
+#include <cstdlib>   // for atoi()
+#include <string>
+#include <vector>
+
+using std::string;
+using std::vector;
+
+namespace hw3 {
+
+// A lexical token of a query.
+typedef struct {
+  enum Type {
+    kWord,        // "words" holds the word, as typed.
+    kPhrase,      // "words" holds the (lowercased) words of the phrase.
+    kOpenParen,
+    kCloseParen,
+    kOrOperator,
+    kAndOperator,
+    kNotOperator,
+  } type;
+  vector<string> words;
+} Token;
+
+// Splits "text" into Tokens.
+static vector<Token> Tokenize(const string& text);
+
+// Recursive descent parsers for the grammar
+//
+//   or    := and ( OR and )*
+//   and   := unary ( [AND] unary )*
+//   unary := ( NOT | - ) unary | primary
+//   primary := ( or ) | "phrase" | word [ NEAR/k word ] | pattern
+//
+// Each parses from tokens[*pos], advancing *pos past what it consumed,
+// and returns false if it didn't produce a clause (e.g., because of
+// empty parentheses or a dangling operator).
+static bool ParseOr(const vector<Token>& tokens, size_t* const pos,
+                    QueryNode* const node);
+static bool ParseAnd(const vector<Token>& tokens, size_t* const pos,
+                     QueryNode* const node);
+static bool ParseUnary(const vector<Token>& tokens, size_t* const pos,
+                       QueryNode* const node);
+static bool ParsePrimary(const vector<Token>& tokens, size_t* const pos,
+                         QueryNode* const node);
+
+// Returns true if "word" is a NEAR/k operator (in either case), in which
+// case k is returned through "distance".
+static bool IsNearOperator(const string& word, int* const distance);
+
+// Returns true if "word" is a wildcard pattern, i.e., contains a '*' or
+// '?'.
+static bool IsPattern(const string& word);
+
+// Returns "word" converted to lowercase.
+static string Lowercase(const string& word);
+
+// Returns a kTerm node for "word".
+static QueryNode MakeTerm(const string& word);
+
+// Returns a kAnd or kOr node of "children", collapsing it into its only
+// child if there is just one.
+static QueryNode MakeGroup(QueryNode::Kind kind,
+                           const vector<QueryNode>& children);
+
+// Returns the canonical string for "node"; a "nested" kAnd or kOr is
+// wrapped in parentheses.
+static string NodeToString(const QueryNode& node, bool nested);
+
+string QueryNode::ToString() const {
+  // ParseQuery() wraps a lone kOr in a kAnd; don't parenthesize it.
+  if (kind == kAnd && children.size() == 1) {
+    return NodeToString(children[0], false);
+  }
+  return NodeToString(*this, false);
+}
+
+QueryNode ParseQuery(const string& text) {
+  vector<Token> tokens = Tokenize(text);
+
+  // Parse as many ORs as we can, skipping over any closing parentheses
+  // that don't match an opening one.
+  vector<QueryNode> clauses;
+  size_t pos = 0;
+  while (pos < tokens.size()) {
+    QueryNode clause;
+    if (ParseOr(tokens, &pos, &clause)) {
+      clauses.push_back(clause);
+    }
+    if (pos < tokens.size()) {
+      pos++;
+    }
+  }
+
+  QueryNode query = MakeGroup(QueryNode::kAnd, clauses);
+  if (query.kind != QueryNode::kAnd) {
+    QueryNode root;
+    root.kind = QueryNode::kAnd;
+    root.children.push_back(query);
+    return root;
+  }
+  return query;
+}
+
+static vector<Token> Tokenize(const string& text) {
+  vector<Token> tokens;
+  size_t i = 0;
+  while (i < text.size()) {
+    unsigned char c = text[i];
+    Token token;
+    if (isspace(c)) {
+      i++;
+      continue;
+    }
+
+    if (c == '(' || c == ')') {
+      token.type = c == '(' ? Token::kOpenParen : Token::kCloseParen;
+      tokens.push_back(token);
+      i++;
+      continue;
+    }
+
+    if (c == '-') {
+      // A leading '-' negates whatever follows it; on its own, it's
+      // ignored.
+      if (i + 1 < text.size() &&
+          !isspace(static_cast<unsigned char>(text[i + 1]))) {
+        token.type = Token::kNotOperator;
+        tokens.push_back(token);
+      }
+      i++;
+      continue;
+    }
+
+    if (c == '"') {
+      // A phrase runs to the closing quote, or the end of the text.
+      size_t end = text.find('"', i + 1);
+      if (end == string::npos) {
+        end = text.size();
+      }
+      token.type = Token::kPhrase;
+      string word;
+      for (size_t j = i + 1; j <= end; j++) {
+        if (j < end && isalpha(static_cast<unsigned char>(text[j]))) {
+          word.push_back(tolower(static_cast<unsigned char>(text[j])));
+        } else if (!word.empty()) {
+          token.words.push_back(word);
+          word.clear();
+        }
+      }
+      tokens.push_back(token);
+      i = end + 1;
+      continue;
+    }
+
+    // A word runs to the next whitespace, quote or parenthesis.
+    string word;
+    while (i < text.size() && text[i] != '"' && text[i] != '(' &&
+           text[i] != ')' && !isspace(static_cast<unsigned char>(text[i]))) {
+      word.push_back(text[i]);
+      i++;
+    }
+    if (word == "OR") {
+      token.type = Token::kOrOperator;
+    } else if (word == "AND") {
+      token.type = Token::kAndOperator;
+    } else if (word == "NOT") {
+      token.type = Token::kNotOperator;
+    } else {
+      token.type = Token::kWord;
+      token.words.push_back(word);
+    }
+    tokens.push_back(token);
+  }
+  return tokens;
+}
+
+static bool ParseOr(const vector<Token>& tokens, size_t* const pos,
+                    QueryNode* const node) {
+  vector<QueryNode> alternatives;
+  while (*pos < tokens.size()) {
+    QueryNode alternative;
+    if (ParseAnd(tokens, pos, &alternative)) {
+      if (alternative.kind == QueryNode::kOr) {
+        alternatives.insert(alternatives.end(),
+                            alternative.children.begin(),
+                            alternative.children.end());
+      } else {
+        alternatives.push_back(alternative);
+      }
+    }
+    if (*pos >= tokens.size() || tokens[*pos].type != Token::kOrOperator) {
+      break;
+    }
+    (*pos)++;
+  }
+
+  if (alternatives.empty()) {
+    return false;
+  }
+  *node = MakeGroup(QueryNode::kOr, alternatives);
+  return true;
+}
+
+static bool ParseAnd(const vector<Token>& tokens, size_t* const pos,
+                     QueryNode* const node) {
+  vector<QueryNode> clauses;
+  while (*pos < tokens.size() &&
+         tokens[*pos].type != Token::kOrOperator &&
+         tokens[*pos].type != Token::kCloseParen) {
+    if (tokens[*pos].type == Token::kAndOperator) {
+      (*pos)++;
+      continue;
+    }
+
+    QueryNode clause;
+    if (ParseUnary(tokens, pos, &clause)) {
+      if (clause.kind == QueryNode::kAnd) {
+        clauses.insert(clauses.end(), clause.children.begin(),
+                       clause.children.end());
+      } else {
+        clauses.push_back(clause);
+      }
+    }
+  }
+
+  if (clauses.empty()) {
+    return false;
+  }
+  *node = MakeGroup(QueryNode::kAnd, clauses);
+  return true;
+}
+
+static bool ParseUnary(const vector<Token>& tokens, size_t* const pos,
+                       QueryNode* const node) {
+  if (tokens[*pos].type != Token::kNotOperator) {
+    return ParsePrimary(tokens, pos, node);
+  }
+
+  (*pos)++;
+  QueryNode operand;
+  if (*pos >= tokens.size() || tokens[*pos].type == Token::kOrOperator ||
+      tokens[*pos].type == Token::kCloseParen ||
+      !ParseUnary(tokens, pos, &operand)) {
+    return false;
+  }
+
+  if (operand.kind == QueryNode::kNot) {
+    // Two wrongs make a right.
+    *node = operand.children[0];
+  } else {
+    node->kind = QueryNode::kNot;
+    node->children.push_back(operand);
+  }
+  return true;
+}
+
+static bool ParsePrimary(const vector<Token>& tokens, size_t* const pos,
+                         QueryNode* const node) {
+  const Token& token = tokens[(*pos)++];
+  switch (token.type) {
+    case Token::kOpenParen: {
+      // A group runs to the closing parenthesis, or the end of the text.
+      bool parsed = ParseOr(tokens, pos, node);
+      if (*pos < tokens.size() && tokens[*pos].type == Token::kCloseParen) {
+        (*pos)++;
+      }
+      return parsed;
+    }
+
+    case Token::kPhrase:
+      if (token.words.size() == 1) {
+        *node = MakeTerm(token.words[0]);
+        return true;
+      }
+      node->kind = QueryNode::kPhrase;
+      node->words = token.words;
+      return token.words.size() > 1;
+
+    case Token::kWord: {
+      if (IsPattern(token.words[0])) {
+        // A pattern has to pin down at least one letter; "*" on its own
+        // would match every word in the index.
+        const string& word = token.words[0];
+        if (std::none_of(word.begin(), word.end(), [](char c) {
+              return isalpha(static_cast<unsigned char>(c));
+            })) {
+          return false;
+        }
+        node->kind = QueryNode::kWildcard;
+        node->words.push_back(Lowercase(word));
+        return true;
+      }
+
+      // Fold "word NEAR/k word" into a single clause.
+      int distance;
+      if (*pos + 1 < tokens.size() &&
+          tokens[*pos].type == Token::kWord &&
+          tokens[*pos + 1].type == Token::kWord &&
+          !IsPattern(tokens[*pos + 1].words[0]) &&
+          IsNearOperator(tokens[*pos].words[0], &distance)) {
+        node->kind = QueryNode::kNear;
+        node->words.push_back(Lowercase(token.words[0]));
+        node->words.push_back(Lowercase(tokens[*pos + 1].words[0]));
+        node->distance = distance;
+        *pos += 2;
+        return true;
+      }
+      *node = MakeTerm(Lowercase(token.words[0]));
+      return true;
+    }
+
+    default:
+      // A stray operator; ignore it.
+      return false;
+  }
+}
+
+static bool IsNearOperator(const string& word, int* const distance) {
+  static const string kPrefix = "near/";
+  if (word.size() <= kPrefix.size() ||
+      Lowercase(word.substr(0, kPrefix.size())) != kPrefix ||
+      word.size() > kPrefix.size() + 4) {
+    return false;
+  }
+  for (size_t i = kPrefix.size(); i < word.size(); i++) {
+    if (!isdigit(static_cast<unsigned char>(word[i]))) {
+      return false;
+    }
+  }
+  *distance = atoi(word.c_str() + kPrefix.size());
+  return true;
+}
+
+static bool IsPattern(const string& word) {
+  return word.find_first_of("*?") != string::npos;
+}
+
+static string Lowercase(const string& word) {
+  string ret(word);
+  for (char& c : ret) {
+    c = tolower(static_cast<unsigned char>(c));
+  }
+  return ret;
+}
+
+static QueryNode MakeTerm(const string& word) {
+  QueryNode term;
+  term.kind = QueryNode::kTerm;
+  term.words.push_back(word);
+  return term;
+}
+
+static QueryNode MakeGroup(QueryNode::Kind kind,
+                           const vector<QueryNode>& children) {
+  if (children.size() == 1) {
+    return children[0];
+  }
+  QueryNode group;
+  group.kind = kind;
+  group.children = children;
+  return group;
+}
+
+static string NodeToString(const QueryNode& node, bool nested) {
+  switch (node.kind) {
+    case QueryNode::kTerm:
+    case QueryNode::kWildcard:
+      return node.words[0];
+
+    case QueryNode::kPhrase: {
+      string ret = "\"";
+      for (size_t i = 0; i < node.words.size(); i++) {
+        ret += (i == 0 ? "" : " ") + node.words[i];
+      }
+      return ret + "\"";
+    }
+
+    case QueryNode::kNear:
+      return node.words[0] + " near/" + std::to_string(node.distance) + " " +
+        node.words[1];
+
+    case QueryNode::kNot:
+      return "-" + NodeToString(node.children[0], true);
+
+    case QueryNode::kAnd:
+    case QueryNode::kOr:
+    default: {
+      vector<string> clauses;
+      for (const QueryNode& child : node.children) {
+        clauses.push_back(NodeToString(child, true));
+      }
+      std::sort(clauses.begin(), clauses.end());
+      string separator = node.kind == QueryNode::kOr ? " OR " : " ";
+      string ret;
+      for (size_t i = 0; i < clauses.size(); i++) {
+        ret += (i == 0 ? "" : separator) + clauses[i];
+      }
+      return nested ? "(" + ret + ")" : ret;
+    }
+  }
+}
+
+}  // namespace hw3
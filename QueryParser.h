@@ -0,0 +1,102 @@
+/*
+ * Copyright ©2024 Hannah C. Tang.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Washington
+ * CSE 333 for use solely during Spring Quarter 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#ifndef HW3_QUERYPARSER_H_
+#define HW3_QUERYPARSER_H_
+
+#include <string>
+#include <vector>
+
+using std::string;
+using std::vector;
+
+namespace hw3 {
+
+// A parsed query.  Queries are trees: the leaves match words or sequences
+// of words within a document, and the interior nodes combine their
+// children's matches.
+class QueryNode {
+ public:
+  enum Kind {
+    // A single word.
+    kTerm,
+
+    // A quoted phrase: all of "words", consecutively and in order.
+    kPhrase,
+
+    // words[0] NEAR/distance words[1]: both words, with at most "distance"
+    // other words between them, in either order.
+    kNear,
+
+    // Any word matching the pattern words[0], in which '*' matches any
+    // run of characters and '?' matches any single character.
+    kWildcard,
+
+    // Every one of "children".
+    kAnd,
+
+    // Any of "children".
+    kOr,
+
+    // Not children[0].  Since there's no list of every document to take
+    // the complement of, a kNot only excludes documents from the other
+    // clauses of the kAnd it belongs to; anywhere else, it matches
+    // nothing.
+    kNot,
+  };
+
+  QueryNode() : kind(kAnd), distance(0) { }
+
+  // Returns a canonical string for the query, suitable for use as a cache
+  // key: the children of a kAnd or kOr are sorted, since their order
+  // doesn't affect the results.
+  string ToString() const;
+
+  Kind            kind;
+  vector<string>  words;     // kTerm, kPhrase, kNear and kWildcard only.
+  int             distance;  // kNear only.
+  vector<QueryNode> children;  // kAnd, kOr and kNot only.
+};
+
+// Parses a query typed by a user.  The syntax is a whitespace-separated
+// list of clauses, all of which must match:
+//
+//   - word: matches documents containing the word.
+//   - "some words": matches documents containing the phrase.  Like the
+//     indexer, phrases split words on non-alphabetic characters.  The
+//     index only records byte offsets, so words separated by more than
+//     two non-alphabetic characters don't count as a phrase.
+//   - word NEAR/k word: matches documents containing both words with
+//     roughly at most k other words between them, estimated from the
+//     bytes between them.
+//   - pattern: a word containing '*' (any run of characters) or '?' (any
+//     single character), such as data* or wom?n, matches documents
+//     containing any word that matches the pattern.  A pattern without a
+//     letter in it is ignored.
+//   - clause OR clause: matches documents matching either clause.  OR
+//     binds more loosely than the implicit AND between clauses, so
+//     "a b OR c" means "(a b) OR c".
+//   - NOT clause, or -clause: excludes documents matching the clause.
+//   - ( clauses ): groups clauses.
+//
+// OR, AND (which is implied, but allowed) and NOT are only operators when
+// written in uppercase; everything else is converted to lowercase.
+// Parsing is lenient, since queries come straight from a search box: an
+// unterminated quote or parenthesis runs to the end of the query, stray
+// closing parentheses and dangling operators are ignored, and a NEAR/k
+// that isn't between two words is treated as an ordinary word.  The
+// result is always a kAnd; a query with no words parses to a kAnd with no
+// children.
+QueryNode ParseQuery(const string& text);
+
+}  // namespace hw3
+
+#endif  // HW3_QUERYPARSER_H_
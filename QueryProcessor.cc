@@ -11,15 +11,28 @@
 
 #include "./QueryProcessor.h"
 
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <time.h>
+#include <unistd.h>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
 #include <iostream>
 #include <algorithm>
+#include <functional>
+#include <limits>
 #include <list>
+#include <memory>
+#include <queue>
 #include <string>
 #include <vector>
 
 extern "C" {
   #include "./libhw1/CSE333.h"
 }
+#include "./BM25.h"
+#include "./FlatHashMap.h"
 
 using std::list;
 using std::sort;
@@ -28,34 +41,127 @@ using std::vector;
 
 namespace hw3 {
 
-// creates DocIDTableReader* array by searching for query
-// in index tables from itr_array.
-// takes query to search index tables, itr_array to access
-// all index tables, array_len for length of itr_array, and
-// docidtr_array to store the output resulting DocIDTableReader*.
-// returns list of offsets for the element fields in hash value bucket.
-//  returns empty list if not elements in bucket.
-static void createDocidtrArray(const std::string& query,
-  IndexTableReader** itr_array, const int& array_len,
-  vector<DocIDTableReader*>* docidtr_array);
-
-// creates QueryResult array by searching docidtr_array for DocID table headers
-// and looking for the DocID in the doc tables to get rank.
-// take docidtr_array to get pointers to DocIDTableReader and
-// doctr_array to access all DocTables.
-// returns array of query results withDocID and rank.
-static vector<QueryProcessor::QueryResult> getQueryResults(
-  const vector<DocIDTableReader*>& docidtr_array, DocTableReader** doctr_array);
-
-QueryProcessor::QueryProcessor(const list<string>& index_list, bool validate) {
+// Phrase words must be separated by at most this many bytes.  The index
+// stores byte offsets rather than word numbers, but FileParser splits
+// words on every non-alphabetic character, so a word in between would
+// take at least three bytes: a separator, a letter, and another separator.
+// That makes a match certain to be a real phrase, but not every real
+// phrase matches: words separated by more than two non-alphabetic
+// characters, such as "white,  whale", "white -- whale", or a line break
+// followed by indentation, are missed.
+static constexpr int64_t kMaxPhraseGapBytes = 2;
+
+// NEAR/k can't count words either, so it allows this many bytes for each
+// intervening word: roughly an average English word plus its separator.
+// It therefore matches some words more than k words apart and misses some
+// that are closer, when the words in between are unusually short or long.
+// NEAR/0 has the same false negatives as a two-word phrase, but matches
+// the words in either order.
+static constexpr int64_t kNearBytesPerWord = 6;
+
+// Looking a document up in a word's docID table costs roughly this many
+// times as much as reading one of the table's entries sequentially.  When
+// a kAnd has fewer than 1/kProbeCost as many candidate documents left as a
+// word has documents, the word's table is probed rather than read.
+static constexpr int64_t kProbeCost = 4;
+
+// Returns the current time, in nanoseconds, for QueryTimings.
+static int64_t NowNanos() {
+  struct timespec ts;
+  Verify333(clock_gettime(CLOCK_MONOTONIC, &ts) == 0);
+  return static_cast<int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+typedef QueryProcessor::QueryExplain QueryExplain;
+
+// Measures the phases of a query for a QueryExplain.  Each measurement
+// takes a couple of system calls, so the time they take is kept off the
+// books, as are the reads of the kernel's I/O counters; nested phases
+// (a word's lookup within an index's evaluation) therefore don't inflate
+// each other.  The static methods do nothing for a null QueryExplainer,
+// so that the query code can call them whether or not it's explaining.
+class QueryExplainer {
+ public:
+  // A point in the query to measure a phase's cost from.
+  typedef QueryExplain::Cost Mark;
+
+  // Starts explaining a query over the index files "index_list" into
+  // "explain".
+  QueryExplainer(QueryExplain* const explain,
+                 const list<string>& index_list);
+  ~QueryExplainer();
+
+  // Returns the current point in the query, or a zero Mark if "explainer"
+  // is null.
+  static Mark Start(QueryExplainer* const explainer);
+
+  // Returns the cost since "*mark", and moves "*mark" up to now; or a zero
+  // Cost if "explainer" is null.
+  static QueryExplain::Cost Lap(QueryExplainer* const explainer,
+                                Mark* const mark);
+
+  // Adds the cost since "*start" to a phase of "term" in index file
+  // "index", along with the number of docID table entries it read, and
+  // moves "*start" up to now.
+  static void AddTermCost(QueryExplainer* const explainer, Mark* const start,
+                          int index, const string& term,
+                          QueryExplain::Cost QueryExplain::Term::* phase,
+                          int64_t postings_read = 0);
+
+  // Records the number of documents "term" has in index file "index".
+  static void SetTermPostings(QueryExplainer* const explainer, int index,
+                              const string& term, int64_t postings);
+
+  // Records that the pattern "term" was truncated in index file "index".
+  static void SetTermTruncated(QueryExplainer* const explainer, int index,
+                               const string& term);
+
+ private:
+  // Returns the current point in the query.
+  Mark Now();
+
+  // Returns "term"'s entry, adding it if it's new.
+  QueryExplain::Term* TermFor(int index, const string& term);
+
+  QueryExplain* explain_;
+  int io_fd_;              // this thread's /proc/thread-self/io, or -1.
+  int64_t own_nanos_;      // time spent measuring.
+  int64_t own_reads_;      // read()s of io_fd_.
+  int64_t own_bytes_;      // bytes they returned.
+};
+
+// Adds "cost" to "*total".
+static void AddCost(const QueryExplain::Cost& cost,
+                    QueryExplain::Cost* const total);
+
+// Returns "cost" as human-readable text.
+static string FormatCost(const QueryExplain::Cost& cost, bool io_counted);
+
+// Returns the index of the first element of "positions", at or after
+// index "from", that is >= "target"; or positions.size() if there is none.
+// Gallops forward from "from" before binary searching, so sweeping a
+// cursor through a list costs time logarithmic in the distances skipped
+// rather than linear in the list length.
+static size_t GallopTo(const vector<DocPositionOffset_t>& positions,
+                       size_t from, int64_t target);
+
+// Reads the positions of "doc_id" out of "ditr" into "positions".
+static void ReadPositions(DocIDTableReader* ditr, DocID_t doc_id,
+                          vector<DocPositionOffset_t>* const positions);
+
+QueryProcessor::QueryProcessor(const list<string>& index_list, bool validate,
+                               RankingMode ranking_mode)
+  : ranking_mode_(ranking_mode) {
   // Stash away a copy of the index list.
   index_list_ = index_list;
+  index_names_ = index_list;
   array_len_ = index_list_.size();
   Verify333(array_len_ > 0);
 
   // Create the arrays of DocTableReader*'s. and IndexTableReader*'s.
   dtr_array_ = new DocTableReader* [array_len_];
   itr_array_ = new IndexTableReader* [array_len_];
+  position_readers_ = new FlatHashMap<string, DocIDTableReader*>[array_len_];
 
   // Populate the arrays with heap-allocated DocTableReader and
   // IndexTableReader object instances.
@@ -64,10 +170,46 @@ QueryProcessor::QueryProcessor(const list<string>& index_list, bool validate) {
     FileIndexReader fir(*idx_iterator, validate);
     dtr_array_[i] = fir.NewDocTableReader();
     itr_array_[i] = fir.NewIndexTableReader();
+    tdr_array_.push_back(fir.NewTermDictReader());
+    if (ranking_mode_ == kRankByBM25) {
+      LoadBM25Stats(fir);
+    }
     idx_iterator++;
   }
 }
 
+void QueryProcessor::LoadBM25Stats(const FileIndexReader& fir) {
+  tbr_array_.push_back(fir.NewTermBoundTableReader());
+
+  DocLengthTableReader* dltr = fir.NewDocLengthTableReader();
+  if (dltr == nullptr) {
+    // Without document lengths, every document is treated as being of
+    // average length.
+    num_docs_.push_back(dtr_array_[num_docs_.size()]->NumDocs());
+    length_norms_.emplace_back();
+    return;
+  }
+
+  // Precompute each document's length normalization term, so that
+  // scoring a posting is a handful of float operations.
+  num_docs_.push_back(dltr->NumDocs());
+  length_norms_.emplace_back();
+  vector<float>& norms = length_norms_.back();
+  double avg_length = dltr->AverageDocLength();
+  for (int i = 0; i < dltr->MaxDocID(); i++) {
+    norms.push_back(BM25LengthNorm(dltr->DocLength(i + 1), avg_length));
+  }
+  delete dltr;
+}
+
+float QueryProcessor::LengthNorm(int index, DocID_t doc_id) const {
+  const vector<float>& norms = length_norms_[index];
+  if (doc_id >= 1 && doc_id <= norms.size()) {
+    return norms[doc_id - 1];
+  }
+  return kBM25K1;
+}
+
 QueryProcessor::~QueryProcessor() {
   // Delete the heap-allocated DocTableReader and IndexTableReader
   // object instances.
@@ -83,90 +225,1005 @@ QueryProcessor::~QueryProcessor() {
   delete[] itr_array_;
   dtr_array_ = nullptr;
   itr_array_ = nullptr;
+
+  for (TermBoundTableReader* tbr : tbr_array_) {
+    delete tbr;
+  }
+  for (TermDictReader* tdr : tdr_array_) {
+    delete tdr;
+  }
+  for (int i = 0; i < array_len_; i++) {
+    position_readers_[i].ForEach([](const string&, DocIDTableReader* ditr) {
+      delete ditr;
+    });
+  }
+  delete[] position_readers_;
 }
 
-// This structure is used to store a index-file-specific query result.
-typedef struct {
-  DocID_t doc_id;  // The document ID within the index file.
-  int     rank;    // The rank of the result so far.
-} IdxQueryResult;
+void QueryProcessor::set_index_names(const list<string>& index_names) {
+  Verify333(index_names.size() == index_list_.size());
+  index_names_ = index_names;
+}
 
 vector<QueryProcessor::QueryResult>
 QueryProcessor::ProcessQuery(const vector<string>& query) const {
   Verify333(query.size() > 0);
 
-  // STEP 1.
-  // (the only step in this file)
-  vector<QueryProcessor::QueryResult> final_result;
-
-  vector<DocIDTableReader*> docidtr_array;
-  createDocidtrArray(query.front(), itr_array_, array_len_, &docidtr_array);
-
-  final_result = getQueryResults(docidtr_array, dtr_array_);
-  docidtr_array.clear();
-  int query_size = static_cast<int>(query.size());
-  for (int i = 1; i < query_size; i++) {
-    createDocidtrArray(query[i], itr_array_, array_len_, &docidtr_array);
-
-    vector<QueryProcessor::QueryResult> curr_res =
-      getQueryResults(docidtr_array, dtr_array_);
-    docidtr_array.clear();
-
-    for (auto it = final_result.begin(); it != final_result.end(); ) {
-      bool wasFound = false;
-      for (QueryProcessor::QueryResult curr_query : curr_res) {
-        if (it->document_name == curr_query.document_name) {
-          it->rank += curr_query.rank;
-          wasFound = true;
-          it++;
-          break;
+  // Every word is a separate clause.
+  QueryNode node;
+  node.kind = QueryNode::kAnd;
+  for (const string& word : query) {
+    QueryNode term;
+    term.kind = QueryNode::kTerm;
+    term.words.push_back(word);
+    node.children.push_back(term);
+  }
+  return ProcessQuery(node);
+}
+
+vector<QueryProcessor::QueryResult>
+QueryProcessor::ProcessQuery(const QueryNode& query,
+                             QueryTimings* const timings,
+                             QueryExplain* const explain,
+                             vector<string>* const truncated) const {
+  int64_t start = timings != nullptr ? NowNanos() : 0;
+  std::unique_ptr<QueryExplainer> explainer;
+  if (explain != nullptr) {
+    explainer.reset(new QueryExplainer(explain, index_names_));
+  }
+  QueryExplainer::Mark query_start = QueryExplainer::Start(explainer.get());
+  vector<QueryMatch> matches = MatchQuery(query, truncated, explain,
+                                          explainer.get());
+
+  // Look up the names of the matching documents an index file at a time,
+  // so that each index's share of the lookups can be explained.
+  int64_t resolve_start = timings != nullptr ? NowNanos() : 0;
+  vector<vector<size_t>> by_index(array_len_);
+  for (size_t j = 0; j < matches.size(); j++) {
+    by_index[matches[j].index].push_back(j);
+  }
+  vector<QueryProcessor::QueryResult> final_result(matches.size());
+  for (int i = 0; i < array_len_; i++) {
+    QueryExplainer::Mark mark = QueryExplainer::Start(explainer.get());
+    for (size_t j : by_index[i]) {
+      final_result[j].document_name = LookupDocName(matches[j]);
+      final_result[j].rank = matches[j].rank;
+      final_result[j].score = matches[j].score;
+    }
+    if (explain != nullptr) {
+      explain->indices[i].resolve = QueryExplainer::Lap(explainer.get(),
+                                                        &mark);
+    }
+  }
+  if (explain != nullptr) {
+    explain->total = QueryExplainer::Lap(explainer.get(), &query_start);
+  }
+  if (timings != nullptr) {
+    timings->evaluate_nanos = resolve_start - start;
+    timings->resolve_nanos = NowNanos() - resolve_start;
+  }
+  return final_result;
+}
+
+vector<QueryProcessor::QueryMatch>
+QueryProcessor::MatchQuery(const QueryNode& query,
+                           vector<string>* const truncated) const {
+  return MatchQuery(query, truncated, nullptr, nullptr);
+}
+
+vector<QueryProcessor::QueryMatch>
+QueryProcessor::MatchQuery(const QueryNode& query,
+                           vector<string>* const truncated,
+                           QueryExplain* const explain,
+                           QueryExplainer* const explainer) const {
+  vector<QueryMatch> matches;
+  if (truncated != nullptr) {
+    truncated->clear();
+  }
+  for (int i = 0; i < array_len_; i++) {
+    QueryExplainer::Mark mark = QueryExplainer::Start(explainer);
+    vector<IdxQueryResult> idx_results;
+    IndexLookups lookups;
+    EvaluateQuery(i, query, &idx_results, &lookups, explainer);
+    if (truncated != nullptr) {
+      AddTruncatedWildcards(&lookups, truncated);
+    }
+    QueryExplain::Cost evaluate_cost = QueryExplainer::Lap(explainer, &mark);
+    sort(idx_results.begin(), idx_results.end(),
+         [](const IdxQueryResult& a, const IdxQueryResult& b) {
+           return a.doc_id < b.doc_id;
+         });
+    for (const IdxQueryResult& idx_result : idx_results) {
+      matches.push_back({ i, idx_result.doc_id, idx_result.rank,
+                          idx_result.score });
+    }
+    if (explainer != nullptr) {
+      explain->indices[i].results = idx_results.size();
+      explain->indices[i].evaluate = evaluate_cost;
+      AddCost(QueryExplainer::Lap(explainer, &mark), &explain->sort);
+    }
+  }
+
+  // Sort the matches, keeping ties in index and docID order.
+  QueryExplainer::Mark sort_start = QueryExplainer::Start(explainer);
+  if (ranking_mode_ == kRankByBM25) {
+    std::stable_sort(matches.begin(), matches.end(),
+                     [](const QueryMatch& a, const QueryMatch& b) {
+                       return a.score > b.score;
+                     });
+  } else {
+    std::stable_sort(matches.begin(), matches.end(),
+                     [](const QueryMatch& a, const QueryMatch& b) {
+                       return a.rank > b.rank;
+                     });
+  }
+  if (explainer != nullptr) {
+    AddCost(QueryExplainer::Lap(explainer, &sort_start), &explain->sort);
+  }
+  return matches;
+}
+
+string QueryProcessor::LookupDocName(const QueryMatch& match) const {
+  Verify333(match.index >= 0 && match.index < array_len_);
+  string name;
+  Verify333(dtr_array_[match.index]->LookupDocID(match.doc_id, &name));
+  return name;
+}
+
+bool QueryProcessor::LookupPositions(
+    const QueryMatch& match, const string& word,
+    vector<DocPositionOffset_t>* const positions) const {
+  Verify333(match.index >= 0 && match.index < array_len_);
+  FlatHashMap<string, DocIDTableReader*>& readers =
+    position_readers_[match.index];
+  DocIDTableReader* ditr;
+  DocIDTableReader* const* cached = readers.Find(word);
+  if (cached != nullptr) {
+    ditr = *cached;
+  } else {
+    ditr = itr_array_[match.index]->LookupWord(word);
+    readers[word] = ditr;
+  }
+  if (ditr == nullptr) {
+    return false;
+  }
+  list<DocPositionOffset_t> position_list;
+  bool found = ditr->LookupDocID(match.doc_id, &position_list);
+  if (found) {
+    positions->assign(position_list.begin(), position_list.end());
+  }
+  return found;
+}
+
+void QueryProcessor::EvaluateQuery(int index, const QueryNode& query,
+                                   vector<IdxQueryResult>* const results,
+                                   IndexLookups* const lookups,
+                                   QueryExplainer* const explainer) const {
+  switch (query.kind) {
+    case QueryNode::kTerm:
+      EvaluateTerm(index, query.words[0], results, lookups, explainer);
+      return;
+
+    case QueryNode::kWildcard: {
+      const vector<IdxQueryResult>& wildcard_results =
+        LookupWildcard(index, query, lookups, explainer).results;
+      results->insert(results->end(), wildcard_results.begin(),
+                      wildcard_results.end());
+      return;
+    }
+
+    case QueryNode::kPhrase:
+    case QueryNode::kNear:
+      EvaluatePositional(index, query, results, lookups, explainer);
+      return;
+
+    case QueryNode::kAnd:
+      EvaluateAnd(index, query, results, lookups, explainer);
+      return;
+
+    case QueryNode::kOr:
+      EvaluateOr(index, query, results, lookups, explainer);
+      return;
+
+    case QueryNode::kNot:
+      // On its own, a kNot has nothing to exclude documents from.
+      return;
+  }
+}
+
+int64_t QueryProcessor::EstimateMatches(int index, const QueryNode& query,
+                                        IndexLookups* const lookups,
+                                        QueryExplainer* const explainer)
+  const {
+  switch (query.kind) {
+    case QueryNode::kTerm:
+      return LookupTerm(index, query.words[0], lookups, explainer).doc_freq;
+
+    case QueryNode::kWildcard:
+      // Counting a wildcard's documents costs nearly as much as finding
+      // them, so find them, and keep them for evaluating the clause.
+      return LookupWildcard(index, query, lookups, explainer).results.size();
+
+    case QueryNode::kPhrase:
+    case QueryNode::kNear: {
+      // A document has to contain every one of the words.
+      int64_t estimate = std::numeric_limits<int64_t>::max();
+      for (const string& word : query.words) {
+        estimate = std::min(estimate,
+                            LookupTerm(index, word, lookups, explainer)
+                            .doc_freq);
+      }
+      return estimate;
+    }
+
+    case QueryNode::kAnd: {
+      int64_t estimate = std::numeric_limits<int64_t>::max();
+      bool has_positive_clause = false;
+      for (const QueryNode& child : query.children) {
+        if (child.kind != QueryNode::kNot) {
+          estimate = std::min(estimate,
+                              EstimateMatches(index, child, lookups,
+                                              explainer));
+          has_positive_clause = true;
         }
       }
+      return has_positive_clause ? estimate : 0;
+    }
 
-      if (!wasFound) {
-        it = final_result.erase(it);
+    case QueryNode::kOr: {
+      int64_t estimate = 0;
+      for (const QueryNode& child : query.children) {
+        estimate += EstimateMatches(index, child, lookups, explainer);
       }
+      return estimate;
     }
+
+    case QueryNode::kNot:
+    default:
+      return 0;
   }
+}
 
-  // Sort the final results.
-  sort(final_result.begin(), final_result.end());
-  return final_result;
+void QueryProcessor::EvaluateAnd(int index, const QueryNode& query,
+                                 vector<IdxQueryResult>* const results,
+                                 IndexLookups* const lookups,
+                                 QueryExplainer* const explainer) const {
+  // Plan the evaluation: the clauses that match the fewest documents go
+  // first, so that the intermediate results stay small; the exclusions go
+  // last, since they can only remove documents.
+  vector<std::pair<int64_t, const QueryNode*>> plan;
+  vector<const QueryNode*> exclusions;
+  for (const QueryNode& child : query.children) {
+    if (child.kind == QueryNode::kNot) {
+      exclusions.push_back(&child.children[0]);
+    } else {
+      plan.push_back({EstimateMatches(index, child, lookups, explainer),
+                      &child});
+    }
+  }
+  if (plan.empty()) {
+    return;
+  }
+  std::stable_sort(plan.begin(), plan.end(),
+                   [](const std::pair<int64_t, const QueryNode*>& a,
+                      const std::pair<int64_t, const QueryNode*>& b) {
+                     return a.first < b.first;
+                   });
+
+  // If any clause can't match, neither can the kAnd.
+  if (plan[0].first == 0) {
+    return;
+  }
+
+  vector<IdxQueryResult> and_results;
+  EvaluateQuery(index, *plan[0].second, &and_results, lookups, explainer);
+  for (size_t i = 1; i < plan.size() && !and_results.empty(); i++) {
+    FilterResults(index, *plan[i].second, plan[i].first, false,
+                  &and_results, lookups, explainer);
+  }
+  for (size_t i = 0; i < exclusions.size() && !and_results.empty(); i++) {
+    FilterResults(index, *exclusions[i],
+                  EstimateMatches(index, *exclusions[i], lookups,
+                                  explainer),
+                  true, &and_results, lookups, explainer);
+  }
+  results->insert(results->end(), and_results.begin(), and_results.end());
 }
 
-static void createDocidtrArray(const std::string& query,
-  IndexTableReader** itr_array, const int& array_len,
-  vector<DocIDTableReader*>* docidtr_array) {
-  for (int i = 0; i < array_len; i++) {
-    docidtr_array->push_back(itr_array[i]->LookupWord(query));
+void QueryProcessor::EvaluateOr(int index, const QueryNode& query,
+                                vector<IdxQueryResult>* const results,
+                                IndexLookups* const lookups,
+                                QueryExplainer* const explainer) const {
+  // Merge the alternatives' matches, summing the ranks and scores of
+  // documents that match more than one.
+  vector<IdxQueryResult> or_results;
+  FlatHashMap<DocID_t, size_t> result_index;
+  for (const QueryNode& child : query.children) {
+    vector<IdxQueryResult> child_results;
+    EvaluateQuery(index, child, &child_results, lookups, explainer);
+    for (const IdxQueryResult& child_result : child_results) {
+      auto inserted =
+        result_index.Insert(child_result.doc_id, or_results.size());
+      if (inserted.second) {
+        or_results.push_back(child_result);
+      } else {
+        or_results[*inserted.first].rank += child_result.rank;
+        or_results[*inserted.first].score += child_result.score;
+      }
+    }
   }
+  results->insert(results->end(), or_results.begin(), or_results.end());
 }
 
-static vector<QueryProcessor::QueryResult> getQueryResults(
-  const vector<DocIDTableReader*>& docidtr_array,
-    DocTableReader** doctr_array) {
-  vector<QueryProcessor::QueryResult> query_result;
-  int count = 0;
+void QueryProcessor::FilterResults(int index, const QueryNode& clause,
+                                   int64_t estimate, bool negate,
+                                   vector<IdxQueryResult>* const results,
+                                   IndexLookups* const lookups,
+                                   QueryExplainer* const explainer) const {
+  if (estimate == 0) {
+    // The clause doesn't match anything.
+    if (!negate) {
+      results->clear();
+    }
+    return;
+  }
+
+  size_t num_kept = 0;
+  if (clause.kind == QueryNode::kTerm &&
+      static_cast<int64_t>(results->size()) * kProbeCost < estimate) {
+    // It's cheaper to look each remaining document up in the word's docID
+    // table than to read the whole table.
+    DocIDTableReader* ditr =
+      LookupTerm(index, clause.words[0], lookups, explainer).reader;
+    Verify333(ditr != nullptr);
+    QueryExplainer::Mark start = QueryExplainer::Start(explainer);
+    int64_t num_probes = results->size();
+    float idf = 0.0f;
+    if (ranking_mode_ == kRankByBM25) {
+      idf = BM25IDF(num_docs_[index], estimate);
+    }
+    for (IdxQueryResult& result : *results) {
+      int32_t num_positions;
+      if (ditr->LookupNumPositions(result.doc_id, &num_positions) == negate) {
+        continue;
+      }
+      if (!negate) {
+        result.rank += num_positions;
+        if (ranking_mode_ == kRankByBM25) {
+          result.score += BM25Score(idf, num_positions,
+                                    LengthNorm(index, result.doc_id));
+        }
+      }
+      (*results)[num_kept++] = result;
+    }
+    results->resize(num_kept);
+    QueryExplainer::AddTermCost(explainer, &start, index, clause.words[0],
+                                &QueryExplain::Term::postings_cost,
+                                num_probes);
+    return;
+  }
+
+  vector<IdxQueryResult> clause_results;
+  EvaluateQuery(index, clause, &clause_results, lookups, explainer);
+  FlatHashMap<DocID_t, const IdxQueryResult*> clause_docs(
+      clause_results.size());
+  for (const IdxQueryResult& clause_result : clause_results) {
+    clause_docs[clause_result.doc_id] = &clause_result;
+  }
 
-  for (DocIDTableReader* docidtr : docidtr_array) {
-    if (docidtr == nullptr) {
-      count++;
+  for (IdxQueryResult& result : *results) {
+    const IdxQueryResult* const* match = clause_docs.Find(result.doc_id);
+    if ((match != nullptr) == negate) {
       continue;
     }
+    if (!negate) {
+      result.rank += (*match)->rank;
+      result.score += (*match)->score;
+    }
+    (*results)[num_kept++] = result;
+  }
+  results->resize(num_kept);
+}
 
-    list<DocIDElementHeader> docidElementHeaderList = docidtr->GetDocIDList();
-    for (DocIDElementHeader docidElementHeader : docidElementHeaderList) {
-      QueryProcessor::QueryResult queryResult;
-      queryResult.rank = docidElementHeader.num_positions;
-      doctr_array[count]->LookupDocID(docidElementHeader.doc_id,
-        &queryResult.document_name);
+void QueryProcessor::EvaluateTerm(int index, const string& word,
+                                  vector<IdxQueryResult>* const results,
+                                  IndexLookups* const lookups,
+                                  QueryExplainer* const explainer) const {
+  DocIDTableReader* ditr = LookupTerm(index, word, lookups, explainer).reader;
+  if (ditr == nullptr) {
+    return;
+  }
+  QueryExplainer::Mark start = QueryExplainer::Start(explainer);
+  list<DocIDElementHeader> headers = ditr->GetDocIDList();
+  QueryExplainer::AddTermCost(explainer, &start, index, word,
+                              &QueryExplain::Term::postings_cost,
+                              headers.size());
+
+  // The word's IDF is the same for every posting in this index, so
+  // compute it once up front.
+  float idf = 0.0f;
+  if (ranking_mode_ == kRankByBM25) {
+    idf = BM25IDF(num_docs_[index], headers.size());
+  }
 
-      query_result.push_back(queryResult);
+  for (const DocIDElementHeader& header : headers) {
+    IdxQueryResult result = {header.doc_id, header.num_positions, 0.0f};
+    if (ranking_mode_ == kRankByBM25) {
+      result.score = BM25Score(idf, header.num_positions,
+                               LengthNorm(index, header.doc_id));
     }
-    count++;
+    results->push_back(result);
+  }
+}
+
+QueryProcessor::TermLookup
+QueryProcessor::LookupTerm(int index, const string& word,
+                           IndexLookups* const lookups,
+                           QueryExplainer* const explainer) const {
+  const TermLookup* found = lookups->terms.Find(word);
+  if (found != nullptr) {
+    return *found;
+  }
+
+  // The document frequency is the number of elements in the word's docID
+  // table, which only takes reading its bucket records.
+  QueryExplainer::Mark start = QueryExplainer::Start(explainer);
+  TermLookup term;
+  term.reader = itr_array_[index]->LookupWord(word);
+  term.doc_freq = term.reader != nullptr ? term.reader->NumDocIDs() : 0;
+  QueryExplainer::AddTermCost(explainer, &start, index, word,
+                              &QueryExplain::Term::lookup);
+  QueryExplainer::SetTermPostings(explainer, index, word, term.doc_freq);
+  lookups->terms[word] = term;
+  return term;
+}
+
+vector<TermDictReader::Term>
+QueryProcessor::ExpandWildcard(int index, const string& pattern,
+                               bool* const truncated) const {
+  vector<TermDictReader::Term> terms;
+  *truncated = false;
+  if (tdr_array_[index] == nullptr) {
+    return terms;
+  }
+  *truncated =
+    !tdr_array_[index]->LookupPattern(pattern, kMaxWildcardTerms, &terms);
+
+  // Visit the words' docID tables in file order.
+  sort(terms.begin(), terms.end(),
+       [](const TermDictReader::Term& a, const TermDictReader::Term& b) {
+         return a.element < b.element;
+       });
+  return terms;
+}
+
+void QueryProcessor::EvaluateWildcard(int index, const string& pattern,
+                                      vector<IdxQueryResult>* const results,
+                                      bool* const truncated,
+                                      QueryExplainer* const explainer) const {
+  QueryExplainer::Mark start = QueryExplainer::Start(explainer);
+  vector<TermDictReader::Term> terms =
+    ExpandWildcard(index, pattern, truncated);
+  QueryExplainer::AddTermCost(explainer, &start, index, pattern,
+                              &QueryExplain::Term::lookup);
+  if (*truncated) {
+    QueryExplainer::SetTermTruncated(explainer, index, pattern);
   }
 
-  return query_result;
+  // Read each matching word's docID table straight from the element the
+  // dictionary points at, merging the postings as EvaluateOr() would.
+  FlatHashMap<DocID_t, size_t> result_index;
+  int64_t num_postings = 0;
+  for (const TermDictReader::Term& term : terms) {
+    DocIDTableReader* ditr = itr_array_[index]->LookupElement(term.element);
+    list<DocIDElementHeader> headers = ditr->GetDocIDList();
+    delete ditr;
+    num_postings += headers.size();
+
+    float idf = 0.0f;
+    if (ranking_mode_ == kRankByBM25) {
+      idf = BM25IDF(num_docs_[index], headers.size());
+    }
+    for (const DocIDElementHeader& header : headers) {
+      float score = 0.0f;
+      if (ranking_mode_ == kRankByBM25) {
+        score = BM25Score(idf, header.num_positions,
+                          LengthNorm(index, header.doc_id));
+      }
+      auto inserted = result_index.Insert(header.doc_id, results->size());
+      if (inserted.second) {
+        results->push_back({header.doc_id, header.num_positions, score});
+      } else {
+        (*results)[*inserted.first].rank += header.num_positions;
+        (*results)[*inserted.first].score += score;
+      }
+    }
+  }
+  QueryExplainer::AddTermCost(explainer, &start, index, pattern,
+                              &QueryExplain::Term::postings_cost,
+                              num_postings);
+  QueryExplainer::SetTermPostings(explainer, index, pattern, num_postings);
+}
+
+const QueryProcessor::WildcardResult& QueryProcessor::LookupWildcard(
+    int index, const QueryNode& clause, IndexLookups* const lookups,
+    QueryExplainer* const explainer) const {
+  WildcardResult* result = lookups->wildcards.Find(&clause);
+  if (result == nullptr) {
+    WildcardResult wildcard_result;
+    EvaluateWildcard(index, clause.words[0], &wildcard_result.results,
+                     &wildcard_result.truncated, explainer);
+    result = &lookups->wildcards[&clause];
+    *result = std::move(wildcard_result);
+  }
+  return *result;
+}
+
+QueryProcessor::IndexLookups::~IndexLookups() {
+  terms.ForEach([](const string&, const TermLookup& term) {
+    delete term.reader;
+  });
+}
+
+void QueryProcessor::AddTruncatedWildcards(IndexLookups* const lookups,
+                                           vector<string>* const truncated) {
+  lookups->wildcards.ForEach([truncated](const QueryNode* clause,
+                                         const WildcardResult& result) {
+    if (result.truncated) {
+      truncated->push_back(clause->words[0]);
+    }
+  });
+  sort(truncated->begin(), truncated->end());
+  truncated->erase(std::unique(truncated->begin(), truncated->end()),
+                   truncated->end());
+}
+
+void QueryProcessor::EvaluatePositional(int index, const QueryNode& clause,
+                                        vector<IdxQueryResult>* const results,
+                                        IndexLookups* const lookups,
+                                        QueryExplainer* const explainer)
+  const {
+  const vector<string>& words = clause.words;
+
+  // If any of the words is missing from the index, nothing can match.
+  // Otherwise, drive the docID intersection from the rarest word.
+  vector<DocIDTableReader*> ditrs;
+  size_t rarest = 0;
+  int64_t rarest_num_docs = 0;
+  for (const string& word : words) {
+    TermLookup term = LookupTerm(index, word, lookups, explainer);
+    if (term.reader == nullptr) {
+      return;
+    }
+    if (ditrs.empty() || term.doc_freq < rarest_num_docs) {
+      rarest = ditrs.size();
+      rarest_num_docs = term.doc_freq;
+    }
+    ditrs.push_back(term.reader);
+  }
+  QueryExplainer::Mark start = QueryExplainer::Start(explainer);
+
+  vector<vector<DocPositionOffset_t>> positions(words.size());
+  int64_t num_postings_read = rarest_num_docs;
+  for (const DocIDElementHeader& header : ditrs[rarest]->GetDocIDList()) {
+    // Make sure the document contains every word before reading any of
+    // the (much larger) position lists.
+    bool in_all = true;
+    for (size_t i = 0; i < ditrs.size() && in_all; i++) {
+      int32_t num_positions;
+      in_all = i == rarest ||
+        ditrs[i]->LookupNumPositions(header.doc_id, &num_positions);
+      num_postings_read += i != rarest;
+    }
+    if (!in_all) {
+      continue;
+    }
+
+    for (size_t i = 0; i < ditrs.size(); i++) {
+      ReadPositions(ditrs[i], header.doc_id, &positions[i]);
+    }
+    int num_matches = clause.kind == QueryNode::kPhrase ?
+      CountPhraseMatches(positions, words) :
+      CountNearMatches(positions[0], positions[1], words[0], words[1],
+                       clause.distance);
+    if (num_matches > 0) {
+      results->push_back({header.doc_id, num_matches, 0.0f});
+    }
+  }
+
+  if (explainer != nullptr) {
+    string clause_str = clause.ToString();
+    QueryExplainer::AddTermCost(explainer, &start, index, clause_str,
+                                &QueryExplain::Term::postings_cost,
+                                num_postings_read);
+    QueryExplainer::SetTermPostings(explainer, index, clause_str,
+                                    results->size());
+  }
+
+  // Score the clause as though it were a single word, whose document
+  // frequency is the number of documents it matched.
+  if (ranking_mode_ == kRankByBM25) {
+    float idf = BM25IDF(num_docs_[index], results->size());
+    for (IdxQueryResult& result : *results) {
+      result.score = BM25Score(idf, result.rank,
+                               LengthNorm(index, result.doc_id));
+    }
+  }
+}
+
+// A query word within one index file, as seen by ProcessQueryTopK().
+typedef struct {
+  DocIDTableReader* ditr;       // the word's docID table.
+  float             idf;        // the word's BM25 IDF.
+  float             max_score;  // the word's stored score bound.
+} TopKTerm;
+
+// A fully-scored document that is a candidate for the top k.
+typedef struct {
+  float   score;   // the document's BM25 score.
+  int     rank;    // the number of occurrences of query words.
+  int     index;   // the index file the document is in.
+  DocID_t doc_id;  // the document ID within that index file.
+} TopKCandidate;
+
+// Orders TopKCandidates so that std::priority_queue keeps the *lowest*
+// score on top, ready to be displaced.
+static bool operator>(const TopKCandidate& a, const TopKCandidate& b) {
+  return a.score > b.score;
+}
+
+vector<QueryProcessor::QueryResult>
+QueryProcessor::ProcessQueryTopK(const vector<string>& query, int k,
+                                 TopKStats* const stats, bool prune) const {
+  Verify333(query.size() > 0);
+  Verify333(k > 0);
+  Verify333(ranking_mode_ == kRankByBM25);
+
+  // With OR semantics, repeating a word shouldn't count it twice.
+  vector<string> words(query);
+  sort(words.begin(), words.end());
+  words.erase(std::unique(words.begin(), words.end()), words.end());
+
+  TopKStats local_stats = {0, 0};
+  std::priority_queue<TopKCandidate, vector<TopKCandidate>,
+                      std::greater<TopKCandidate>> heap;
+  size_t heap_limit = k;
+
+  for (int i = 0; i < array_len_; i++) {
+    vector<TopKTerm> terms;
+    for (const string& word : words) {
+      DocIDTableReader* ditr = itr_array_[i]->LookupWord(word);
+      if (ditr == nullptr) {
+        continue;
+      }
+
+      // Without a stored bound, nothing can be skipped on this word's
+      // behalf.
+      int doc_freq = ditr->NumDocIDs();
+      TopKTerm term = {ditr, BM25IDF(num_docs_[i], doc_freq),
+                       std::numeric_limits<float>::infinity()};
+      if (tbr_array_[i] != nullptr) {
+        tbr_array_[i]->LookupMaxScore(word, &term.max_score);
+      }
+      local_stats.postings_total += doc_freq;
+      terms.push_back(term);
+    }
+
+    // Visit the words with the biggest bounds first; remaining_bound[j] is
+    // the most that words j and later can add to any document's score.
+    sort(terms.begin(), terms.end(),
+         [](const TopKTerm& a, const TopKTerm& b) {
+           return a.max_score > b.max_score;
+         });
+    vector<float> remaining_bound(terms.size() + 1, 0.0f);
+    for (int j = static_cast<int>(terms.size()) - 1; j >= 0; j--) {
+      remaining_bound[j] = remaining_bound[j + 1] + terms[j].max_score;
+    }
+
+    // Documents that have already been scored against every word.
+    FlatHashMap<DocID_t, bool> seen;
+    for (size_t j = 0; j < terms.size(); j++) {
+      // A document we haven't seen yet only contains words j and later,
+      // so if they can't beat the current k'th best score, we're done.
+      if (prune && heap.size() == heap_limit &&
+          remaining_bound[j] <= heap.top().score) {
+        break;
+      }
+
+      for (const DocIDElementHeader& header : terms[j].ditr->GetDocIDList()) {
+        if (!seen.Insert(header.doc_id, true).second) {
+          continue;
+        }
+
+        // Earlier words don't contain this document (or we'd have seen it),
+        // so only the later words need to be checked.
+        float norm = LengthNorm(i, header.doc_id);
+        TopKCandidate candidate = {
+          BM25Score(terms[j].idf, header.num_positions, norm),
+          header.num_positions, i, header.doc_id};
+        local_stats.postings_scored++;
+
+        bool pruned = false;
+        for (size_t l = j + 1; l < terms.size(); l++) {
+          if (prune && heap.size() == heap_limit &&
+              candidate.score + remaining_bound[l] <= heap.top().score) {
+            pruned = true;
+            break;
+          }
+          int32_t num_positions;
+          if (terms[l].ditr->LookupNumPositions(header.doc_id,
+                                                &num_positions)) {
+            candidate.score += BM25Score(terms[l].idf, num_positions, norm);
+            candidate.rank += num_positions;
+            local_stats.postings_scored++;
+          }
+        }
+        if (pruned) {
+          continue;
+        }
+
+        if (heap.size() < heap_limit) {
+          heap.push(candidate);
+        } else if (candidate.score > heap.top().score) {
+          heap.pop();
+          heap.push(candidate);
+        }
+      }
+    }
+
+    for (TopKTerm& term : terms) {
+      delete term.ditr;
+    }
+  }
+
+  // Drain the heap from worst to best, and only now look up the names of
+  // the documents that made the cut.
+  vector<QueryResult> results(heap.size());
+  for (int n = static_cast<int>(heap.size()) - 1; n >= 0; n--) {
+    const TopKCandidate& candidate = heap.top();
+    results[n].rank = candidate.rank;
+    results[n].score = candidate.score;
+    dtr_array_[candidate.index]->LookupDocID(candidate.doc_id,
+                                             &results[n].document_name);
+    heap.pop();
+  }
+
+  if (stats != nullptr) {
+    *stats = local_stats;
+  }
+  return results;
+}
+
+QueryExplainer::QueryExplainer(QueryExplain* const explain,
+                               const list<string>& index_list)
+  : explain_(explain), own_nanos_(0), own_reads_(0), own_bytes_(0) {
+  // The counters are per thread, and the query runs on this one.
+  io_fd_ = open("/proc/thread-self/io", O_RDONLY);
+  explain_->io_counted = io_fd_ != -1;
+  explain_->indices.clear();
+  for (const string& file : index_list) {
+    explain_->indices.push_back({file, 0, {}, {}});
+  }
+  explain_->terms.clear();
+  explain_->sort = {};
+  explain_->total = {};
+}
+
+QueryExplainer::~QueryExplainer() {
+  if (io_fd_ != -1) {
+    close(io_fd_);
+  }
+}
+
+QueryExplainer::Mark QueryExplainer::Start(QueryExplainer* const explainer) {
+  return explainer != nullptr ? explainer->Now() : Mark();
+}
+
+QueryExplain::Cost QueryExplainer::Lap(QueryExplainer* const explainer,
+                                       Mark* const mark) {
+  if (explainer == nullptr) {
+    return QueryExplain::Cost();
+  }
+  Mark now = explainer->Now();
+  QueryExplain::Cost cost = {now.nanos - mark->nanos,
+                             now.read_calls - mark->read_calls,
+                             now.bytes_read - mark->bytes_read,
+                             now.page_faults - mark->page_faults};
+  *mark = now;
+  return cost;
+}
+
+void QueryExplainer::AddTermCost(QueryExplainer* const explainer,
+                                 Mark* const start, int index,
+                                 const string& term,
+                                 QueryExplain::Cost QueryExplain::Term::* phase,
+                                 int64_t postings_read) {
+  if (explainer == nullptr) {
+    return;
+  }
+  QueryExplain::Cost cost = Lap(explainer, start);
+  QueryExplain::Term* entry = explainer->TermFor(index, term);
+  AddCost(cost, &(entry->*phase));
+  entry->postings_read += postings_read;
+}
+
+void QueryExplainer::SetTermPostings(QueryExplainer* const explainer,
+                                     int index, const string& term,
+                                     int64_t postings) {
+  if (explainer != nullptr) {
+    explainer->TermFor(index, term)->postings = postings;
+  }
+}
+
+void QueryExplainer::SetTermTruncated(QueryExplainer* const explainer,
+                                      int index, const string& term) {
+  if (explainer != nullptr) {
+    explainer->TermFor(index, term)->truncated = true;
+  }
+}
+
+QueryExplainer::Mark QueryExplainer::Now() {
+  int64_t start = NowNanos();
+  Mark mark = {start - own_nanos_, 0, 0, 0};
+
+  if (io_fd_ != -1) {
+    char buf[512];
+    ssize_t len = pread(io_fd_, buf, sizeof(buf) - 1, 0);
+    if (len > 0) {
+      buf[len] = '\0';
+      const char* syscr = strstr(buf, "syscr: ");
+      const char* rchar = strstr(buf, "rchar: ");
+      if (syscr != nullptr && rchar != nullptr) {
+        mark.read_calls = strtoll(syscr + 7, nullptr, 10) - own_reads_;
+        mark.bytes_read = strtoll(rchar + 7, nullptr, 10) - own_bytes_;
+      }
+      // The kernel counts this read after taking the snapshot it returns,
+      // so it's the next Mark that has to discount it.
+      own_reads_++;
+      own_bytes_ += len;
+    }
+  }
+
+  struct rusage usage;
+  if (getrusage(RUSAGE_THREAD, &usage) == 0) {
+    mark.page_faults = usage.ru_minflt + usage.ru_majflt;
+  }
+  own_nanos_ += NowNanos() - start;
+  return mark;
+}
+
+QueryExplain::Term* QueryExplainer::TermFor(int index, const string& term) {
+  for (QueryExplain::Term& entry : explain_->terms) {
+    if (entry.index == index && entry.term == term) {
+      return &entry;
+    }
+  }
+  explain_->terms.push_back({index, term, 0, 0, {}, {}, false});
+  return &explain_->terms.back();
+}
+
+string QueryProcessor::QueryExplain::ToString() const {
+  string out = "query: " + FormatCost(total, io_counted) + "\n";
+  for (size_t i = 0; i < indices.size(); i++) {
+    const Index& index = indices[i];
+    out += "index " + std::to_string(i) + " (" + index.file + "): " +
+           std::to_string(index.results) + " results\n";
+    out += "  evaluate: " + FormatCost(index.evaluate, io_counted) + "\n";
+    for (const Term& term : terms) {
+      if (term.index != static_cast<int>(i)) {
+        continue;
+      }
+      out += "    " + term.term + ": " + std::to_string(term.postings) +
+             " postings, " + std::to_string(term.postings_read) + " read";
+      if (term.truncated) {
+        out += ", truncated to " + std::to_string(kMaxWildcardTerms) +
+               " words";
+      }
+      out += "\n";
+      out += "      lookup: " + FormatCost(term.lookup, io_counted) + "\n";
+      out += "      postings: " + FormatCost(term.postings_cost, io_counted) +
+             "\n";
+    }
+    out += "  resolve: " + FormatCost(index.resolve, io_counted) + "\n";
+  }
+  out += "sort: " + FormatCost(sort, io_counted) + "\n";
+  return out;
+}
+
+static void AddCost(const QueryExplain::Cost& cost,
+                    QueryExplain::Cost* const total) {
+  total->nanos += cost.nanos;
+  total->read_calls += cost.read_calls;
+  total->bytes_read += cost.bytes_read;
+  total->page_faults += cost.page_faults;
+}
+
+static string FormatCost(const QueryExplain::Cost& cost, bool io_counted) {
+  char buf[128];
+  if (io_counted) {
+    snprintf(buf, sizeof(buf),
+             "%.1f us, %" PRId64 " reads, %" PRId64 " bytes, %" PRId64
+             " page faults", cost.nanos / 1000.0, cost.read_calls,
+             cost.bytes_read, cost.page_faults);
+  } else {
+    snprintf(buf, sizeof(buf), "%.1f us, %" PRId64 " page faults",
+             cost.nanos / 1000.0, cost.page_faults);
+  }
+  return buf;
+}
+
+static size_t GallopTo(const vector<DocPositionOffset_t>& positions,
+                       size_t from, int64_t target) {
+  // Double the step until we overshoot, then binary search the last step.
+  size_t lo = from, hi = from, step = 1;
+  while (hi < positions.size() && positions[hi] < target) {
+    lo = hi + 1;
+    hi += step;
+    step *= 2;
+  }
+  hi = std::min(hi + 1, positions.size());
+  return std::lower_bound(positions.begin() + lo, positions.begin() + hi,
+                          target) - positions.begin();
+}
+
+int CountPhraseMatches(
+  const vector<vector<DocPositionOffset_t>>& positions,
+  const vector<string>& words) {
+  // For each occurrence of the first word, chase the following words one
+  // at a time.  Every cursor only ever moves forward, since the first
+  // word's occurrences are visited in ascending order.
+  vector<size_t> cursors(words.size(), 0);
+  int num_matches = 0;
+  for (DocPositionOffset_t start : positions[0]) {
+    int64_t prev = start;
+    bool matched = true;
+    for (size_t i = 1; i < words.size() && matched; i++) {
+      int64_t prev_end = prev + words[i - 1].size();
+      cursors[i] = GallopTo(positions[i], cursors[i], prev_end + 1);
+      matched = cursors[i] < positions[i].size() &&
+        positions[i][cursors[i]] <= prev_end + kMaxPhraseGapBytes;
+      if (matched) {
+        prev = positions[i][cursors[i]];
+      }
+    }
+    if (matched) {
+      num_matches++;
+    }
+  }
+  return num_matches;
+}
+
+int CountNearMatches(const vector<DocPositionOffset_t>& a_positions,
+                     const vector<DocPositionOffset_t>& b_positions,
+                     const string& a, const string& b, int distance) {
+  int64_t window = kMaxPhraseGapBytes + distance * kNearBytesPerWord;
+  int64_t a_len = a.size(), b_len = b.size();
+
+  // For each occurrence of "a", look for a "b" that ends at most "window"
+  // bytes before it, or starts at most "window" bytes after it.  The
+  // earliest acceptable "b" only moves forward, so gallop a cursor to it.
+  size_t cursor = 0;
+  int num_matches = 0;
+  for (DocPositionOffset_t a_pos : a_positions) {
+    cursor = GallopTo(b_positions, cursor, a_pos - window - b_len);
+    for (size_t i = cursor;
+         i < b_positions.size() && b_positions[i] <= a_pos + a_len + window;
+         i++) {
+      // Skip over "a" itself, when a and b are the same word.
+      if (b_positions[i] + b_len < a_pos || b_positions[i] > a_pos + a_len) {
+        num_matches++;
+        break;
+      }
+    }
+  }
+  return num_matches;
+}
+
+static void ReadPositions(DocIDTableReader* ditr, DocID_t doc_id,
+                          vector<DocPositionOffset_t>* const positions) {
+  list<DocPositionOffset_t> position_list;
+  Verify333(ditr->LookupDocID(doc_id, &position_list));
+  positions->assign(position_list.begin(), position_list.end());
 }
 
 }  // namespace hw3
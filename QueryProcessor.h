@@ -19,7 +19,11 @@
 #include "./DocIDTableReader.h"
 #include "./DocTableReader.h"
 #include "./FileIndexReader.h"
+#include "./FlatHashMap.h"
 #include "./IndexTableReader.h"
+#include "./QueryParser.h"
+#include "./TermBoundTableReader.h"
+#include "./TermDictReader.h"
 #include "./Utils.h"
 
 using std::list;
@@ -28,11 +32,27 @@ using std::vector;
 
 namespace hw3 {
 
+// Measures the phases of a query for QueryProcessor::QueryExplain; see
+// QueryProcessor.cc.
+class QueryExplainer;
+
 // A QueryProcessor is a class that is given a set of names of index
 // files, and uses the various FileIndexReader and HashTableReader
 // classes to process queries against the indices.
 class QueryProcessor {
  public:
+  // The ways in which ProcessQuery() can rank its results.
+  enum RankingMode {
+    // The sum of the number of occurrences of the query words within the
+    // document, as in HW2.
+    kRankByOccurrences,
+
+    // The Okapi BM25 score of the document, which favors rare query words
+    // and discounts long documents.  Index files written without a
+    // document length section are scored without length normalization.
+    kRankByBM25,
+  };
+
   // Construct a QueryProcessor.
   //
   // Arguments:
@@ -40,11 +60,20 @@ class QueryProcessor {
   //   file names that the QueryProcessor should use.
   // - validate: a bool indicating whether or not to validate the
   //   checksums in the index files.  Defaults to true.
-  explicit QueryProcessor(const list<string>& index_list, bool validate=true);
+  // - ranking_mode: how to rank query results.  Defaults to
+  //   kRankByOccurrences.
+  explicit QueryProcessor(const list<string>& index_list, bool validate=true,
+                          RankingMode ranking_mode=kRankByOccurrences);
 
   // The destructor.
   ~QueryProcessor();
 
+  // Sets the names query explanations give the index files, in the same
+  // order as the list the QueryProcessor was constructed with, for when
+  // the files were opened through other names (e.g., /proc/self/fd/N).
+  // By default, they're given the names in that list.
+  void set_index_names(const list<string>& index_names);
+
   // This structure defines a single query result.  As with HW2,
   // the rank of a query result is the sum of the number of occurrences
   // of query words within the document.
@@ -54,17 +83,170 @@ class QueryProcessor {
 
     string document_name;  // The name of a matching document.
     int    rank;           // The rank of the matching document.
+    float  score;          // The BM25 score of the matching document, or 0
+                           // if not ranking by kRankByBM25.
   };
 
   // This method processes a query against the indices and returns a
-  // vector of QueryResults, sorted in descending order of rank.  If no
-  // documents match the query, then a valid but empty vector will be
-  // returned.
+  // vector of QueryResults, sorted in descending order of rank (or of
+  // score, when ranking by kRankByBM25).  Ties are broken by the order of
+  // the index files, then by docID.  If no documents match the query,
+  // then a valid but empty vector will be returned.
   vector<QueryResult> ProcessQuery(const vector<string>& query) const;
 
+  // As above, but for a parsed query (see QueryParser.h).  Phrase and
+  // NEAR/k clauses rank by their number of matches within the document,
+  // and are scored by BM25 as though each clause were a single word.  A
+  // document matching a kOr is ranked by the sum over the alternatives it
+  // matches; kNot clauses don't contribute to the rank.  A wildcard
+  // ranks and scores as a kOr of the words it expands to, up to the first
+  // kMaxWildcardTerms of them in byte order.
+  //
+  // Phrase and NEAR/k clauses are evaluated in two passes: the docIDs are
+  // intersected first, starting from the rarest word, and only documents
+  // containing every word have their position lists read and merged.
+  //
+  // If "timings" is non-null, it receives the time spent in each phase.
+  // If "explain" is non-null, it receives a much finer breakdown of the
+  // query's cost (see QueryExplain), which takes a few system calls per
+  // phase to measure; it's meant for finding out why a query is slow.
+  // If "truncated" is non-null, it receives the wildcard patterns that
+  // matched more than kMaxWildcardTerms words in some index file, and so
+  // may have missed documents, in byte order.
+  struct QueryTimings {
+    int64_t evaluate_nanos;  // evaluating the query against the indices.
+    int64_t resolve_nanos;   // looking up the matching documents' names.
+  };
+  struct QueryExplain;
+  vector<QueryResult> ProcessQuery(const QueryNode& query,
+                                   QueryTimings* const timings = nullptr,
+                                   QueryExplain* const explain = nullptr,
+                                   vector<string>* const truncated = nullptr)
+    const;
+
+  // A wildcard is expanded into at most this many words, so that a pattern
+  // like "a*" can't turn into a query over most of the index.
+  static constexpr size_t kMaxWildcardTerms = 1024;
+
+  // Where a query's time went, per index file and per word.
+  struct QueryExplain {
+    // The cost of a phase of the query: its time, the read() system calls
+    // it issued and the bytes they returned, and the page faults it took
+    // (which is how indices read in place from an mmap() show their I/O).
+    // The I/O is counted by the kernel, so it includes reads that stdio
+    // buffered; where it can't be counted (io_counted is false), the
+    // system call and byte counts are zero.
+    struct Cost {
+      int64_t nanos;
+      int64_t read_calls;
+      int64_t bytes_read;
+      int64_t page_faults;
+    };
+
+    // A word, wildcard pattern, or phrase or NEAR/k clause, in one index
+    // file.  A word's cost is split between finding it in the index
+    // table's hash table (or, for a pattern, the term dictionary), which
+    // includes estimating its size when planning a kAnd, and reading or
+    // probing its docID table.  A phrase or NEAR/k clause's words are
+    // listed separately, and the clause's own "postings" cost is that of
+    // intersecting their docID tables and merging their positions.
+    struct Term {
+      int     index;          // the index file, by its position in the list.
+      string  term;
+      int64_t postings;       // documents in its docID table(s); for a
+                              // clause, the documents it matched.
+      int64_t postings_read;  // docID table entries read or looked up.
+      Cost    lookup;
+      Cost    postings_cost;
+      bool    truncated;      // for a pattern, whether it matched more
+                              // than kMaxWildcardTerms words.
+    };
+
+    // An index file.  Its evaluation includes its terms' costs.
+    struct Index {
+      string  file;
+      int64_t results;        // documents that matched.
+      Cost    evaluate;       // evaluating the query.
+      Cost    resolve;        // looking up the matching documents' names.
+    };
+
+    bool          io_counted;
+    vector<Index> indices;
+    vector<Term>  terms;      // in the order they were first looked up.
+    Cost          sort;       // sorting the results.
+    Cost          total;
+
+    // Returns the breakdown as human-readable text, one line per phase.
+    string ToString() const;
+  };
+
+  // A query result whose document name hasn't been looked up, for callers
+  // that only need the names of some of the results, such as a page of
+  // them.
+  struct QueryMatch {
+    int     index;   // the index file, by its position in the list.
+    DocID_t doc_id;  // the document within that index file.
+    int     rank;
+    float   score;
+  };
+
+  // Processes a parsed query like ProcessQuery(), returning the matches in
+  // the same order, without looking up any document names.  "truncated"
+  // is as for ProcessQuery().
+  vector<QueryMatch> MatchQuery(const QueryNode& query,
+                                vector<string>* const truncated = nullptr)
+    const;
+
+  // Returns the name of a match's document.
+  string LookupDocName(const QueryMatch& match) const;
+
+  // Reads the positions (byte offsets) of "word" within a match's
+  // document into "positions", in ascending order.  Returns false, leaving
+  // "positions" untouched, if the document doesn't contain the word.
+  // Each word's docID table is only looked up once per index file and
+  // kept until the QueryProcessor is destroyed, so reading the positions
+  // of a page of matches costs a docID lookup apiece.
+  bool LookupPositions(const QueryMatch& match, const string& word,
+                       vector<DocPositionOffset_t>* const positions) const;
+
+  // Counters describing how much work ProcessQueryTopK() did.
+  struct TopKStats {
+    int64_t postings_total;   // postings in the query words' docID tables.
+    int64_t postings_scored;  // postings whose BM25 score was computed.
+  };
+
+  // This method processes a disjunctive query against the indices: a
+  // document matches if it contains *any* of the query words.  It returns
+  // only the "k" matches with the highest BM25 scores, sorted in
+  // descending order of score; each result's rank is the number of
+  // occurrences of query words within it.  The QueryProcessor must have
+  // been constructed with kRankByBM25.
+  //
+  // Rather than scoring every posting, words are visited in descending
+  // order of their stored score bounds (MaxScore).  Once the bounds of
+  // the unvisited words sum to no more than the k'th best score so far,
+  // their docID tables are never read; and a document whose partial score
+  // plus the bounds of the words it hasn't been checked against can't make
+  // the cut is dropped without further lookups.  Index files without a
+  // score bound section are evaluated exhaustively.
+  //
+  // Arguments:
+  // - query: the query words.
+  // - k: the maximum number of results to return; must be > 0.
+  // - stats: (output parameter) if non-null, receives the work counters.
+  // - prune: if false, score every posting; useful for benchmarking.
+  vector<QueryResult> ProcessQueryTopK(const vector<string>& query, int k,
+                                       TopKStats* const stats = nullptr,
+                                       bool prune = true) const;
+
+  // Returns the ranking mode this QueryProcessor was constructed with.
+  RankingMode ranking_mode() const { return ranking_mode_; }
+
  protected:
-  // The list of index files we process.
+  // The list of index files we process, and the names to explain them
+  // by.
   list<string> index_list_;
+  list<string> index_names_;
 
   // The arrays of pointers to DocTableReader and IndexTableReader
   // objects.
@@ -72,10 +254,190 @@ class QueryProcessor {
   DocTableReader**    dtr_array_;
   IndexTableReader**  itr_array_;
 
+  RankingMode ranking_mode_;
+
+  // Per-index BM25 statistics, only populated when ranking by
+  // kRankByBM25.  num_docs_[i] is the number of documents in index i, and
+  // length_norms_[i][d - 1] is the precomputed length normalization term
+  // k1 * (1 - b + b * |d| / avgdl) for docID d in index i.  The latter is
+  // empty for index files without a document length section.
+  vector<int>            num_docs_;
+  vector<vector<float>>  length_norms_;
+
+  // Per-index score bound readers, only populated when ranking by
+  // kRankByBM25.  Entries are nullptr for index files without a score
+  // bound section.
+  vector<TermBoundTableReader*> tbr_array_;
+
+  // Per-index term dictionary readers, used to expand wildcard patterns.
+  // Entries are nullptr for index files without a term dictionary, in
+  // which patterns match nothing.
+  vector<TermDictReader*> tdr_array_;
+
+  // Per-index docID tables looked up by LookupPositions(), by word, or
+  // nullptr for words that aren't in the index file.
+  FlatHashMap<string, DocIDTableReader*>* position_readers_;
+
  private:
+  // Appends the BM25 statistics for the index file open in "fir" to
+  // num_docs_ and length_norms_.
+  void LoadBM25Stats(const FileIndexReader& fir);
+
+  // Returns the BM25 length normalization term for "doc_id" in index
+  // "index".
+  float LengthNorm(int index, DocID_t doc_id) const;
+
+  // This structure is used to store a index-file-specific query result.
+  typedef struct {
+    DocID_t doc_id;  // The document ID within the index file.
+    int     rank;    // The rank of the result so far.
+    float   score;   // The BM25 score of the result so far.
+  } IdxQueryResult;
+
+  // A kWildcard clause evaluated against an index file.
+  struct WildcardResult {
+    vector<IdxQueryResult> results;
+    bool truncated;  // whether the pattern matched too many words.
+  };
+
+  // A word looked up in an index file.
+  struct TermLookup {
+    DocIDTableReader* reader;  // its docID table, or nullptr if it's not
+                               // in the index.
+    int64_t doc_freq;          // the number of documents containing it.
+  };
+
+  // What evaluating a query against an index file has looked up so far,
+  // so that nothing is looked up twice.  Planning a kAnd estimates each
+  // clause's matches from its words' docID tables, and since knowing how
+  // many documents a wildcard matches takes expanding it and opening
+  // every one of its words' tables, wildcards are evaluated outright.
+  // Either way, what planning finds is kept for when the clause itself is
+  // evaluated.  The docID table readers are owned by the IndexLookups.
+  struct IndexLookups {
+    IndexLookups() { }
+    ~IndexLookups();
+
+    FlatHashMap<const QueryNode*, WildcardResult> wildcards;
+    FlatHashMap<string, TermLookup> terms;
+
+    DISALLOW_COPY_AND_ASSIGN(IndexLookups);
+  };
+
+  // Adds the patterns in "lookups" that were truncated to "truncated",
+  // keeping it in byte order without duplicates.
+  static void AddTruncatedWildcards(IndexLookups* const lookups,
+                                    vector<string>* const truncated);
+
+  // Does the work of MatchQuery().  If "explainer" is non-null, the cost
+  // of evaluating the query against each index file, and of sorting the
+  // matches, is recorded in it and in "explain".
+  vector<QueryMatch> MatchQuery(const QueryNode& query,
+                                vector<string>* const truncated,
+                                QueryExplain* const explain,
+                                QueryExplainer* const explainer) const;
+
+  // Evaluates "query" against index file "index", appending the matching
+  // documents to "results" in no particular order.  "lookups" holds what
+  // has been looked up for this query and index so far; pass the same one
+  // to every method below.  If "explainer" is non-null, the cost of each
+  // word's lookups is recorded in it; so it is for the methods below.
+  void EvaluateQuery(int index, const QueryNode& query,
+                     vector<IdxQueryResult>* const results,
+                     IndexLookups* const lookups,
+                     QueryExplainer* const explainer) const;
+
+  // Returns an upper bound on the number of documents in index file
+  // "index" that "query" can match, used to plan the order in which the
+  // clauses of a kAnd are evaluated.  Only looks words up and reads their
+  // docID tables' bucket records, except for wildcards, which are
+  // evaluated (see IndexLookups).
+  int64_t EstimateMatches(int index, const QueryNode& query,
+                          IndexLookups* const lookups,
+                          QueryExplainer* const explainer) const;
+
+  // Evaluates a kAnd; see EvaluateQuery().  The clauses are evaluated
+  // from the fewest estimated matches to the most, followed by the kNot
+  // clauses, stopping as soon as no documents remain.
+  void EvaluateAnd(int index, const QueryNode& query,
+                   vector<IdxQueryResult>* const results,
+                   IndexLookups* const lookups,
+                   QueryExplainer* const explainer) const;
+
+  // Evaluates a kOr; see EvaluateQuery().
+  void EvaluateOr(int index, const QueryNode& query,
+                  vector<IdxQueryResult>* const results,
+                  IndexLookups* const lookups,
+                  QueryExplainer* const explainer) const;
+
+  // Narrows "results" down to the documents that match "clause" (or, if
+  // "negate" is true, that don't), adding the clause's rank and score to
+  // those that remain.  "estimate" is EstimateMatches() for the clause.
+  void FilterResults(int index, const QueryNode& clause, int64_t estimate,
+                     bool negate, vector<IdxQueryResult>* const results,
+                     IndexLookups* const lookups,
+                     QueryExplainer* const explainer) const;
+
+  // Evaluates a kTerm clause for "word"; see EvaluateQuery().
+  void EvaluateTerm(int index, const string& word,
+                    vector<IdxQueryResult>* const results,
+                    IndexLookups* const lookups,
+                    QueryExplainer* const explainer) const;
+
+  // Returns "word" as looked up in index file "index", looking it up and
+  // counting its documents if "lookups" doesn't have it yet.
+  TermLookup LookupTerm(int index, const string& word,
+                        IndexLookups* const lookups,
+                        QueryExplainer* const explainer) const;
+
+  // Returns the words in index file "index" that match the wildcard
+  // "pattern", in the order their elements appear in the file.  At most
+  // kMaxWildcardTerms words are returned; "*truncated" is set to whether
+  // there were more.
+  vector<TermDictReader::Term> ExpandWildcard(int index,
+                                              const string& pattern,
+                                              bool* const truncated) const;
+
+  // Evaluates a kWildcard clause for "pattern"; see EvaluateQuery().  A
+  // document's rank and score are summed over the words it contains, as
+  // for a kOr of them.  "*truncated" is set as by ExpandWildcard().
+  void EvaluateWildcard(int index, const string& pattern,
+                        vector<IdxQueryResult>* const results,
+                        bool* const truncated,
+                        QueryExplainer* const explainer) const;
+
+  // Returns the results of the kWildcard clause "clause" in "lookups",
+  // evaluating it with EvaluateWildcard() if it hasn't been yet.  The
+  // reference is only valid until "lookups" is next modified.
+  const WildcardResult& LookupWildcard(
+    int index, const QueryNode& clause, IndexLookups* const lookups,
+    QueryExplainer* const explainer) const;
+
+  // Evaluates a kPhrase or kNear clause; see EvaluateQuery().
+  void EvaluatePositional(int index, const QueryNode& clause,
+                          vector<IdxQueryResult>* const results,
+                          IndexLookups* const lookups,
+                          QueryExplainer* const explainer) const;
+
   DISALLOW_COPY_AND_ASSIGN(QueryProcessor);
 };
 
+// Returns the number of occurrences of the phrase "words" within a
+// document, given the ascending positions (byte offsets) of each word in
+// the document.  Since the positions are byte offsets, consecutive words
+// may be separated by at most two non-alphabetic characters; see
+// QueryProcessor.cc.
+int CountPhraseMatches(const vector<vector<DocPositionOffset_t>>& positions,
+                       const vector<string>& words);
+
+// Returns the number of occurrences of the word "a" that have an
+// occurrence of the word "b" roughly at most "distance" words away, in
+// either order, given the ascending positions of each.  The distance is
+// estimated from the bytes between the words; see QueryProcessor.cc.
+int CountNearMatches(const vector<DocPositionOffset_t>& a_positions,
+                     const vector<DocPositionOffset_t>& b_positions,
+                     const string& a, const string& b, int distance);
+
 }  // namespace hw3
 
 #endif  // HW3_QUERYPROCESSOR_H_
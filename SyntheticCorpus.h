@@ -0,0 +1,69 @@
+/*
+ * Copyright ©2024 Hannah C. Tang.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Washington
+ * CSE 333 for use solely during Spring Quarter 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#ifndef HW4_SYNTHETICCORPUS_H_
+#define HW4_SYNTHETICCORPUS_H_
+
+#include <algorithm>  // for std::lower_bound(), std::min()
+#include <cmath>      // for std::pow()
+#include <random>     // for std::mt19937_64
+#include <string>
+#include <vector>
+
+namespace hw4 {
+
+// Helpers for generating synthetic text, shared by the benchmarks and the
+// corpus generator so that they all draw from the same vocabulary.
+
+// Returns the rank'th word of the synthetic vocabulary: a pronounceable
+// string of syllables, distinct for every rank.
+inline std::string VocabularyWord(int rank) {
+  static const char* kSyllables[] = {
+    "ba", "ce", "di", "fo", "gu", "ha", "je", "ki", "lo", "mu",
+    "na", "pe", "qui", "ro", "su", "ta", "ve", "wi", "xo", "zu"
+  };
+  std::string word;
+  for (int n = rank + 20; n > 0; n /= 20) {
+    word += kSyllables[n % 20];
+  }
+  return word;
+}
+
+// Draws ranks in [0, n) with probability proportional to
+// 1/(rank + 1)^exponent; an exponent of 1 is the classic Zipf's law that
+// natural-language word frequencies roughly follow.
+class ZipfSampler {
+ public:
+  explicit ZipfSampler(int n, double exponent = 1.0) : cdf_(n) {
+    double total = 0;
+    for (int i = 0; i < n; i++) {
+      total += 1.0 / std::pow(i + 1, exponent);
+      cdf_[i] = total;
+    }
+    for (double& p : cdf_) {
+      p /= total;
+    }
+  }
+
+  int Sample(std::mt19937_64* rng) const {
+    double u = std::uniform_real_distribution<double>(0.0, 1.0)(*rng);
+    size_t rank = std::lower_bound(cdf_.begin(), cdf_.end(), u) -
+                  cdf_.begin();
+    return std::min(rank, cdf_.size() - 1);
+  }
+
+ private:
+  std::vector<double> cdf_;
+};
+
+}  // namespace hw4
+
+#endif  // HW4_SYNTHETICCORPUS_H_
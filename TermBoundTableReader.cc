@@ -0,0 +1,67 @@
+/*
+ * Copyright ©2024 Hannah C. Tang.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Washington
+ * CSE 333 for use solely during Spring Quarter 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#include "./TermBoundTableReader.h"
+
+#include <cstdio>    // for (FILE*)
+#include <string>    // for std::string
+
+extern "C" {
+  #include "libhw1/CSE333.h"
+  #include "libhw1/HashTable.h"  // for HashWithID().
+}
+
+using std::string;
+
+namespace hw3 {
+
+TermBoundTableReader::TermBoundTableReader(FILE* f, IndexFileOffset_t offset,
+                                           int32_t bytes, HTHashID_t hash_id)
+  : file_(f), offset_(offset), hash_id_(hash_id) {
+  Verify333(bytes % sizeof(TermBoundRecord) == 0);
+  num_records_ = bytes / sizeof(TermBoundRecord);
+}
+
+TermBoundTableReader::~TermBoundTableReader() {
+  fclose(file_);
+  file_ = nullptr;
+}
+
+bool TermBoundTableReader::LookupMaxScore(const string& word,
+                                          float* const max_score) const {
+  char* word_c_str = const_cast<char*>(word.c_str());
+  HTKey_t word_hash =
+    HashWithID(hash_id_, reinterpret_cast<unsigned char*>(word_c_str),
+               word.length());
+
+  // Binary search for the word's hash in [lo, hi).
+  int lo = 0, hi = num_records_;
+  while (lo < hi) {
+    int mid = lo + (hi - lo) / 2;
+    TermBoundRecord record;
+    Verify333(fseek(file_, offset_ + mid * sizeof(TermBoundRecord),
+                    SEEK_SET) == 0);
+    Verify333(fread(&record, sizeof(TermBoundRecord), 1, file_) == 1);
+    record.ToHostFormat();
+
+    if (record.word_hash == word_hash) {
+      *max_score = record.max_score;
+      return true;
+    } else if (record.word_hash < word_hash) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  return false;
+}
+
+}  // namespace hw3
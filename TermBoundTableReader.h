@@ -0,0 +1,67 @@
+/*
+ * Copyright ©2024 Hannah C. Tang.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Washington
+ * CSE 333 for use solely during Spring Quarter 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#ifndef HW3_TERMBOUNDTABLEREADER_H_
+#define HW3_TERMBOUNDTABLEREADER_H_
+
+#include <cstdio>    // for (FILE*)
+#include <string>    // for std::string
+
+#include "./LayoutStructs.h"
+#include "./Utils.h"
+
+namespace hw3 {
+
+// A TermBoundTableReader is used to read the per-word BM25 score bound
+// section of an index file.  The table is sorted by word hash, so lookups
+// binary search it in place rather than loading it into memory.
+class TermBoundTableReader {
+ public:
+  // Construct a TermBoundTableReader.  Arguments:
+  //
+  // - f: an open (FILE*) for the underlying index file.  The constructed
+  //   object takes ownership of the (FILE*) and will fclose() it on
+  //   destruction.
+  //
+  // - offset: the byte offset of the section's payload (i.e., just past
+  //   its SectionHeader) within the file.
+  //
+  // - bytes: the size of the section's payload.
+  //
+  // - hash_id: the hash function the index's words were keyed with.
+  TermBoundTableReader(FILE* f, IndexFileOffset_t offset, int32_t bytes,
+                       HTHashID_t hash_id);
+  ~TermBoundTableReader();
+
+  // Looks up the upper bound on the BM25 score "word" can contribute to
+  // any single document.
+  //
+  // Arguments:
+  // - word: the word to look for.
+  // - max_score: (output parameter) the word's bound.  Nothing is returned
+  //   through this if the word isn't in the table.
+  //
+  // Returns:
+  // - true if the word is found, false otherwise.
+  bool LookupMaxScore(const std::string& word, float* const max_score) const;
+
+ private:
+  FILE* file_;
+  IndexFileOffset_t offset_;
+  int num_records_;
+  HTHashID_t hash_id_;
+
+  DISALLOW_COPY_AND_ASSIGN(TermBoundTableReader);
+};
+
+}  // namespace hw3
+
+#endif  // HW3_TERMBOUNDTABLEREADER_H_
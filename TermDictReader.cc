@@ -0,0 +1,162 @@
+/*
+ * Copyright ©2024 Hannah C. Tang.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Washington
+ * CSE 333 for use solely during Spring Quarter 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#include "./TermDictReader.h"
+
+#include <cstdio>    // for (FILE*)
+#include <string>    // for std::string
+#include <vector>    // for std::vector
+
+extern "C" {
+  #include "libhw1/CSE333.h"
+}
+
+using std::string;
+using std::vector;
+
+namespace hw3 {
+
+// Decodes the varint at *pos in "buf", advancing *pos past it.
+static uint64_t GetVarint(const vector<uint8_t>& buf, size_t* const pos) {
+  uint64_t value = 0;
+  for (int shift = 0; ; shift += 7) {
+    Verify333(*pos < buf.size() && shift < 64);
+    uint8_t byte = buf[(*pos)++];
+    value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+    if ((byte & 0x80) == 0) {
+      return value;
+    }
+  }
+}
+
+TermDictReader::TermDictReader(FILE* f, IndexFileOffset_t offset,
+                               int32_t bytes)
+  : file_(f), offset_(offset), bytes_(bytes) {
+  // Slurp in the header and the block records; the blocks themselves are
+  // only read as they're needed.
+  TermDictHeader header;
+  Verify333(bytes_ >= static_cast<int32_t>(sizeof(TermDictHeader)));
+  Verify333(fseek(file_, offset_, SEEK_SET) == 0);
+  Verify333(fread(&header, sizeof(TermDictHeader), 1, file_) == 1);
+  header.ToHostFormat();
+  num_terms_ = header.num_terms;
+  Verify333(header.num_blocks >= 0 &&
+            sizeof(TermDictHeader) +
+            header.num_blocks * sizeof(TermDictBlockRecord) <=
+            static_cast<size_t>(bytes_));
+
+  vector<TermDictBlockRecord> records(header.num_blocks);
+  Verify333(fread(records.data(), sizeof(TermDictBlockRecord), records.size(),
+                  file_) == records.size());
+  for (TermDictBlockRecord& record : records) {
+    record.ToHostFormat();
+    block_positions_.push_back(record.position);
+  }
+  block_positions_.push_back(bytes_);
+}
+
+TermDictReader::~TermDictReader() {
+  fclose(file_);
+  file_ = nullptr;
+}
+
+vector<TermDictReader::Term> TermDictReader::ReadBlock(int block) const {
+  int32_t start = block_positions_[block];
+  int32_t end = block_positions_[block + 1];
+  Verify333(start >= 0 && start <= end && end <= bytes_);
+  vector<uint8_t> buf(end - start);
+  Verify333(fseek(file_, offset_ + start, SEEK_SET) == 0);
+  Verify333(fread(buf.data(), 1, buf.size(), file_) == buf.size());
+
+  // Each word is the shared prefix of the one before it, followed by its
+  // own suffix.
+  vector<Term> terms;
+  string word;
+  size_t pos = 0;
+  while (pos < buf.size()) {
+    uint64_t shared = GetVarint(buf, &pos);
+    uint64_t suffix_bytes = GetVarint(buf, &pos);
+    Verify333(shared <= word.size() && suffix_bytes <= buf.size() - pos);
+    word.resize(shared);
+    word.append(reinterpret_cast<const char*>(&buf[pos]), suffix_bytes);
+    pos += suffix_bytes;
+    terms.push_back({word, static_cast<IndexFileOffset_t>(
+                             GetVarint(buf, &pos))});
+  }
+  return terms;
+}
+
+bool TermDictReader::LookupPattern(const string& pattern, size_t max_terms,
+                                   vector<Term>* const terms) const {
+  string prefix = pattern.substr(0, pattern.find_first_of("*?"));
+  int num_blocks = block_positions_.size() - 1;
+
+  // Binary search for the last block whose first word comes before the
+  // prefix; the words beginning with the prefix start there, if anywhere.
+  int lo = 0, hi = num_blocks;
+  while (hi - lo > 1) {
+    int mid = lo + (hi - lo) / 2;
+    if (ReadBlock(mid)[0].word < prefix) {
+      lo = mid;
+    } else {
+      hi = mid;
+    }
+  }
+
+  // Scan forward from there until the words no longer begin with the
+  // prefix.
+  size_t num_matched = 0;
+  for (int block = lo; block < num_blocks; block++) {
+    for (Term& term : ReadBlock(block)) {
+      if (term.word < prefix) {
+        continue;
+      }
+      if (term.word.compare(0, prefix.size(), prefix) != 0) {
+        return true;
+      }
+      if (MatchesPattern(pattern, term.word)) {
+        if (num_matched++ == max_terms) {
+          return false;
+        }
+        terms->push_back(term);
+      }
+    }
+  }
+  return true;
+}
+
+bool MatchesPattern(const string& pattern, const string& word) {
+  // Match greedily, remembering the most recent '*' so that we can back up
+  // and let it swallow one more character whenever we get stuck.
+  size_t p = 0, w = 0;
+  size_t star = string::npos, star_w = 0;
+  while (w < word.size()) {
+    if (p < pattern.size() &&
+        (pattern[p] == '?' || (pattern[p] != '*' && pattern[p] == word[w]))) {
+      p++;
+      w++;
+    } else if (p < pattern.size() && pattern[p] == '*') {
+      star = p++;
+      star_w = w;
+    } else if (star != string::npos) {
+      p = star + 1;
+      w = ++star_w;
+    } else {
+      return false;
+    }
+  }
+  while (p < pattern.size() && pattern[p] == '*') {
+    p++;
+  }
+  return p == pattern.size();
+}
+
+}  // namespace hw3
@@ -0,0 +1,103 @@
+/*
+ * Copyright ©2024 Hannah C. Tang.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Washington
+ * CSE 333 for use solely during Spring Quarter 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#ifndef HW3_TERMDICTREADER_H_
+#define HW3_TERMDICTREADER_H_
+
+#include <cstdio>    // for (FILE*)
+#include <string>    // for std::string
+#include <vector>    // for std::vector
+
+#include "./LayoutStructs.h"
+#include "./Utils.h"
+
+namespace hw3 {
+
+// A TermDictReader is used to read the sorted term dictionary section of
+// an index file, which lists every word in the index in ascending byte
+// order, so that the words matching a prefix or a wildcard pattern can be
+// found without knowing them in advance.
+//
+// The words are grouped into blocks of kTermDictBlockTerms, and front
+// coded within each block: every word is stored as the number of leading
+// bytes it shares with the word before it (0 for the first word of a
+// block), the number of bytes that follow, those bytes, and then the byte
+// offset of the word's element within the index table (see
+// IndexTableReader::LookupElement()).  All four are varints: 7 bits per
+// byte, least significant first, with the top bit set on every byte but
+// the last.  Since the first word of every block is stored in full, the
+// blocks can be binary searched, and only the blocks that can hold
+// matching words are decoded.
+class TermDictReader {
+ public:
+  // Construct a TermDictReader.  Arguments:
+  //
+  // - f: an open (FILE*) for the underlying index file.  The constructed
+  //   object takes ownership of the (FILE*) and will fclose() it on
+  //   destruction.
+  //
+  // - offset: the byte offset of the section's payload (i.e., just past
+  //   its SectionHeader) within the file.
+  //
+  // - bytes: the size of the section's payload.
+  TermDictReader(FILE* f, IndexFileOffset_t offset, int32_t bytes);
+  ~TermDictReader();
+
+  // A word in the dictionary.
+  struct Term {
+    std::string        word;
+    IndexFileOffset_t  element;  // the word's element in the index table.
+  };
+
+  // Finds the words matching a pattern, in which '*' matches any run of
+  // characters (including none), '?' matches any single character, and
+  // everything else matches itself.  Only the words that begin with the
+  // pattern's literal prefix (everything before its first wildcard) are
+  // examined.
+  //
+  // Arguments:
+  // - pattern: the pattern to match.
+  // - max_terms: the most words to return.
+  // - terms: (output parameter) the matching words, in ascending order,
+  //   are appended to this.
+  //
+  // Returns:
+  // - false if more than "max_terms" words matched, in which case only the
+  //   first "max_terms" were appended; true otherwise.
+  bool LookupPattern(const std::string& pattern, size_t max_terms,
+                     std::vector<Term>* const terms) const;
+
+  // Returns the number of words in the dictionary.
+  int NumTerms() const { return num_terms_; }
+
+ private:
+  // Reads and decodes all of the words in block "block".
+  std::vector<Term> ReadBlock(int block) const;
+
+  FILE* file_;
+  IndexFileOffset_t offset_;
+  int32_t bytes_;
+  int num_terms_;
+
+  // The start of each block, relative to offset_, followed by the end of
+  // the last one.
+  std::vector<int32_t> block_positions_;
+
+  DISALLOW_COPY_AND_ASSIGN(TermDictReader);
+};
+
+// Returns true if "word" matches "pattern", as for
+// TermDictReader::LookupPattern().
+bool MatchesPattern(const std::string& pattern, const std::string& word);
+
+}  // namespace hw3
+
+#endif  // HW3_TERMDICTREADER_H_
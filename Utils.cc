@@ -11,8 +11,10 @@
 
 #include "./Utils.h"
 
-#include <stdio.h>   // for fprintf()
-#include <string.h>  // for strcmp()
+#include <stdio.h>     // for fprintf()
+#include <string.h>    // for strcmp()
+#include <sys/mman.h>  // for mmap()
+#include <sys/stat.h>  // for fstat()
 
 extern "C" {
   #include "libhw1/CSE333.h"
@@ -22,6 +24,28 @@ namespace hw3 {
 
 const uint32_t kMagicNumber = 0xCAFEF00D;
 
+uint32_t MagicNumberForHashID(HTHashID_t hash_id, IndexFormat format) {
+  Verify333(hash_id >= 0 && hash_id < HT_NUM_HASH_IDS);
+  Verify333(format >= kIndexFormat32 && format <= kIndexFormatNative);
+  return kMagicNumber + static_cast<uint32_t>(hash_id) +
+    (static_cast<uint32_t>(format) << 8);
+}
+
+bool HashIDForMagicNumber(uint32_t magic_number, HTHashID_t* const hash_id,
+                          IndexFormat* const format) {
+  uint32_t id = (magic_number - kMagicNumber) & 0xFF;
+  uint32_t format_id = (magic_number - kMagicNumber) >> 8;
+  if (id >= HT_NUM_HASH_IDS || format_id > kIndexFormatNative ||
+      (format == nullptr && format_id != kIndexFormat32)) {
+    return false;
+  }
+  *hash_id = static_cast<HTHashID_t>(id);
+  if (format != nullptr) {
+    *format = static_cast<IndexFormat>(format_id);
+  }
+  return true;
+}
+
 // Initialize the "CRC32::table_is_initialized" static member variable.
 bool CRC32::table_is_initialized_ = false;
 
@@ -60,6 +84,15 @@ void CRC32::FoldByteIntoCRC(uint8_t next_byte) {
   crc_state_ = (crc_state_ >> 8) ^ table_[(crc_state_ & 0xFF) ^ next_byte];
 }
 
+void CRC32::FoldBytesIntoCRC(const uint8_t* bytes, size_t len) {
+  Verify333(finalized_ != true);
+  uint32_t crc = crc_state_;
+  for (size_t i = 0; i < len; i++) {
+    crc = (crc >> 8) ^ table_[(crc & 0xFF) ^ bytes[i]];
+  }
+  crc_state_ = crc;
+}
+
 uint32_t CRC32::GetFinalCRC(void) {
   if (!finalized_) {
     finalized_ = true;
@@ -68,6 +101,63 @@ uint32_t CRC32::GetFinalCRC(void) {
   return crc_state_;
 }
 
+// Multiplies the 32x32 matrix over GF(2) "mat" (one column per word) by
+// the vector "vec".
+static uint32_t GF2MatrixTimes(const uint32_t* mat, uint32_t vec) {
+  uint32_t sum = 0;
+  for (; vec != 0; vec >>= 1, mat++) {
+    if (vec & 1) {
+      sum ^= *mat;
+    }
+  }
+  return sum;
+}
+
+// Sets "square" to "mat" times itself.
+static void GF2MatrixSquare(uint32_t* square, const uint32_t* mat) {
+  for (int n = 0; n < 32; n++) {
+    square[n] = GF2MatrixTimes(mat, mat[n]);
+  }
+}
+
+uint32_t CRC32::Combine(uint32_t crc_a, uint32_t crc_b, uint64_t len_b) {
+  // This is zlib's crc32_combine().  Appending B to A is the same as
+  // appending len_b zero bytes to A, then xor'ing in B's CRC.  The effect of
+  // appending zeroes is linear, so we apply it with a matrix that we
+  // square repeatedly to handle len_b one bit at a time.
+  if (len_b == 0) {
+    return crc_a;
+  }
+
+  // The operator for one zero bit, then for two and four.
+  uint32_t odd[32], even[32];
+  odd[0] = 0xEDB88320;  // the reflected polynomial
+  for (int n = 1; n < 32; n++) {
+    odd[n] = 1U << (n - 1);
+  }
+  GF2MatrixSquare(even, odd);
+  GF2MatrixSquare(odd, even);
+
+  // Now apply one, two, four, ... zero bytes wherever len_b has a 1 bit.
+  do {
+    GF2MatrixSquare(even, odd);
+    if (len_b & 1) {
+      crc_a = GF2MatrixTimes(even, crc_a);
+    }
+    len_b >>= 1;
+    if (len_b == 0) {
+      break;
+    }
+    GF2MatrixSquare(odd, even);
+    if (len_b & 1) {
+      crc_a = GF2MatrixTimes(odd, crc_a);
+    }
+    len_b >>= 1;
+  } while (len_b != 0);
+
+  return crc_a ^ crc_b;
+}
+
 void CRC32::Initialize(void) {
   static const uint32_t kPolynomial = 0x04C11DB7;
 
@@ -96,4 +186,19 @@ FILE* FileDup(FILE* f) {
   return retfile;
 }
 
+MappedFile::MappedFile(int fd) {
+  struct stat f_stat;
+  Verify333(fstat(fd, &f_stat) == 0);
+  Verify333(f_stat.st_size > 0);
+  size_ = f_stat.st_size;
+
+  void* data = mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0);
+  Verify333(data != MAP_FAILED);
+  data_ = static_cast<uint8_t*>(data);
+}
+
+MappedFile::~MappedFile() {
+  Verify333(munmap(data_, size_) == 0);
+}
+
 }  // namespace hw3
@@ -16,6 +16,11 @@
 #include <arpa/inet.h>  // For htonl(), etc.
 #include <unistd.h>     // for dup().
 #include <cstdio>       // for fdopen(), (FILE*).
+#include <cstddef>      // for size_t.
+
+extern "C" {
+  #include "libhw1/HashTable.h"  // for HTHashID_t.
+}
 
 // Useful #defines, macros, utility functions, and utility classes.
 
@@ -27,6 +32,30 @@ namespace hw3 {
 // plays the role of a commit record.
 extern const uint32_t kMagicNumber;
 
+// The layouts an index file can have; see LayoutStructs.h.  The first two
+// differ only in the width of the fields that hold byte offsets and sizes.
+enum IndexFormat {
+  kIndexFormat32 = 0,      // the original layout, for files of up to 2GB.
+  kIndexFormat64 = 1,      // 64-bit offsets and sizes, for bigger files.
+  kIndexFormatNative = 2,  // aligned, host-order records, read in place
+                           // from an mmap() of the file.
+};
+
+// The magic number also records which hash function the file's words were
+// keyed with, and the file's format: a file whose word hashes were
+// computed with "hash_id" begins with kMagicNumber + hash_id +
+// (format << 8).  Files of FNV-1a hashes (ID 0) in the original format
+// thus keep the original magic number, and readers that predate the other
+// hash functions or formats refuse files they would otherwise misread.
+uint32_t MagicNumberForHashID(HTHashID_t hash_id,
+                              IndexFormat format = kIndexFormat32);
+
+// The inverse of MagicNumberForHashID().  Returns false if "magic_number"
+// doesn't belong to a well-formed index file.  If "format" is nullptr,
+// only files in the original format are accepted.
+bool HashIDForMagicNumber(uint32_t magic_number, HTHashID_t* const hash_id,
+                          IndexFormat* const format = nullptr);
+
 
 // Macros to convert 64-bit integers between "host order" and "network order".
 //
@@ -69,10 +98,19 @@ class CRC32 {
   // Use this function to fold the next byte into the CRC.
   void FoldByteIntoCRC(uint8_t nextbyte);
 
+  // Use this function to fold the next "len" bytes into the CRC.
+  void FoldBytesIntoCRC(const uint8_t* bytes, size_t len);
+
   // Once you're done folding bytes into the CRC, use this function to
   // get the final 32-bit CRC value.
   uint32_t GetFinalCRC(void);
 
+  // Given the final CRCs of two byte sequences A and B, and the length of
+  // B, returns the final CRC of A followed by B, without looking at the
+  // bytes again.  This lets separate threads checksum separate ranges of a
+  // file.
+  static uint32_t Combine(uint32_t crc_a, uint32_t crc_b, uint64_t len_b);
+
  private:
   // Initialize the table_ to the appropriate values according to the
   // CRC32 algorithm.  Needs to be called once per program execution.
@@ -114,6 +152,30 @@ class CRC32 {
 // when multiple threads are accessing the same logical file.
 FILE* FileDup(FILE* f);
 
+
+// A read-only mmap() of an entire file, for readers that use the records
+// of a kIndexFormatNative index file in place.  The mapping doesn't depend
+// on the file descriptor it was made from staying open, and is unmapped
+// when the MappedFile is destroyed.
+class MappedFile {
+ public:
+  // Maps all of the open file "fd".  Crashes on error.
+  explicit MappedFile(int fd);
+  ~MappedFile();
+
+  // Returns the first byte of the file.
+  const uint8_t* data() const { return data_; }
+
+  // Returns the size of the file, in bytes.
+  int64_t size() const { return size_; }
+
+ private:
+  uint8_t* data_;
+  int64_t size_;
+
+  DISALLOW_COPY_AND_ASSIGN(MappedFile);
+};
+
 }  // namespace hw3
 
 #endif  // HW3_UTILS_H_
@@ -0,0 +1,109 @@
+/*
+ * Copyright ©2024 Hannah C. Tang.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Washington
+ * CSE 333 for use solely during Spring Quarter 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#include "./WordPool.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "libhw1/CSE333.h"
+#include "libhw1/HashTable.h"
+
+// The size of a chunk of word storage.  Words longer than this get a chunk
+// of their own.
+#define WORDPOOL_CHUNK_BYTES (64 * 1024)
+
+// A block of word storage; the words are packed into "bytes" one after
+// another, each followed by its null terminator.
+typedef struct wp_chunk {
+  struct wp_chunk* next;  // the previously-filled chunk, if any
+  int              size;  // the number of bytes in "bytes"
+  int              used;  // the number of bytes used so far
+  char             bytes[];
+} WordPoolChunk;
+
+// The pool itself.
+static struct {
+  int            refcount;  // 0 if there's no pool
+  HashTable*     words;     // word hash -> interned word
+  WordPoolChunk* chunks;    // the chunk being filled, then all the others
+} pool;
+
+// The word copies are owned by the chunks, not the table.
+static void WP_NoOpFree(HTValue_t value) { }
+
+void WordPool_Acquire(void) {
+  if (pool.refcount++ == 0) {
+    pool.words = HashTable_Allocate(1024);
+    pool.chunks = NULL;
+  }
+}
+
+void WordPool_Release(void) {
+  Verify333(pool.refcount > 0);
+  if (--pool.refcount > 0) {
+    return;
+  }
+
+  HashTable_Free(pool.words, &WP_NoOpFree);
+  pool.words = NULL;
+  while (pool.chunks != NULL) {
+    WordPoolChunk* next = pool.chunks->next;
+    free(pool.chunks);
+    pool.chunks = next;
+  }
+}
+
+const char* WordPool_Intern(const char* word, int len, HTKey_t hash) {
+  HTKeyValue_t kv;
+  char* copy;
+
+  Verify333(pool.refcount > 0);
+  if (HashTable_Find(pool.words, hash, &kv)) {
+    // Ensure we don't have hash collisions (two different words that hash
+    // to the same key, which is very unlikely).
+    copy = (char*) kv.value;
+    Verify333(strncmp(copy, word, len) == 0 && copy[len] == '\0');
+    return copy;
+  }
+
+  // Copy the word into the current chunk, starting a new one if it
+  // doesn't fit.  An oversized word's chunk goes behind the current one,
+  // which may still have room for the next word.
+  WordPoolChunk* chunk = pool.chunks;
+  if (chunk == NULL || chunk->size - chunk->used < len + 1) {
+    int size = len + 1 > WORDPOOL_CHUNK_BYTES ? len + 1 : WORDPOOL_CHUNK_BYTES;
+    chunk = (WordPoolChunk*) malloc(sizeof(WordPoolChunk) + size);
+    Verify333(chunk != NULL);
+    chunk->size = size;
+    chunk->used = 0;
+    if (size > WORDPOOL_CHUNK_BYTES && pool.chunks != NULL) {
+      chunk->next = pool.chunks->next;
+      pool.chunks->next = chunk;
+    } else {
+      chunk->next = pool.chunks;
+      pool.chunks = chunk;
+    }
+  }
+  copy = chunk->bytes + chunk->used;
+  memcpy(copy, word, len);
+  copy[len] = '\0';
+  chunk->used += len + 1;
+
+  kv.key = hash;
+  kv.value = copy;
+  HashTable_Insert(pool.words, kv, &kv);
+  return copy;
+}
+
+int WordPool_NumWords(void) {
+  return pool.refcount > 0 ? HashTable_NumElements(pool.words) : 0;
+}
@@ -0,0 +1,58 @@
+/*
+ * Copyright ©2024 Hannah C. Tang.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Washington
+ * CSE 333 for use solely during Spring Quarter 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#ifndef HW2_WORDPOOL_H_
+#define HW2_WORDPOOL_H_
+
+#include "libhw1/HashTable.h"
+
+// The word pool is a process-wide table of interned words: it keeps a
+// single copy of every distinct word that FileParser and MemIndex have
+// seen, so that a word that appears in a million files is copied once
+// rather than strdup()'ed (and usually free()'d again) a million times.
+// An interned word is identified by its pointer, which stays valid for as
+// long as the pool exists; two words are equal exactly when their
+// pointers are.
+//
+// The words themselves are packed end to end into large chunks, which are
+// only freed along with the whole pool.  The pool is reference counted:
+// every structure that holds interned words (a MemIndex, or a word table
+// from FileParser) takes a reference when it's allocated and drops it when
+// it's freed, and the pool goes away with the last reference.
+//
+// The pool is not thread-safe.
+
+// Takes a reference on the word pool, creating the pool if there isn't
+// one.
+void WordPool_Acquire(void);
+
+// Drops a reference on the word pool.  If it was the last one, the pool
+// and every word in it are freed.
+void WordPool_Release(void);
+
+// Returns the interned copy of a word, adding it to the pool if it isn't
+// there yet.  The caller must hold a reference on the pool.
+//
+// Arguments:
+// - word: the word to intern; it needn't be null-terminated.
+// - len: the number of bytes in the word.
+// - hash: the word's MemIndex_HashWord() hash.
+//
+// Returns:
+// - the pool's null-terminated copy of the word, valid until the last
+//   reference on the pool is dropped.  It must not be modified or freed.
+const char* WordPool_Intern(const char* word, int len, HTKey_t hash);
+
+// Returns the number of distinct words in the pool, or 0 if there's no
+// pool.
+int WordPool_NumWords(void);
+
+#endif  // HW2_WORDPOOL_H_
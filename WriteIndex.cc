@@ -11,8 +11,22 @@
 
 #include "./WriteIndex.h"
 
-#include <cstdio>    // for (FILE *).
-#include <cstring>   // for strlen(), etc.
+#include <errno.h>    // for errno.
+#include <unistd.h>   // for unlink(), pwrite().
+
+#include <algorithm>  // for std::sort().
+#include <atomic>     // for std::atomic.
+#include <cmath>      // for std::nextafter().
+#include <cstdio>     // for (FILE *).
+#include <cstring>    // for strlen(), etc.
+#include <functional>  // for std::greater.
+#include <limits>     // for std::numeric_limits.
+#include <memory>     // for std::unique_ptr.
+#include <queue>      // for std::priority_queue.
+#include <string>     // for std::string.
+#include <thread>     // for std::thread.
+#include <utility>    // for std::pair.
+#include <vector>     // for std::vector.
 
 // We need to peek inside the implementation of a HashTable so
 // that we can iterate through its buckets and their chain elements.
@@ -20,32 +34,180 @@ extern "C" {
   #include "libhw1/CSE333.h"
   #include "libhw1/HashTable_priv.h"
 }
+#include "./BloomFilter.h"
+#include "./BM25.h"
+#include "./FlatHashMap.h"
 #include "./LayoutStructs.h"
 #include "./Utils.h"
 
+using std::pair;
+using std::string;
+using std::unique_ptr;
+using std::vector;
+
 namespace hw3 {
 //////////////////////////////////////////////////////////////////////////////
 // Helper function declarations and constants.
 
 static constexpr int kFailedWrite = -1;
 
+// A word in the term dictionary, and the offset of its element within the
+// memindex.
+typedef pair<string, IndexFileOffset_t> DictTerm;
+
+// The helpers whose output depends on the index file's format are
+// templated on the format's set of records, Offsets32, Offsets64 or
+// OffsetsNative (see LayoutStructs.h).
+//
+// In formats with a kAlignment greater than one, each element's size is
+// rounded up to a multiple of it.  The writers leave the padding as a gap
+// in the file, which reads back as zeros since there's always something
+// written after it.
+
+// Helper function for WriteIndex() which writes the index file in the
+// format "Offsets".
+template <typename Offsets>
+static int64_t WriteIndexFile(MemIndex* mi, DocTable* dt,
+                              const char* file_name, int num_threads);
+
+// Helper function for MergeIndexRuns() which writes the index file in the
+// format "Offsets".
+template <typename Offsets>
+static int64_t MergeIndexFile(const vector<string>& run_names, DocTable* dt,
+                              const char* file_name);
+
 // Helper function to write the docid->filename mapping from the
 // DocTable "dt" into file "f", starting at byte offset "offset".
 // Returns the size of the written DocTable or a negative value on error.
-static int WriteDocTable(FILE* f, DocTable* dt, IndexFileOffset_t offset);
+template <typename Offsets>
+static int64_t WriteDocTable(FILE* f, DocTable* dt, IndexFileOffset_t offset);
 
 // Helper function to write the MemIndex "mi" into file "f", starting
-// at byte offset "offset".  Returns the size of the written MemIndex
+// at byte offset "offset", using "num_threads" threads.  It's laid out
+// exactly as WriteHashTable() would lay it out.  Also computes the BM25
+// score bound of every word into "term_bounds" ("doc_lengths" is as
+// computed by ComputeDocLengths()), every word and where it was written
+// into "terms", and the CRC of the written bytes into *crc.  Returns the
+// size of the written MemIndex or a negative value on error.
+template <typename Offsets>
+static int64_t WriteMemIndex(FILE* f, MemIndex* mi, IndexFileOffset_t offset,
+                             int num_threads,
+                             const vector<uint32_t>& doc_lengths,
+                             vector<TermBoundRecord>* term_bounds,
+                             vector<DictTerm>* terms,
+                             uint32_t* crc);
+
+// Helper function for WriteMemIndex() which returns the number of bytes
+// that WriteWordToPostingsFn() would write for the WordPostings "wp".
+template <typename Offsets>
+static int64_t WordPostingsBytes(WordPostings* wp);
+
+// Helper function for WriteMemIndex() which serializes the MemIndex
+// element "kv" into "buf" exactly as WriteWordToPostingsFn() would write
+// it at byte offset "offset" of the file.  Returns the end of the
+// serialized element within "buf".
+template <typename Offsets>
+static uint8_t* SerializeWordPostings(HTKeyValue_t* kv,
+                                      IndexFileOffset_t offset,
+                                      uint8_t* buf);
+
+// Helper function to find the largest docID in the DocTable "dt".
+static DocID_t MaxDocID(DocTable* dt);
+
+// Helper function to compute the length of every document in the
+// DocTable "dt": the total number of word positions recorded for it across
+// the MemIndex "mi".  On return, (*doc_lengths)[i] is the length of docID
+// (i + 1), or 0 if there is no such document.
+static void ComputeDocLengths(MemIndex* mi, DocTable* dt,
+                              vector<uint32_t>* doc_lengths);
+
+// Helper function to write everything that follows the memindex -- the
+// auxiliary sections, built from "doc_lengths", the word hashes and bounds
+// in "term_bounds" and the words in "terms" -- into file "f", starting at
+// byte offset "offset", and then the header.  "memidx_crc" is as for
+// WriteHeader().  Returns the number of bytes written or a negative value
+// on error.
+template <typename Offsets>
+static int64_t WriteSectionsAndHeader(FILE* f, int64_t doctable_bytes,
+                                      int64_t memidx_bytes,
+                                      IndexFileOffset_t offset,
+                                      const vector<uint32_t>& doc_lengths,
+                                      vector<TermBoundRecord>* term_bounds,
+                                      vector<DictTerm>* terms,
+                                      const uint32_t* memidx_crc);
+
+// Helper function to write the per-document length section built from
+// "doc_lengths" into file "f", starting at byte offset "offset".  Returns
+// the size of the written section (including its SectionHeader) or a
+// negative value on error.
+static int WriteDocLengths(FILE* f, const vector<uint32_t>& doc_lengths,
+                           IndexFileOffset_t offset);
+
+// Helper function to compute the collection statistics that BM25 needs
+// from "doc_lengths", as computed by ComputeDocLengths(), exactly as
+// DocLengthTableReader will at query time: the number of documents, and
+// the length normalization of each one.
+static void ComputeLengthNorms(const vector<uint32_t>& doc_lengths,
+                               int* num_docs, vector<float>* length_norms);
+
+// Helper function to compute a word's BM25 score bound: its best score
+// over all of the documents in its docID->postings table "postings".
+static float TermBound(HashTable* postings, int num_docs,
+                       const vector<float>& length_norms);
+
+// Helper function to write the per-word BM25 score bound section built
+// from "term_bounds" into file "f", starting at byte offset "offset".
+// Returns the size of the written section (including its SectionHeader)
 // or a negative value on error.
-static int WriteMemIndex(FILE* f, MemIndex* mi, IndexFileOffset_t offset);
+static int WriteTermBounds(FILE* f, vector<TermBoundRecord>* term_bounds,
+                           IndexFileOffset_t offset);
+
+// Helper function to write the sorted term dictionary section built from
+// "terms" into file "f", starting at byte offset "offset".  Returns the
+// size of the written section (including its SectionHeader) or a negative
+// value on error.
+static int WriteTermDict(FILE* f, vector<DictTerm>* terms,
+                         IndexFileOffset_t offset);
+
+// Helper function to write the Bloom filter section holding "filter" into
+// file "f", starting at byte offset "offset".  Returns the size of the
+// written section (including its SectionHeader) or a negative value on
+// error.
+static int WriteBloomFilter(FILE* f, const BloomFilter& filter,
+                            IndexFileOffset_t offset);
+
+// Helper function to write a section header followed by "payload_bytes"
+// bytes from "payload" into file "f", starting at byte offset "offset".
+// Returns the size of the written section or a negative value on error.
+static int WriteSection(FILE* f, IndexFileOffset_t offset, uint32_t tag,
+                        const void* payload, int32_t payload_bytes);
 
 // Helper function to write the index file's header into file "f".
-// Will atomically write the kMagicNumber as its very last operation;
+// Will atomically write the magic number as its very last operation;
 // as a result, if we crash part way through writing an index file,
-// it won't contain a valid kMagicNumber and the rest of HW3 will
-// know to report an error.  On success, returns the number of header
-// bytes written; on failure, a negative value.
-static int WriteHeader(FILE* f, int doctable_bytes, int memidx_bytes);
+// it won't contain a valid magic number and the rest of HW3 will
+// know to report an error.  The magic number also records
+// MemIndex_WordHashID(), the hash function the MemIndex's words were
+// keyed with, and the file's format.  On success, returns the number of
+// header bytes written; on failure, a negative value.
+//
+// "section_bytes" is the total size of the auxiliary sections that follow
+// the memindex; they are included in the checksum.  If "memidx_crc" isn't
+// nullptr, it's the CRC of the memindex, which is then not read back.
+template <typename Offsets>
+static int64_t WriteHeader(FILE* f, int64_t doctable_bytes,
+                           int64_t memidx_bytes, int64_t section_bytes,
+                           const uint32_t* memidx_crc);
+
+// Helper function to fold the "len" bytes of file "f" starting at byte
+// offset "offset" into "crc".  Returns false on error.
+static bool ChecksumFileRange(FILE* f, IndexFileOffset_t offset,
+                              int64_t len, CRC32* crc);
+
+// Helper function to pwrite() all "len" bytes of "buf" to file descriptor
+// "fd" at byte offset "offset".  Returns false on error.
+static bool PWriteAll(int fd, const uint8_t* buf, size_t len,
+                      IndexFileOffset_t offset);
 
 // Function pointer used by WriteHashTable() to write a HashTable's
 // HTKeyValue_t element into the index file at a specified byte offset.
@@ -58,8 +220,8 @@ static int WriteHeader(FILE* f, int doctable_bytes, int memidx_bytes);
 //
 // Returns:
 //   - the number of bytes written, or a negative value on error.
-typedef int (*WriteElementFn)(FILE* f, IndexFileOffset_t offset,
-                              HTKeyValue_t* kv);
+typedef int64_t (*WriteElementFn)(FILE* f, IndexFileOffset_t offset,
+                                  HTKeyValue_t* kv);
 
 // Writes a HashTable into the index file at a specified byte offset.
 //
@@ -80,8 +242,9 @@ typedef int (*WriteElementFn)(FILE* f, IndexFileOffset_t offset,
 //
 // Returns:
 //   - the number of bytes written, or a negative value on error.
-static int WriteHashTable(FILE* f, IndexFileOffset_t offset, HashTable* ht,
-                          WriteElementFn fn);
+template <typename Offsets>
+static int64_t WriteHashTable(FILE* f, IndexFileOffset_t offset,
+                              HashTable* ht, WriteElementFn fn);
 
 // Helper function used by WriteHashTable() to write a BucketRecord (ie, a
 // "bucket_rec" within the hw3 diagrams).
@@ -97,9 +260,10 @@ static int WriteHashTable(FILE* f, IndexFileOffset_t offset, HashTable* ht,
 //
 // Returns:
 //   - the number of bytes written, or a negative value on error.
-static int WriteHTBucketRecord(FILE* f, IndexFileOffset_t offset,
-                               int32_t num_elts,
-                               IndexFileOffset_t bucket_offset);
+template <typename Offsets>
+static int64_t WriteHTBucketRecord(FILE* f, IndexFileOffset_t offset,
+                                   int32_t num_elts,
+                                   IndexFileOffset_t bucket_offset);
 
 // Helper function used by WriteHashTable() to write out a bucket.
 //
@@ -117,8 +281,9 @@ static int WriteHTBucketRecord(FILE* f, IndexFileOffset_t offset,
 //
 // Returns:
 //   - the number of bytes written, or a negative value on error.
-static int WriteHTBucket(FILE* f, IndexFileOffset_t offset,
-                         LinkedList* li, WriteElementFn fn);
+template <typename Offsets>
+static int64_t WriteHTBucket(FILE* f, IndexFileOffset_t offset,
+                             LinkedList* li, WriteElementFn fn);
 
 
 //////////////////////////////////////////////////////////////////////////////
@@ -129,30 +294,47 @@ static int WriteHTBucket(FILE* f, IndexFileOffset_t offset,
 
 // Writes an element of the IdToName table from a DocTable into
 // a specified file at a specified offset.
-static int WriteDocidToDocnameFn(FILE* f, IndexFileOffset_t offset,
-                                 HTKeyValue_t* kv);
+template <typename Offsets>
+static int64_t WriteDocidToDocnameFn(FILE* f, IndexFileOffset_t offset,
+                                     HTKeyValue_t* kv);
 
 
 // Writes an element of the MemIndex into a
 // a specified file at a specified offset.
-static int WriteWordToPostingsFn(FILE* f, IndexFileOffset_t offset,
-                                 HTKeyValue_t* kv);
+template <typename Offsets>
+static int64_t WriteWordToPostingsFn(FILE* f, IndexFileOffset_t offset,
+                                     HTKeyValue_t* kv);
 
 // Writes an element of an inner postings table into
 // a specified file at a specified offset.
-static int WriteDocIDToPositionListFn(FILE* f, IndexFileOffset_t offset,
-                                      HTKeyValue_t* kv);
+template <typename Offsets>
+static int64_t WriteDocIDToPositionListFn(FILE* f, IndexFileOffset_t offset,
+                                          HTKeyValue_t* kv);
 
 
 //////////////////////////////////////////////////////////////////////////////
 // WriteIndex
 
-int WriteIndex(MemIndex* mi, DocTable* dt, const char* file_name) {
+int64_t WriteIndex(MemIndex* mi, DocTable* dt, const char* file_name,
+                   int num_threads, IndexFormat format) {
   // Do some sanity checking on the arguments we were given.
   Verify333(mi != nullptr);
   Verify333(dt != nullptr);
   Verify333(file_name != nullptr);
 
+  if (format == kIndexFormat64) {
+    return WriteIndexFile<Offsets64>(mi, dt, file_name, num_threads);
+  }
+  if (format == kIndexFormatNative) {
+    return WriteIndexFile<OffsetsNative>(mi, dt, file_name, num_threads);
+  }
+  Verify333(format == kIndexFormat32);
+  return WriteIndexFile<Offsets32>(mi, dt, file_name, num_threads);
+}
+
+template <typename Offsets>
+static int64_t WriteIndexFile(MemIndex* mi, DocTable* dt,
+                              const char* file_name, int num_threads) {
   // fopen() the file for writing; use mode "wb+" to indicate binary,
   // write mode, and to create/truncate the file.
   FILE* f = fopen(file_name, "wb+");
@@ -161,15 +343,15 @@ int WriteIndex(MemIndex* mi, DocTable* dt, const char* file_name) {
   }
 
   // Remember that the format of the index file is a header, followed by a
-  // doctable, and then lastly a memindex.
+  // doctable, then a memindex, and lastly any auxiliary sections.
   //
   // We write out the doctable and memindex first, since we need to know
   // their sizes before we can calculate the header.  So we'll skip over
   // the header for now.
-  IndexFileOffset_t cur_pos = sizeof(IndexFileHeader);
+  IndexFileOffset_t cur_pos = sizeof(typename Offsets::Header);
 
   // Write the document table.
-  int dt_bytes = WriteDocTable(f, dt, cur_pos);
+  int64_t dt_bytes = WriteDocTable<Offsets>(f, dt, cur_pos);
   if (dt_bytes == kFailedWrite) {
     fclose(f);
     unlink(file_name);  // delete the file
@@ -178,9 +360,20 @@ int WriteIndex(MemIndex* mi, DocTable* dt, const char* file_name) {
   cur_pos += dt_bytes;
 
   // STEP 1.
-  // Write the memindex.
+  // Write the memindex.  The word bounds are computed along the way, so
+  // the document lengths they depend on are needed first.
+  vector<uint32_t> doc_lengths;
+  ComputeDocLengths(mi, dt, &doc_lengths);
+  vector<TermBoundRecord> term_bounds;
+  vector<DictTerm> terms;
+  if (num_threads <= 0) {
+    num_threads = std::max(1U, std::thread::hardware_concurrency());
+  }
 
-  int mt_bytes = WriteMemIndex(f, mi, cur_pos);
+  uint32_t mt_crc;
+  int64_t mt_bytes = WriteMemIndex<Offsets>(f, mi, cur_pos, num_threads,
+                                            doc_lengths, &term_bounds,
+                                            &terms, &mt_crc);
   if (mt_bytes == kFailedWrite) {
     fclose(f);
     unlink(file_name);
@@ -188,10 +381,21 @@ int WriteIndex(MemIndex* mi, DocTable* dt, const char* file_name) {
   }
   cur_pos += mt_bytes;
 
-  // STEP 2.
-  // Finally, backtrack to write the index header and write it.
+  // Every offset written so far is smaller than this one, so if it fits
+  // in the format's offsets, they all do.
+  if (cur_pos > Offsets::kMaxOffset) {
+    fclose(f);
+    unlink(file_name);
+    return kFailedWrite;
+  }
 
-  int res = WriteHeader(f, dt_bytes, mt_bytes);
+  // STEP 2.
+  // Write the auxiliary sections that follow the memindex, and finally,
+  // backtrack to write the index header.
+  int64_t res = WriteSectionsAndHeader<Offsets>(f, dt_bytes, mt_bytes,
+                                                cur_pos, doc_lengths,
+                                                &term_bounds, &terms,
+                                                &mt_crc);
   if (res == kFailedWrite) {
     fclose(f);
     unlink(file_name);
@@ -205,53 +409,1108 @@ int WriteIndex(MemIndex* mi, DocTable* dt, const char* file_name) {
 }
 
 
+//////////////////////////////////////////////////////////////////////////////
+// Index runs
+//
+// A run is a temporary file holding part of an inverted index, for
+// building an index in bounded memory.  Runs are private to this file and
+// never outlive the build, so they're written in host byte order:
+//
+//   RunHeader
+//   num_docs x RunDocLength   (the length of each of the run's documents)
+//   num_words x HTKey_t       (the words' hashes, in increasing order)
+//   num_words x {             (the words, in the same order)
+//     RunWordHeader, then the word itself (without a null terminator),
+//     num_docs x {            (in increasing docID order)
+//       RunDocHeader, then num_positions x DocPositionOffset_t
+//     }
+//   }
+//
+// The hashes are repeated up front so that MergeIndexRuns() can count the
+// merged index's words without reading the postings.
+
+static constexpr uint32_t kRunMagicNumber = 0x52554E31;  // "RUN1"
+
+struct RunHeader {
+  uint32_t magic;      // kRunMagicNumber
+  uint32_t num_docs;   // the number of RunDocLengths
+  uint64_t num_words;  // the number of words
+};
+
+struct RunDocLength {
+  DocID_t  doc_id;  // a document in the run
+  uint32_t length;  // its length, as for the DocLengths section
+};
+
+struct RunWordHeader {
+  HTKey_t  word_hash;   // the word's MemIndex_HashWord() hash
+  uint32_t word_bytes;  // the length of the word that follows
+  uint32_t num_docs;    // the number of documents that follow the word
+};
+
+struct RunDocHeader {
+  DocID_t  doc_id;         // a document containing the word
+  uint32_t num_positions;  // the number of positions that follow
+};
+
+// Reads a run back in, one word at a time.  A run that can't be read in
+// full (say, one cut short by a full disk) makes the read that runs into
+// the problem fail, and failed() true from then on.
+class RunReader {
+ public:
+  RunReader() : file_(nullptr), hashes_(nullptr), words_left_(0),
+                hashes_left_(0), failed_(false) { }
+  ~RunReader() {
+    if (file_ != nullptr) {
+      fclose(file_);
+    }
+    if (hashes_ != nullptr) {
+      fclose(hashes_);
+    }
+  }
+
+  // Opens the run "file_name", and records the lengths of its documents
+  // in "doc_lengths", which must have room for them.  Returns false on
+  // failure.
+  bool Open(const char* file_name, vector<uint32_t>* doc_lengths) {
+    RunHeader header;
+    file_ = fopen(file_name, "rb");
+    hashes_ = fopen(file_name, "rb");
+    if (file_ == nullptr || hashes_ == nullptr ||
+        fread(&header, sizeof(RunHeader), 1, file_) != 1 ||
+        header.magic != kRunMagicNumber) {
+      return false;
+    }
+
+    vector<RunDocLength> lengths(header.num_docs);
+    if (header.num_docs > 0 &&
+        fread(lengths.data(), sizeof(RunDocLength), lengths.size(), file_) !=
+        lengths.size()) {
+      return false;
+    }
+    for (const RunDocLength& length : lengths) {
+      if (length.doc_id < 1 || length.doc_id > doc_lengths->size()) {
+        return false;
+      }
+      (*doc_lengths)[length.doc_id - 1] = length.length;
+    }
+
+    // The hashes are read through their own FILE, so that both streams
+    // stay sequential.
+    long hashes_pos = ftell(file_);  // NOLINT(runtime/int)
+    words_left_ = hashes_left_ = header.num_words;
+    return fseek(hashes_, hashes_pos, SEEK_SET) == 0 &&
+      fseek(file_, hashes_pos + header.num_words * sizeof(HTKey_t),
+            SEEK_SET) == 0;
+  }
+
+  // Reads the next word's hash into *hash, or returns false if there are
+  // no more or it can't be read.
+  bool NextHash(HTKey_t* hash) {
+    if (hashes_left_ == 0 || failed_) {
+      return false;
+    }
+    hashes_left_--;
+    failed_ = fread(hash, sizeof(HTKey_t), 1, hashes_) != 1;
+    return !failed_;
+  }
+
+  // Reads the next word, or returns false if there are no more or it
+  // can't be read.  The current word's postings must have been read
+  // first.
+  bool NextWord() {
+    Verify333(header_.num_docs == 0);
+    if (words_left_ == 0 || failed_) {
+      return false;
+    }
+    words_left_--;
+    if (fread(&header_, sizeof(RunWordHeader), 1, file_) != 1) {
+      header_ = RunWordHeader();
+      failed_ = true;
+      return false;
+    }
+    word_.resize(header_.word_bytes);
+    failed_ = fread(&word_[0], 1, word_.size(), file_) != word_.size();
+    if (failed_) {
+      header_.num_docs = 0;
+    }
+    return !failed_;
+  }
+
+  HTKey_t word_hash() const { return header_.word_hash; }
+  const string& word() const { return word_; }
+
+  // Reads the current word's postings, adding them to the docID->postings
+  // table "postings".  Returns false if they can't all be read, in which
+  // case some of them may have been added.
+  bool ReadPostings(HashTable* postings) {
+    RunDocHeader doc;
+    vector<DocPositionOffset_t> positions;
+    for (; header_.num_docs > 0; header_.num_docs--) {
+      if (fread(&doc, sizeof(RunDocHeader), 1, file_) != 1) {
+        break;
+      }
+      positions.resize(doc.num_positions);
+      if (fread(positions.data(), sizeof(DocPositionOffset_t),
+                positions.size(), file_) != positions.size()) {
+        break;
+      }
+
+      LinkedList* list = LinkedList_Allocate();
+      for (DocPositionOffset_t position : positions) {
+        LinkedList_Append(list, (LLPayload_t) (int64_t) position);
+      }
+      HTKeyValue_t kv, old_kv;
+      kv.key = doc.doc_id;
+      kv.value = list;
+      Verify333(!HashTable_Insert(postings, kv, &old_kv));
+    }
+    if (header_.num_docs > 0) {
+      header_.num_docs = 0;
+      failed_ = true;
+    }
+    return !failed_;
+  }
+
+  // Returns whether a read from the run has failed.
+  bool failed() const { return failed_; }
+
+ private:
+  FILE* file_;            // the run, positioned at the next word's postings
+  FILE* hashes_;          // the run, positioned at the next word's hash
+  uint64_t words_left_;   // the number of words not yet read from file_
+  uint64_t hashes_left_;  // the number of hashes not yet read from hashes_
+  RunWordHeader header_ = RunWordHeader();  // the current word; num_docs
+                                            // counts down as they're read
+  string word_;           // the current word
+  bool failed_;           // whether a read has failed
+
+  DISALLOW_COPY_AND_ASSIGN(RunReader);
+};
+
+// Frees a docID->postings table entry read by RunReader::ReadPostings().
+static void FreePositions(HTValue_t value) {
+  LinkedList_Free(static_cast<LinkedList*>(value), [](LLPayload_t p) { });
+}
+
+// Returns whether reading any of "runs" has failed.
+static bool AnyRunFailed(const vector<unique_ptr<RunReader>>& runs) {
+  for (const unique_ptr<RunReader>& run : runs) {
+    if (run->failed()) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// A (hash, run) pair; a min-heap of them orders the runs' next words by
+// hash, and then by run.
+typedef pair<HTKey_t, size_t> RunHead;
+typedef std::priority_queue<RunHead, vector<RunHead>, std::greater<RunHead>>
+  RunHeap;
+
+int64_t WriteIndexRun(MemIndex* mi, const char* file_name) {
+  Verify333(mi != nullptr);
+  Verify333(file_name != nullptr);
+
+  FILE* f = fopen(file_name, "wb");
+  if (f == nullptr) {
+    return kFailedWrite;
+  }
+
+  // Sort the words by hash, and add up the documents' lengths.
+  vector<HTKeyValue_t> words;
+  words.reserve(mi->num_elements);
+  FlatHashMap<DocID_t, uint32_t> lengths;
+  HTIterator word_it;
+  for (HTIterator_Init(&word_it, mi);
+       HTIterator_IsValid(&word_it);
+       HTIterator_Next(&word_it)) {
+    HTKeyValue_t word_kv;
+    HTIterator_Get(&word_it, &word_kv);
+    words.push_back(word_kv);
+
+    HTIterator doc_it;
+    HashTable* postings = static_cast<WordPostings*>(word_kv.value)->postings;
+    for (HTIterator_Init(&doc_it, postings);
+         HTIterator_IsValid(&doc_it);
+         HTIterator_Next(&doc_it)) {
+      HTKeyValue_t kv;
+      HTIterator_Get(&doc_it, &kv);
+      lengths[kv.key] +=
+        LinkedList_NumElements(static_cast<LinkedList*>(kv.value));
+    }
+  }
+  auto by_key = [](const HTKeyValue_t& a, const HTKeyValue_t& b) {
+    return a.key < b.key;
+  };
+  std::sort(words.begin(), words.end(), by_key);
+
+  vector<RunDocLength> doc_lengths;
+  doc_lengths.reserve(lengths.size());
+  lengths.ForEach([&doc_lengths](const DocID_t& doc_id, uint32_t& length) {
+    doc_lengths.push_back({doc_id, length});
+  });
+
+  // Write the header, the lengths and the hashes.
+  RunHeader header = {kRunMagicNumber,
+                      static_cast<uint32_t>(doc_lengths.size()), words.size()};
+  bool ok = fwrite(&header, sizeof(RunHeader), 1, f) == 1 &&
+    fwrite(doc_lengths.data(), sizeof(RunDocLength), doc_lengths.size(), f) ==
+    doc_lengths.size();
+  for (size_t i = 0; ok && i < words.size(); i++) {
+    ok = fwrite(&words[i].key, sizeof(HTKey_t), 1, f) == 1;
+  }
+
+  // Then each word and its postings, in docID order.
+  vector<HTKeyValue_t> docs;
+  vector<DocPositionOffset_t> positions;
+  for (size_t i = 0; ok && i < words.size(); i++) {
+    WordPostings* wp = static_cast<WordPostings*>(words[i].value);
+    docs.clear();
+    HashTable_ForEach(wp->postings, [](HTKeyValue_t* kv, void* arg) {
+      static_cast<vector<HTKeyValue_t>*>(arg)->push_back(*kv);
+    }, &docs);
+    std::sort(docs.begin(), docs.end(), by_key);
+
+    RunWordHeader word_header = {words[i].key,
+                                 static_cast<uint32_t>(strlen(wp->word)),
+                                 static_cast<uint32_t>(docs.size())};
+    ok = fwrite(&word_header, sizeof(RunWordHeader), 1, f) == 1 &&
+      fwrite(wp->word, 1, word_header.word_bytes, f) ==
+      word_header.word_bytes;
+    for (size_t j = 0; ok && j < docs.size(); j++) {
+      LinkedList* list = static_cast<LinkedList*>(docs[j].value);
+      positions.clear();
+      LLIterator it;
+      for (LLIterator_Init(&it, list);
+           LLIterator_IsValid(&it);
+           LLIterator_Next(&it)) {
+        LLPayload_t payload;
+        LLIterator_Get(&it, &payload);
+        positions.push_back((DocPositionOffset_t) (int64_t) payload);
+      }
+      RunDocHeader doc_header = {docs[j].key,
+                                 static_cast<uint32_t>(positions.size())};
+      ok = fwrite(&doc_header, sizeof(RunDocHeader), 1, f) == 1 &&
+        fwrite(positions.data(), sizeof(DocPositionOffset_t),
+               positions.size(), f) == positions.size();
+    }
+  }
+
+  long bytes = ftell(f);  // NOLINT(runtime/int)
+  if (fclose(f) != 0 || !ok) {
+    unlink(file_name);
+    return kFailedWrite;
+  }
+  return bytes;
+}
+
+// Helper function for MergeIndexRuns(), which merges the words of the
+// runs read by "runs" into a memindex in file "f", starting at byte offset
+// "offset", computing their BM25 score bounds as it goes.  Returns the size
+// of the written memindex or a negative value on error.
+//
+// The memindex is laid out a little differently than WriteHashTable() lays
+// out a HashTable: each word is written as soon as it has been merged, so
+// the words aren't grouped by bucket, and every bucket's list of
+// ElementPositionRecords comes after all of the words.  Readers only ever
+// follow the offsets, so they can't tell the difference.
+template <typename Offsets>
+static int64_t MergeMemIndex(FILE* f,
+                             const vector<unique_ptr<RunReader>>& runs,
+                             const vector<uint32_t>& doc_lengths,
+                             IndexFileOffset_t offset,
+                             vector<TermBoundRecord>* term_bounds,
+                             vector<DictTerm>* terms) {
+  typedef typename Offsets::ListHeader BucketListHeader;
+  typedef typename Offsets::Bucket BucketRecord;
+  typedef typename Offsets::ElementPosition ElementPositionRecord;
+
+  // Count the distinct words, and give the table at least one bucket per
+  // word.
+  RunHeap heap;
+  HTKey_t hash;
+  for (size_t i = 0; i < runs.size(); i++) {
+    if (runs[i]->NextHash(&hash)) {
+      heap.push(RunHead(hash, i));
+    }
+  }
+  int num_words = 0;
+  while (!heap.empty()) {
+    RunHead head = heap.top();
+    heap.pop();
+    if (num_words == 0 || head.first != hash) {
+      num_words++;
+      hash = head.first;
+    }
+    if (runs[head.second]->NextHash(&head.first)) {
+      heap.push(head);
+    }
+  }
+  if (AnyRunFailed(runs)) {
+    return kFailedWrite;
+  }
+  int32_t num_buckets = 1;
+  while (num_buckets < num_words) {
+    num_buckets *= 2;
+  }
+
+  // Write the words, remembering which bucket each is in and where.
+  int num_docs;
+  vector<float> length_norms;
+  ComputeLengthNorms(doc_lengths, &num_docs, &length_norms);
+  term_bounds->reserve(num_words);
+  terms->reserve(num_words);
+
+  vector<pair<int32_t, IndexFileOffset_t>> elements;
+  elements.reserve(num_words);
+  IndexFileOffset_t element_pos = offset + sizeof(BucketListHeader) +
+    num_buckets * sizeof(BucketRecord);
+  for (size_t i = 0; i < runs.size(); i++) {
+    if (runs[i]->NextWord()) {
+      heap.push(RunHead(runs[i]->word_hash(), i));
+    }
+  }
+  while (!heap.empty()) {
+    // The heap yields the runs holding the next word in run order, so
+    // their documents are added in increasing docID order, just as
+    // CrawlFileTree() would have added them.
+    hash = heap.top().first;
+    string word = runs[heap.top().second]->word();
+    HashTable* postings = HashTable_Allocate(16);
+    while (!heap.empty() && heap.top().first == hash) {
+      size_t i = heap.top().second;
+      heap.pop();
+      Verify333(runs[i]->word() == word);
+      if (!runs[i]->ReadPostings(postings)) {
+        HashTable_Free(postings, &FreePositions);
+        return kFailedWrite;
+      }
+      if (runs[i]->NextWord()) {
+        heap.push(RunHead(runs[i]->word_hash(), i));
+      }
+    }
+
+    WordPostings wp = {word.c_str(), postings};
+    HTKeyValue_t kv;
+    kv.key = hash;
+    kv.value = &wp;
+    int64_t element_bytes =
+      WriteWordToPostingsFn<Offsets>(f, element_pos, &kv);
+    term_bounds->emplace_back(hash,
+                              TermBound(postings, num_docs, length_norms));
+    HashTable_Free(postings, &FreePositions);
+    if (element_bytes == kFailedWrite) {
+      return kFailedWrite;
+    }
+    elements.emplace_back(hash & (num_buckets - 1), element_pos);
+    terms->emplace_back(std::move(word), element_pos);
+    element_pos += element_bytes;
+  }
+  if (AnyRunFailed(runs)) {
+    return kFailedWrite;
+  }
+
+  // Now that we know where every word is, write the buckets' lists of
+  // element positions, and the bucket records pointing to them.
+  std::stable_sort(elements.begin(), elements.end(),
+                   [](const pair<int32_t, IndexFileOffset_t>& a,
+                      const pair<int32_t, IndexFileOffset_t>& b) {
+                     return a.first < b.first;
+                   });
+  vector<BucketRecord> bucket_records;
+  bucket_records.reserve(num_buckets);
+  vector<ElementPositionRecord> position_records;
+  position_records.reserve(elements.size());
+  IndexFileOffset_t bucket_pos = element_pos;
+  size_t e = 0;
+  for (int32_t b = 0; b < num_buckets; b++) {
+    int32_t chain_len = 0;
+    for (; e < elements.size() && elements[e].first == b; e++, chain_len++) {
+      position_records.emplace_back(elements[e].second);
+      position_records.back().ToDiskFormat();
+    }
+    bucket_records.emplace_back(chain_len, bucket_pos);
+    bucket_records.back().ToDiskFormat();
+    bucket_pos += chain_len * sizeof(ElementPositionRecord);
+  }
+
+  BucketListHeader header(num_buckets);
+  header.ToDiskFormat();
+  if (fseek(f, offset, SEEK_SET) != 0 ||
+      fwrite(&header, sizeof(BucketListHeader), 1, f) != 1 ||
+      fwrite(bucket_records.data(), sizeof(BucketRecord),
+             bucket_records.size(), f) != bucket_records.size() ||
+      fseek(f, element_pos, SEEK_SET) != 0 ||
+      fwrite(position_records.data(), sizeof(ElementPositionRecord),
+             position_records.size(), f) != position_records.size()) {
+    return kFailedWrite;
+  }
+  return bucket_pos - offset;
+}
+
+int64_t MergeIndexRuns(const vector<string>& run_names, DocTable* dt,
+                       const char* file_name, IndexFormat format) {
+  Verify333(dt != nullptr);
+  Verify333(file_name != nullptr);
+
+  if (format == kIndexFormat64) {
+    return MergeIndexFile<Offsets64>(run_names, dt, file_name);
+  }
+  if (format == kIndexFormatNative) {
+    return MergeIndexFile<OffsetsNative>(run_names, dt, file_name);
+  }
+  Verify333(format == kIndexFormat32);
+  return MergeIndexFile<Offsets32>(run_names, dt, file_name);
+}
+
+template <typename Offsets>
+static int64_t MergeIndexFile(const vector<string>& run_names, DocTable* dt,
+                              const char* file_name) {
+  // Open the runs, gathering up the documents' lengths as we go; each
+  // document is in exactly one run.
+  vector<uint32_t> doc_lengths(MaxDocID(dt), 0);
+  vector<unique_ptr<RunReader>> runs;
+  for (const string& run_name : run_names) {
+    runs.emplace_back(new RunReader());
+    if (!runs.back()->Open(run_name.c_str(), &doc_lengths)) {
+      return kFailedWrite;
+    }
+  }
+
+  FILE* f = fopen(file_name, "wb+");
+  if (f == nullptr) {
+    return kFailedWrite;
+  }
+
+  // The file is laid out just as WriteIndex() lays it out, except for the
+  // memindex; see MergeMemIndex().
+  IndexFileOffset_t cur_pos = sizeof(typename Offsets::Header);
+  int64_t dt_bytes = WriteDocTable<Offsets>(f, dt, cur_pos);
+  if (dt_bytes == kFailedWrite) {
+    fclose(f);
+    unlink(file_name);
+    return kFailedWrite;
+  }
+  cur_pos += dt_bytes;
+
+  vector<TermBoundRecord> term_bounds;
+  vector<DictTerm> terms;
+  int64_t mt_bytes = MergeMemIndex<Offsets>(f, runs, doc_lengths, cur_pos,
+                                            &term_bounds, &terms);
+  if (mt_bytes == kFailedWrite || cur_pos + mt_bytes > Offsets::kMaxOffset) {
+    fclose(f);
+    unlink(file_name);
+    return kFailedWrite;
+  }
+  cur_pos += mt_bytes;
+
+  int64_t res = WriteSectionsAndHeader<Offsets>(f, dt_bytes, mt_bytes,
+                                                cur_pos, doc_lengths,
+                                                &term_bounds, &terms,
+                                                nullptr);
+  if (res == kFailedWrite) {
+    fclose(f);
+    unlink(file_name);
+    return kFailedWrite;
+  }
+  cur_pos += res;
+
+  fclose(f);
+  return cur_pos;
+}
+
+
 //////////////////////////////////////////////////////////////////////////////
 // Helper function definitions
 
-static int WriteDocTable(FILE* f, DocTable* dt, IndexFileOffset_t offset) {
+template <typename Offsets>
+static int64_t WriteDocTable(FILE* f, DocTable* dt, IndexFileOffset_t offset) {
   // Break the DocTable abstraction in order to grab the docid->filename
   // hash table, then serialize it to disk.
-  return WriteHashTable(f, offset, DT_GetIDToNameTable(dt),
-                        &WriteDocidToDocnameFn);
+  return WriteHashTable<Offsets>(f, offset, DT_GetIDToNameTable(dt),
+                                 &WriteDocidToDocnameFn<Offsets>);
 }
 
-static int WriteMemIndex(FILE* f, MemIndex* mi, IndexFileOffset_t offset) {
-  // Use WriteHashTable() to write the MemIndex into the file.  You'll
-  // need to pass in the WriteWordToPostingsFn helper function as the
-  // final argument.
-  return WriteHashTable(f, offset, mi, &WriteWordToPostingsFn);
+// Runs fn(0), ..., fn(num_threads - 1) on that many threads, the first on
+// the calling thread, and waits for them all to finish.
+template <typename Fn>
+static void RunOnThreads(int num_threads, Fn fn) {
+  vector<std::thread> threads;
+  for (int i = 1; i < num_threads; i++) {
+    threads.emplace_back(fn, i);
+  }
+  fn(0);
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
 }
 
-static int WriteHeader(FILE* f, int doctable_bytes, int memidx_bytes) {
-  // STEP 3.
-  // We need to calculate the checksum over the doctable and index
-  // table.  (Note that the checksum does not include the index file
-  // header, just these two tables.)
-  //
-  // Use fseek() to seek to the right location, and use a CRC32 object
-  // to do the CRC checksum calculation, feeding it characters that you
-  // read from the index file using fread().
-  // Seek to the start of the doctable.
-  CRC32 crc;
+// Copies "record" into "buf" in disk format, returning the end of the copy.
+template <typename T>
+static uint8_t* Put(uint8_t* buf, T record) {
+  record.ToDiskFormat();
+  memcpy(buf, &record, sizeof(T));
+  return buf + sizeof(T);
+}
+
+template <typename Offsets>
+static int64_t WriteMemIndex(FILE* f, MemIndex* mi, IndexFileOffset_t offset,
+                             int num_threads,
+                             const vector<uint32_t>& doc_lengths,
+                             vector<TermBoundRecord>* term_bounds,
+                             vector<DictTerm>* terms,
+                             uint32_t* crc) {
+  typedef typename Offsets::ListHeader BucketListHeader;
+  typedef typename Offsets::Bucket BucketRecord;
+  typedef typename Offsets::ElementPosition ElementPositionRecord;
+
+  // WriteHashTable() would write the MemIndex one element at a time, since
+  // it can't know where an element goes until the one before it has been
+  // written.  But each element's size can be worked out independently, so
+  // we work out all of their sizes in parallel, add them up to find every
+  // element's offset, and then have each thread serialize a contiguous
+  // range of buckets and pwrite() it into place.  Each thread checksums
+  // its range, and the ranges' CRCs are combined at the end.
+  int64_t num_buckets = mi->num_buckets;
+
+  // List the elements in the order they're written: bucket by bucket, and
+  // in chain order within each bucket.
+  vector<HTKeyValue_t*> elements;
+  elements.reserve(mi->num_elements);
+  vector<size_t> first_element(num_buckets + 1);
+  for (int64_t b = 0; b < num_buckets; b++) {
+    first_element[b] = elements.size();
+    LLIterator it;
+    for (LLIterator_Init(&it, mi->buckets[b]);
+         LLIterator_IsValid(&it);
+         LLIterator_Next(&it)) {
+      LLPayload_t payload;
+      LLIterator_Get(&it, &payload);
+      elements.push_back(static_cast<HTKeyValue_t*>(payload));
+    }
+  }
+  first_element[num_buckets] = elements.size();
+
+  // Size every element, and compute its word's bound while we're there.
+  // The words' sizes vary wildly, so the threads claim small batches of
+  // elements as they go rather than splitting them up in advance.
+  int num_docs;
+  vector<float> length_norms;
+  ComputeLengthNorms(doc_lengths, &num_docs, &length_norms);
+  vector<int64_t> sizes(elements.size());
+  term_bounds->resize(elements.size());
+  std::atomic<size_t> next_element(0);
+  RunOnThreads(num_threads, [&](int thread) {
+    static constexpr size_t kBatch = 64;
+    size_t begin;
+    while ((begin = next_element.fetch_add(kBatch)) < elements.size()) {
+      size_t end = std::min(begin + kBatch, elements.size());
+      for (size_t i = begin; i < end; i++) {
+        WordPostings* wp = static_cast<WordPostings*>(elements[i]->value);
+        sizes[i] = WordPostingsBytes<Offsets>(wp);
+        (*term_bounds)[i] = TermBoundRecord(
+          elements[i]->key, TermBound(wp->postings, num_docs, length_norms));
+      }
+    }
+  });
+
+  // Add up the sizes to find where each bucket, and each word, goes.
+  vector<IndexFileOffset_t> bucket_pos(num_buckets + 1);
+  int64_t pos = offset + sizeof(BucketListHeader)
+    + num_buckets * sizeof(BucketRecord);
+  terms->reserve(elements.size());
+  for (int64_t b = 0; b < num_buckets; b++) {
+    bucket_pos[b] = pos;
+    pos += (first_element[b + 1] - first_element[b])
+      * sizeof(ElementPositionRecord);
+    for (size_t i = first_element[b]; i < first_element[b + 1]; i++) {
+      WordPostings* wp = static_cast<WordPostings*>(elements[i]->value);
+      terms->emplace_back(wp->word, pos);
+      pos += sizes[i];
+    }
+  }
+  bucket_pos[num_buckets] = pos;
+  if (pos > Offsets::kMaxOffset) {
+    return kFailedWrite;
+  }
+
+  // Write the header and the bucket records ourselves.  Anything the
+  // FILE has buffered must reach the file before the threads write
+  // around it.
+  vector<uint8_t> records(sizeof(BucketListHeader)
+                          + num_buckets * sizeof(BucketRecord));
+  uint8_t* p = Put(records.data(), BucketListHeader(num_buckets));
+  for (int64_t b = 0; b < num_buckets; b++) {
+    p = Put(p, BucketRecord(first_element[b + 1] - first_element[b],
+                            bucket_pos[b]));
+  }
+  CRC32 records_crc;
+  records_crc.FoldBytesIntoCRC(records.data(), records.size());
+  int fd = fileno(f);
+  if (fflush(f) != 0 ||
+      !PWriteAll(fd, records.data(), records.size(), offset)) {
+    return kFailedWrite;
+  }
+
+  // Split the buckets into one contiguous range per thread, with about
+  // the same number of bytes in each.
+  num_threads = std::max<int64_t>(1, std::min<int64_t>(num_threads,
+                                                       num_buckets));
+  vector<int64_t> first_bucket(num_threads + 1);
+  int64_t range_bytes = bucket_pos[num_buckets] - bucket_pos[0];
+  int64_t b = 0;
+  for (int t = 0; t < num_threads; t++) {
+    int64_t target = bucket_pos[0] + range_bytes * t / num_threads;
+    while (b < num_buckets && bucket_pos[b] < target) {
+      b++;
+    }
+    first_bucket[t] = b;
+  }
+  first_bucket[num_threads] = num_buckets;
+
+  // Serialize and write each range, a buffer at a time.
+  vector<uint32_t> range_crcs(num_threads);
+  vector<char> range_ok(num_threads);
+  RunOnThreads(num_threads, [&](int thread) {
+    static constexpr size_t kBufferBytes = 1 << 22;
+    CRC32 crc;
+    vector<uint8_t> buf;
+    IndexFileOffset_t buf_pos = bucket_pos[first_bucket[thread]];
+    bool ok = true;
+    for (int64_t b = first_bucket[thread];
+         ok && b < first_bucket[thread + 1];
+         b++) {
+      size_t used = buf.size();
+      buf.resize(used + (bucket_pos[b + 1] - bucket_pos[b]));
+      uint8_t* bucket = buf.data() + used;
+      uint8_t* records = bucket;
+      uint8_t* p = records + (first_element[b + 1] - first_element[b])
+        * sizeof(ElementPositionRecord);
+      for (size_t i = first_element[b]; i < first_element[b + 1]; i++) {
+        IndexFileOffset_t element_pos = bucket_pos[b] + (p - bucket);
+        records = Put(records, ElementPositionRecord(element_pos));
+        p = SerializeWordPostings<Offsets>(elements[i], element_pos, p);
+      }
+      Verify333(p == buf.data() + buf.size());
+
+      if (buf.size() >= kBufferBytes || b + 1 == first_bucket[thread + 1]) {
+        crc.FoldBytesIntoCRC(buf.data(), buf.size());
+        ok = PWriteAll(fd, buf.data(), buf.size(), buf_pos);
+        buf_pos += buf.size();
+        buf.clear();
+      }
+    }
+    range_crcs[thread] = crc.GetFinalCRC();
+    range_ok[thread] = ok;
+  });
+
+  *crc = records_crc.GetFinalCRC();
+  for (int t = 0; t < num_threads; t++) {
+    if (!range_ok[t]) {
+      return kFailedWrite;
+    }
+    *crc = CRC32::Combine(*crc, range_crcs[t],
+                          bucket_pos[first_bucket[t + 1]]
+                          - bucket_pos[first_bucket[t]]);
+  }
+  return bucket_pos[num_buckets] - offset;
+}
+
+template <typename Offsets>
+static int64_t WordPostingsBytes(WordPostings* wp) {
+  typedef typename Offsets::ListHeader BucketListHeader;
+  typedef typename Offsets::Bucket BucketRecord;
+  typedef typename Offsets::ElementPosition ElementPositionRecord;
+  typedef typename Offsets::WordHeader WordPostingsHeader;
+  typedef typename Offsets::DocIDHeader DocIDElementHeader;
+  typedef typename Offsets::Position DocIDElementPosition;
+
+  HashTable* postings = wp->postings;
+  int64_t bytes =
+    AlignedBytes<Offsets>(sizeof(WordPostingsHeader) + strlen(wp->word))
+    + sizeof(BucketListHeader) + postings->num_buckets * sizeof(BucketRecord);
+  HTIterator it;
+  for (HTIterator_Init(&it, postings);
+       HTIterator_IsValid(&it);
+       HTIterator_Next(&it)) {
+    HTKeyValue_t kv;
+    HTIterator_Get(&it, &kv);
+    bytes += sizeof(ElementPositionRecord) + AlignedBytes<Offsets>(
+      sizeof(DocIDElementHeader)
+      + LinkedList_NumElements(static_cast<LinkedList*>(kv.value))
+      * sizeof(DocIDElementPosition));
+  }
+  return bytes;
+}
+
+template <typename Offsets>
+static uint8_t* SerializeWordPostings(HTKeyValue_t* kv,
+                                      IndexFileOffset_t offset,
+                                      uint8_t* buf) {
+  typedef typename Offsets::ListHeader BucketListHeader;
+  typedef typename Offsets::Bucket BucketRecord;
+  typedef typename Offsets::ElementPosition ElementPositionRecord;
+  typedef typename Offsets::WordHeader WordPostingsHeader;
+  typedef typename Offsets::DocIDHeader DocIDElementHeader;
+  typedef typename Offsets::Position DocIDElementPosition;
+
+  WordPostings* wp = static_cast<WordPostings*>(kv->value);
+  HashTable* postings = wp->postings;
+  uint8_t* start = buf;
+
+  // The header goes in last, once we know the docID table's size.  The
+  // caller has zeroed "buf", so the padding is already in place.
+  int16_t word_bytes = strlen(wp->word);
+  memcpy(buf + sizeof(WordPostingsHeader), wp->word, word_bytes);
+  buf += AlignedBytes<Offsets>(sizeof(WordPostingsHeader) + word_bytes);
+
+  // Then the docID table, just as WriteHashTable() lays it out.
+  uint8_t* table = buf;
+  buf = Put(buf, BucketListHeader(postings->num_buckets));
+  uint8_t* records = buf;
+  buf += postings->num_buckets * sizeof(BucketRecord);
+  for (int64_t b = 0; b < postings->num_buckets; b++) {
+    LinkedList* chain = postings->buckets[b];
+    int num_elts = LinkedList_NumElements(chain);
+    records = Put(records, BucketRecord(num_elts, offset + (buf - start)));
+
+    uint8_t* element_records = buf;
+    buf += num_elts * sizeof(ElementPositionRecord);
+    LLIterator it;
+    for (LLIterator_Init(&it, chain);
+         LLIterator_IsValid(&it);
+         LLIterator_Next(&it)) {
+      LLPayload_t payload;
+      LLIterator_Get(&it, &payload);
+      HTKeyValue_t* doc_kv = static_cast<HTKeyValue_t*>(payload);
+      LinkedList* positions = static_cast<LinkedList*>(doc_kv->value);
+
+      element_records = Put(element_records,
+                            ElementPositionRecord(offset + (buf - start)));
+      uint8_t* element = buf;
+      buf = Put(buf, DocIDElementHeader(doc_kv->key,
+                                        LinkedList_NumElements(positions)));
+      LLIterator pos_it;
+      for (LLIterator_Init(&pos_it, positions);
+           LLIterator_IsValid(&pos_it);
+           LLIterator_Next(&pos_it)) {
+        LLIterator_Get(&pos_it, &payload);
+        buf = Put(buf, DocIDElementPosition(
+                         static_cast<DocPositionOffset_t>(
+                           reinterpret_cast<uint64_t>(payload))));
+      }
+      buf = element + AlignedBytes<Offsets>(buf - element);
+    }
+  }
+
+  Put(start, WordPostingsHeader(word_bytes, buf - table));
+  return buf;
+}
+
+static DocID_t MaxDocID(DocTable* dt) {
+  DocID_t max_doc_id = 0;
+  HashTable_ForEach(DT_GetIDToNameTable(dt),
+                    [](HTKeyValue_t* kv, void* arg) {
+    DocID_t* max_id = static_cast<DocID_t*>(arg);
+    if (kv->key > *max_id) {
+      *max_id = kv->key;
+    }
+  }, &max_doc_id);
+  return max_doc_id;
+}
+
+static void ComputeDocLengths(MemIndex* mi, DocTable* dt,
+                              vector<uint32_t>* doc_lengths) {
+  // DocIDs are handed out sequentially starting from 1, so the table is
+  // just an array indexed by (docID - 1).  Find out how big it needs to be.
+  DocID_t max_doc_id = MaxDocID(dt);
+
+  // Sum up each document's positions across every word's postings.
+  vector<uint32_t>& num_words = *doc_lengths;
+  num_words.assign(max_doc_id, 0);
+  HTIterator word_it;
+  for (HTIterator_Init(&word_it, mi);
+       HTIterator_IsValid(&word_it);
+       HTIterator_Next(&word_it)) {
+    HTKeyValue_t word_kv;
+    HTIterator_Get(&word_it, &word_kv);
+    HashTable* postings = static_cast<WordPostings*>(word_kv.value)->postings;
+    HashTable_ForEach(postings, [](HTKeyValue_t* kv, void* arg) {
+      vector<uint32_t>& num_words = *static_cast<vector<uint32_t>*>(arg);
+      Verify333(kv->key >= 1 && kv->key <= num_words.size());
+      num_words[kv->key - 1] +=
+        LinkedList_NumElements(static_cast<LinkedList*>(kv->value));
+    }, &num_words);
+  }
+}
+
+static int WriteDocLengths(FILE* f, const vector<uint32_t>& doc_lengths,
+                           IndexFileOffset_t offset) {
+  // Convert the table to disk format and write it out in one go.
+  vector<DocLengthRecord> records;
+  records.reserve(doc_lengths.size());
+  for (uint32_t n : doc_lengths) {
+    records.emplace_back(n);
+    records.back().ToDiskFormat();
+  }
+  return WriteSection(f, offset, kDocLengthsSectionTag, records.data(),
+                      sizeof(DocLengthRecord) * records.size());
+}
+
+static void ComputeLengthNorms(const vector<uint32_t>& doc_lengths,
+                               int* num_docs, vector<float>* length_norms) {
+  // Gather the collection statistics exactly as DocLengthTableReader will
+  // at query time, so that the bounds match the scores QueryProcessor
+  // computes.
+  *num_docs = 0;
+  uint64_t total_words = 0;
+  for (uint32_t n : doc_lengths) {
+    if (n > 0) {
+      (*num_docs)++;
+      total_words += n;
+    }
+  }
+  double avg_length = *num_docs > 0 ?
+    static_cast<double>(total_words) / *num_docs : 0.0;
+
+  length_norms->clear();
+  length_norms->reserve(doc_lengths.size());
+  for (uint32_t n : doc_lengths) {
+    length_norms->push_back(BM25LengthNorm(n, avg_length));
+  }
+}
+
+static float TermBound(HashTable* postings, int num_docs,
+                       const vector<float>& length_norms) {
+  float idf = BM25IDF(num_docs, postings->num_elements);
+  float max_score = 0.0f;
+  HTIterator doc_it;
+  for (HTIterator_Init(&doc_it, postings);
+       HTIterator_IsValid(&doc_it);
+       HTIterator_Next(&doc_it)) {
+    HTKeyValue_t kv;
+    HTIterator_Get(&doc_it, &kv);
+    float tf = LinkedList_NumElements(static_cast<LinkedList*>(kv.value));
+    float score = BM25Score(idf, tf, length_norms[kv.key - 1]);
+    if (score > max_score) {
+      max_score = score;
+    }
+  }
+
+  // Round up by one ulp, so that a query-time score computed in a
+  // slightly different order never exceeds its bound.
+  return std::nextafter(max_score, std::numeric_limits<float>::infinity());
+}
+
+template <typename Offsets>
+static int64_t WriteSectionsAndHeader(FILE* f, int64_t doctable_bytes,
+                                      int64_t memidx_bytes,
+                                      IndexFileOffset_t offset,
+                                      const vector<uint32_t>& doc_lengths,
+                                      vector<TermBoundRecord>* term_bounds,
+                                      vector<DictTerm>* terms,
+                                      const uint32_t* memidx_crc) {
+  // Every word's hash is in "term_bounds", but WriteTermBounds() converts
+  // them to disk format, so fill in the Bloom filter first.
+  BloomFilter filter(term_bounds->size());
+  for (const TermBoundRecord& record : *term_bounds) {
+    filter.Add(record.word_hash);
+  }
+
+  int dl_bytes = WriteDocLengths(f, doc_lengths, offset);
+  if (dl_bytes == kFailedWrite) {
+    return kFailedWrite;
+  }
+
+  int tb_bytes = WriteTermBounds(f, term_bounds, offset + dl_bytes);
+  if (tb_bytes == kFailedWrite) {
+    return kFailedWrite;
+  }
+
+  int td_bytes = WriteTermDict(f, terms, offset + dl_bytes + tb_bytes);
+  if (td_bytes == kFailedWrite) {
+    return kFailedWrite;
+  }
+
+  int bf_bytes = WriteBloomFilter(f, filter,
+                                  offset + dl_bytes + tb_bytes + td_bytes);
+  if (bf_bytes == kFailedWrite) {
+    return kFailedWrite;
+  }
+
+  int64_t section_bytes = dl_bytes + tb_bytes + td_bytes + bf_bytes;
+  int64_t res = WriteHeader<Offsets>(f, doctable_bytes, memidx_bytes,
+                                     section_bytes, memidx_crc);
+  if (res == kFailedWrite) {
+    return kFailedWrite;
+  }
+  return section_bytes + res;
+}
+
+static int WriteTermBounds(FILE* f, vector<TermBoundRecord>* term_bounds,
+                           IndexFileOffset_t offset) {
+  vector<TermBoundRecord>& records = *term_bounds;
+
+  // Sort by hash so that readers can binary search the table.  Words that
+  // share a hash are collapsed into a single record holding the larger
+  // bound.
+  std::sort(records.begin(), records.end(),
+            [](const TermBoundRecord& a, const TermBoundRecord& b) {
+              return a.word_hash < b.word_hash;
+            });
+  size_t num_records = 0;
+  for (size_t i = 0; i < records.size(); i++) {
+    if (num_records > 0 &&
+        records[num_records - 1].word_hash == records[i].word_hash) {
+      if (records[i].max_score > records[num_records - 1].max_score) {
+        records[num_records - 1].max_score = records[i].max_score;
+      }
+    } else {
+      records[num_records++] = records[i];
+    }
+  }
+  records.resize(num_records);
+  for (TermBoundRecord& record : records) {
+    record.ToDiskFormat();
+  }
+
+  return WriteSection(f, offset, kTermBoundsSectionTag, records.data(),
+                      sizeof(TermBoundRecord) * records.size());
+}
+
+// Appends "value" to "buf" as a varint; see TermDictReader.
+static void PutVarint(uint64_t value, vector<uint8_t>* buf) {
+  while (value >= 0x80) {
+    buf->push_back(static_cast<uint8_t>(value) | 0x80);
+    value >>= 7;
+  }
+  buf->push_back(static_cast<uint8_t>(value));
+}
+
+static int WriteTermDict(FILE* f, vector<DictTerm>* terms,
+                         IndexFileOffset_t offset) {
+  // Sort the words bytewise, which is the order that TermDictReader
+  // searches them in, and front code them in blocks.  The payload is
+  // built in memory, block records first, and written in one go.
+  std::sort(terms->begin(), terms->end());
+  int32_t num_blocks =
+    (terms->size() + kTermDictBlockTerms - 1) / kTermDictBlockTerms;
+  size_t records_bytes =
+    sizeof(TermDictHeader) + num_blocks * sizeof(TermDictBlockRecord);
+  vector<uint8_t> payload(records_bytes);
+  vector<TermDictBlockRecord> records;
+  records.reserve(num_blocks);
+
+  const string* prev = nullptr;
+  for (size_t i = 0; i < terms->size(); i++) {
+    const string& word = (*terms)[i].first;
+    size_t shared = 0;
+    if (i % kTermDictBlockTerms == 0) {
+      records.emplace_back(payload.size());
+    } else {
+      while (shared < prev->size() && shared < word.size() &&
+             (*prev)[shared] == word[shared]) {
+        shared++;
+      }
+    }
+    PutVarint(shared, &payload);
+    PutVarint(word.size() - shared, &payload);
+    payload.insert(payload.end(), word.begin() + shared, word.end());
+    PutVarint((*terms)[i].second, &payload);
+    prev = &word;
+  }
+  if (payload.size() > static_cast<size_t>(INT32_MAX)) {
+    return kFailedWrite;
+  }
+
+  TermDictHeader header(terms->size(), num_blocks);
+  header.ToDiskFormat();
+  memcpy(payload.data(), &header, sizeof(TermDictHeader));
+  for (TermDictBlockRecord& record : records) {
+    record.ToDiskFormat();
+  }
+  memcpy(payload.data() + sizeof(TermDictHeader), records.data(),
+         records.size() * sizeof(TermDictBlockRecord));
+
+  return WriteSection(f, offset, kTermDictSectionTag, payload.data(),
+                      payload.size());
+}
+
+static int WriteBloomFilter(FILE* f, const BloomFilter& filter,
+                            IndexFileOffset_t offset) {
+  vector<uint32_t> words(filter.words());
+  if (words.size() * sizeof(uint32_t) > static_cast<size_t>(INT32_MAX)) {
+    return kFailedWrite;
+  }
+  for (uint32_t& word : words) {
+    word = htonl(word);
+  }
+  return WriteSection(f, offset, kBloomFilterSectionTag, words.data(),
+                      words.size() * sizeof(uint32_t));
+}
 
-  // moves f (file pointer) to location of header.
-  if (fseek(f, sizeof(IndexFileHeader), SEEK_SET) != 0) {
+static int WriteSection(FILE* f, IndexFileOffset_t offset, uint32_t tag,
+                        const void* payload, int32_t payload_bytes) {
+  SectionHeader header(tag, payload_bytes);
+  header.ToDiskFormat();
+  if (fseek(f, offset, SEEK_SET) != 0) {
+    return kFailedWrite;
+  }
+  if (fwrite(&header, sizeof(SectionHeader), 1, f) != 1) {
+    return kFailedWrite;
+  }
+  if (payload_bytes > 0 && fwrite(payload, payload_bytes, 1, f) != 1) {
     return kFailedWrite;
   }
+  return sizeof(SectionHeader) + payload_bytes;
+}
+
+template <typename Offsets>
+static int64_t WriteHeader(FILE* f, int64_t doctable_bytes,
+                           int64_t memidx_bytes, int64_t section_bytes,
+                           const uint32_t* memidx_crc) {
+  typedef typename Offsets::Header IndexFileHeader;
 
-  // feed chars from doctable_bytes into CRC32 w/ fread.
-  uint8_t next_byte;
-  for (int i = 0; i < doctable_bytes + memidx_bytes; i++) {
-    if (fread(&next_byte, 1, 1, f) != 1) {
+  // STEP 3.
+  // We need to calculate the checksum over the doctable, index
+  // table and auxiliary sections.  (Note that the checksum does not
+  // include the index file header, just what follows it.)
+  //
+  // Use fseek() to seek to the right location, and use a CRC32 object
+  // to do the CRC checksum calculation, feeding it characters that you
+  // read from the index file using fread().  If we already know the
+  // memindex's CRC, we only need to read the rest, and combine the CRCs.
+  IndexFileOffset_t memidx_pos = sizeof(IndexFileHeader) + doctable_bytes;
+  IndexFileOffset_t section_pos = memidx_pos + memidx_bytes;
+  uint32_t final_crc;
+  if (memidx_crc == nullptr) {
+    CRC32 crc;
+    if (!ChecksumFileRange(f, sizeof(IndexFileHeader),
+                           doctable_bytes + memidx_bytes + section_bytes,
+                           &crc)) {
+      return kFailedWrite;
+    }
+    final_crc = crc.GetFinalCRC();
+  } else {
+    CRC32 doctable_crc, section_crc;
+    if (!ChecksumFileRange(f, sizeof(IndexFileHeader), doctable_bytes,
+                           &doctable_crc) ||
+        !ChecksumFileRange(f, section_pos, section_bytes, &section_crc)) {
       return kFailedWrite;
     }
-    crc.FoldByteIntoCRC(next_byte);
+    final_crc = CRC32::Combine(doctable_crc.GetFinalCRC(), *memidx_crc,
+                               memidx_bytes);
+    final_crc = CRC32::Combine(final_crc, section_crc.GetFinalCRC(),
+                               section_bytes);
   }
 
   // Write the header fields.  Be sure to convert the fields to
   // network order before writing them!
-  IndexFileHeader header(kMagicNumber, crc.GetFinalCRC(),
-                         doctable_bytes, memidx_bytes);
+  IndexFileHeader header(MagicNumberForHashID(MemIndex_WordHashID(),
+                                              Offsets::kFormat),
+                         final_crc, doctable_bytes, memidx_bytes);
   header.ToDiskFormat();
 
   if (fseek(f, 0, SEEK_SET) != 0) {
@@ -268,8 +1527,46 @@ static int WriteHeader(FILE* f, int doctable_bytes, int memidx_bytes) {
   return sizeof(IndexFileHeader);
 }
 
-static int WriteHashTable(FILE* f, IndexFileOffset_t offset, HashTable* ht,
-                          WriteElementFn fn) {
+static bool ChecksumFileRange(FILE* f, IndexFileOffset_t offset,
+                              int64_t len, CRC32* crc) {
+  if (fseek(f, offset, SEEK_SET) != 0) {
+    return false;
+  }
+  uint8_t buf[1 << 16];
+  while (len > 0) {
+    size_t n = std::min(static_cast<int64_t>(sizeof(buf)), len);
+    if (fread(buf, 1, n, f) != n) {
+      return false;
+    }
+    crc->FoldBytesIntoCRC(buf, n);
+    len -= n;
+  }
+  return true;
+}
+
+static bool PWriteAll(int fd, const uint8_t* buf, size_t len,
+                      IndexFileOffset_t offset) {
+  while (len > 0) {
+    ssize_t n = pwrite(fd, buf, len, offset);
+    if (n < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return false;
+    }
+    buf += n;
+    len -= n;
+    offset += n;
+  }
+  return true;
+}
+
+template <typename Offsets>
+static int64_t WriteHashTable(FILE* f, IndexFileOffset_t offset,
+                              HashTable* ht, WriteElementFn fn) {
+  typedef typename Offsets::ListHeader BucketListHeader;
+  typedef typename Offsets::Bucket BucketRecord;
+
   // Write the HashTable's header, which consists simply of the number of
   // buckets.
   BucketListHeader header(ht->num_buckets);
@@ -299,11 +1596,11 @@ static int WriteHashTable(FILE* f, IndexFileOffset_t offset, HashTable* ht,
   // empty.  For that case, you still have to write a record for the
   // bucket, but you won't write a bucket.
   LinkedList* bucket;
-  int curr_byte;
-  for (int i = 0; i < ht->num_buckets; i++) {
+  int64_t curr_byte;
+  for (int64_t i = 0; i < ht->num_buckets; i++) {
     // STEP 4.
     bucket = ht->buckets[i];
-    curr_byte = WriteHTBucketRecord(f, record_pos,
+    curr_byte = WriteHTBucketRecord<Offsets>(f, record_pos,
                    LinkedList_NumElements(bucket), bucket_pos);
 
     if (curr_byte < 0) {
@@ -313,7 +1610,7 @@ static int WriteHashTable(FILE* f, IndexFileOffset_t offset, HashTable* ht,
     // updates next bucket record to write into.
     record_pos += sizeof(BucketRecord);
     // writes data of current bucket.
-    curr_byte = WriteHTBucket(f, bucket_pos, bucket, fn);
+    curr_byte = WriteHTBucket<Offsets>(f, bucket_pos, bucket, fn);
 
     if (curr_byte < 0) {
       return kFailedWrite;
@@ -327,10 +1624,13 @@ static int WriteHashTable(FILE* f, IndexFileOffset_t offset, HashTable* ht,
   return bucket_pos - offset;
 }
 
-static int WriteHTBucketRecord(FILE* f,
-                               IndexFileOffset_t offset,
-                               int32_t num_elts,
-                               IndexFileOffset_t bucket_offset) {
+template <typename Offsets>
+static int64_t WriteHTBucketRecord(FILE* f,
+                                   IndexFileOffset_t offset,
+                                   int32_t num_elts,
+                                   IndexFileOffset_t bucket_offset) {
+  typedef typename Offsets::Bucket BucketRecord;
+
   // STEP 5.
   // Initialize a BucketRecord in network byte order.
 
@@ -353,8 +1653,11 @@ static int WriteHTBucketRecord(FILE* f,
   return sizeof(BucketRecord);
 }
 
-static int WriteHTBucket(FILE* f, IndexFileOffset_t offset, LinkedList* li,
-                         WriteElementFn fn) {
+template <typename Offsets>
+static int64_t WriteHTBucket(FILE* f, IndexFileOffset_t offset,
+                             LinkedList* li, WriteElementFn fn) {
+  typedef typename Offsets::ElementPosition ElementPositionRecord;
+
   int num_elts = LinkedList_NumElements(li);
   if (num_elts == 0) {
     // Not an error; nothing to write
@@ -375,8 +1678,8 @@ static int WriteHTBucket(FILE* f, IndexFileOffset_t offset, LinkedList* li,
   //
   // Be sure to write in network order, and use the "fn" argument to write
   // the element (ie, the list payload) itself.
-  LLIterator* it = LLIterator_Allocate(li);
-  Verify333(it != nullptr);
+  LLIterator it;
+  LLIterator_Init(&it, li);
   LLPayload_t payload;
   HTKeyValue_t* kv;
   for (int i = 0; i < num_elts; i++) {
@@ -398,9 +1701,9 @@ static int WriteHTBucket(FILE* f, IndexFileOffset_t offset, LinkedList* li,
     // STEP 8.
     // Write the element itself, using fn.
 
-    LLIterator_Get(it, &payload);
+    LLIterator_Get(&it, &payload);
     kv = static_cast<HTKeyValue_t*>(payload);
-    int curr_byte = fn(f, element_pos, kv);
+    int64_t curr_byte = fn(f, element_pos, kv);
     if (curr_byte < 0) {
       return kFailedWrite;
     }
@@ -408,9 +1711,8 @@ static int WriteHTBucket(FILE* f, IndexFileOffset_t offset, LinkedList* li,
     // Advance to the next element in the chain, updating our offsets.
     record_pos += sizeof(ElementPositionRecord);
     element_pos += curr_byte;
-    LLIterator_Next(it);
+    LLIterator_Next(&it);
   }
-  LLIterator_Free(it);
 
   // Return the total amount of data written.
   return element_pos - offset;
@@ -422,8 +1724,11 @@ static int WriteHTBucket(FILE* f, IndexFileOffset_t offset, LinkedList* li,
 
 // This write_element_fn is used to write a doc_id->doc_name mapping
 // element, i.e., an element of the "doctable" table.
-static int WriteDocidToDocnameFn(FILE* f, IndexFileOffset_t offset,
-                                 HTKeyValue_t* kv) {
+template <typename Offsets>
+static int64_t WriteDocidToDocnameFn(FILE* f, IndexFileOffset_t offset,
+                                     HTKeyValue_t* kv) {
+  typedef typename Offsets::DocHeader DoctableElementHeader;
+
   // STEP 9.
   // Determine the file name length
 
@@ -453,16 +1758,21 @@ static int WriteDocidToDocnameFn(FILE* f, IndexFileOffset_t offset,
   }
 
   // STEP 11.
-  // Calculate and return the total amount written.
-  return sizeof(DoctableElementHeader) + file_name_bytes;
+  // Calculate and return the total amount written, including padding.
+  return AlignedBytes<Offsets>(sizeof(DoctableElementHeader) +
+                               file_name_bytes);
 }
 
 // This write_element_fn is used to write a DocID + position list
 // element (i.e., an element of a nested docID table) into the file at
 // offset 'offset'.
-static int WriteDocIDToPositionListFn(FILE* f,
-                                      IndexFileOffset_t offset,
-                                      HTKeyValue_t* kv) {
+template <typename Offsets>
+static int64_t WriteDocIDToPositionListFn(FILE* f,
+                                          IndexFileOffset_t offset,
+                                          HTKeyValue_t* kv) {
+  typedef typename Offsets::DocIDHeader DocIDElementHeader;
+  typedef typename Offsets::Position DocIDElementPosition;
+
   // Extract the docID from the HTKeyValue_t.
   DocID_t doc_id = static_cast<DocID_t>(kv->key);
 
@@ -487,14 +1797,14 @@ static int WriteDocIDToPositionListFn(FILE* f,
 
   // Loop through the positions list, writing each position out.
   DocIDElementPosition position;
-  LLIterator* it = LLIterator_Allocate(positions);
-  Verify333(it != nullptr);
+  LLIterator it;
+  LLIterator_Init(&it, positions);
   uint64_t payload;
   for (int i = 0; i < num_positions; i++) {
     // STEP 13.
     // Get the next position from the list.
 
-    LLIterator_Get(it, reinterpret_cast<LLPayload_t*> (&payload));
+    LLIterator_Get(&it, reinterpret_cast<LLPayload_t*> (&payload));
 
     // STEP 14.
     // Truncate to 32 bits, then convert it to network order and write it out.
@@ -506,22 +1816,25 @@ static int WriteDocIDToPositionListFn(FILE* f,
     }
 
     // Advance to the next position.
-    LLIterator_Next(it);
+    LLIterator_Next(&it);
   }
-  LLIterator_Free(it);
 
   // STEP 15.
-  // Calculate and return the total amount of data written.
+  // Calculate and return the total amount of data written, including
+  // padding.
 
-  return sizeof(DocIDElementHeader) + sizeof(DocIDElementPosition)
-         * num_positions;
+  return AlignedBytes<Offsets>(sizeof(DocIDElementHeader) +
+                               sizeof(DocIDElementPosition) * num_positions);
 }
 
 // This write_element_fn is used to write a WordPostings
 // element into the file at position 'offset'.
-static int WriteWordToPostingsFn(FILE* f,
-                                 IndexFileOffset_t offset,
-                                 HTKeyValue_t* kv) {
+template <typename Offsets>
+static int64_t WriteWordToPostingsFn(FILE* f,
+                                     IndexFileOffset_t offset,
+                                     HTKeyValue_t* kv) {
+  typedef typename Offsets::WordHeader WordPostingsHeader;
+
   // Extract the WordPostings from the HTKeyValue_t.
   WordPostings* wp = static_cast<WordPostings*>(kv->value);
   Verify333(wp != nullptr);
@@ -535,11 +1848,13 @@ static int WriteWordToPostingsFn(FILE* f,
   // table" element in the diagrams).  Use WriteHashTable() to do it,
   // passing it the wp->postings table and using the
   // WriteDocIDToPositionListFn helper function as the final parameter.
-  int ht_bytes = WriteHashTable(
+  int64_t header_bytes =
+    AlignedBytes<Offsets>(sizeof(WordPostingsHeader) + word_bytes);
+  int64_t ht_bytes = WriteHashTable<Offsets>(
     f,
-    offset + sizeof(WordPostingsHeader) + word_bytes,
+    offset + header_bytes,
     wp->postings,
-    &WriteDocIDToPositionListFn);
+    &WriteDocIDToPositionListFn<Offsets>);
 
   if (ht_bytes == kFailedWrite) {
     return kFailedWrite;
@@ -569,6 +1884,6 @@ static int WriteWordToPostingsFn(FILE* f,
 
   // STEP 19.
   // Calculate and return the total amount of data written.
-  return ht_bytes + sizeof(WordPostingsHeader) + word_bytes;
+  return ht_bytes + header_bytes;
 }
 }  // namespace hw3
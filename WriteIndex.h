@@ -18,28 +18,75 @@
 // linkage.  Since WriteIndex.cc is compiled by g++, we need
 // do use 'extern "C"' to tell g++ that the routines accessed through
 // these header files were compiled with gcc.
+#include <string>  // for std::string.
+#include <vector>  // for std::vector.
+
 extern "C" {
   #include "libhw1/CSE333.h"
   #include "libhw2/DocTable.h"
   #include "libhw2/MemIndex.h"
 }
+#include "./Utils.h"  // for IndexFormat.
 
 namespace hw3 {
 
 // Writes the contents of a MemIndex and the docid_to_docname mapping of a
 // DocTable into an index file.  The on-disk representation is defined in
-// detail on the hw3 web page.
+// detail on the hw3 web page.  The MemIndex's words are serialized in
+// parallel; the file is the same however many threads write it.
+//
+// Arguments:
+//   - mi: the MemIndex to write.
+//   - dt: the DocTable to write.
+//   - file_name: a C-style string containing the name of the index
+//     file that we should create.
+//   - num_threads: the number of threads to write with, or 0 for one per
+//     core.
+//   - format: the format to write the file in.  A file in the original
+//     format can't be bigger than 2GB; if it would be, nothing is written
+//     and an error is returned.
+//
+// Returns:
+//   - the resulting size of the index file, in bytes, or negative value
+//     on error
+int64_t WriteIndex(MemIndex* mi, DocTable* dt, const char* file_name,
+                   int num_threads = 0, IndexFormat format = kIndexFormat32);
+
+// Writes the contents of a MemIndex into a "run": a temporary file holding
+// part of an inverted index, sorted by word hash, for MergeIndexRuns() to
+// merge with others into an index file.  This is how an index too big to
+// build in memory is built (see CrawlFileTree_Spill()): each time the
+// MemIndex fills up, it's written out as a run and emptied.
 //
 // Arguments:
 //   - mi: the MemIndex to write.
+//   - file_name: the name of the run file to create.
+//
+// Returns:
+//   - the resulting size of the run file, in bytes, or negative value
+//     on error
+int64_t WriteIndexRun(MemIndex* mi, const char* file_name);
+
+// Merges runs written by WriteIndexRun() and the docid_to_docname mapping
+// of a DocTable into an index file, which answers queries just like the
+// file WriteIndex() would have written for the runs' combined MemIndex.
+// Only one word's postings are in memory at a time.
+//
+// Arguments:
+//   - run_names: the names of the runs to merge.  No document may be in
+//     more than one run, and each run's docIDs must be larger than those of
+//     the runs before it.  The runs are left in place.
 //   - dt: the DocTable to write.
 //   - file_name: a C-style string containing the name of the index
 //     file that we should create.
+//   - format: the format to write the file in, as for WriteIndex().
 //
 // Returns:
 //   - the resulting size of the index file, in bytes, or negative value
 //     on error
-int WriteIndex(MemIndex* mi, DocTable* dt, const char* file_name);
+int64_t MergeIndexRuns(const std::vector<std::string>& run_names,
+                       DocTable* dt, const char* file_name,
+                       IndexFormat format = kIndexFormat32);
 
 }  // namespace hw3
 
@@ -12,6 +12,8 @@
 #include <stdlib.h>
 #include <unistd.h>
 #include <iostream>
+#include <string>
+#include <vector>
 
 extern "C" {
   #include "./libhw2/CrawlFileTree.h"
@@ -23,37 +25,148 @@ extern "C" {
 using std::cerr;
 using std::cout;
 using std::endl;
+using std::string;
+using std::vector;
 
 void Usage(char* filename) {
   cerr << "Usage: " << filename;
-  cerr << " crawlrootdir indexfilename" << endl;
+  cerr << " [-m budget_mb] [-w | -n] [-H hash] crawlrootdir indexfilename"
+       << endl;
   cerr << "where:" << endl;
+  cerr << "  budget_mb, if given, bounds the memory used for the inverted"
+       << endl;
+  cerr << "    index; it's spilled to disk and merged whenever it's full"
+       << endl;
+  cerr << "  -w writes the index with 64-bit offsets, so that it can be"
+       << endl;
+  cerr << "    bigger than 2GB" << endl;
+  cerr << "  -n writes the index with aligned, native-endian records, to be"
+       << endl;
+  cerr << "    read in place from an mmap() of the file" << endl;
+  cerr << "  hash is the function used to hash words: fnv1a (the default,"
+       << endl;
+  cerr << "    readable by older tools) or wyhash (faster)" << endl;
   cerr << "  crawlrootdir is the name of a directory to crawl" << endl;
   cerr << "  indexfilename is the name of the index file to create" << endl;
   exit(EXIT_FAILURE);
 }
 
+// Returns the hash function named "name" in "hash_id", or false if there
+// isn't one by that name.
+static bool HashIDForName(const string& name, HTHashID_t* const hash_id) {
+  if (name == "fnv1a") {
+    *hash_id = HT_HASH_FNV1A64;
+  } else if (name == "wyhash") {
+    *hash_id = HT_HASH_WYHASH64;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+// The runs written so far by a budgeted build.
+struct Runs {
+  string prefix;        // the runs are named prefix0, prefix1, ...
+  vector<string> names;
+};
 
-// Crawls the filesystem starting at the subtree specified by argv[1], builds
-// an in-memory inverted index (see HW2 CrawlFileTree()), and then writes it
-// out using WriteIndex().
+// Writes a partial MemIndex out as the next run; "arg" is the Runs.
+static bool SpillRun(MemIndex* index, void* arg) {
+  Runs* runs = static_cast<Runs*>(arg);
+  string name = runs->prefix + std::to_string(runs->names.size());
+  if (hw3::WriteIndexRun(index, name.c_str()) < 0) {
+    return false;
+  }
+  runs->names.push_back(name);
+  return true;
+}
+
+// Crawls the filesystem subtree rooted at "root", spilling the inverted
+// index to runs next to "index_file" whenever it reaches "budget_bytes",
+// then merges the runs into "index_file".  Returns the size of the index
+// file, or a negative value on error.
+static int64_t BuildWithBudget(char* root, size_t budget_bytes,
+                               const char* index_file,
+                               hw3::IndexFormat format) {
+  DocTable* dt;
+  Runs runs;
+  runs.prefix = string(index_file) + ".run";
+
+  cout << "Crawling " << root << " with a budget of "
+       << (budget_bytes >> 20) << " MB..." << endl;
+  int64_t idx_len = -1;
+  if (CrawlFileTree_Spill(root, &dt, budget_bytes, &SpillRun, &runs)) {
+    cout << "Merging " << runs.names.size() << " runs into " << index_file;
+    cout << "..." << endl;
+    idx_len = hw3::MergeIndexRuns(runs.names, dt, index_file, format);
+    DocTable_Free(dt);
+  }
+
+  for (const string& name : runs.names) {
+    unlink(name.c_str());
+  }
+  return idx_len;
+}
+
+// Crawls the filesystem starting at the subtree named by the first argument,
+// builds an in-memory inverted index (see HW2 CrawlFileTree()), and then
+// writes it out using WriteIndex().  With -m, the inverted index is instead
+// built a budget's worth at a time (see CrawlFileTree_Spill()), and the
+// pieces are merged with MergeIndexRuns().  With -w, the index is written in
+// the 64-bit format, and with -n, in the native format.  -H chooses the
+// function words are hashed with, which is recorded in the index.
 int main(int argc, char** argv) {
   DocTable* dt;
   MemIndex* idx;
 
   // Make sure the user provided us the right command-line options.
-  if (argc != 3)
+  int64_t budget_mb = 0;
+  hw3::IndexFormat format = hw3::kIndexFormat32;
+  HTHashID_t hash_id = HT_HASH_FNV1A64;
+  int opt;
+  while ((opt = getopt(argc, argv, "m:wnH:")) != -1) {
+    switch (opt) {
+      case 'm':
+        budget_mb = atoll(optarg);
+        if (budget_mb <= 0)
+          Usage(argv[0]);
+        break;
+      case 'w':
+        format = hw3::kIndexFormat64;
+        break;
+      case 'n':
+        format = hw3::kIndexFormatNative;
+        break;
+      case 'H':
+        if (!HashIDForName(optarg, &hash_id))
+          Usage(argv[0]);
+        break;
+      default:
+        Usage(argv[0]);
+    }
+  }
+  if (argc - optind != 2)
     Usage(argv[0]);
+  char* root = argv[optind];
+  char* index_file = argv[optind + 1];
+  MemIndex_SetWordHashID(hash_id);
+
+  if (budget_mb > 0) {
+    if (BuildWithBudget(root, budget_mb << 20, index_file, format) <= 0)
+      return EXIT_FAILURE;
+    cout << "Done." << endl;
+    return EXIT_SUCCESS;
+  }
 
   // Try to crawl.
-  cout << "Crawling " << argv[1] << "..." << endl;
-  if (CrawlFileTree(argv[1], &dt, &idx) != 1)
+  cout << "Crawling " << root << "..." << endl;
+  if (CrawlFileTree(root, &dt, &idx) != 1)
     Usage(argv[0]);
 
   // Try to write out the index file.
-  cout << "Writing index to " << argv[2];
+  cout << "Writing index to " << index_file;
   cout << "..." << endl;
-  int idx_len = hw3::WriteIndex(idx, dt, argv[2]);
+  int64_t idx_len = hw3::WriteIndex(idx, dt, index_file, 0, format);
   if (idx_len <= 0) {
     DocTable_Free(dt);
     MemIndex_Free(idx);
@@ -10,10 +10,9 @@
  */
 
 #include <cstdlib>    // for EXIT_SUCCESS, EXIT_FAILURE
+#include <cstring>    // for strcmp()
 #include <iostream>   // for std::cout, std::cerr, etc.
 #include <string>     // for std::string
-#include <sstream>    // for std::istringstream
-#include <algorithm>  // for std::transform
 
 #include "./QueryProcessor.h"
 
@@ -89,28 +88,38 @@ int main(int argc, char** argv) {
   // STEP 1:
   // Implement filesearchshell!
   // Probably want to write some helper methods ...
+  // an optional leading "-bm25" selects BM25 ranking, and "-explain"
+  // prints where each query's time went after its results.
+  int first_index = 1;
+  hw3::QueryProcessor::RankingMode ranking_mode =
+    hw3::QueryProcessor::kRankByOccurrences;
+  bool explain = false;
+  for (; first_index < argc && argv[first_index][0] == '-'; first_index++) {
+    if (strcmp(argv[first_index], "-bm25") == 0) {
+      ranking_mode = hw3::QueryProcessor::kRankByBM25;
+    } else if (strcmp(argv[first_index], "-explain") == 0) {
+      explain = true;
+    } else {
+      Usage(argv[0]);
+    }
+  }
+  if (first_index >= argc) {
+    Usage(argv[0]);
+  }
+
   // get the index list from the command line
   list<string> index_list;
-  for (int i = 1; i < argc; i++) {
+  for (int i = first_index; i < argc; i++) {
     index_list.push_back(argv[i]);
   }
 
   // take in files and process them.
-  hw3::QueryProcessor queryProcessor(index_list);
+  hw3::QueryProcessor queryProcessor(index_list, true, ranking_mode);
   while (true) {
     std::cout << "Enter query: " << std::endl;
 
     std::string query;
     std::getline(std::cin, query);
-    std::istringstream stringstream(query);
-    std::string word;
-
-    std::vector<std::string> query_words;
-    while (stringstream >> word) {
-      // make lowercase.
-      std::transform(word.begin(), word.end(), word.begin(), ::tolower);
-      query_words.push_back(word);
-    }
 
     // when no words in command line.
     if (query.empty()) {
@@ -118,21 +127,44 @@ int main(int argc, char** argv) {
       break;
     }
 
+    // parse the words, "phrases", NEAR/k's, wildcards and boolean
+    // operators.
+    hw3::QueryNode parsed_query = hw3::ParseQuery(query);
+
+    hw3::QueryProcessor::QueryExplain query_explain;
+    std::vector<std::string> truncated;
     std::vector<hw3::QueryProcessor::QueryResult> results =
-                        queryProcessor.ProcessQuery(query_words);
+      queryProcessor.ProcessQuery(parsed_query, nullptr,
+                                  explain ? &query_explain : nullptr,
+                                  &truncated);
     if (results.empty()) {
       std::cout << "\t[No results found]" << std::endl;
     } else {
       for (auto curr : results) {
-        std::cout << " " << curr.document_name << " (" << curr.rank <<
-             ")" << std::endl;
+        std::cout << " " << curr.document_name << " (";
+        if (ranking_mode == hw3::QueryProcessor::kRankByBM25) {
+          std::cout << curr.score;
+        } else {
+          std::cout << curr.rank;
+        }
+        std::cout << ")" << std::endl;
       }
     }
+    for (const std::string& pattern : truncated) {
+      std::cout << "\t[Only the first "
+                << hw3::QueryProcessor::kMaxWildcardTerms
+                << " words matching " << pattern << " were searched]"
+                << std::endl;
+    }
+    if (explain) {
+      std::cout << query_explain.ToString();
+    }
   }
   return EXIT_SUCCESS;
 }
 
 static void Usage(char* prog_name) {
-  cerr << "Usage: " << prog_name << " [index files+]" << endl;
+  cerr << "Usage: " << prog_name << " [-bm25] [-explain] [index files+]"
+       << endl;
   exit(EXIT_FAILURE);
 }
@@ -0,0 +1,154 @@
+/*
+ * Copyright ©2024 Hannah C. Tang.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Washington
+ * CSE 333 for use solely during Spring Quarter 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <sys/time.h>
+#include <algorithm>
+#include <iostream>
+#include <random>
+#include <vector>
+
+extern "C" {
+  #include "libhw1/CSE333.h"
+  #include "libhw1/HashTable.h"
+}
+#include "./FlatHashMap.h"
+
+using std::cerr;
+using std::cout;
+using std::endl;
+using std::vector;
+
+using hw3::FlatHashMap;
+
+// Returns the current time, in microseconds.
+static double NowMicros() {
+  struct timeval tv;
+  gettimeofday(&tv, nullptr);
+  return tv.tv_sec * 1e6 + tv.tv_usec;
+}
+
+// The values are stored inline, so there's nothing to free.
+static void NoOpFree(HTValue_t value) { }
+
+// Prints one line of results.
+static void Report(const char* table, size_t n, const char* op,
+                   double usec, uint64_t checksum) {
+  cout << table << "\t" << n << "\t" << op << "\t"
+       << static_cast<int64_t>(usec) << "\t"
+       << usec * 1000.0 / n << "\t" << checksum << endl;
+}
+
+// Times inserting "keys" into a libhw1 HashTable, then finding each of
+// "lookups" (the same keys, in another order) and each of "misses".
+static void BenchHashTable(const vector<HTKey_t>& keys,
+                           const vector<HTKey_t>& lookups,
+                           const vector<HTKey_t>& misses) {
+  size_t n = keys.size();
+  HashTable* table = HashTable_Allocate(16);
+  HTKeyValue_t kv, old_kv;
+
+  double start = NowMicros();
+  for (size_t i = 0; i < n; i++) {
+    kv.key = keys[i];
+    kv.value = reinterpret_cast<HTValue_t>(i);
+    HashTable_Insert(table, kv, &old_kv);
+  }
+  Report("HashTable", n, "insert", NowMicros() - start, 0);
+
+  uint64_t checksum = 0;
+  start = NowMicros();
+  for (size_t i = 0; i < n; i++) {
+    Verify333(HashTable_Find(table, lookups[i], &kv));
+    checksum += reinterpret_cast<uint64_t>(kv.value);
+  }
+  Report("HashTable", n, "find", NowMicros() - start, checksum);
+
+  checksum = 0;
+  start = NowMicros();
+  for (size_t i = 0; i < n; i++) {
+    checksum += HashTable_Find(table, misses[i], &kv);
+  }
+  Report("HashTable", n, "miss", NowMicros() - start, checksum);
+
+  HashTable_Free(table, &NoOpFree);
+}
+
+// The same, for a FlatHashMap.
+static void BenchFlatHashMap(const vector<HTKey_t>& keys,
+                             const vector<HTKey_t>& lookups,
+                             const vector<HTKey_t>& misses) {
+  size_t n = keys.size();
+  FlatHashMap<HTKey_t, uint64_t>* map = new FlatHashMap<HTKey_t, uint64_t>();
+
+  double start = NowMicros();
+  for (size_t i = 0; i < n; i++) {
+    (*map)[keys[i]] = i;
+  }
+  Report("FlatHashMap", n, "insert", NowMicros() - start, 0);
+
+  uint64_t checksum = 0;
+  start = NowMicros();
+  for (size_t i = 0; i < n; i++) {
+    const uint64_t* value = map->Find(lookups[i]);
+    Verify333(value != nullptr);
+    checksum += *value;
+  }
+  Report("FlatHashMap", n, "find", NowMicros() - start, checksum);
+
+  checksum = 0;
+  start = NowMicros();
+  for (size_t i = 0; i < n; i++) {
+    checksum += map->Contains(misses[i]);
+  }
+  Report("FlatHashMap", n, "miss", NowMicros() - start, checksum);
+
+  delete map;
+}
+
+// Benchmarks libhw1's HashTable against FlatHashMap with 10^6 and 10^7
+// random 64-bit keys, like word hashes (or the key counts given as
+// arguments), printing one tab-separated line per table, size and
+// operation.  The finds look the keys up in a different order than they
+// were inserted, so neither table gets the benefit of the cache.  The
+// checksums of the two tables' find lines should match.
+int main(int argc, char** argv) {
+  vector<size_t> sizes;
+  for (int i = 1; i < argc; i++) {
+    int64_t n = atoll(argv[i]);
+    if (n <= 0) {
+      cerr << "Usage: " << argv[0] << " [num_keys ...]" << endl;
+      return EXIT_FAILURE;
+    }
+    sizes.push_back(n);
+  }
+  if (sizes.empty()) {
+    sizes = {1000000, 10000000};
+  }
+
+  cout << "table\tkeys\top\tusec\tns_per_op\tchecksum" << endl;
+  for (size_t n : sizes) {
+    // Distinct random keys, plus as many keys that aren't in the tables.
+    std::mt19937_64 rng(333);
+    vector<HTKey_t> keys(n), misses(n);
+    for (size_t i = 0; i < n; i++) {
+      keys[i] = rng() | 1;
+      misses[i] = rng() & ~static_cast<HTKey_t>(1);
+    }
+    vector<HTKey_t> lookups(keys);
+    std::shuffle(lookups.begin(), lookups.end(), rng);
+
+    BenchHashTable(keys, lookups, misses);
+    BenchFlatHashMap(keys, lookups, misses);
+  }
+  return EXIT_SUCCESS;
+}
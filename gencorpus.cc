@@ -0,0 +1,222 @@
+/*
+ * Copyright ©2024 Hannah C. Tang.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Washington
+ * CSE 333 for use solely during Spring Quarter 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#include <errno.h>
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/types.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "./SyntheticCorpus.h"
+
+using std::cerr;
+using std::cout;
+using std::endl;
+using std::string;
+using std::vector;
+
+// Returns the current time, in microseconds.
+static double NowMicros() {
+  struct timeval tv;
+  gettimeofday(&tv, nullptr);
+  return tv.tv_sec * 1e6 + tv.tv_usec;
+}
+
+static void Usage(char* progname) {
+  cerr << "Usage: " << progname << " [-n files] [-w words] [-d depth]"
+       << " [-f fanout] [-v vocabulary] [-z exponent] [-S seed] outdir"
+       << endl;
+  cerr << "where:" << endl;
+  cerr << "  files is the number of files to write (default 1000)" << endl;
+  cerr << "  words is the mean number of words per file (default 400);"
+       << endl;
+  cerr << "    file lengths are log-normally distributed around it" << endl;
+  cerr << "  depth is the depth of the directory tree (default 2)" << endl;
+  cerr << "  fanout is the number of subdirectories per directory"
+       << " (default 10)" << endl;
+  cerr << "  vocabulary is the number of distinct words (default 50000)"
+       << endl;
+  cerr << "  exponent is the Zipf exponent of the word frequencies"
+       << " (default 1)" << endl;
+  cerr << "  seed seeds the generator; the same options and seed always"
+       << " write the same tree (default 333)" << endl;
+  cerr << "  outdir is the directory to create the tree in; it must not"
+       << " exist" << endl;
+  exit(EXIT_FAILURE);
+}
+
+// Creates directory "path", returning false (and complaining) if it
+// couldn't be created.  If "may_exist", it's fine for it to exist already.
+static bool MakeDir(const string& path, bool may_exist) {
+  if (mkdir(path.c_str(), 0755) == 0 || (may_exist && errno == EEXIST)) {
+    return true;
+  }
+  perror(path.c_str());
+  return false;
+}
+
+// Returns the directory, under "root", that holds the files of leaf
+// directory number "leaf" of a tree "depth" levels deep with "fanout"
+// subdirectories per directory, creating its ancestors as needed.
+static bool MakeLeafDir(const string& root, int64_t leaf, int depth,
+                        int fanout, string* const dir) {
+  vector<int> digits(depth);
+  for (int level = depth - 1; level >= 0; level--) {
+    digits[level] = leaf % fanout;
+    leaf /= fanout;
+  }
+  *dir = root;
+  for (int digit : digits) {
+    *dir += "/d" + std::to_string(digit);
+    if (!MakeDir(*dir, true)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Writes a synthetic corpus for building indices from: a tree of
+// directories "depth" levels deep, each with "fanout" subdirectories,
+// whose leaves hold "files" text files between them, dealt out round
+// robin.  Each file is a sequence of sentences of words drawn from a
+// Zipf-distributed vocabulary (see SyntheticCorpus.h).  Everything is
+// drawn from a generator seeded with "seed", so a tree can be recreated
+// anywhere from its options alone.
+//
+// With the defaults, each leaf directory holds files/100 files; for very
+// large trees, raise the depth or fan-out to keep directories a sensible
+// size.  A summary line is printed once the tree is written.
+int main(int argc, char** argv) {
+  int64_t num_files = 1000;
+  int64_t mean_words = 400;
+  int depth = 2;
+  int fanout = 10;
+  int vocabulary_size = 50000;
+  double exponent = 1.0;
+  uint64_t seed = 333;
+  int opt;
+  while ((opt = getopt(argc, argv, "n:w:d:f:v:z:S:")) != -1) {
+    switch (opt) {
+      case 'n':
+        num_files = atoll(optarg);
+        if (num_files <= 0)
+          Usage(argv[0]);
+        break;
+      case 'w':
+        mean_words = atoll(optarg);
+        if (mean_words <= 0)
+          Usage(argv[0]);
+        break;
+      case 'd':
+        depth = atoi(optarg);
+        if (depth < 0 || depth > 16)
+          Usage(argv[0]);
+        break;
+      case 'f':
+        fanout = atoi(optarg);
+        if (fanout <= 0)
+          Usage(argv[0]);
+        break;
+      case 'v':
+        vocabulary_size = atoi(optarg);
+        if (vocabulary_size <= 0)
+          Usage(argv[0]);
+        break;
+      case 'z':
+        exponent = atof(optarg);
+        if (exponent < 0)
+          Usage(argv[0]);
+        break;
+      case 'S':
+        seed = strtoull(optarg, nullptr, 10);
+        break;
+      default:
+        Usage(argv[0]);
+    }
+  }
+  if (argc - optind != 1)
+    Usage(argv[0]);
+  string root = argv[optind];
+
+  int64_t num_leaves = 1;
+  for (int level = 0; level < depth; level++) {
+    num_leaves *= fanout;
+    if (num_leaves > num_files) {
+      cerr << "The tree has more leaf directories than files" << endl;
+      return EXIT_FAILURE;
+    }
+  }
+  if (!MakeDir(root, false)) {
+    return EXIT_FAILURE;
+  }
+
+  double start = NowMicros();
+  std::mt19937_64 rng(seed);
+  hw4::ZipfSampler zipf(vocabulary_size, exponent);
+  vector<string> vocabulary;
+  for (int i = 0; i < vocabulary_size; i++) {
+    vocabulary.push_back(hw4::VocabularyWord(i));
+  }
+
+  // A log-normal with sigma 1 has a mean of exp(mu + 1/2), so this
+  // centers the file lengths on mean_words, with a long tail of big files.
+  std::lognormal_distribution<double> length(std::log(mean_words) - 0.5,
+                                             1.0);
+  vector<string> leaf_dirs(num_leaves);
+  int64_t total_words = 0, total_bytes = 0;
+  string text;
+  for (int64_t f = 0; f < num_files; f++) {
+    int64_t leaf = f % num_leaves;
+    if (leaf_dirs[leaf].empty() &&
+        !MakeLeafDir(root, leaf, depth, fanout, &leaf_dirs[leaf])) {
+      return EXIT_FAILURE;
+    }
+
+    int64_t num_words = std::max(INT64_C(1), static_cast<int64_t>(
+                                   std::llround(length(rng))));
+    text.clear();
+    for (int64_t w = 0; w < num_words; w++) {
+      text += vocabulary[zipf.Sample(&rng)];
+      text += (w % 12 == 11 || w == num_words - 1) ? ".\n" : " ";
+    }
+
+    char name[32];
+    snprintf(name, sizeof(name), "/f%09" PRId64 ".txt", f);
+    string path = leaf_dirs[leaf] + name;
+    FILE* file = fopen(path.c_str(), "w");
+    bool written = file != nullptr &&
+                   fwrite(text.data(), 1, text.size(), file) == text.size();
+    if (file != nullptr && fclose(file) != 0) {
+      written = false;
+    }
+    if (!written) {
+      perror(path.c_str());
+      return EXIT_FAILURE;
+    }
+    total_words += num_words;
+    total_bytes += text.size();
+  }
+
+  cout << "# files=" << num_files << " leaf_dirs=" << num_leaves
+       << " words=" << total_words << " bytes=" << total_bytes
+       << " usec=" << static_cast<int64_t>(NowMicros() - start) << endl;
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,351 @@
+/*
+ * Copyright ©2024 Hannah C. Tang.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Washington
+ * CSE 333 for use solely during Spring Quarter 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <strings.h>
+#include <time.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "./HttpUtils.h"
+#include "./Metrics.h"
+
+using std::cerr;
+using std::cout;
+using std::endl;
+using std::string;
+using std::vector;
+
+using hw4::ConnectToServer;
+using hw4::Metrics;
+using hw4::WrappedRead;
+using hw4::WrappedWrite;
+
+// What to send, and how hard.
+struct BenchConfig {
+  string host;
+  uint16_t port;
+  int connections;
+  double duration_s;
+  double rate;              // total requests/second, or 0 for closed loop.
+  double zipf_exponent;     // 0 to replay the queries in order.
+  double static_fraction;   // of requests sent to static_path instead.
+  string static_path;
+  uint64_t seed;
+  vector<string> queries;   // URL-encoded, ready to append to "terms=".
+  vector<double> zipf_cdf;  // the cumulative popularity of each query.
+};
+
+// What one connection's thread did.
+struct ConnectionState {
+  const BenchConfig* config;
+  Metrics* metrics;
+  int index;
+  uint64_t requests;
+  uint64_t errors;
+  uint64_t bytes;
+};
+
+static void Usage(char* prog_name) {
+  cerr << "Usage: " << prog_name << " [-c connections] [-d seconds]"
+       << " [-r rate] [-z exponent] [-s fraction -p path] [-S seed]"
+       << " host port queryfile" << endl;
+  cerr << "where:" << endl;
+  cerr << "  connections is the number of keep-alive connections to open,"
+       << " each with one request" << endl
+       << "    outstanding at a time (default 16)" << endl;
+  cerr << "  seconds is how long to run for (default 10)" << endl;
+  cerr << "  rate is the total requests/second to send on a fixed schedule;"
+       << " latencies are" << endl
+       << "    measured from when each request was due (default 0: send"
+       << " each request" << endl
+       << "    as soon as the previous one on its connection completes)"
+       << endl;
+  cerr << "  exponent, if non-zero, picks each query at random, with the"
+       << " n'th line of the" << endl
+       << "    query file 1/n^exponent as popular as the first (default 0:"
+       << " replay the" << endl
+       << "    queries in order)" << endl;
+  cerr << "  fraction is the fraction of requests to send to /static/path"
+       << " (default 0)" << endl;
+  cerr << "  seed seeds the random choices (default 1)" << endl;
+  cerr << "  queryfile contains one query per line" << endl;
+  exit(EXIT_FAILURE);
+}
+
+// Returns "query" encoded for use in a URL's query string.
+static string EncodeQuery(const string& query) {
+  static const char* kHex = "0123456789ABCDEF";
+  string encoded;
+  for (unsigned char c : query) {
+    if (isalnum(c) || c == '-' || c == '_' || c == '.' || c == '*') {
+      encoded += c;
+    } else if (c == ' ') {
+      encoded += '+';
+    } else {
+      encoded += '%';
+      encoded += kHex[c >> 4];
+      encoded += kHex[c & 0xF];
+    }
+  }
+  return encoded;
+}
+
+// Sends "request" on *fd and reads the response, reconnecting first if
+// *fd is -1.  Returns the number of bytes in the response if it was a
+// 200, or -1 (closing *fd if the connection is no good) otherwise.
+static int64_t Exchange(const BenchConfig& config, const string& request,
+                        int* const fd) {
+  if (*fd == -1 && !ConnectToServer(config.host, config.port, fd)) {
+    *fd = -1;
+    return -1;
+  }
+  if (WrappedWrite(*fd, reinterpret_cast<const unsigned char*>(
+                     request.data()), request.size())
+      != static_cast<int>(request.size())) {
+    close(*fd);
+    *fd = -1;
+    return -1;
+  }
+
+  // Read up to the end of the headers, then as much body as they say.
+  string response;
+  unsigned char buf[16384];
+  size_t header_end;
+  while ((header_end = response.find("\r\n\r\n")) == string::npos) {
+    int bytes_read = WrappedRead(*fd, buf, sizeof(buf));
+    if (bytes_read <= 0) {
+      close(*fd);
+      *fd = -1;
+      return -1;
+    }
+    response.append(reinterpret_cast<char*>(buf), bytes_read);
+  }
+  size_t body_bytes = 0;
+  const char* length = strcasestr(response.c_str(), "\r\nContent-length:");
+  if (length != nullptr && length < response.c_str() + header_end) {
+    body_bytes = strtoul(length + strlen("\r\nContent-length:"), nullptr, 10);
+  }
+  size_t total_bytes = header_end + 4 + body_bytes;
+  while (response.size() < total_bytes) {
+    int bytes_read = WrappedRead(*fd, buf, std::min(sizeof(buf),
+                                 total_bytes - response.size()));
+    if (bytes_read <= 0) {
+      close(*fd);
+      *fd = -1;
+      return -1;
+    }
+    response.append(reinterpret_cast<char*>(buf), bytes_read);
+  }
+
+  // "HTTP/1.1 200 OK"
+  size_t code = response.find(' ');
+  if (code == string::npos || response.compare(code + 1, 3, "200") != 0) {
+    return -1;
+  }
+  return total_bytes;
+}
+
+// Runs one connection's worth of requests until the time is up.
+static void* ConnectionThread(void* arg) {
+  ConnectionState* state = static_cast<ConnectionState*>(arg);
+  const BenchConfig& config = *state->config;
+  std::mt19937_64 rng(config.seed * 1000003 + state->index);
+  std::uniform_real_distribution<double> uniform(0.0, 1.0);
+
+  // In order, each connection starts at a different place in the file.
+  size_t next_query = state->index * config.queries.size() /
+                      config.connections;
+  double interval = config.rate > 0 ? 1e9 * config.connections / config.rate
+                                    : 0;
+  int64_t start = Metrics::Now();
+  int64_t end = start + static_cast<int64_t>(config.duration_s * 1e9);
+  int64_t due = start + static_cast<int64_t>(interval * uniform(rng));
+  int fd = -1;
+  while (true) {
+    // In an open loop, wait until the request is due.  If we're running
+    // late, it's sent right away, but still timed from when it was due, so
+    // that a stalled server can't hide the requests it held up.
+    int64_t now = Metrics::Now();
+    if (config.rate > 0) {
+      if (due >= end) {
+        break;
+      }
+      if (due > now) {
+        struct timespec ts;
+        ts.tv_sec = (due - now) / 1000000000;
+        ts.tv_nsec = (due - now) % 1000000000;
+        nanosleep(&ts, nullptr);
+      }
+    } else if (now >= end) {
+      break;
+    } else {
+      due = now;
+    }
+
+    string uri;
+    if (config.static_fraction > 0 &&
+        uniform(rng) < config.static_fraction) {
+      uri = "/static/" + config.static_path;
+    } else if (config.zipf_exponent > 0) {
+      size_t q = std::lower_bound(config.zipf_cdf.begin(),
+                                  config.zipf_cdf.end(), uniform(rng)) -
+                 config.zipf_cdf.begin();
+      uri = "/query?terms=" +
+            config.queries[std::min(q, config.queries.size() - 1)];
+    } else {
+      uri = "/query?terms=" + config.queries[next_query];
+      next_query = (next_query + 1) % config.queries.size();
+    }
+    string request = "GET " + uri + " HTTP/1.1\r\nHost: " + config.host +
+                     "\r\n\r\n";
+
+    int64_t bytes = Exchange(config, request, &fd);
+    state->metrics->Record(Metrics::kRequest, Metrics::Now() - due);
+    state->requests++;
+    if (bytes < 0) {
+      state->errors++;
+    } else {
+      state->bytes += bytes;
+    }
+    due += static_cast<int64_t>(interval);
+  }
+  if (fd != -1) {
+    close(fd);
+  }
+  return nullptr;
+}
+
+// Opens the configured number of keep-alive connections to an http333d
+// and sends it queries (and, optionally, static file requests) for a
+// while, then reports the throughput and the distribution of latencies.
+// The last line of output summarizes the run as key=value pairs.
+int main(int argc, char** argv) {
+  BenchConfig config;
+  config.connections = 16;
+  config.duration_s = 10;
+  config.rate = 0;
+  config.zipf_exponent = 0;
+  config.static_fraction = 0;
+  config.seed = 1;
+
+  int opt;
+  while ((opt = getopt(argc, argv, "c:d:r:z:s:p:S:")) != -1) {
+    switch (opt) {
+      case 'c': config.connections = atoi(optarg); break;
+      case 'd': config.duration_s = atof(optarg); break;
+      case 'r': config.rate = atof(optarg); break;
+      case 'z': config.zipf_exponent = atof(optarg); break;
+      case 's': config.static_fraction = atof(optarg); break;
+      case 'p': config.static_path = optarg; break;
+      case 'S': config.seed = strtoull(optarg, nullptr, 10); break;
+      default: Usage(argv[0]);
+    }
+  }
+  if (argc - optind != 3 || config.connections <= 0 ||
+      config.duration_s <= 0 || config.rate < 0 ||
+      config.zipf_exponent < 0 || config.static_fraction < 0 ||
+      config.static_fraction > 1 ||
+      (config.static_fraction > 0 && config.static_path.empty())) {
+    Usage(argv[0]);
+  }
+  config.host = argv[optind];
+  config.port = atoi(argv[optind + 1]);
+
+  std::ifstream query_file(argv[optind + 2]);
+  if (!query_file) {
+    cerr << "couldn't open " << argv[optind + 2] << endl;
+    Usage(argv[0]);
+  }
+  string line;
+  while (std::getline(query_file, line)) {
+    if (line.find_first_not_of(" \t\r") != string::npos) {
+      config.queries.push_back(EncodeQuery(line));
+    }
+  }
+  if (config.queries.empty()) {
+    cerr << "no queries in " << argv[optind + 2] << endl;
+    Usage(argv[0]);
+  }
+  if (config.zipf_exponent > 0) {
+    double total = 0;
+    for (size_t i = 0; i < config.queries.size(); i++) {
+      total += 1.0 / pow(i + 1, config.zipf_exponent);
+      config.zipf_cdf.push_back(total);
+    }
+    for (double& p : config.zipf_cdf) {
+      p /= total;
+    }
+  }
+
+  Metrics metrics;
+  vector<ConnectionState> states(config.connections);
+  vector<pthread_t> threads(config.connections);
+  int64_t start = Metrics::Now();
+  for (int i = 0; i < config.connections; i++) {
+    states[i] = { &config, &metrics, i, 0, 0, 0 };
+    if (pthread_create(&threads[i], nullptr, &ConnectionThread,
+                       &states[i]) != 0) {
+      cerr << "couldn't create a thread" << endl;
+      return EXIT_FAILURE;
+    }
+  }
+  uint64_t requests = 0, errors = 0, bytes = 0;
+  for (int i = 0; i < config.connections; i++) {
+    pthread_join(threads[i], nullptr);
+    requests += states[i].requests;
+    errors += states[i].errors;
+    bytes += states[i].bytes;
+  }
+  double elapsed_s = (Metrics::Now() - start) / 1e9;
+
+  Metrics::Histogram latency;
+  metrics.GetHistogram(Metrics::kRequest, &latency);
+  const double kQuantiles[] = { 0.5, 0.9, 0.99, 0.999 };
+  const char* kQuantileNames[] = { "p50", "p90", "p99", "p999" };
+  cout << "# latency_us";
+  for (const char* name : kQuantileNames) {
+    cout << "\t" << name;
+  }
+  cout << "\tmax" << endl;
+  cout << "latency_us";
+  for (double quantile : kQuantiles) {
+    cout << "\t" << latency.ValueAtQuantile(quantile) / 1000;
+  }
+  cout << "\t" << latency.max / 1000 << endl;
+
+  cout << "# connections=" << config.connections
+       << " mode=" << (config.rate > 0 ? "open" : "closed")
+       << " rate=" << config.rate
+       << " zipf=" << config.zipf_exponent
+       << " static=" << config.static_fraction
+       << " seconds=" << elapsed_s
+       << " requests=" << requests
+       << " errors=" << errors
+       << " bytes=" << bytes
+       << " qps=" << static_cast<int64_t>(requests / elapsed_s);
+  for (size_t i = 0; i < sizeof(kQuantiles) / sizeof(kQuantiles[0]); i++) {
+    cout << " " << kQuantileNames[i] << "_us="
+         << latency.ValueAtQuantile(kQuantiles[i]) / 1000;
+  }
+  cout << " max_us=" << latency.max / 1000 << endl;
+  return errors == 0 && requests > 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
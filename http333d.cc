@@ -9,6 +9,7 @@
  * author.
  */
 
+#include <ctype.h>
 #include <dirent.h>
 #include <fcntl.h>
 #include <sys/types.h>
@@ -17,6 +18,7 @@
 #include <signal.h>
 #include <cstdlib>
 #include <cstdio>
+#include <cstring>
 #include <iostream>
 #include <list>
 
@@ -37,7 +39,8 @@ static void Usage(char* prog_name);
 //
 // Params:
 // - argc: number of argumnets
-// - argv: array of arguments
+// - argv: array of arguments, whose positional arguments start at
+//   argv[optind] once getopt() has consumed the options
 // - port: output parameter returning the port number to listen on
 // - path: output parameter returning the directory with our static files
 // - indices: output parameter returning the list of index file names
@@ -64,6 +67,23 @@ int main(int argc, char** argv) {
   // disconnects unexpectedly.
   signal(SIGPIPE, SIG_IGN);
 
+  // "-z level" sets the level dynamic responses are compressed at.
+  int compression_level = hw4::kDefaultCompressionLevel;
+  int opt;
+  while ((opt = getopt(argc, argv, "z:")) != -1) {
+    switch (opt) {
+      case 'z':
+        if (strlen(optarg) != 1 || !isdigit(optarg[0])) {
+          cerr << "compression level must be from 0 to 9." << endl;
+          Usage(argv[0]);
+        }
+        compression_level = optarg[0] - '0';
+        break;
+      default:
+        Usage(argv[0]);
+    }
+  }
+
   // Get the port number and list of index files.
   uint16_t port_num;
   string static_dir;
@@ -71,9 +91,15 @@ int main(int argc, char** argv) {
   GetPortAndPath(argc, argv, &port_num, &static_dir, &indices);
   cout << "    port: " << port_num << endl;
   cout << "    path: " << static_dir << endl;
+  cout << "    compression level: " << compression_level << endl;
+
+  // The indices can be rebuilt while the server runs; tell the user how
+  // to get it to pick them up.
+  cout << "    (send SIGHUP or GET /admin/reload from localhost to reload"
+       << " the indices)" << endl;
 
   // Run the server.
-  hw4::HttpServer hs(port_num, static_dir, indices);
+  hw4::HttpServer hs(port_num, static_dir, indices, compression_level);
   if (!hs.Run()) {
     cerr << "  server failed to run!?" << endl;
   }
@@ -84,8 +110,12 @@ int main(int argc, char** argv) {
 
 
 static void Usage(char* prog_name) {
-  cerr << "Usage: " << prog_name << " port staticfiles_directory indices+";
-  cerr << endl;
+  cerr << "Usage: " << prog_name << " [-z level] port staticfiles_directory"
+       << " indices+" << endl;
+  cerr << "where level is how hard to compress dynamic responses, from 1"
+       << " (fastest) to" << endl;
+  cerr << "  9 (smallest), or 0 not to; the default is "
+       << hw4::kDefaultCompressionLevel << endl;
   exit(EXIT_FAILURE);
 }
 
@@ -97,37 +127,38 @@ static void GetPortAndPath(int argc,
   // Here are some considerations when implementing this function:
   // - There is a reasonable number of command line arguments
   // - The port number is reasonable
-  // - The path (i.e., argv[2]) is a readable directory
+  // - The path (i.e., argv[optind + 1]) is a readable directory
   // - You have at least 1 index, and all indices are readable files
 
   // STEP 1:
-  // check if at least four arguments are provided.
-  if (argc < 4) {
+  // check if at least three positional arguments are provided.
+  int first = optind;
+  if (argc - first < 3) {
     Usage(argv[0]);
   }
 
-  // validate the port number (argv[1]).
-  *port = atoi(argv[1]);
+  // validate the port number (argv[first]).
+  *port = atoi(argv[first]);
   if (*port < 1024) {
     cerr << "port number < 1024 is not valid." << endl;
     Usage(argv[0]);
   }
 
-  // check if the directory path (argv[2]) is readable.
+  // check if the directory path (argv[first + 1]) is readable.
   struct stat dir_stat;
-  if (stat(argv[2], &dir_stat) == -1) {
-    cerr << argv[2] << " is not readable." << endl;
+  if (stat(argv[first + 1], &dir_stat) == -1) {
+    cerr << argv[first + 1] << " is not readable." << endl;
     Usage(argv[0]);
   }
 
   if (!S_ISDIR(dir_stat.st_mode)) {
-    cerr << argv[2] << " is not a directory." << endl;
+    cerr << argv[first + 1] << " is not a directory." << endl;
     Usage(argv[0]);
   }
 
-  *path = std::string(argv[2]);
+  *path = std::string(argv[first + 1]);
   // check for readable index files among the remaining arguments.
-  for (int i = 3; i < argc; i++) {
+  for (int i = first + 2; i < argc; i++) {
     std::string fname(argv[i]);
     if (fname.length() >= 4 && fname.substr(fname.length() - 4) == ".idx") {
       struct stat fstat;
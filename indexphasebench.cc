@@ -0,0 +1,179 @@
+/*
+ * Copyright ©2024 Hannah C. Tang.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Washington
+ * CSE 333 for use solely during Spring Quarter 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <time.h>
+#include <unistd.h>
+#include <iostream>
+#include <string>
+#include <vector>
+
+extern "C" {
+  #include "libhw1/CSE333.h"
+  #include "libhw2/CrawlFileTree.h"
+  #include "libhw2/DocTable.h"
+  #include "libhw2/MemIndex.h"
+}
+#include "./libhw3/WriteIndex.h"
+
+using std::cerr;
+using std::cout;
+using std::endl;
+using std::string;
+using std::vector;
+
+// Returns the current time, in nanoseconds.
+static int64_t NowNanos() {
+  struct timespec ts;
+  Verify333(clock_gettime(CLOCK_MONOTONIC, &ts) == 0);
+  return static_cast<int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+// Returns the peak resident set size of this process so far, in MB.
+static double PeakRssMb() {
+  struct rusage usage;
+  Verify333(getrusage(RUSAGE_SELF, &usage) == 0);
+  return usage.ru_maxrss / 1024.0;
+}
+
+static void Usage(char* progname) {
+  cerr << "Usage: " << progname << " [-m budget_mb] crawlrootdir"
+       << " [indexfilename]" << endl;
+  cerr << "where:" << endl;
+  cerr << "  budget_mb, if given, bounds the memory used for the inverted"
+       << endl;
+  cerr << "    index, as for buildfileindex -m" << endl;
+  cerr << "  crawlrootdir is the name of a directory to index" << endl;
+  cerr << "  indexfilename, if given, is where to keep the index; otherwise"
+       << endl;
+  cerr << "    it's written to /tmp and deleted" << endl;
+  exit(EXIT_FAILURE);
+}
+
+// Writes each of a crawl's spills out as a run named run_prefix0, ...,
+// recording its name in "runs".
+struct SpillRunsArg {
+  string run_prefix;
+  vector<string> runs;
+};
+static bool SpillRun(MemIndex* index, void* arg) {
+  SpillRunsArg* spill_arg = static_cast<SpillRunsArg*>(arg);
+  string name = spill_arg->run_prefix +
+    std::to_string(spill_arg->runs.size());
+  if (hw3::WriteIndexRun(index, name.c_str()) <= 0) {
+    return false;
+  }
+  spill_arg->runs.push_back(name);
+  return true;
+}
+
+// Builds an index of a directory tree the way buildfileindex does, timing
+// each phase of the build separately, and prints a tab-separated header
+// and a line with what was indexed, the time spent in each phase, the
+// peak RSS once the tree was indexed and at the end, and the size of the
+// index.  Run it on trees written by gencorpus with growing -n to see how
+// each phase scales.
+//
+// The crawl is CrawlFileTree_Timed(), or with -m, CrawlFileTree_SpillTimed()
+// spilling runs with WriteIndexRun(); see CrawlTimes for its phases.
+// Writing is WriteIndex(), or with -m, MergeIndexRuns().  The
+// filesystem's cache isn't dropped, so run it twice to time a warm crawl.
+//
+// Each run is a fresh process, so its peak RSS is its own: run it without
+// -m and with each budget to compare building in memory with building in
+// runs.  The budget only bounds the inverted index, so the peak RSS also
+// includes the DocTable, the word pool and the largest file's postings.
+int main(int argc, char** argv) {
+  int64_t budget_mb = 0;
+  int opt;
+  while ((opt = getopt(argc, argv, "m:")) != -1) {
+    switch (opt) {
+      case 'm':
+        budget_mb = atoll(optarg);
+        if (budget_mb <= 0)
+          Usage(argv[0]);
+        break;
+      default:
+        Usage(argv[0]);
+    }
+  }
+  if (argc - optind != 1 && argc - optind != 2)
+    Usage(argv[0]);
+  string root = argv[optind];
+  struct stat st;
+  if (stat(root.c_str(), &st) != 0 || !S_ISDIR(st.st_mode)) {
+    cerr << root << " isn't a directory" << endl;
+    return EXIT_FAILURE;
+  }
+
+  bool keep_index = argc - optind == 2;
+  string index_file = keep_index ? argv[optind + 1] :
+    "/tmp/indexphasebench." + std::to_string(getpid()) + ".idx";
+  SpillRunsArg spill_arg;
+  spill_arg.run_prefix = index_file + ".run";
+
+  DocTable* dt;
+  MemIndex* mi = nullptr;
+  CrawlTimes times;
+  int64_t start = NowNanos();
+  bool crawled = budget_mb > 0 ?
+    CrawlFileTree_SpillTimed(const_cast<char*>(root.c_str()), &dt,
+                             budget_mb << 20, &SpillRun, &spill_arg,
+                             &times) :
+    CrawlFileTree_Timed(const_cast<char*>(root.c_str()), &dt, &mi, &times);
+  int64_t indexed = NowNanos();
+  double indexed_rss_mb = PeakRssMb();
+
+  int64_t idx_len = -1;
+  if (!crawled) {
+    cerr << "Crawling " << root << " failed" << endl;
+  } else if (budget_mb > 0) {
+    idx_len = hw3::MergeIndexRuns(spill_arg.runs, dt, index_file.c_str());
+  } else {
+    idx_len = hw3::WriteIndex(mi, dt, index_file.c_str());
+  }
+  int64_t end = NowNanos();
+
+  for (const string& name : spill_arg.runs) {
+    unlink(name.c_str());
+  }
+  if (!keep_index) {
+    unlink(index_file.c_str());
+  }
+  if (!crawled) {
+    return EXIT_FAILURE;
+  }
+  if (mi != nullptr) {
+    MemIndex_Free(mi);
+  }
+  DocTable_Free(dt);
+  if (idx_len <= 0) {
+    cerr << "Writing the index failed" << endl;
+    return EXIT_FAILURE;
+  }
+
+  cout << "budget_mb\tfiles\tbytes\tcrawl_usec\tread_usec\tparse_usec"
+       << "\tmerge_usec\tspill_usec\twrite_usec\ttotal_usec"
+       << "\tindexed_peak_rss_mb\tpeak_rss_mb\tindex_bytes" << endl;
+  cout << budget_mb << "\t" << times.num_files << "\t" << times.num_bytes
+       << "\t" << times.crawl_nanos / 1000 << "\t" << times.read_nanos / 1000
+       << "\t" << times.parse_nanos / 1000
+       << "\t" << times.merge_nanos / 1000
+       << "\t" << times.spill_nanos / 1000
+       << "\t" << (end - indexed) / 1000
+       << "\t" << (end - start) / 1000 << "\t" << indexed_rss_mb
+       << "\t" << PeakRssMb() << "\t" << idx_len << endl;
+  return EXIT_SUCCESS;
+}
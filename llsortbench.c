@@ -0,0 +1,125 @@
+/*
+ * Copyright ©2024 Hannah C. Tang.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Washington
+ * CSE 333 for use solely during Spring Quarter 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+
+#include "CSE333.h"
+#include "LinkedList.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// Prototypes
+
+// Compares payloads holding integers, counting the comparisons it makes.
+static int CountingComparator(LLPayload_t p1, LLPayload_t p2);
+
+// The payloads aren't pointers, so there's nothing to free.
+static void NoOpFree(LLPayload_t payload) { }
+
+// Returns a list of n pseudo-random integer payloads.
+static LinkedList *MakeList(int n, uint32_t seed);
+
+// Times one LinkedList_SortTopK() (or, if k < 0, LinkedList_Sort()) of a
+// fresh n-element list, and prints a line of results.
+static void RunOne(int n, int k);
+
+// Returns the current time, in microseconds.
+static double NowMicros(void);
+
+static uint64_t num_comparisons = 0;
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Main
+//
+// Benchmarks LinkedList_Sort() and LinkedList_SortTopK() on lists of 10^3
+// to 10^6 elements (or only those up to the optional argument), printing
+// one tab-separated line per run:
+//
+//   n  k  microseconds  comparisons  comparisons/(n log2 n)
+//
+// where k is "all" for a full sort.
+int main(int argc, char **argv) {
+  int max_n = 1000000;
+  if (argc > 2) {
+    fprintf(stderr, "Usage: %s [max_n]\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+  if (argc == 2) {
+    max_n = atoi(argv[1]);
+  }
+
+  printf("n\tk\tusec\tcomparisons\tper_nlogn\n");
+  for (int n = 1000; n <= max_n; n *= 10) {
+    RunOne(n, -1);
+    RunOne(n, 10);
+    RunOne(n, 100);
+    RunOne(n, 1000);
+  }
+  return EXIT_SUCCESS;
+}
+
+static int CountingComparator(LLPayload_t p1, LLPayload_t p2) {
+  uintptr_t a = (uintptr_t) p1, b = (uintptr_t) p2;
+  num_comparisons++;
+  if (a < b)
+    return -1;
+  if (a > b)
+    return 1;
+  return 0;
+}
+
+static LinkedList *MakeList(int n, uint32_t seed) {
+  LinkedList *list = LinkedList_Allocate();
+  for (int i = 0; i < n; i++) {
+    seed = seed * 1103515245 + 12345;
+    LinkedList_Append(list, (LLPayload_t) (uintptr_t) (seed >> 8));
+  }
+  return list;
+}
+
+static void RunOne(int n, int k) {
+  LinkedList *list = MakeList(n, 333);
+  num_comparisons = 0;
+
+  double start = NowMicros();
+  if (k < 0) {
+    LinkedList_Sort(list, false, &CountingComparator);
+  } else {
+    LinkedList_SortTopK(list, false, &CountingComparator, k);
+  }
+  double elapsed = NowMicros() - start;
+
+  double log_n = 0;
+  for (int m = n; m > 1; m /= 2) {
+    log_n++;
+  }
+  if (k < 0) {
+    printf("%d\tall", n);
+  } else {
+    printf("%d\t%d", n, k);
+  }
+  printf("\t%.0f\t%" PRIu64 "\t%.3f\n", elapsed, num_comparisons,
+         num_comparisons / (n * log_n));
+  LinkedList_Free(list, &NoOpFree);
+}
+
+static double NowMicros(void) {
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return tv.tv_sec * 1e6 + tv.tv_usec;
+}
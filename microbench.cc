@@ -0,0 +1,490 @@
+/*
+ * Copyright ©2024 Hannah C. Tang.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Washington
+ * CSE 333 for use solely during Spring Quarter 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include <algorithm>
+#include <functional>
+#include <iostream>
+#include <list>
+#include <random>
+#include <string>
+#include <vector>
+
+extern "C" {
+  #include "libhw1/CSE333.h"
+  #include "libhw1/HashTable.h"
+  #include "libhw1/LinkedList.h"
+  #include "libhw2/CrawlFileTree.h"
+  #include "libhw2/DocTable.h"
+  #include "libhw2/FileParser.h"
+  #include "libhw2/MemIndex.h"
+}
+#include "./libhw3/DocIDTableReader.h"
+#include "./libhw3/FileIndexReader.h"
+#include "./libhw3/IndexTableReader.h"
+#include "./libhw3/QueryProcessor.h"
+#include "./libhw3/WriteIndex.h"
+#include "./SyntheticCorpus.h"
+
+using std::cerr;
+using std::cout;
+using std::endl;
+using std::list;
+using std::string;
+using std::vector;
+using hw4::VocabularyWord;
+using hw4::ZipfSampler;
+
+// The size of everything.  These are fixed, so that the results of runs
+// on different commits can be compared line for line.
+static const int kNumKeys = 1000000;      // HashTable and LinkedList.
+static const int kVocabularySize = 20000;
+static const int kNumDocs = 2000;
+static const int kWordsPerDoc = 400;
+static const int kNumLookups = 50000;
+static const int kNumQueries = 500;
+
+// A benchmark times its hot loop, storing the time in *usec, and returns
+// a checksum of what it computed, which must be the same on every run.
+typedef std::function<uint64_t(double* usec)> BenchFn;
+
+// Returns the current time, in microseconds.
+static double NowMicros() {
+  struct timeval tv;
+  gettimeofday(&tv, nullptr);
+  return tv.tv_sec * 1e6 + tv.tv_usec;
+}
+
+// The values and payloads aren't pointers, so there's nothing to free.
+static void NoOpFree(void* value) { }
+
+// Orders LinkedList payloads holding integers.
+static int CompareInts(LLPayload_t a, LLPayload_t b) {
+  uint64_t x = reinterpret_cast<uint64_t>(a);
+  uint64_t y = reinterpret_cast<uint64_t>(b);
+  return x < y ? -1 : (x > y ? 1 : 0);
+}
+
+// The synthetic corpus the libhw2 and libhw3 benchmarks run over, and
+// the index built from it.
+struct Corpus {
+  vector<string> vocabulary;
+  vector<string> docs;
+  string index_file;
+};
+
+// Parses and indexes the corpus's documents, returning a new DocTable and
+// MemIndex through "dt" and "mi".
+static void IndexCorpus(const Corpus& corpus, DocTable** const dt,
+                        MemIndex** const mi) {
+  *dt = DocTable_Allocate();
+  *mi = MemIndex_Allocate();
+  for (int d = 0; d < kNumDocs; d++) {
+    string name = "doc" + std::to_string(d) + ".txt";
+    DocID_t doc_id = DocTable_Add(*dt, const_cast<char*>(name.c_str()));
+    HashTable* tab = ParseIntoWordPositionsTable(strdup(
+                                                   corpus.docs[d].c_str()));
+    Verify333(tab != nullptr);
+    CrawlFileTree_AddDocument(*mi, doc_id, tab, nullptr, nullptr);
+  }
+}
+
+// Builds the corpus, and writes its index to a file in "dir".
+static void BuildCorpus(const string& dir, Corpus* corpus) {
+  std::mt19937_64 rng(333);
+  ZipfSampler zipf(kVocabularySize);
+  for (int i = 0; i < kVocabularySize; i++) {
+    corpus->vocabulary.push_back(VocabularyWord(i));
+  }
+  for (int d = 0; d < kNumDocs; d++) {
+    string doc;
+    for (int w = 0; w < kWordsPerDoc; w++) {
+      doc += corpus->vocabulary[zipf.Sample(&rng)];
+      doc += (w % 12 == 11) ? ".\n" : " ";
+    }
+    corpus->docs.push_back(doc);
+  }
+
+  DocTable* dt;
+  MemIndex* mi;
+  IndexCorpus(*corpus, &dt, &mi);
+  corpus->index_file = dir + "/microbench.idx";
+  Verify333(hw3::WriteIndex(mi, dt, corpus->index_file.c_str(), 1) > 0);
+  MemIndex_Free(mi);
+  DocTable_Free(dt);
+}
+
+// Returns kNumKeys distinct random keys, in a fixed order.
+static vector<HTKey_t> RandomKeys(uint64_t seed) {
+  std::mt19937_64 rng(seed);
+  vector<HTKey_t> keys(kNumKeys);
+  for (HTKey_t& key : keys) {
+    key = rng() | 1;
+  }
+  return keys;
+}
+
+static uint64_t BenchHashTableInsert(int64_t initial_buckets, double* usec) {
+  vector<HTKey_t> keys = RandomKeys(1);
+  HashTable* table = HashTable_Allocate(initial_buckets);
+  HTKeyValue_t kv, old_kv;
+  double start = NowMicros();
+  for (int i = 0; i < kNumKeys; i++) {
+    kv.key = keys[i];
+    kv.value = reinterpret_cast<HTValue_t>(static_cast<intptr_t>(i));
+    HashTable_Insert(table, kv, &old_kv);
+  }
+  *usec = NowMicros() - start;
+  uint64_t checksum = HashTable_NumElements(table);
+  HashTable_Free(table, &NoOpFree);
+  return checksum;
+}
+
+static uint64_t BenchHashTableFind(bool hits, double* usec) {
+  vector<HTKey_t> keys = RandomKeys(1);
+  HashTable* table = HashTable_Allocate(16);
+  HTKeyValue_t kv, old_kv;
+  for (int i = 0; i < kNumKeys; i++) {
+    kv.key = keys[i];
+    kv.value = reinterpret_cast<HTValue_t>(static_cast<intptr_t>(i));
+    HashTable_Insert(table, kv, &old_kv);
+  }
+
+  // Look the keys up in a different order than they went in, or look up
+  // keys that aren't there (they're even; the ones in the table are odd).
+  std::mt19937_64 rng(2);
+  if (hits) {
+    std::shuffle(keys.begin(), keys.end(), rng);
+  } else {
+    for (HTKey_t& key : keys) {
+      key = rng() & ~static_cast<HTKey_t>(1);
+    }
+  }
+  uint64_t checksum = 0;
+  double start = NowMicros();
+  for (int i = 0; i < kNumKeys; i++) {
+    if (HashTable_Find(table, keys[i], &kv)) {
+      checksum += reinterpret_cast<uint64_t>(kv.value);
+    }
+  }
+  *usec = NowMicros() - start;
+  HashTable_Free(table, &NoOpFree);
+  return checksum;
+}
+
+static uint64_t BenchLinkedListAppend(double* usec) {
+  LinkedList* ll = LinkedList_Allocate();
+  double start = NowMicros();
+  for (intptr_t i = 0; i < kNumKeys; i++) {
+    LinkedList_Append(ll, reinterpret_cast<LLPayload_t>(i));
+  }
+  *usec = NowMicros() - start;
+  uint64_t checksum = LinkedList_NumElements(ll);
+  LinkedList_Free(ll, &NoOpFree);
+  return checksum;
+}
+
+static uint64_t BenchLinkedListSort(double* usec) {
+  vector<HTKey_t> keys = RandomKeys(3);
+  LinkedList* ll = LinkedList_Allocate();
+  for (HTKey_t key : keys) {
+    LinkedList_Append(ll, reinterpret_cast<LLPayload_t>(key >> 1));
+  }
+  double start = NowMicros();
+  LinkedList_Sort(ll, true, &CompareInts);
+  *usec = NowMicros() - start;
+
+  // Check the order, and checksum the first element.
+  LLPayload_t first, payload, prev = nullptr;
+  LLIterator* it = LLIterator_Allocate(ll);
+  LLIterator_Get(it, &first);
+  while (LLIterator_IsValid(it)) {
+    LLIterator_Get(it, &payload);
+    Verify333(CompareInts(prev, payload) <= 0);
+    prev = payload;
+    LLIterator_Next(it);
+  }
+  LLIterator_Free(it);
+  LinkedList_Free(ll, &NoOpFree);
+  return reinterpret_cast<uint64_t>(first);
+}
+
+static uint64_t BenchParse(const Corpus& corpus, double* usec) {
+  vector<char*> contents;
+  for (const string& doc : corpus.docs) {
+    contents.push_back(strdup(doc.c_str()));
+  }
+  vector<HashTable*> tables;
+  double start = NowMicros();
+  for (char* doc : contents) {
+    tables.push_back(ParseIntoWordPositionsTable(doc));
+  }
+  *usec = NowMicros() - start;
+  uint64_t checksum = 0;
+  for (HashTable* table : tables) {
+    checksum += HashTable_NumElements(table);
+    FreeWordPositionsTable(table);
+  }
+  return checksum;
+}
+
+static uint64_t BenchMemIndexAdd(const Corpus& corpus, double* usec) {
+  // Every document's words, each with a single position.  Both the words
+  // and the lists are handed over to the MemIndex.
+  struct Posting {
+    char* word;
+    DocID_t doc_id;
+    LinkedList* positions;
+  };
+  vector<Posting> postings;
+  for (int d = 0; d < kNumDocs; d++) {
+    HashTable* tab = ParseIntoWordPositionsTable(strdup(
+                                                   corpus.docs[d].c_str()));
+    HTIterator* it = HTIterator_Allocate(tab);
+    for (; HTIterator_IsValid(it); HTIterator_Next(it)) {
+      HTKeyValue_t kv;
+      HTIterator_Get(it, &kv);
+      WordPositions* wp = static_cast<WordPositions*>(kv.value);
+      LinkedList* positions = LinkedList_Allocate();
+      LinkedList_Append(positions, nullptr);
+      postings.push_back({strdup(wp->word), static_cast<DocID_t>(d + 1),
+                          positions});
+    }
+    HTIterator_Free(it);
+    FreeWordPositionsTable(tab);
+  }
+
+  MemIndex* mi = MemIndex_Allocate();
+  double start = NowMicros();
+  for (const Posting& posting : postings) {
+    MemIndex_AddPostingList(mi, posting.word, posting.doc_id,
+                            posting.positions);
+  }
+  *usec = NowMicros() - start;
+  uint64_t checksum =
+    static_cast<uint64_t>(MemIndex_NumWords(mi)) * 1000003 + postings.size();
+  MemIndex_Free(mi);
+  return checksum;
+}
+
+static uint64_t BenchWriteIndex(const Corpus& corpus, double* usec) {
+  DocTable* dt;
+  MemIndex* mi;
+  IndexCorpus(corpus, &dt, &mi);
+
+  string file_name = corpus.index_file + ".tmp";
+  double start = NowMicros();
+  Verify333(hw3::WriteIndex(mi, dt, file_name.c_str(), 1) > 0);
+  *usec = NowMicros() - start;
+  struct stat st;
+  Verify333(stat(file_name.c_str(), &st) == 0);
+  unlink(file_name.c_str());
+  MemIndex_Free(mi);
+  DocTable_Free(dt);
+  return st.st_size;
+}
+
+// Returns the words to look up: kNumLookups words from the vocabulary,
+// drawn as they are in the corpus, or, if "misses", the same number of
+// words that aren't in it.
+static vector<string> LookupWords(const Corpus& corpus, bool misses) {
+  std::mt19937_64 rng(4);
+  ZipfSampler zipf(kVocabularySize);
+  vector<string> words;
+  for (int i = 0; i < kNumLookups; i++) {
+    string word = corpus.vocabulary[zipf.Sample(&rng)];
+    words.push_back(misses ? word + "zz" : word);
+  }
+  return words;
+}
+
+static uint64_t BenchLookupWord(const Corpus& corpus, bool misses,
+                                double* usec) {
+  vector<string> words = LookupWords(corpus, misses);
+  hw3::FileIndexReader fir(corpus.index_file, false);
+  hw3::IndexTableReader* itr = fir.NewIndexTableReader();
+  uint64_t checksum = 0;
+  double start = NowMicros();
+  for (const string& word : words) {
+    hw3::DocIDTableReader* ditr = itr->LookupWord(word);
+    if (ditr != nullptr) {
+      checksum++;
+      delete ditr;
+    }
+  }
+  *usec = NowMicros() - start;
+  delete itr;
+  return checksum;
+}
+
+static uint64_t BenchGetDocIDList(const Corpus& corpus, double* usec) {
+  // The lists of the most common words are the longest, so only read one
+  // word's list in a hundred.
+  vector<string> words = LookupWords(corpus, false);
+  words.resize(kNumLookups / 100);
+  hw3::FileIndexReader fir(corpus.index_file, false);
+  hw3::IndexTableReader* itr = fir.NewIndexTableReader();
+  vector<hw3::DocIDTableReader*> readers;
+  for (const string& word : words) {
+    readers.push_back(itr->LookupWord(word));
+    Verify333(readers.back() != nullptr);
+  }
+
+  uint64_t checksum = 0;
+  double start = NowMicros();
+  for (hw3::DocIDTableReader* ditr : readers) {
+    checksum += ditr->GetDocIDList().size();
+  }
+  *usec = NowMicros() - start;
+  for (hw3::DocIDTableReader* ditr : readers) {
+    delete ditr;
+  }
+  delete itr;
+  return checksum;
+}
+
+static uint64_t BenchProcessQuery(const Corpus& corpus, double* usec) {
+  // One- and two-word queries, drawn from the vocabulary as the corpus is,
+  // so that they're mostly common words with long lists.
+  std::mt19937_64 rng(5);
+  ZipfSampler zipf(kVocabularySize);
+  vector<vector<string>> queries;
+  for (int i = 0; i < kNumQueries; i++) {
+    vector<string> query = { corpus.vocabulary[zipf.Sample(&rng)] };
+    if (i % 2 == 1) {
+      query.push_back(corpus.vocabulary[zipf.Sample(&rng)]);
+    }
+    queries.push_back(query);
+  }
+
+  hw3::QueryProcessor qp(list<string>{corpus.index_file}, false);
+  uint64_t checksum = 0;
+  double start = NowMicros();
+  for (const vector<string>& query : queries) {
+    checksum += qp.ProcessQuery(query).size();
+  }
+  *usec = NowMicros() - start;
+  return checksum;
+}
+
+// Runs "fn" "repetitions" times and prints a line with the fastest and
+// the median times, unless "filter" isn't part of the benchmark's name.
+static void Run(const string& name, int64_t n, int repetitions,
+                const string& filter, const BenchFn& fn) {
+  if (name.find(filter) == string::npos) {
+    return;
+  }
+  vector<double> usecs;
+  uint64_t checksum = 0;
+  for (int rep = 0; rep < repetitions; rep++) {
+    double usec;
+    uint64_t rep_checksum = fn(&usec);
+    Verify333(rep == 0 || rep_checksum == checksum);
+    checksum = rep_checksum;
+    usecs.push_back(usec);
+  }
+  std::sort(usecs.begin(), usecs.end());
+  cout << name << "\t" << n << "\t" << repetitions << "\t"
+       << static_cast<int64_t>(usecs.front()) << "\t"
+       << static_cast<int64_t>(usecs[usecs.size() / 2]) << "\t"
+       << usecs.front() * 1000.0 / n << "\t" << checksum << endl;
+}
+
+static void Usage(char* prog_name) {
+  cerr << "Usage: " << prog_name << " [-r repetitions] [-f filter]" << endl;
+  cerr << "where:" << endl;
+  cerr << "  repetitions is how many times to run each benchmark"
+       << " (default 5)" << endl;
+  cerr << "  filter, if given, only runs the benchmarks whose names"
+       << " contain it" << endl;
+  exit(EXIT_FAILURE);
+}
+
+// Microbenchmarks the hot paths of libhw1, libhw2 and libhw3, over fixed
+// synthetic data generated from fixed seeds, so that every run does
+// exactly the same work.  Prints one tab-separated line per benchmark:
+//
+//   name  n  repetitions  min_usec  median_usec  min_ns_per_op  checksum
+//
+// where n is the number of operations (or, for parsing and writing, of
+// bytes) each run does.  The checksum depends only on what was computed,
+// so it should only change when the code's results do.
+int main(int argc, char** argv) {
+  int repetitions = 5;
+  string filter;
+  int opt;
+  while ((opt = getopt(argc, argv, "r:f:")) != -1) {
+    switch (opt) {
+      case 'r': repetitions = atoi(optarg); break;
+      case 'f': filter = optarg; break;
+      default: Usage(argv[0]);
+    }
+  }
+  if (optind != argc || repetitions <= 0) {
+    Usage(argv[0]);
+  }
+
+  char dir_template[] = "/tmp/microbench.XXXXXX";
+  Verify333(mkdtemp(dir_template) != nullptr);
+  Corpus corpus;
+  BuildCorpus(dir_template, &corpus);
+  int64_t corpus_bytes = 0;
+  for (const string& doc : corpus.docs) {
+    corpus_bytes += doc.size();
+  }
+  int64_t num_postings = 0;
+  for (const string& doc : corpus.docs) {
+    HashTable* tab = ParseIntoWordPositionsTable(strdup(doc.c_str()));
+    num_postings += HashTable_NumElements(tab);
+    FreeWordPositionsTable(tab);
+  }
+  struct stat st;
+  Verify333(stat(corpus.index_file.c_str(), &st) == 0);
+
+  using std::placeholders::_1;
+  cout << "name\tn\trepetitions\tmin_usec\tmedian_usec\tmin_ns_per_op"
+       << "\tchecksum" << endl;
+  Run("HashTable_Insert/presized", kNumKeys, repetitions, filter,
+      std::bind(&BenchHashTableInsert, kNumKeys, _1));
+  Run("HashTable_Insert/resizing", kNumKeys, repetitions, filter,
+      std::bind(&BenchHashTableInsert, 2, _1));
+  Run("HashTable_Find/hit", kNumKeys, repetitions, filter,
+      std::bind(&BenchHashTableFind, true, _1));
+  Run("HashTable_Find/miss", kNumKeys, repetitions, filter,
+      std::bind(&BenchHashTableFind, false, _1));
+  Run("LinkedList_Append", kNumKeys, repetitions, filter,
+      &BenchLinkedListAppend);
+  Run("LinkedList_Sort", kNumKeys, repetitions, filter,
+      &BenchLinkedListSort);
+  Run("ParseIntoWordPositionsTable", corpus_bytes, repetitions, filter,
+      std::bind(&BenchParse, std::cref(corpus), _1));
+  Run("MemIndex_AddPostingList", num_postings, repetitions, filter,
+      std::bind(&BenchMemIndexAdd, std::cref(corpus), _1));
+  Run("WriteIndex", st.st_size, repetitions, filter,
+      std::bind(&BenchWriteIndex, std::cref(corpus), _1));
+  Run("IndexTableReader::LookupWord/hit", kNumLookups, repetitions, filter,
+      std::bind(&BenchLookupWord, std::cref(corpus), false, _1));
+  Run("IndexTableReader::LookupWord/miss", kNumLookups, repetitions, filter,
+      std::bind(&BenchLookupWord, std::cref(corpus), true, _1));
+  Run("DocIDTableReader::GetDocIDList", kNumLookups / 100, repetitions,
+      filter, std::bind(&BenchGetDocIDList, std::cref(corpus), _1));
+  Run("QueryProcessor::ProcessQuery", kNumQueries, repetitions, filter,
+      std::bind(&BenchProcessQuery, std::cref(corpus), _1));
+
+  unlink(corpus.index_file.c_str());
+  rmdir(dir_template);
+  return EXIT_SUCCESS;
+}
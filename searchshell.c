@@ -26,7 +26,8 @@
 //////////////////////////////////////////////////////////////////////////////
 // Helper function declarations, constants, etc
 static void Usage(void);
-static void ProcessQueries(DocTable* dt, MemIndex* mi);
+static void ProcessQueries(DocTable* dt, MemIndex* mi,
+                           SearchResultArray* results);
 static int GetNextLine(FILE* f, char** ret_str);
 static void ToLowerCase(char* string);
 
@@ -68,14 +69,18 @@ int main(int argc, char** argv) {
     Usage();
   }
 
-  // prints result of queries until EOF is inputted.
+  // prints result of queries until EOF is inputted, reusing one results
+  // array for all of them.
+  SearchResultArray results;
+  SearchResultArray_Init(&results);
   while (!feof(stdin)) {
     fprintf(stdout, "enter query:\n");
-    ProcessQueries(doctable, index);
+    ProcessQueries(doctable, index, &results);
   }
 
   // cleaning up.
   fprintf(stdout, "shutting down...\n");
+  SearchResultArray_Free(&results);
   MemIndex_Free(index);
   DocTable_Free(doctable);
   return EXIT_SUCCESS;
@@ -93,7 +98,8 @@ static void Usage(void) {
   exit(EXIT_FAILURE);
 }
 
-static void ProcessQueries(DocTable* dt, MemIndex* mi) {
+static void ProcessQueries(DocTable* dt, MemIndex* mi,
+                           SearchResultArray* results) {
   char input[MAX_INPUT_SIZE];
   // returns if there is nothing to read.
   if (!GetNextLine(stdin, &input[0])) {
@@ -111,26 +117,13 @@ static void ProcessQueries(DocTable* dt, MemIndex* mi) {
     query_index++;
   }
 
-  LinkedList* search_results = MemIndex_Search(mi, queries, query_index);
-  // returns if no matching docs found in MemIndex.
-  if (search_results == NULL) {
-    return;
-  }
-
   // prints name and rank from search results.
-  LLIterator* iter = LLIterator_Allocate(search_results);
-  while (LLIterator_IsValid(iter)) {
-    LLPayload_t payload;
-    LLIterator_Get(iter, &payload);
-    SearchResult* sr = (SearchResult*) payload;
-
+  MemIndex_SearchArray(mi, queries, query_index, results);
+  for (int i = 0; i < results->num_results; i++) {
+    SearchResult* sr = &results->results[i];
     fprintf(stdout, "\t%s (%d)\n", DocTable_GetDocName(dt, sr->doc_id),
             sr->rank);
-    LLIterator_Next(iter);
   }
-
-  LLIterator_Free(iter);
-  LinkedList_Free(search_results, free);
 }
 
 static int GetNextLine(FILE *f, char **ret_str) {
@@ -0,0 +1,98 @@
+/*
+ * Copyright ©2024 Hannah C. Tang.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Washington
+ * CSE 333 for use solely during Spring Quarter 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#include <stdint.h>
+#include <unistd.h>
+
+#include <memory>
+#include <random>
+#include <string>
+
+#include "gtest/gtest.h"
+#include "./BloomFilter.h"
+#include "./FileIndexReader.h"
+#include "./IndexTableReader.h"
+#include "./test_suite.h"
+
+using std::string;
+
+namespace hw3 {
+
+TEST(Test_BloomFilter, TestBloomFilterBasic) {
+  HW3Environment::OpenTestCase();
+
+  static constexpr int kNumWords = 10000;
+  static constexpr int kNumProbes = 100000;
+  std::mt19937_64 rng(333);
+  BloomFilter filter(kNumWords);
+  std::mt19937_64 added(rng);
+  for (int i = 0; i < kNumWords; i++) {
+    filter.Add(rng());
+  }
+
+  // Everything that was added is found...
+  for (int i = 0; i < kNumWords; i++) {
+    ASSERT_TRUE(filter.MayContain(added()));
+  }
+
+  // ...and very little that wasn't is.
+  int false_positives = 0;
+  for (int i = 0; i < kNumProbes; i++) {
+    if (filter.MayContain(rng())) {
+      false_positives++;
+    }
+  }
+  ASSERT_GT(kNumProbes / 100, false_positives);
+
+  // Even an empty filter has somewhere to put things.
+  BloomFilter empty(0);
+  ASSERT_LT(0U, empty.words().size());
+  ASSERT_FALSE(empty.MayContain(rng()));
+
+  HW3Environment::AddPoints(5);
+}
+
+TEST(Test_BloomFilter, TestIndexBloomFilter) {
+  HW3Environment::OpenTestCase();
+
+  // Crawl a test tree and write it out to a fresh index file, since the
+  // indices in ./unit_test_indices predate Bloom filters.
+  string idx_name;
+  ASSERT_NO_FATAL_FAILURE(
+    WriteTestIndex("./test_tree/books", "bloomfilter", &idx_name));
+
+  FileIndexReader fir(idx_name);
+  ASSERT_NE(nullptr, fir.bloom_filter());
+  std::unique_ptr<IndexTableReader> itr(fir.NewIndexTableReader());
+
+  // Words that are there get through the filter, and words that aren't
+  // are almost always turned away by it.
+  IndexTableReader::BloomFilterStats before =
+    IndexTableReader::GetBloomFilterStats();
+  std::unique_ptr<DocIDTableReader> ditr(itr->LookupWord("whale"));
+  ASSERT_NE(nullptr, ditr.get());
+  for (int i = 0; i < 1000; i++) {
+    ASSERT_EQ(nullptr, itr->LookupWord("zzzxxyyqq" + std::to_string(i)));
+  }
+  IndexTableReader::BloomFilterStats after =
+    IndexTableReader::GetBloomFilterStats();
+  ASSERT_EQ(1001U, after.lookups - before.lookups);
+  ASSERT_EQ(1000U, (after.skipped - before.skipped) +
+                   (after.false_positives - before.false_positives));
+  ASSERT_LT(980U, after.skipped - before.skipped);
+
+  unlink(idx_name.c_str());
+
+  // Done!
+  HW3Environment::AddPoints(10);
+}
+
+}  // namespace hw3
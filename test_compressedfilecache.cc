@@ -0,0 +1,101 @@
+/*
+ * Copyright ©2024 Hannah C. Tang.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Washington
+ * CSE 333 for use solely during Spring Quarter 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#include <sys/stat.h>
+#include <memory>
+#include <string>
+
+#include "gtest/gtest.h"
+#include "./CompressedFileCache.h"
+#include "./test_suite.h"
+
+using std::make_shared;
+using std::shared_ptr;
+using std::string;
+
+namespace hw4 {
+
+// Returns a stat() result for version "version" of a "size"-byte file.
+static struct stat FileVersion(int version, off_t size) {
+  struct stat st = { };
+  st.st_ino = 333;
+  st.st_size = size;
+  st.st_mtim.tv_sec = 1700000000;
+  st.st_mtim.tv_nsec = version;
+  return st;
+}
+
+TEST(Test_CompressedFileCache, TestCompressedFileCacheBasic) {
+  CompressedFileCache cache(1024 * 1024);
+  struct stat v1 = FileVersion(1, 100);
+  ASSERT_EQ(nullptr, cache.Lookup("a.txt", kGzip, v1));
+  ASSERT_EQ(0U, cache.hits());
+  ASSERT_EQ(1U, cache.misses());
+
+  cache.Insert("a.txt", kGzip, v1, make_shared<string>("gzipped a"));
+  shared_ptr<const string> hit = cache.Lookup("a.txt", kGzip, v1);
+  ASSERT_NE(nullptr, hit);
+  ASSERT_EQ("gzipped a", *hit);
+  ASSERT_EQ(1U, cache.hits());
+  ASSERT_LT(0U, cache.bytes_used());
+
+  // Each coding is cached separately.
+  ASSERT_EQ(nullptr, cache.Lookup("a.txt", kDeflate, v1));
+  cache.Insert("a.txt", kDeflate, v1, make_shared<string>("deflated a"));
+  ASSERT_EQ("deflated a", *cache.Lookup("a.txt", kDeflate, v1));
+  ASSERT_EQ("gzipped a", *cache.Lookup("a.txt", kGzip, v1));
+
+  // A file that's changed since it was compressed misses, whether it's
+  // been modified, resized or replaced, and its stale entry goes away.
+  struct stat v2 = FileVersion(2, 100);
+  struct stat resized = FileVersion(1, 101);
+  struct stat replaced = v1;
+  replaced.st_ino++;
+  ASSERT_EQ(nullptr, cache.Lookup("a.txt", kGzip, resized));
+  cache.Insert("a.txt", kGzip, v1, make_shared<string>("gzipped a"));
+  ASSERT_EQ(nullptr, cache.Lookup("a.txt", kGzip, replaced));
+  cache.Insert("a.txt", kGzip, v1, make_shared<string>("gzipped a"));
+  ASSERT_EQ(nullptr, cache.Lookup("a.txt", kGzip, v2));
+  ASSERT_EQ(nullptr, cache.Lookup("a.txt", kGzip, v1));
+  cache.Insert("a.txt", kGzip, v2, make_shared<string>("gzipped a v2"));
+  ASSERT_EQ("gzipped a v2", *cache.Lookup("a.txt", kGzip, v2));
+}
+
+TEST(Test_CompressedFileCache, TestCompressedFileCacheEviction) {
+  // Room for about three 1000-byte entries.
+  CompressedFileCache cache(3500);
+  struct stat st = FileVersion(1, 5000);
+  for (const char* name : { "a", "b", "c" }) {
+    cache.Insert(name, kGzip, st, make_shared<string>(1000, name[0]));
+  }
+  size_t bytes = cache.bytes_used();
+  ASSERT_LE(3000U, bytes);
+  ASSERT_GE(3500U, bytes);
+
+  // Touching "a" makes "b" the least recently used, so it's evicted to
+  // make room for "d".
+  ASSERT_NE(nullptr, cache.Lookup("a", kGzip, st));
+  cache.Insert("d", kGzip, st, make_shared<string>(1000, 'd'));
+  ASSERT_EQ(nullptr, cache.Lookup("b", kGzip, st));
+  ASSERT_NE(nullptr, cache.Lookup("a", kGzip, st));
+  ASSERT_NE(nullptr, cache.Lookup("c", kGzip, st));
+  ASSERT_NE(nullptr, cache.Lookup("d", kGzip, st));
+  ASSERT_EQ(bytes, cache.bytes_used());
+
+  // Something bigger than the whole cache isn't cached, and doesn't evict
+  // anything.
+  cache.Insert("e", kGzip, st, make_shared<string>(4000, 'e'));
+  ASSERT_EQ(nullptr, cache.Lookup("e", kGzip, st));
+  ASSERT_NE(nullptr, cache.Lookup("a", kGzip, st));
+  ASSERT_EQ(bytes, cache.bytes_used());
+}
+
+}  // namespace hw4
@@ -126,5 +126,36 @@ TEST(Test_CrawlFileTree, CheckDocTable) {
   HW2Environment::AddPoints(10);
 }
 
+TEST(Test_CrawlFileTree, TimesPhases) {
+  DocTable* doc_table;
+  MemIndex* index;
+  DocTable* timed_doc_table;
+  MemIndex* timed_index;
+  CrawlTimes times;
+  char* directory = const_cast<char*>("./test_tree/bash-4.2/doc/");
+
+  // Timing the crawl doesn't change what it indexes.
+  ASSERT_TRUE(CrawlFileTree(directory, &doc_table, &index));
+  ASSERT_TRUE(CrawlFileTree_Timed(directory, &timed_doc_table, &timed_index,
+                                  &times));
+  ASSERT_EQ(DocTable_NumDocs(doc_table), DocTable_NumDocs(timed_doc_table));
+  ASSERT_EQ(MemIndex_NumWords(index), MemIndex_NumWords(timed_index));
+
+  // Every indexed file is counted, and each phase took some time, except
+  // spilling, since nothing was spilled.
+  ASSERT_EQ(DocTable_NumDocs(doc_table), times.num_files);
+  ASSERT_LT(0, times.num_bytes);
+  ASSERT_LT(0, times.crawl_nanos);
+  ASSERT_LT(0, times.read_nanos);
+  ASSERT_LT(0, times.parse_nanos);
+  ASSERT_LT(0, times.merge_nanos);
+  ASSERT_EQ(0, times.spill_nanos);
+
+  DocTable_Free(doc_table);
+  MemIndex_Free(index);
+  DocTable_Free(timed_doc_table);
+  MemIndex_Free(timed_index);
+}
+
 }  // namespace hw2
 
@@ -0,0 +1,115 @@
+/*
+ * Copyright ©2024 Hannah C. Tang.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Washington
+ * CSE 333 for use solely during Spring Quarter 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#include <stdint.h>
+#include <unistd.h>
+
+#include <list>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "./DocLengthTableReader.h"
+#include "./FileIndexReader.h"
+#include "./QueryProcessor.h"
+#include "./test_suite.h"
+
+using std::list;
+using std::string;
+using std::vector;
+
+namespace hw3 {
+
+class Test_DocLengthTableReader : public ::testing::Test {
+ protected:
+  // Crawl a test tree and write it out to a fresh index file, since the
+  // indices in ./unit_test_indices predate document length sections.
+  static void SetUpTestCase() {
+    ASSERT_NO_FATAL_FAILURE(WriteTestIndex("./test_tree/books", "doclengths",
+                                           &idx_name_, &num_docs_));
+  }
+
+  static void TearDownTestCase() {
+    unlink(idx_name_.c_str());
+  }
+
+  static string idx_name_;
+  static int num_docs_;
+};
+
+// Statics:
+string Test_DocLengthTableReader::idx_name_;
+int Test_DocLengthTableReader::num_docs_;
+
+
+TEST_F(Test_DocLengthTableReader, TestDocLengthTableReaderBasic) {
+  HW3Environment::OpenTestCase();
+
+  FileIndexReader fir(idx_name_);
+  DocLengthTableReader* dltr = fir.NewDocLengthTableReader();
+  ASSERT_NE(static_cast<DocLengthTableReader*>(nullptr), dltr);
+
+  // Every document in the doctable has a length; nothing else does.
+  ASSERT_EQ(num_docs_, dltr->NumDocs());
+  ASSERT_EQ(num_docs_, dltr->MaxDocID());
+  ASSERT_EQ(0U, dltr->DocLength(0));
+  ASSERT_EQ(0U, dltr->DocLength(dltr->MaxDocID() + 1));
+
+  uint64_t total = 0;
+  for (int i = 1; i <= dltr->MaxDocID(); i++) {
+    ASSERT_LT(0U, dltr->DocLength(i));
+    total += dltr->DocLength(i);
+  }
+  ASSERT_DOUBLE_EQ(static_cast<double>(total) / num_docs_,
+                   dltr->AverageDocLength());
+  delete dltr;
+
+  // The doctable and document frequencies agree with the length table.
+  DocTableReader* dtr = fir.NewDocTableReader();
+  ASSERT_EQ(num_docs_, dtr->NumDocs());
+  delete dtr;
+
+  IndexTableReader* itr = fir.NewIndexTableReader();
+  DocIDTableReader* ditr = itr->LookupWord("whale");
+  ASSERT_NE(static_cast<DocIDTableReader*>(nullptr), ditr);
+  ASSERT_EQ(ditr->GetDocIDList().size(),
+            static_cast<size_t>(itr->LookupDocumentFrequency("whale")));
+  ASSERT_EQ(0, itr->LookupDocumentFrequency("zzzxxyyqq"));
+  delete ditr;
+  delete itr;
+
+  // Done!
+  HW3Environment::AddPoints(10);
+}
+
+TEST_F(Test_DocLengthTableReader, TestDocLengthTableReaderBM25) {
+  HW3Environment::OpenTestCase();
+
+  list<string> idx_list;
+  idx_list.push_back(idx_name_);
+  QueryProcessor qp(idx_list, true, QueryProcessor::kRankByBM25);
+
+  vector<string> query;
+  query.push_back("whale");
+  vector<QueryProcessor::QueryResult> res = qp.ProcessQuery(query);
+  ASSERT_LT(0U, res.size());
+  for (size_t i = 0; i < res.size(); i++) {
+    ASSERT_LT(0.0f, res[i].score);
+    if (i > 0) {
+      ASSERT_GE(res[i - 1].score, res[i].score);
+    }
+  }
+
+  // Done!
+  HW3Environment::AddPoints(10);
+}
+
+}  // namespace hw3
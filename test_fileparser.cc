@@ -14,6 +14,7 @@
 
 extern "C" {
   #include "./FileParser.h"
+  #include "./MemIndex.h"
 }
 
 #include "gtest/gtest.h"
@@ -78,8 +79,7 @@ TEST(Test_FileParser, ParseIntoWordPositionsTable) {
   LLPayload_t pos;
 
   static const char *kW1 = "article";  // 154, 170
-  ASSERT_TRUE(HashTable_Find(tab,
-                             FNVHash64((unsigned char*) kW1, strlen(kW1)),
+  ASSERT_TRUE(HashTable_Find(tab, MemIndex_HashWord(kW1, strlen(kW1)),
                              &kv));
   wp = static_cast<WordPositions*>(kv.value);
   ASSERT_STREQ(kW1, wp->word);
@@ -91,8 +91,7 @@ TEST(Test_FileParser, ParseIntoWordPositionsTable) {
   HW2Environment::AddPoints(5);
 
   static const char *kW2 = "identical";  // 918
-  ASSERT_TRUE(HashTable_Find(tab,
-                             FNVHash64((unsigned char*) kW2, strlen(kW2)),
+  ASSERT_TRUE(HashTable_Find(tab, MemIndex_HashWord(kW2, strlen(kW2)),
                              &kv));
   wp = static_cast<WordPositions*>(kv.value);
   ASSERT_STREQ(kW2, wp->word);
@@ -102,8 +101,7 @@ TEST(Test_FileParser, ParseIntoWordPositionsTable) {
   HW2Environment::AddPoints(5);
 
   static const char *kW3 = "versions";  // 499, 550, 653
-  ASSERT_TRUE(HashTable_Find(tab,
-                             FNVHash64((unsigned char*) kW3, strlen(kW3)),
+  ASSERT_TRUE(HashTable_Find(tab, MemIndex_HashWord(kW3, strlen(kW3)),
                              &kv));
   wp = static_cast<WordPositions*>(kv.value);
   ASSERT_STREQ(kW3, wp->word);
@@ -118,7 +116,7 @@ TEST(Test_FileParser, ParseIntoWordPositionsTable) {
 
   ASSERT_FALSE(HashTable_Find(
                   tab,
-                  FNVHash64((unsigned char*) "nonexistantword", 4),
+                  MemIndex_HashWord("nonexistantword", 4),
                   &kv));
   HW2Environment::AddPoints(10);
 
@@ -0,0 +1,128 @@
+/*
+ * Copyright ©2024 Hannah C. Tang.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Washington
+ * CSE 333 for use solely during Spring Quarter 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#include <stdint.h>
+
+#include <map>
+#include <random>
+#include <string>
+
+#include "gtest/gtest.h"
+#include "./FlatHashMap.h"
+#include "./test_suite.h"
+
+using std::string;
+
+namespace hw3 {
+
+// A hash that sends every key to the same slot, so that every lookup has
+// to probe past the others.
+struct CollidingHash {
+  size_t operator()(uint64_t key) const { return 42; }
+};
+
+TEST(Test_FlatHashMap, Basic) {
+  HW3Environment::OpenTestCase();
+  FlatHashMap<string, int> map;
+  ASSERT_TRUE(map.empty());
+  ASSERT_EQ(nullptr, map.Find("whale"));
+
+  auto inserted = map.Insert("whale", 1);
+  ASSERT_TRUE(inserted.second);
+  ASSERT_EQ(1, *inserted.first);
+
+  // Inserting an existing key leaves its value alone.
+  inserted = map.Insert("whale", 2);
+  ASSERT_FALSE(inserted.second);
+  ASSERT_EQ(1, *inserted.first);
+
+  map["ocean"] += 5;
+  map["ocean"] += 5;
+  ASSERT_EQ(2U, map.size());
+  ASSERT_EQ(10, *map.Find("ocean"));
+  ASSERT_TRUE(map.Contains("whale"));
+
+  ASSERT_TRUE(map.Erase("whale"));
+  ASSERT_FALSE(map.Erase("whale"));
+  ASSERT_FALSE(map.Contains("whale"));
+  ASSERT_EQ(1U, map.size());
+
+  map.Clear();
+  ASSERT_TRUE(map.empty());
+  ASSERT_EQ(nullptr, map.Find("ocean"));
+  HW3Environment::AddPoints(5);
+}
+
+TEST(Test_FlatHashMap, MatchesStdMap) {
+  HW3Environment::OpenTestCase();
+
+  // Apply the same random mix of inserts, updates and erases to a
+  // FlatHashMap and a std::map, and check that they always agree.  The
+  // small key range makes for long probe runs with plenty of erasures in
+  // the middle of them.
+  FlatHashMap<uint64_t, int> map;
+  FlatHashMap<uint64_t, int, CollidingHash> colliding;
+  std::map<uint64_t, int> expected;
+  std::mt19937_64 rng(333);
+  for (int i = 0; i < 20000; i++) {
+    uint64_t key = rng() % 500;
+    switch (rng() % 3) {
+      case 0:
+        map[key] = i;
+        colliding[key] = i;
+        expected[key] = i;
+        break;
+      case 1:
+        ASSERT_EQ(expected.count(key) == 1, map.Erase(key));
+        ASSERT_EQ(expected.count(key) == 1, colliding.Erase(key));
+        expected.erase(key);
+        break;
+      default:
+        if (expected.count(key) == 1) {
+          ASSERT_EQ(expected[key], *map.Find(key));
+          ASSERT_EQ(expected[key], *colliding.Find(key));
+        } else {
+          ASSERT_EQ(nullptr, map.Find(key));
+          ASSERT_EQ(nullptr, colliding.Find(key));
+        }
+        break;
+    }
+    ASSERT_EQ(expected.size(), map.size());
+    ASSERT_EQ(expected.size(), colliding.size());
+  }
+
+  // Every element is visited exactly once.
+  std::map<uint64_t, int> visited;
+  map.ForEach([&visited](const uint64_t& key, int& value) {
+    ASSERT_EQ(0U, visited.count(key));
+    visited[key] = value;
+  });
+  ASSERT_EQ(expected, visited);
+  HW3Environment::AddPoints(10);
+}
+
+TEST(Test_FlatHashMap, Grow) {
+  HW3Environment::OpenTestCase();
+
+  // Sequential keys are the common case for docIDs.
+  FlatHashMap<uint64_t, uint64_t> map(10);
+  for (uint64_t i = 0; i < 100000; i++) {
+    ASSERT_TRUE(map.Insert(i, i * 3).second);
+  }
+  ASSERT_EQ(100000U, map.size());
+  for (uint64_t i = 0; i < 100000; i++) {
+    ASSERT_EQ(i * 3, *map.Find(i));
+  }
+  ASSERT_EQ(nullptr, map.Find(100000));
+  HW3Environment::AddPoints(5);
+}
+
+}  // namespace hw3
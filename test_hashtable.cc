@@ -9,6 +9,8 @@
  * author.
  */
 
+#include <string.h>
+
 extern "C" {
   #include "./HashTable.h"
   #include "./HashTable_priv.h"
@@ -60,14 +62,16 @@ const int Test_HashTable::kMagicNum;
 
 
 TEST_F(Test_HashTable, AllocFree) {
+  // The number of buckets is rounded up to a power of two.
   HashTable *ht = HashTable_Allocate(3);
   ASSERT_EQ(0, ht->num_elements);
-  ASSERT_EQ(3, ht->num_buckets);
+  ASSERT_EQ(4, ht->num_buckets);
 
   ASSERT_TRUE(ht->buckets != NULL);
   ASSERT_EQ(0, LinkedList_NumElements(ht->buckets[0]));
   ASSERT_EQ(0, LinkedList_NumElements(ht->buckets[1]));
   ASSERT_EQ(0, LinkedList_NumElements(ht->buckets[2]));
+  ASSERT_EQ(0, LinkedList_NumElements(ht->buckets[3]));
   HashTable_Free(ht, &Test_HashTable::VerifiedFree);
 }
 
@@ -393,4 +397,143 @@ TEST_F(Test_HashTable, Resize) {
   HW1Environment::AddPoints(10);
 }
 
+// A HashTable_ForEach callback that adds each value (an integer stored in
+// the pointer) into the int64_t pointed to by "arg", then doubles it.
+static void SumAndDouble(HTKeyValue_t *kv, void *arg) {
+  int64_t value = reinterpret_cast<int64_t>(kv->value);
+  *static_cast<int64_t *>(arg) += value;
+  kv->value = reinterpret_cast<HTValue_t>(value * 2);
+}
+
+// A HashTable_Drain callback that records which keys it has been handed
+// in the int array pointed to by "arg", then frees the payload.
+static void RecordAndFree(HTKeyValue_t kv, void *arg) {
+  int *num_times_seen = static_cast<int *>(arg);
+  Payload *op = static_cast<Payload *>(kv.value);
+  ASSERT_EQ(static_cast<int>(kv.key), op->payload_num);
+  num_times_seen[kv.key]++;
+  free(op);
+}
+
+TEST_F(Test_HashTable, StackIteratorForEachDrain) {
+  HW1Environment::OpenTestCase();
+  HashTable *table = HashTable_Allocate(2);
+  HTKeyValue_t kv, oldkv;
+
+  // A stack iterator over an empty table is immediately past the end.
+  HTIterator it;
+  HTIterator_Init(&it, table);
+  ASSERT_FALSE(HTIterator_IsValid(&it));
+  ASSERT_FALSE(HTIterator_Get(&it, &kv));
+
+  // Enough elements to force a few resizes.
+  int64_t expected_sum = 0;
+  for (int i = 0; i < 100; i++) {
+    kv.key = i;
+    kv.value = reinterpret_cast<HTValue_t>(static_cast<int64_t>(i));
+    ASSERT_FALSE(HashTable_Insert(table, kv, &oldkv));
+    expected_sum += i;
+  }
+
+  // The stack iterator visits every element exactly once.
+  int num_times_seen[100] = { 0 };
+  int count = 0;
+  for (HTIterator_Init(&it, table);
+       HTIterator_IsValid(&it);
+       HTIterator_Next(&it)) {
+    ASSERT_TRUE(HTIterator_Get(&it, &kv));
+    ASSERT_EQ(0, num_times_seen[kv.key]);
+    num_times_seen[kv.key]++;
+    count++;
+  }
+  ASSERT_EQ(100, count);
+  HW1Environment::AddPoints(5);
+
+  // ForEach visits every element and can update the values in place.
+  int64_t sum = 0;
+  HashTable_ForEach(table, &SumAndDouble, &sum);
+  ASSERT_EQ(expected_sum, sum);
+  for (int i = 0; i < 100; i++) {
+    ASSERT_TRUE(HashTable_Find(table, i, &kv));
+    ASSERT_EQ(static_cast<int64_t>(i) * 2,
+              reinterpret_cast<int64_t>(kv.value));
+  }
+  ASSERT_EQ(100, HashTable_NumElements(table));
+  HW1Environment::AddPoints(5);
+  HashTable_Free(table, &NoOpFree);
+
+  // Drain hands over every element exactly once and leaves the table
+  // empty but usable.
+  table = HashTable_Allocate(10);
+  for (int i = 0; i < 50; i++) {
+    Payload *np = static_cast<Payload *>(malloc(sizeof(Payload)));
+    ASSERT_TRUE(np != NULL);
+    np->magic_num = kMagicNum;
+    np->payload_num = i;
+    kv.key = i;
+    kv.value = np;
+    ASSERT_FALSE(HashTable_Insert(table, kv, &oldkv));
+  }
+  int num_times_drained[50] = { 0 };
+  HashTable_Drain(table, &RecordAndFree, num_times_drained);
+  for (int i = 0; i < 50; i++) {
+    ASSERT_EQ(1, num_times_drained[i]);
+  }
+  ASSERT_EQ(0, HashTable_NumElements(table));
+  HTIterator_Init(&it, table);
+  ASSERT_FALSE(HTIterator_IsValid(&it));
+
+  kv.key = 7;
+  kv.value = NULL;
+  ASSERT_FALSE(HashTable_Insert(table, kv, &oldkv));
+  ASSERT_TRUE(HashTable_Find(table, 7, &oldkv));
+  HashTable_Free(table, &NoOpFree);
+  HW1Environment::AddPoints(10);
+}
+
+TEST_F(Test_HashTable, WyHash) {
+  HW1Environment::OpenTestCase();
+
+  // Word hashes end up in index files, so they must never change.  These
+  // cover each of WyHash64()'s code paths: empty, 1-3, 4-16, 17-47 and
+  // 48+ bytes.
+  static const struct {
+    const char *str;
+    HTKey_t hash;
+  } kVectors[] = {
+    { "", 0x93228a4de0eec5a2ULL },
+    { "a", 0xaced12527fe5bff8ULL },
+    { "abc", 0x989b4a209c1011c9ULL },
+    { "whale", 0x5ce10be518e34e9bULL },
+    { "abcdefghijklmnop", 0x35309de45dc92e4aULL },
+    { "abcdefghijklmnopq", 0x9e0aa4c61a2da95dULL },
+    { "the quick brown fox jumps over the lazy dog, then again and again!",
+      0x7dbacb09769c5c64ULL },
+  };
+  for (const auto &v : kVectors) {
+    unsigned char *buf = (unsigned char *) v.str;
+    int len = strlen(v.str);
+    ASSERT_EQ(v.hash, WyHash64(buf, len));
+    ASSERT_EQ(v.hash, HashWithID(HT_HASH_WYHASH64, buf, len));
+    ASSERT_EQ(FNVHash64(buf, len), HashWithID(HT_HASH_FNV1A64, buf, len));
+  }
+  HW1Environment::AddPoints(5);
+
+  // Only the first "len" bytes matter, wherever the buffer starts.
+  unsigned char buf[128];
+  for (int i = 0; i < 128; i++) {
+    buf[i] = (unsigned char) (i * 7 + 1);
+  }
+  for (int len = 0; len < 100; len++) {
+    unsigned char copy[128];
+    memcpy(copy + 3, buf, len);
+    copy[3 + len] = 0xFF;
+    ASSERT_EQ(WyHash64(buf, len), WyHash64(copy + 3, len));
+    if (len > 0) {
+      ASSERT_NE(WyHash64(buf, len), WyHash64(buf, len - 1));
+    }
+  }
+  HW1Environment::AddPoints(5);
+}
+
 }  // namespace hw1
@@ -0,0 +1,130 @@
+/*
+ * Copyright ©2024 Hannah C. Tang.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Washington
+ * CSE 333 for use solely during Spring Quarter 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#include <zlib.h>
+#include <string>
+
+#include "gtest/gtest.h"
+#include "./HttpCompression.h"
+#include "./test_suite.h"
+
+using std::string;
+
+namespace hw4 {
+
+// Decompresses "data", in either the gzip or the zlib format, into "out";
+// returns false if it isn't a complete, valid stream.
+static bool Decompress(const string& data, string* const out) {
+  z_stream stream = { };
+  // 32 more than the window bits detects the format from the header.
+  if (inflateInit2(&stream, 15 + 32) != Z_OK) {
+    return false;
+  }
+  stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+  stream.avail_in = data.size();
+  out->clear();
+  int res;
+  do {
+    char buf[4096];
+    stream.next_out = reinterpret_cast<Bytef*>(buf);
+    stream.avail_out = sizeof(buf);
+    res = inflate(&stream, Z_NO_FLUSH);
+    out->append(buf, sizeof(buf) - stream.avail_out);
+  } while (res == Z_OK);
+  inflateEnd(&stream);
+  return res == Z_STREAM_END;
+}
+
+TEST(Test_HttpCompression, TestNegotiateContentCoding) {
+  ASSERT_EQ(kIdentity, NegotiateContentCoding(""));
+  ASSERT_EQ(kIdentity, NegotiateContentCoding("identity"));
+  ASSERT_EQ(kIdentity, NegotiateContentCoding("br, compress"));
+  ASSERT_EQ(kGzip, NegotiateContentCoding("gzip"));
+  ASSERT_EQ(kGzip, NegotiateContentCoding("x-gzip"));
+  ASSERT_EQ(kDeflate, NegotiateContentCoding("deflate"));
+
+  // gzip wins ties, but q-values rule.
+  ASSERT_EQ(kGzip, NegotiateContentCoding("deflate, gzip"));
+  ASSERT_EQ(kGzip, NegotiateContentCoding("gzip, deflate, br"));
+  ASSERT_EQ(kDeflate, NegotiateContentCoding("gzip;q=0.5, deflate"));
+  ASSERT_EQ(kDeflate, NegotiateContentCoding(" GZIP ; Q=0.2 ,Deflate;q=0.3"));
+  ASSERT_EQ(kIdentity, NegotiateContentCoding("gzip;q=0, deflate;q=0"));
+  ASSERT_EQ(kDeflate, NegotiateContentCoding("gzip;q=0, deflate"));
+
+  // "*" covers whatever isn't named.
+  ASSERT_EQ(kGzip, NegotiateContentCoding("*"));
+  ASSERT_EQ(kDeflate, NegotiateContentCoding("gzip;q=0, *"));
+  ASSERT_EQ(kIdentity, NegotiateContentCoding("*;q=0"));
+}
+
+TEST(Test_HttpCompression, TestIsCompressibleType) {
+  ASSERT_TRUE(IsCompressibleType("text/html"));
+  ASSERT_TRUE(IsCompressibleType("text/plain; version=0.0.4"));
+  ASSERT_TRUE(IsCompressibleType("Text/CSS"));
+  ASSERT_TRUE(IsCompressibleType("application/json"));
+  ASSERT_TRUE(IsCompressibleType("application/xml"));
+  ASSERT_TRUE(IsCompressibleType("image/svg+xml"));
+  ASSERT_FALSE(IsCompressibleType(""));
+  ASSERT_FALSE(IsCompressibleType("image/png"));
+  ASSERT_FALSE(IsCompressibleType("image/jpeg"));
+}
+
+TEST(Test_HttpCompression, TestCompressString) {
+  string text;
+  for (int i = 0; i < 1000; i++) {
+    text += "<li><a href=\"/static/doc" + std::to_string(i) + ".txt\">doc" +
+            std::to_string(i) + "</a></li>";
+  }
+
+  string compressed, decompressed;
+  CompressString(text, kGzip, kDefaultCompressionLevel, &compressed);
+  ASSERT_LT(compressed.size(), text.size() / 4);
+  ASSERT_EQ('\x1f', compressed[0]);  // the gzip magic number.
+  ASSERT_EQ('\x8b', compressed[1]);
+  ASSERT_TRUE(Decompress(compressed, &decompressed));
+  ASSERT_EQ(text, decompressed);
+
+  CompressString(text, kDeflate, 1, &compressed);
+  ASSERT_EQ(0x78, static_cast<unsigned char>(compressed[0]));  // zlib.
+  ASSERT_TRUE(Decompress(compressed, &decompressed));
+  ASSERT_EQ(text, decompressed);
+
+  // An empty body still makes a valid stream.
+  CompressString("", kGzip, 9, &compressed);
+  ASSERT_TRUE(Decompress(compressed, &decompressed));
+  ASSERT_EQ("", decompressed);
+}
+
+TEST(Test_HttpCompression, TestCompressorPieces) {
+  // Every piece is flushed, so each one's output decodes on its own, and
+  // the pieces add up to the whole body.
+  Compressor compressor(kGzip, 6);
+  string text, stream, piece;
+  for (int i = 0; i < 10; i++) {
+    string data(i * 1000, 'a' + i);
+    text += data;
+    piece.clear();
+    compressor.Compress(data, false, &piece);
+    ASSERT_FALSE(piece.empty());
+    stream += piece;
+  }
+  string decompressed;
+  ASSERT_FALSE(Decompress(stream, &decompressed));  // not finished yet...
+  ASSERT_EQ(text, decompressed);                    // ...but all there.
+
+  piece.clear();
+  compressor.Compress("the end", true, &piece);
+  stream += piece;
+  ASSERT_TRUE(Decompress(stream, &decompressed));
+  ASSERT_EQ(text + "the end", decompressed);
+}
+
+}  // namespace hw4
@@ -254,6 +254,40 @@ TEST(Test_HttpConnection, TestHttpConnectionPartialRead) {
   close(spair[1]);
 }
 
+TEST(Test_HttpConnection, TestHttpConnectionChunked) {
+  int spair[2] = {-1, -1};
+  ASSERT_EQ(0, socketpair(AF_UNIX, SOCK_STREAM, 0, spair));
+  HttpConnection hc(spair[0]);
+
+  // A chunked response's headers come without a body or a Content-length.
+  HttpResponse rep;
+  rep.set_protocol("HTTP/1.1");
+  rep.set_response_code(200);
+  rep.set_message("OK");
+  rep.set_content_type("application/json");
+  rep.set_chunked(true);
+  rep.AppendToBody("ignored");
+  string expected = "HTTP/1.1 200 OK\r\n";
+  expected += "Content-type: application/json\r\n";
+  expected += "Transfer-Encoding: chunked\r\n\r\n";
+  ASSERT_EQ(expected, rep.GenerateResponseString());
+  ASSERT_TRUE(hc.WriteResponse(rep));
+
+  // Each chunk is prefixed by its size in hex, and the empty chunk ends
+  // the body.
+  string big(1000, 'x');
+  ASSERT_TRUE(hc.WriteChunk("Hello"));
+  ASSERT_TRUE(hc.WriteChunk(big));
+  ASSERT_TRUE(hc.WriteChunk(""));
+  expected += "5\r\nHello\r\n3e8\r\n" + big + "\r\n0\r\n\r\n";
+
+  unsigned char buf[2048] = { 0 };
+  ASSERT_EQ(static_cast<int>(expected.size()),
+            WrappedRead(spair[1], buf, sizeof(buf)));
+  ASSERT_EQ(expected, (const char*) buf);
+  close(spair[1]);
+}
+
 static void WritePartialRequests(void* args) {
   int socket = *static_cast<int*>(args);
   // Write three requests on the socket.
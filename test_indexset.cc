@@ -0,0 +1,159 @@
+/*
+ * Copyright ©2024 Hannah C. Tang.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Washington
+ * CSE 333 for use solely during Spring Quarter 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cstdio>
+#include <list>
+#include <memory>
+#include <string>
+#include <vector>
+
+extern "C" {
+  #include "./libhw2/CrawlFileTree.h"
+  #include "./libhw2/DocTable.h"
+  #include "./libhw2/MemIndex.h"
+}
+#include "gtest/gtest.h"
+#include "./IndexSet.h"
+#include "./libhw3/QueryParser.h"
+#include "./libhw3/QueryProcessor.h"
+#include "./libhw3/WriteIndex.h"
+#include "./test_suite.h"
+
+using std::list;
+using std::shared_ptr;
+using std::string;
+using std::vector;
+
+namespace hw4 {
+
+// Writes "contents" to the file "file_name".
+static void WriteFile(const string& file_name, const string& contents) {
+  FILE* f = fopen(file_name.c_str(), "w");
+  ASSERT_NE(nullptr, f);
+  ASSERT_EQ(contents.size(), fwrite(contents.data(), 1, contents.size(), f));
+  ASSERT_EQ(0, fclose(f));
+}
+
+// Indexes a directory holding a single document, "doc_name", containing
+// "contents", into the index file "index_name".
+static void WriteSingleDocIndex(const string& dir, const string& doc_name,
+                                const string& contents,
+                                const string& index_name) {
+  string doc_dir = dir + "/docs";
+  ASSERT_EQ(0, mkdir(doc_dir.c_str(), 0700));
+  WriteFile(doc_dir + "/" + doc_name, contents);
+
+  DocTable* dt;
+  MemIndex* mi;
+  ASSERT_TRUE(CrawlFileTree(const_cast<char*>(doc_dir.c_str()), &dt, &mi));
+  ASSERT_LT(0, hw3::WriteIndex(mi, dt, index_name.c_str()));
+  DocTable_Free(dt);
+  MemIndex_Free(mi);
+
+  ASSERT_EQ(0, unlink((doc_dir + "/" + doc_name).c_str()));
+  ASSERT_EQ(0, rmdir(doc_dir.c_str()));
+}
+
+// Returns the names of the documents matching "word" in "index_set".
+static vector<string> Search(const IndexSet& index_set, const string& word) {
+  hw3::QueryProcessor qp(index_set.paths(), false);
+  vector<string> names;
+  for (const auto& result : qp.ProcessQuery(vector<string>{word})) {
+    names.push_back(result.document_name);
+  }
+  return names;
+}
+
+TEST(Test_IndexSet, TestIndexSetLoadErrors) {
+  char dir_template[] = "/tmp/test_indexset.XXXXXX";
+  string dir = mkdtemp(dir_template);
+  string error;
+
+  // A missing file can't be loaded...
+  list<string> indices = {dir + "/missing.idx"};
+  ASSERT_EQ(nullptr, IndexSet::Load(indices, &error));
+  ASSERT_NE(string::npos, error.find("missing.idx"));
+
+  // ...and neither can something that isn't an index file.
+  indices = {dir + "/garbage.idx"};
+  WriteFile(indices.front(), string(4096, 'x'));
+  error.clear();
+  ASSERT_EQ(nullptr, IndexSet::Load(indices, &error));
+  ASSERT_NE(string::npos, error.find("garbage.idx"));
+
+  ASSERT_EQ(0, unlink(indices.front().c_str()));
+  ASSERT_EQ(0, rmdir(dir.c_str()));
+}
+
+TEST(Test_IndexSet, TestIndexSetReplacedFile) {
+  char dir_template[] = "/tmp/test_indexset.XXXXXX";
+  string dir = mkdtemp(dir_template);
+  string index = dir + "/test.idx", rebuilt = dir + "/rebuilt.idx";
+  vector<string> whale_doc = {dir + "/docs/whale.txt"};
+  vector<string> ocean_doc = {dir + "/docs/ocean.txt"};
+  WriteSingleDocIndex(dir, "whale.txt", "the white whale\n", index);
+
+  string error;
+  shared_ptr<const IndexSet> old_set = IndexSet::Load({index}, &error);
+  ASSERT_NE(nullptr, old_set);
+  ASSERT_EQ(1U, old_set->paths().size());
+  ASSERT_EQ(whale_doc, Search(*old_set, "whale"));
+
+  // Replace the index by renaming a rebuilt one over it.  The old set
+  // still searches the file it loaded; a new set searches the new one.
+  sleep(1);  // so that the fingerprints' mtimes differ.
+  WriteSingleDocIndex(dir, "ocean.txt", "the deep blue ocean\n", rebuilt);
+  ASSERT_EQ(0, rename(rebuilt.c_str(), index.c_str()));
+  shared_ptr<const IndexSet> new_set = IndexSet::Load({index}, &error);
+  ASSERT_NE(nullptr, new_set);
+  ASSERT_NE(old_set->fingerprint(), new_set->fingerprint());
+
+  ASSERT_EQ(whale_doc, Search(*old_set, "whale"));
+  ASSERT_TRUE(Search(*old_set, "ocean").empty());
+  ASSERT_TRUE(Search(*new_set, "whale").empty());
+  ASSERT_EQ(ocean_doc, Search(*new_set, "ocean"));
+
+  // Even once the file is gone entirely.
+  ASSERT_EQ(0, unlink(index.c_str()));
+  ASSERT_EQ(ocean_doc, Search(*new_set, "ocean"));
+  ASSERT_EQ(0, rmdir(dir.c_str()));
+}
+
+TEST(Test_IndexSet, TestIndexSetNames) {
+  char dir_template[] = "/tmp/test_indexset.XXXXXX";
+  string dir = mkdtemp(dir_template);
+  string index = dir + "/test.idx";
+  WriteSingleDocIndex(dir, "whale.txt", "the white whale\n", index);
+
+  // The files are searched through their descriptors, but keep their
+  // names for explaining queries.
+  string error;
+  shared_ptr<const IndexSet> set = IndexSet::Load({index}, &error);
+  ASSERT_NE(nullptr, set);
+  ASSERT_EQ(list<string>{index}, set->names());
+  ASSERT_NE(set->names(), set->paths());
+
+  hw3::QueryProcessor qp(set->paths(), false);
+  qp.set_index_names(set->names());
+  hw3::QueryProcessor::QueryExplain explain;
+  ASSERT_EQ(1U, qp.ProcessQuery(hw3::ParseQuery("whale"), nullptr,
+                                &explain).size());
+  ASSERT_EQ(1U, explain.indices.size());
+  ASSERT_EQ(index, explain.indices[0].file);
+
+  ASSERT_EQ(0, unlink(index.c_str()));
+  ASSERT_EQ(0, rmdir(dir.c_str()));
+}
+
+}  // namespace hw4
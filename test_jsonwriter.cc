@@ -0,0 +1,98 @@
+/*
+ * Copyright ©2024 Hannah C. Tang.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Washington
+ * CSE 333 for use solely during Spring Quarter 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#include <stdint.h>
+#include <limits>
+#include <string>
+
+#include "gtest/gtest.h"
+#include "./JsonWriter.h"
+#include "./test_suite.h"
+
+using std::string;
+
+namespace hw4 {
+
+TEST(Test_JsonWriter, TestJsonWriterNesting) {
+  string out;
+  JsonWriter w(&out);
+  w.BeginObject();
+  w.EndObject();
+  ASSERT_EQ("{}", out);
+
+  // A writer writes one document, so start another for the next.
+  out.clear();
+  JsonWriter w2(&out);
+  w2.BeginObject();
+  w2.Key("total");
+  w2.Int(-12);
+  w2.Key("results");
+  w2.BeginArray();
+  w2.BeginObject();
+  w2.Key("ok");
+  w2.Bool(true);
+  w2.Key("none");
+  w2.Null();
+  w2.EndObject();
+  w2.BeginArray();
+  w2.EndArray();
+  w2.Int(INT64_MAX);
+  w2.EndArray();
+  w2.Key("after");
+  w2.Bool(false);
+  w2.EndObject();
+  ASSERT_EQ("{\"total\":-12,\"results\":[{\"ok\":true,\"none\":null},[],"
+            "9223372036854775807],\"after\":false}", out);
+}
+
+TEST(Test_JsonWriter, TestJsonWriterInPieces) {
+  // Clearing the string part way through picks up where it left off, so
+  // the pieces add up to the whole document.
+  string out, sent;
+  JsonWriter w(&out);
+  w.BeginArray();
+  for (int i = 0; i < 5; i++) {
+    w.Int(i);
+    sent += out;
+    out.clear();
+  }
+  w.EndArray();
+  sent += out;
+  ASSERT_EQ("[0,1,2,3,4]", sent);
+}
+
+TEST(Test_JsonWriter, TestJsonWriterStrings) {
+  string out;
+  JsonWriter w(&out);
+  w.String(string("a\"b\\c\n\t\r\b\f\x01\x1f\x7f\0z", 15) + "h\xc3\xa9");
+  ASSERT_EQ("\"a\\\"b\\\\c\\n\\t\\r\\b\\f\\u0001\\u001f\x7f\\u0000zh\xc3\xa9\"",
+            out);
+
+  out.clear();
+  JsonWriter::AppendString("", &out);
+  ASSERT_EQ("\"\"", out);
+}
+
+TEST(Test_JsonWriter, TestJsonWriterDoubles) {
+  string out;
+  JsonWriter w(&out);
+  w.BeginArray();
+  w.Double(0.5);
+  w.Double(0.1);
+  w.Double(2.0 / 3.0, 4);
+  w.Double(1e-7, 3);
+  w.Double(std::numeric_limits<double>::infinity());
+  w.Double(std::numeric_limits<double>::quiet_NaN());
+  w.EndArray();
+  ASSERT_EQ("[0.5,0.10000000000000001,0.6667,1e-07,null,null]", out);
+}
+
+}  // namespace hw4
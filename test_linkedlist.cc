@@ -11,8 +11,12 @@
 
 #include <unistd.h>
 #include <errno.h>
+#include <stdint.h>
 #include <sys/select.h>
 
+#include <algorithm>
+#include <vector>
+
 #include "gtest/gtest.h"
 
 extern "C" {
@@ -33,6 +37,49 @@ int TestLLPayloadComparator(LLPayload_t p1, LLPayload_t p2) {
   return 0;
 }
 
+// Payloads for the stability tests encode a key and a sequence number as
+// key * kSeqLimit + seq; this comparator only looks at the key.
+static const uintptr_t kSeqLimit = 100000;
+int TestLLKeyComparator(LLPayload_t p1, LLPayload_t p2) {
+  uintptr_t k1 = (uintptr_t) p1 / kSeqLimit, k2 = (uintptr_t) p2 / kSeqLimit;
+  if (k1 > k2)
+    return 1;
+  if (k1 < k2)
+    return -1;
+  return 0;
+}
+
+// Appends n payloads with pseudo-random keys in [0, num_keys) to "llp",
+// and returns the same payloads in a vector.
+static std::vector<uintptr_t> AppendKeyedPayloads(LinkedList *llp, int n,
+                                                  int num_keys) {
+  std::vector<uintptr_t> payloads;
+  uint32_t seed = 333;
+  for (int i = 0; i < n; i++) {
+    seed = seed * 1103515245 + 12345;
+    uintptr_t payload = ((seed >> 16) % num_keys) * kSeqLimit + i;
+    LinkedList_Append(llp, (LLPayload_t) payload);
+    payloads.push_back(payload);
+  }
+  return payloads;
+}
+
+// Checks that "llp" is correctly linked in both directions, and returns
+// its payloads in order.
+static std::vector<uintptr_t> CheckedPayloads(LinkedList *llp) {
+  std::vector<uintptr_t> payloads;
+  LinkedListNode *prev = NULL;
+  for (LinkedListNode *node = llp->head; node != NULL; node = node->next) {
+    EXPECT_EQ(prev, node->prev);
+    payloads.push_back((uintptr_t) node->payload);
+    prev = node;
+  }
+  EXPECT_EQ(prev, llp->tail);
+  EXPECT_EQ(static_cast<size_t>(LinkedList_NumElements(llp)),
+            payloads.size());
+  return payloads;
+}
+
 class Test_LinkedList : public ::testing::Test {
  protected:
   // Code here will be called before each test executes (ie, before
@@ -265,6 +312,61 @@ TEST_F(Test_LinkedList, Sort) {
   llp = NULL;
 }
 
+TEST_F(Test_LinkedList, SortStable) {
+  HW1Environment::OpenTestCase();
+  for (int n : {2, 3, 17, 1000, 4099}) {
+    LinkedList *llp = LinkedList_Allocate();
+    std::vector<uintptr_t> expected = AppendKeyedPayloads(llp, n, 10);
+
+    // Elements with equal keys keep their original order, both ways.
+    std::stable_sort(expected.begin(), expected.end(),
+                     [](uintptr_t a, uintptr_t b) {
+                       return a / kSeqLimit < b / kSeqLimit;
+                     });
+    LinkedList_Sort(llp, true, &TestLLKeyComparator);
+    ASSERT_EQ(expected, CheckedPayloads(llp));
+
+    std::stable_sort(expected.begin(), expected.end(),
+                     [](uintptr_t a, uintptr_t b) {
+                       return a / kSeqLimit > b / kSeqLimit;
+                     });
+    LinkedList_Sort(llp, false, &TestLLKeyComparator);
+    ASSERT_EQ(expected, CheckedPayloads(llp));
+
+    LinkedList_Free(llp, &Test_LinkedList::StubbedFree);
+  }
+  HW1Environment::AddPoints(5);
+}
+
+TEST_F(Test_LinkedList, SortTopK) {
+  HW1Environment::OpenTestCase();
+  for (int k : {0, 1, 7, 64, 999, 1000, 5000}) {
+    LinkedList *llp = LinkedList_Allocate();
+    std::vector<uintptr_t> original = AppendKeyedPayloads(llp, 1000, 50);
+    std::vector<uintptr_t> expected(original);
+    std::stable_sort(expected.begin(), expected.end(),
+                     [](uintptr_t a, uintptr_t b) {
+                       return a / kSeqLimit > b / kSeqLimit;
+                     });
+
+    LinkedList_SortTopK(llp, false, &TestLLKeyComparator, k);
+    std::vector<uintptr_t> actual = CheckedPayloads(llp);
+
+    // The first k elements are exactly those of a full (stable) sort...
+    size_t num_sorted = std::min(static_cast<size_t>(k), expected.size());
+    ASSERT_TRUE(std::equal(expected.begin(), expected.begin() + num_sorted,
+                           actual.begin()));
+
+    // ...and nothing was lost or duplicated.
+    std::sort(actual.begin(), actual.end());
+    std::sort(original.begin(), original.end());
+    ASSERT_EQ(original, actual);
+
+    LinkedList_Free(llp, &Test_LinkedList::StubbedFree);
+  }
+  HW1Environment::AddPoints(5);
+}
+
 TEST_F(Test_LinkedList, TestLLIteratorBasic) {
   HW1Environment::OpenTestCase();
   // Create a linked list.
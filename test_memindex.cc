@@ -263,4 +263,71 @@ TEST(Test_MemIndex, Simple) {
   MemIndex_Free(idx);
 }
 
+TEST(Test_MemIndex, SearchArray) {
+  HW2Environment::OpenTestCase();
+  constexpr DocID_t kNumDocs = 100;
+  const char* kCommon = "common";
+  const char* kEven = "even";
+  const char* kRare = "rare";
+
+  // Every document has "common" (doc_id times), the even ones have
+  // "even", and every tenth has "rare".
+  MemIndex *idx = MemIndex_Allocate();
+  for (DocID_t doc_id = 1; doc_id <= kNumDocs; doc_id++) {
+    LinkedList* postings = LinkedList_Allocate();
+    for (DocID_t i = 0; i < doc_id; i++) {
+      LinkedList_Append(postings, (LLPayload_t) (i * 10));
+    }
+    MemIndex_AddPostingList(idx, MakeCopy(kCommon), doc_id, postings);
+    if (doc_id % 2 == 0) {
+      postings = LinkedList_Allocate();
+      LinkedList_Append(postings, (LLPayload_t) 1);
+      MemIndex_AddPostingList(idx, MakeCopy(kEven), doc_id, postings);
+    }
+    if (doc_id % 10 == 0) {
+      postings = LinkedList_Allocate();
+      LinkedList_Append(postings, (LLPayload_t) 1);
+      MemIndex_AddPostingList(idx, MakeCopy(kRare), doc_id, postings);
+    }
+  }
+
+  SearchResultArray results;
+  SearchResultArray_Init(&results);
+
+  // The order of the query words doesn't matter.
+  char* query1[] = {const_cast<char*>(kCommon), const_cast<char*>(kEven),
+                    const_cast<char*>(kRare)};
+  ASSERT_EQ(10, MemIndex_SearchArray(idx, query1, 3, &results));
+  ASSERT_EQ(10, results.num_results);
+  for (int i = 0; i < results.num_results; i++) {
+    DocID_t doc_id = kNumDocs - 10 * i;
+    ASSERT_EQ(doc_id, results.results[i].doc_id);
+    ASSERT_EQ(static_cast<int>(doc_id) + 2, results.results[i].rank);
+  }
+  char* query2[] = {const_cast<char*>(kRare), const_cast<char*>(kEven),
+                    const_cast<char*>(kCommon)};
+  ASSERT_EQ(10, MemIndex_SearchArray(idx, query2, 3, &results));
+  ASSERT_EQ(kNumDocs, results.results[0].doc_id);
+
+  // Reusing the array for a bigger result set grows it; ties are broken
+  // by docID.
+  char* query3[] = {const_cast<char*>(kEven)};
+  ASSERT_EQ(50, MemIndex_SearchArray(idx, query3, 1, &results));
+  ASSERT_LE(50, results.capacity);
+  for (int i = 0; i < results.num_results; i++) {
+    ASSERT_EQ(static_cast<DocID_t>(2 * (i + 1)), results.results[i].doc_id);
+  }
+
+  // A missing word means no results.
+  char* query4[] = {const_cast<char*>(kCommon),
+                    const_cast<char*>("missing")};
+  ASSERT_EQ(0, MemIndex_SearchArray(idx, query4, 2, &results));
+  ASSERT_EQ(0, results.num_results);
+
+  SearchResultArray_Free(&results);
+  ASSERT_EQ(nullptr, results.results);
+  MemIndex_Free(idx);
+  HW2Environment::AddPoints(10);
+}
+
 }  // namespace hw2
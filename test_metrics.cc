@@ -0,0 +1,146 @@
+/*
+ * Copyright ©2024 Hannah C. Tang.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Washington
+ * CSE 333 for use solely during Spring Quarter 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#include <pthread.h>
+#include <string>
+
+#include "gtest/gtest.h"
+#include "./Metrics.h"
+#include "./test_suite.h"
+
+using std::string;
+
+namespace hw4 {
+
+TEST(Test_Metrics, TestMetricsBuckets) {
+  // Small values get a bucket apiece...
+  for (int64_t nanos = 0; nanos < Metrics::kSubBuckets; nanos++) {
+    ASSERT_EQ(nanos, Metrics::BucketFor(nanos));
+    ASSERT_EQ(static_cast<uint64_t>(nanos), Metrics::BucketMax(nanos));
+  }
+
+  // ...and larger ones share buckets, but every value lands in a bucket
+  // that holds it, within 1/kSubBuckets of the bucket's largest value.
+  int last_bucket = Metrics::kSubBuckets - 1;
+  for (int64_t nanos = Metrics::kSubBuckets; nanos <= Metrics::kMaxNanos;
+       nanos += nanos / 7 + 1) {
+    int bucket = Metrics::BucketFor(nanos);
+    ASSERT_LE(last_bucket, bucket);
+    ASSERT_GT(Metrics::kNumBuckets, bucket);
+    ASSERT_LE(static_cast<uint64_t>(nanos), Metrics::BucketMax(bucket));
+    ASSERT_GT(Metrics::BucketMax(bucket - 1), static_cast<uint64_t>(
+                nanos - nanos / Metrics::kSubBuckets - 1));
+    ASSERT_LT(Metrics::BucketMax(bucket - 1), static_cast<uint64_t>(nanos));
+    last_bucket = bucket;
+  }
+  ASSERT_EQ(Metrics::kNumBuckets - 1, Metrics::BucketFor(Metrics::kMaxNanos));
+}
+
+TEST(Test_Metrics, TestMetricsQuantiles) {
+  Metrics metrics;
+  Metrics::Histogram histogram;
+  metrics.GetHistogram(Metrics::kLookup, &histogram);
+  ASSERT_EQ(0U, histogram.count);
+  ASSERT_EQ(0U, histogram.ValueAtQuantile(0.99));
+
+  // Record 1..1000 microseconds.
+  for (int64_t micros = 1; micros <= 1000; micros++) {
+    metrics.Record(Metrics::kLookup, micros * 1000);
+  }
+  metrics.GetHistogram(Metrics::kLookup, &histogram);
+  ASSERT_EQ(1000U, histogram.count);
+  ASSERT_EQ(500500U * 1000, histogram.sum);
+
+  // Each quantile is reported to within a bucket.
+  for (double quantile : {0.5, 0.9, 0.99, 0.999}) {
+    double expected = quantile * 1000 * 1000;
+    double actual = histogram.ValueAtQuantile(quantile);
+    ASSERT_LE(expected, actual);
+    ASSERT_GE(expected * (1.0 + 1.0 / Metrics::kSubBuckets), actual);
+  }
+  ASSERT_LE(1000000U, histogram.max);
+
+  // The other stages are untouched.
+  metrics.GetHistogram(Metrics::kParse, &histogram);
+  ASSERT_EQ(0U, histogram.count);
+}
+
+// Records into "arg", a Metrics, from another thread.
+static void* RecordThread(void* arg) {
+  Metrics* metrics = static_cast<Metrics*>(arg);
+  for (int i = 0; i < 1000; i++) {
+    metrics->Record(Metrics::kWrite, 100);
+    metrics->Increment(Metrics::kRequests);
+  }
+  metrics->Increment(Metrics::kConnectionsOpened);
+  return nullptr;
+}
+
+TEST(Test_Metrics, TestMetricsThreads) {
+  Metrics metrics;
+  metrics.Increment(Metrics::kTasksQueued, 8);
+
+  // Each thread records into its own block, and they're summed up.
+  pthread_t threads[4];
+  for (pthread_t& thread : threads) {
+    ASSERT_EQ(0, pthread_create(&thread, nullptr, &RecordThread, &metrics));
+  }
+  for (pthread_t& thread : threads) {
+    ASSERT_EQ(0, pthread_join(thread, nullptr));
+  }
+  Metrics::Histogram histogram;
+  metrics.GetHistogram(Metrics::kWrite, &histogram);
+  ASSERT_EQ(4000U, histogram.count);
+  ASSERT_EQ(4000U * 100, histogram.sum);
+  ASSERT_EQ(4000U, metrics.GetCounter(Metrics::kRequests));
+  ASSERT_EQ(4U, metrics.queue_depth());
+  ASSERT_EQ(4U, metrics.active_connections());
+
+  // A second Metrics doesn't see the first's values.
+  Metrics other;
+  other.Increment(Metrics::kRequests);
+  ASSERT_EQ(1U, other.GetCounter(Metrics::kRequests));
+  ASSERT_EQ(4000U, metrics.GetCounter(Metrics::kRequests));
+
+  // A thread switching back and forth keeps recording into each one's
+  // block.
+  for (int i = 0; i < 1000; i++) {
+    metrics.Increment(Metrics::kRequests);
+    other.Increment(Metrics::kRequests);
+  }
+  ASSERT_EQ(1001U, other.GetCounter(Metrics::kRequests));
+  ASSERT_EQ(5000U, metrics.GetCounter(Metrics::kRequests));
+}
+
+TEST(Test_Metrics, TestMetricsExpose) {
+  Metrics metrics;
+  metrics.Record(Metrics::kParse, 2047);
+  metrics.Increment(Metrics::kRequests, 3);
+  string text = metrics.Expose();
+
+  ASSERT_NE(string::npos,
+            text.find("# TYPE http333d_stage_duration_seconds summary\n"));
+  ASSERT_NE(string::npos, text.find(
+      "http333d_stage_duration_seconds{stage=\"parse\",quantile=\"0.99\"}"
+      " 2.047e-06\n"));
+  ASSERT_NE(string::npos, text.find(
+      "http333d_stage_duration_seconds_count{stage=\"parse\"} 1\n"));
+  ASSERT_NE(string::npos, text.find(
+      "http333d_stage_duration_seconds_count{stage=\"write\"} 0\n"));
+  ASSERT_NE(string::npos, text.find("http333d_requests_total 3\n"));
+
+  Metrics::AppendMetric("http333d_test", "gauge", "A test.", 0.5, &text);
+  ASSERT_NE(string::npos, text.find("# HELP http333d_test A test.\n"
+                                    "# TYPE http333d_test gauge\n"
+                                    "http333d_test 0.5\n"));
+}
+
+}  // namespace hw4
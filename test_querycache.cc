@@ -0,0 +1,110 @@
+/*
+ * Copyright ©2024 Hannah C. Tang.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Washington
+ * CSE 333 for use solely during Spring Quarter 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "./QueryCache.h"
+#include "./test_suite.h"
+
+using std::string;
+using std::vector;
+
+namespace hw4 {
+
+// Builds a cache entry with a single result.
+static QueryCache::Entry MakeEntry(const string& doc_name, int rank) {
+  QueryCache::Entry entry;
+  hw3::QueryProcessor::QueryResult result;
+  result.document_name = doc_name;
+  result.rank = rank;
+  entry.results.push_back(result);
+  entry.html = "<ul><li>" + doc_name + "</li></ul>";
+  return entry;
+}
+
+TEST(Test_QueryCache, TestQueryCacheKey) {
+  vector<string> a = {"whale", "ocean"};
+  vector<string> b = {"ocean", "whale"};
+  vector<string> c = {"ocean"};
+  ASSERT_EQ(string("ocean whale"), QueryCache::NormalizeKey(a));
+  ASSERT_EQ(QueryCache::NormalizeKey(a), QueryCache::NormalizeKey(b));
+  ASSERT_NE(QueryCache::NormalizeKey(a), QueryCache::NormalizeKey(c));
+}
+
+TEST(Test_QueryCache, TestQueryCacheHitMiss) {
+  QueryCache cache(1024 * 1024, 4);
+  QueryCache::Entry entry;
+  uint64_t gen = cache.generation();
+
+  ASSERT_FALSE(cache.Lookup("whale", gen, &entry));
+  ASSERT_EQ(0U, cache.hits());
+  ASSERT_EQ(1U, cache.misses());
+
+  cache.Insert("whale", gen, MakeEntry("mobydick.txt", 7));
+  ASSERT_TRUE(cache.Lookup("whale", gen, &entry));
+  ASSERT_EQ(1U, entry.results.size());
+  ASSERT_EQ(string("mobydick.txt"), entry.results[0].document_name);
+  ASSERT_EQ(7, entry.results[0].rank);
+  ASSERT_EQ(string("<ul><li>mobydick.txt</li></ul>"), entry.html);
+  ASSERT_EQ(1U, cache.hits());
+  ASSERT_LT(0U, cache.bytes_used());
+
+  cache.Clear();
+  ASSERT_FALSE(cache.Lookup("whale", gen, &entry));
+  ASSERT_EQ(0U, cache.bytes_used());
+}
+
+TEST(Test_QueryCache, TestQueryCacheEviction) {
+  // A single shard with room for only a handful of entries.
+  QueryCache cache(1024, 1);
+  QueryCache::Entry entry;
+  uint64_t gen = cache.generation();
+
+  for (int i = 0; i < 100; i++) {
+    cache.Insert("q" + std::to_string(i), gen,
+                 MakeEntry("doc" + std::to_string(i), i));
+    ASSERT_GE(1024U, cache.bytes_used());
+  }
+  ASSERT_LT(0U, cache.evictions());
+
+  // The most recent entry survived, the oldest did not.
+  ASSERT_TRUE(cache.Lookup("q99", gen, &entry));
+  ASSERT_FALSE(cache.Lookup("q0", gen, &entry));
+}
+
+TEST(Test_QueryCache, TestQueryCacheGeneration) {
+  QueryCache cache(1024 * 1024, 4);
+  QueryCache::Entry entry;
+
+  cache.SetIndexFingerprint(1);
+  uint64_t old_gen = cache.generation();
+  cache.Insert("whale", old_gen, MakeEntry("mobydick.txt", 7));
+  ASSERT_TRUE(cache.Lookup("whale", old_gen, &entry));
+
+  // Setting the same fingerprint again doesn't invalidate anything.
+  cache.SetIndexFingerprint(1);
+  ASSERT_EQ(old_gen, cache.generation());
+  ASSERT_TRUE(cache.Lookup("whale", cache.generation(), &entry));
+
+  // A new set of indices invalidates the old entries...
+  cache.SetIndexFingerprint(2);
+  uint64_t new_gen = cache.generation();
+  ASSERT_NE(old_gen, new_gen);
+  ASSERT_FALSE(cache.Lookup("whale", new_gen, &entry));
+
+  // ...and results computed against the old indices are dropped.
+  cache.Insert("whale", old_gen, MakeEntry("mobydick.txt", 7));
+  ASSERT_FALSE(cache.Lookup("whale", new_gen, &entry));
+}
+
+}  // namespace hw4
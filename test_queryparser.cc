@@ -0,0 +1,168 @@
+/*
+ * Copyright ©2024 Hannah C. Tang.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Washington
+ * CSE 333 for use solely during Spring Quarter 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+
+#include <string>
+
+#include "gtest/gtest.h"
+#include "./QueryParser.h"
+#include "./test_suite.h"
+
+using std::string;
+
+namespace hw3 {
+
+TEST(Test_QueryParser, TestQueryParserTerms) {
+  HW3Environment::OpenTestCase();
+
+  QueryNode query = ParseQuery("  Whale   OCEAN ");
+  ASSERT_EQ(QueryNode::kAnd, query.kind);
+  ASSERT_EQ(2U, query.children.size());
+  ASSERT_EQ(QueryNode::kTerm, query.children[0].kind);
+  ASSERT_EQ(string("whale"), query.children[0].words[0]);
+  ASSERT_EQ(string("ocean"), query.children[1].words[0]);
+
+  // The canonical form doesn't depend on the order of the clauses.
+  ASSERT_EQ(string("ocean whale"), query.ToString());
+  ASSERT_EQ(query.ToString(), ParseQuery("ocean whale").ToString());
+
+  // An empty query has no clauses.
+  ASSERT_EQ(0U, ParseQuery("").children.size());
+  ASSERT_EQ(0U, ParseQuery("   \"  \" ").children.size());
+
+  HW3Environment::AddPoints(5);
+}
+
+TEST(Test_QueryParser, TestQueryParserPhrase) {
+  HW3Environment::OpenTestCase();
+
+  // Phrases split words the same way the indexer does.
+  QueryNode query = ParseQuery("\"The White-Whale\" ocean");
+  ASSERT_EQ(2U, query.children.size());
+  ASSERT_EQ(QueryNode::kPhrase, query.children[0].kind);
+  ASSERT_EQ(3U, query.children[0].words.size());
+  ASSERT_EQ(string("the"), query.children[0].words[0]);
+  ASSERT_EQ(string("white"), query.children[0].words[1]);
+  ASSERT_EQ(string("whale"), query.children[0].words[2]);
+  ASSERT_EQ(string("\"the white whale\" ocean"), query.ToString());
+
+  // A one-word phrase is just a term.
+  query = ParseQuery("\"whale\"");
+  ASSERT_EQ(1U, query.children.size());
+  ASSERT_EQ(QueryNode::kTerm, query.children[0].kind);
+
+  // An unterminated quote runs to the end of the query.
+  query = ParseQuery("ocean \"white whale");
+  ASSERT_EQ(2U, query.children.size());
+  ASSERT_EQ(QueryNode::kPhrase, query.children[1].kind);
+  ASSERT_EQ(2U, query.children[1].words.size());
+
+  HW3Environment::AddPoints(5);
+}
+
+TEST(Test_QueryParser, TestQueryParserNear) {
+  HW3Environment::OpenTestCase();
+
+  QueryNode query = ParseQuery("white NEAR/3 whale ocean");
+  ASSERT_EQ(2U, query.children.size());
+  ASSERT_EQ(QueryNode::kNear, query.children[0].kind);
+  ASSERT_EQ(string("white"), query.children[0].words[0]);
+  ASSERT_EQ(string("whale"), query.children[0].words[1]);
+  ASSERT_EQ(3, query.children[0].distance);
+  ASSERT_EQ(string("ocean white near/3 whale"), query.ToString());
+
+  // A NEAR/k that isn't between two words is just a word.
+  query = ParseQuery("near/3 whale");
+  ASSERT_EQ(2U, query.children.size());
+  ASSERT_EQ(QueryNode::kTerm, query.children[0].kind);
+  ASSERT_EQ(string("near/3"), query.children[0].words[0]);
+
+  query = ParseQuery("\"white whale\" near/3 ocean");
+  ASSERT_EQ(3U, query.children.size());
+  ASSERT_EQ(QueryNode::kPhrase, query.children[0].kind);
+
+  // Nor is a malformed operator.
+  query = ParseQuery("white near/x whale");
+  ASSERT_EQ(3U, query.children.size());
+
+  HW3Environment::AddPoints(5);
+}
+
+TEST(Test_QueryParser, TestQueryParserBoolean) {
+  HW3Environment::OpenTestCase();
+
+  // OR binds more loosely than the implicit AND.
+  QueryNode query = ParseQuery("white whale OR ocean");
+  ASSERT_EQ(QueryNode::kAnd, query.kind);
+  ASSERT_EQ(1U, query.children.size());
+  ASSERT_EQ(QueryNode::kOr, query.children[0].kind);
+  ASSERT_EQ(2U, query.children[0].children.size());
+  ASSERT_EQ(QueryNode::kAnd, query.children[0].children[0].kind);
+  ASSERT_EQ(string("(whale white) OR ocean"), query.ToString());
+
+  // Parentheses group, and redundant ANDs and groups are flattened.
+  query = ParseQuery("(white OR grey) AND (whale (ocean))");
+  ASSERT_EQ(3U, query.children.size());
+  ASSERT_EQ(QueryNode::kOr, query.children[0].kind);
+  ASSERT_EQ(string("(grey OR white) ocean whale"), query.ToString());
+
+  // NOT and - both negate, and cancel each other out.
+  query = ParseQuery("whale NOT white -\"sperm whale\" -(grey OR blue)");
+  ASSERT_EQ(4U, query.children.size());
+  ASSERT_EQ(QueryNode::kNot, query.children[1].kind);
+  ASSERT_EQ(QueryNode::kTerm, query.children[1].children[0].kind);
+  ASSERT_EQ(QueryNode::kPhrase, query.children[2].children[0].kind);
+  ASSERT_EQ(QueryNode::kOr, query.children[3].children[0].kind);
+  ASSERT_EQ(string("-\"sperm whale\" -(blue OR grey) -white whale"),
+            query.ToString());
+  ASSERT_EQ(string("whale"), ParseQuery("NOT -whale").ToString());
+
+  // Operators are only operators in uppercase; a '-' inside a word is
+  // part of the word.
+  query = ParseQuery("whale or not well-known");
+  ASSERT_EQ(4U, query.children.size());
+  ASSERT_EQ(string("or"), query.children[1].words[0]);
+  ASSERT_EQ(string("well-known"), query.children[3].words[0]);
+
+  // Dangling operators and unbalanced parentheses are forgiven.
+  ASSERT_EQ(string("ocean whale"),
+            ParseQuery("OR whale) AND (ocean OR").ToString());
+  ASSERT_EQ(string("whale"), ParseQuery("whale NOT").ToString());
+  ASSERT_EQ(0U, ParseQuery("( ) - NOT OR").children.size());
+
+  HW3Environment::AddPoints(10);
+}
+
+TEST(Test_QueryParser, TestQueryParserWildcard) {
+  HW3Environment::OpenTestCase();
+
+  QueryNode query = ParseQuery("Wha* oce?n");
+  ASSERT_EQ(2U, query.children.size());
+  ASSERT_EQ(QueryNode::kWildcard, query.children[0].kind);
+  ASSERT_EQ(string("wha*"), query.children[0].words[0]);
+  ASSERT_EQ(QueryNode::kWildcard, query.children[1].kind);
+  ASSERT_EQ(string("oce?n"), query.children[1].words[0]);
+  ASSERT_EQ(string("oce?n wha*"), query.ToString());
+
+  // Patterns combine like words, but not with NEAR/k.
+  query = ParseQuery("-wh* OR white NEAR/2 wha*");
+  ASSERT_EQ(QueryNode::kOr, query.children[0].kind);
+  ASSERT_EQ(QueryNode::kNot, query.children[0].children[0].kind);
+  ASSERT_EQ(QueryNode::kAnd, query.children[0].children[1].kind);
+  ASSERT_EQ(3U, query.children[0].children[1].children.size());
+
+  // A pattern without any letters would match everything; ignore it.
+  ASSERT_EQ(string("whale"), ParseQuery("* whale ?*").ToString());
+
+  HW3Environment::AddPoints(5);
+}
+
+}  // namespace hw3
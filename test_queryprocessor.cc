@@ -9,11 +9,17 @@
  * author.
  */
 
+#include <unistd.h>
+#include <algorithm>
 #include <list>
 #include <string>
 #include <vector>
 
+extern "C" {
+  #include "libhw2/MemIndex.h"
+}
 #include "gtest/gtest.h"
+#include "./FileIndexReader.h"
 #include "./QueryProcessor.h"
 #include "./test_suite.h"
 
@@ -110,4 +116,351 @@ TEST(Test_QueryProcessor, TestQueryMultiIndex) {
   HW3Environment::AddPoints(50);
 }
 
+TEST(Test_QueryProcessor, TestQueryProcessorBM25) {
+  HW3Environment::OpenTestCase();
+  // This index predates document length sections, so BM25 falls back to
+  // scoring without length normalization.
+  list<string> idx_list;
+  idx_list.push_back("./unit_test_indices/books.idx");
+
+  QueryProcessor occurrences_qp(idx_list);
+  QueryProcessor bm25_qp(idx_list, true, QueryProcessor::kRankByBM25);
+  ASSERT_EQ(QueryProcessor::kRankByBM25, bm25_qp.ranking_mode());
+
+  vector<string> query;
+  query.push_back("whale");
+  query.push_back("ocean");
+  vector<QueryProcessor::QueryResult> occurrences_res =
+    occurrences_qp.ProcessQuery(query);
+  vector<QueryProcessor::QueryResult> bm25_res = bm25_qp.ProcessQuery(query);
+
+  // BM25 only changes the order of the results, not which documents match
+  // or their occurrence counts.
+  ASSERT_LT(0U, bm25_res.size());
+  ASSERT_EQ(occurrences_res.size(), bm25_res.size());
+  int occurrences_total = 0, bm25_total = 0;
+  for (size_t i = 0; i < bm25_res.size(); i++) {
+    occurrences_total += occurrences_res[i].rank;
+    bm25_total += bm25_res[i].rank;
+
+    ASSERT_LT(0.0f, bm25_res[i].score);
+    if (i > 0) {
+      ASSERT_GE(bm25_res[i - 1].score, bm25_res[i].score);
+    }
+  }
+  ASSERT_EQ(occurrences_total, bm25_total);
+
+  // Done!
+  HW3Environment::AddPoints(10);
+}
+
+TEST(Test_QueryProcessor, TestQueryProcessorPhrase) {
+  HW3Environment::OpenTestCase();
+  list<string> idx_list;
+  idx_list.push_back("./unit_test_indices/books.idx");
+  QueryProcessor qp(idx_list);
+
+  // Every phrase match is also a match for the words on their own, and
+  // can't occur more often than its rarest word.
+  vector<QueryProcessor::QueryResult> and_res =
+    qp.ProcessQuery(ParseQuery("the white whale"));
+  vector<QueryProcessor::QueryResult> phrase_res =
+    qp.ProcessQuery(ParseQuery("\"the white whale\""));
+  ASSERT_LT(0U, phrase_res.size());
+  ASSERT_GE(and_res.size(), phrase_res.size());
+  for (const auto& phrase : phrase_res) {
+    bool found = false;
+    for (const auto& conj : and_res) {
+      if (conj.document_name == phrase.document_name) {
+        found = true;
+        ASSERT_GT(conj.rank, phrase.rank);
+      }
+    }
+    ASSERT_TRUE(found);
+  }
+
+  // Widening a NEAR window can only find more matches, and a NEAR/0 is
+  // at least as permissive as the phrase in either order.
+  vector<QueryProcessor::QueryResult> near0_res =
+    qp.ProcessQuery(ParseQuery("white near/0 whale"));
+  vector<QueryProcessor::QueryResult> near5_res =
+    qp.ProcessQuery(ParseQuery("whale near/5 white"));
+  ASSERT_LE(phrase_res.size(), near0_res.size());
+  ASSERT_LE(near0_res.size(), near5_res.size());
+
+  // A phrase made of words that never appear together has no matches.
+  ASSERT_EQ(0U, qp.ProcessQuery(ParseQuery("\"whale huckleberry\"")).size());
+
+  // Done!
+  HW3Environment::AddPoints(10);
+}
+
+TEST(Test_QueryProcessor, TestCountPhraseMatches) {
+  HW3Environment::OpenTestCase();
+  // The positions of the words in
+  //
+  //   white whale. white,  whale. white a whale
+  //   0     6      13      21     28    34 36
+  vector<DocPositionOffset_t> white = {0, 13, 28};
+  vector<DocPositionOffset_t> whale = {6, 21, 36};
+  vector<DocPositionOffset_t> a = {34};
+
+  // Only the first "white whale" is found: the second is separated by
+  // three bytes, which could hold a word, and the third really does have
+  // one in between.
+  ASSERT_EQ(1, CountPhraseMatches({white, whale}, {"white", "whale"}));
+  ASSERT_EQ(1, CountPhraseMatches({white, a, whale},
+                                  {"white", "a", "whale"}));
+  ASSERT_EQ(2, CountPhraseMatches({whale, white}, {"whale", "white"}));
+  ASSERT_EQ(0, CountPhraseMatches({whale, white, whale},
+                                  {"whale", "white", "whale"}));
+  ASSERT_EQ(0, CountPhraseMatches({white, {}}, {"white", "whale"}));
+
+  // A repeated word matches each overlapping pair, as in "a a a".
+  vector<DocPositionOffset_t> a3 = {0, 2, 4};
+  ASSERT_EQ(2, CountPhraseMatches({a3, a3}, {"a", "a"}));
+  ASSERT_EQ(1, CountPhraseMatches({a3, a3, a3}, {"a", "a", "a"}));
+
+  // Done!
+  HW3Environment::AddPoints(10);
+}
+
+TEST(Test_QueryProcessor, TestCountNearMatches) {
+  HW3Environment::OpenTestCase();
+  // The positions of the words in
+  //
+  //   dog one two three cat
+  //   0   4   8   12    18
+  vector<DocPositionOffset_t> dog = {0};
+  vector<DocPositionOffset_t> cat = {18};
+
+  // With typical word lengths, the distance comes out right, in either
+  // order.
+  ASSERT_EQ(0, CountNearMatches(dog, cat, "dog", "cat", 0));
+  ASSERT_EQ(0, CountNearMatches(dog, cat, "dog", "cat", 2));
+  ASSERT_EQ(1, CountNearMatches(dog, cat, "dog", "cat", 3));
+  ASSERT_EQ(0, CountNearMatches(cat, dog, "cat", "dog", 2));
+  ASSERT_EQ(1, CountNearMatches(cat, dog, "cat", "dog", 3));
+  ASSERT_EQ(0, CountNearMatches(dog, {}, "dog", "cat", 10));
+
+  // Each "a" is counted once, however many "b"s are near it.
+  vector<DocPositionOffset_t> one_two = {4, 8};
+  ASSERT_EQ(1, CountNearMatches(dog, one_two, "dog", "one", 1));
+  ASSERT_EQ(2, CountNearMatches(one_two, dog, "one", "dog", 1));
+
+  // A word is near itself only if it occurs twice, as in "dog dog".
+  vector<DocPositionOffset_t> dogs = {0, 4};
+  ASSERT_EQ(0, CountNearMatches(dog, dog, "dog", "dog", 5));
+  ASSERT_EQ(2, CountNearMatches(dogs, dogs, "dog", "dog", 0));
+
+  // Done!
+  HW3Environment::AddPoints(10);
+}
+
+TEST(Test_QueryProcessor, TestQueryProcessorBoolean) {
+  HW3Environment::OpenTestCase();
+  list<string> idx_list;
+  idx_list.push_back("./unit_test_indices/books.idx");
+  QueryProcessor qp(idx_list);
+
+  vector<QueryProcessor::QueryResult> whale_res =
+    qp.ProcessQuery(ParseQuery("whale"));
+  vector<QueryProcessor::QueryResult> ocean_res =
+    qp.ProcessQuery(ParseQuery("ocean"));
+  vector<QueryProcessor::QueryResult> and_res =
+    qp.ProcessQuery(ParseQuery("ocean whale"));
+  vector<QueryProcessor::QueryResult> or_res =
+    qp.ProcessQuery(ParseQuery("whale OR ocean"));
+  vector<QueryProcessor::QueryResult> not_res =
+    qp.ProcessQuery(ParseQuery("whale -ocean"));
+  ASSERT_LT(0U, and_res.size());
+
+  // Every document matches exactly one of "a b" and "a -b".
+  ASSERT_EQ(whale_res.size(), and_res.size() + not_res.size());
+  ASSERT_EQ(whale_res.size() + ocean_res.size(),
+            or_res.size() + and_res.size());
+
+  // A document matching both alternatives of an OR has the same rank as
+  // it would for the AND, and a NOT doesn't change the rank.
+  int and_total = 0, or_total = 0, whale_total = 0, ocean_total = 0;
+  for (const auto& result : and_res) and_total += result.rank;
+  for (const auto& result : or_res) or_total += result.rank;
+  for (const auto& result : whale_res) whale_total += result.rank;
+  for (const auto& result : ocean_res) ocean_total += result.rank;
+  ASSERT_EQ(whale_total + ocean_total, or_total);
+  int not_total = 0;
+  for (const auto& result : not_res) not_total += result.rank;
+  ASSERT_GT(whale_total, not_total);
+
+  // Results are sorted by rank, with ties in document order.
+  for (size_t i = 1; i < or_res.size(); i++) {
+    ASSERT_GE(or_res[i - 1].rank, or_res[i].rank);
+  }
+
+  // The order of the clauses doesn't matter, even though the query is
+  // planned around the rarest one.
+  vector<QueryProcessor::QueryResult> reordered_res =
+    qp.ProcessQuery(ParseQuery("whale ocean"));
+  ASSERT_EQ(and_res.size(), reordered_res.size());
+  for (size_t i = 0; i < and_res.size(); i++) {
+    ASSERT_EQ(and_res[i].document_name, reordered_res[i].document_name);
+    ASSERT_EQ(and_res[i].rank, reordered_res[i].rank);
+  }
+
+  // A query with nothing but exclusions matches nothing, as does an AND
+  // with a missing word.
+  ASSERT_EQ(0U, qp.ProcessQuery(ParseQuery("-whale")).size());
+  ASSERT_EQ(0U, qp.ProcessQuery(ParseQuery("whale zzyzzx")).size());
+
+  // Done!
+  HW3Environment::AddPoints(10);
+}
+
+
+TEST(Test_QueryProcessor, TestQueryProcessorExplain) {
+  HW3Environment::OpenTestCase();
+  list<string> idx_list;
+  idx_list.push_back("./unit_test_indices/books.idx");
+  QueryProcessor qp(idx_list);
+
+  // Explaining a query doesn't change its results.
+  vector<QueryProcessor::QueryResult> res =
+    qp.ProcessQuery(ParseQuery("ocean whale"));
+  QueryProcessor::QueryExplain explain;
+  vector<QueryProcessor::QueryResult> explained_res =
+    qp.ProcessQuery(ParseQuery("ocean whale"), nullptr, &explain);
+  ASSERT_EQ(res.size(), explained_res.size());
+  for (size_t i = 0; i < res.size(); i++) {
+    ASSERT_EQ(res[i].document_name, explained_res[i].document_name);
+    ASSERT_EQ(res[i].rank, explained_res[i].rank);
+  }
+
+  // There's an entry for the index, and one for each word.
+  ASSERT_EQ(1U, explain.indices.size());
+  ASSERT_EQ(idx_list.front(), explain.indices[0].file);
+  ASSERT_EQ(static_cast<int64_t>(res.size()), explain.indices[0].results);
+  ASSERT_EQ(2U, explain.terms.size());
+  for (const QueryProcessor::QueryExplain::Term& term : explain.terms) {
+    ASSERT_EQ(0, term.index);
+    ASSERT_TRUE(term.term == "ocean" || term.term == "whale");
+    ASSERT_LE(static_cast<int64_t>(res.size()), term.postings);
+    ASSERT_LT(0, term.postings_read);
+    ASSERT_LE(term.lookup.nanos, explain.indices[0].evaluate.nanos);
+  }
+
+  // The phases don't overlap, so they add up to no more than the whole
+  // query; and the index is read with stdio, so it takes system calls.
+  ASSERT_LE(explain.indices[0].evaluate.nanos +
+            explain.indices[0].resolve.nanos + explain.sort.nanos,
+            explain.total.nanos);
+  if (explain.io_counted) {
+    ASSERT_LT(0, explain.indices[0].evaluate.read_calls);
+    ASSERT_LE(explain.indices[0].evaluate.read_calls,
+              explain.total.read_calls);
+    ASSERT_LT(0, explain.total.bytes_read);
+  }
+  string text = explain.ToString();
+  ASSERT_NE(string::npos, text.find("index 0 (" + idx_list.front() + "): " +
+                                    std::to_string(res.size()) +
+                                    " results\n"));
+  ASSERT_NE(string::npos, text.find("    whale: "));
+
+  // A missing word is still looked up, and an explain is reset for each
+  // query it's passed to.
+  ASSERT_EQ(0U, qp.ProcessQuery(ParseQuery("zzyzzx"), nullptr,
+                                &explain).size());
+  ASSERT_EQ(1U, explain.terms.size());
+  ASSERT_EQ("zzyzzx", explain.terms[0].term);
+  ASSERT_EQ(0, explain.terms[0].postings);
+  ASSERT_EQ(0, explain.indices[0].results);
+
+  // Done!
+  HW3Environment::AddPoints(10);
+}
+
+TEST(Test_QueryProcessor, TestQueryProcessorMatchQuery) {
+  HW3Environment::OpenTestCase();
+  list<string> idx_list;
+  idx_list.push_back("./unit_test_indices/bash.idx");
+  idx_list.push_back("./unit_test_indices/books.idx");
+  QueryProcessor qp(idx_list);
+
+  // The matches come in the same order as ProcessQuery()'s results, and
+  // name the same documents.
+  QueryNode query = ParseQuery("ocean OR whale OR bash");
+  vector<QueryProcessor::QueryResult> res = qp.ProcessQuery(query);
+  vector<QueryProcessor::QueryMatch> matches = qp.MatchQuery(query);
+  ASSERT_LT(0U, res.size());
+  ASSERT_EQ(res.size(), matches.size());
+  for (size_t i = 0; i < res.size(); i++) {
+    ASSERT_EQ(res[i].document_name, qp.LookupDocName(matches[i]));
+    ASSERT_EQ(res[i].rank, matches[i].rank);
+  }
+
+  // A match's positions are there for the words it contains.
+  vector<DocPositionOffset_t> positions;
+  for (const QueryProcessor::QueryMatch& match : matches) {
+    int rank = 0;
+    for (const char* word : { "ocean", "whale", "bash" }) {
+      positions.clear();
+      if (qp.LookupPositions(match, word, &positions)) {
+        ASSERT_LT(0U, positions.size());
+        ASSERT_TRUE(std::is_sorted(positions.begin(), positions.end()));
+        rank += positions.size();
+      } else {
+        ASSERT_EQ(0U, positions.size());
+      }
+    }
+    ASSERT_EQ(match.rank, rank);
+  }
+  ASSERT_FALSE(qp.LookupPositions(matches[0], "zzyzzx", &positions));
+  ASSERT_EQ(0U, qp.MatchQuery(ParseQuery("zzyzzx")).size());
+
+  // Done!
+  HW3Environment::AddPoints(10);
+}
+
+TEST(Test_QueryProcessor, TestQueryProcessorWyHash) {
+  HW3Environment::OpenTestCase();
+  // Build the same index with each hash function.
+  vector<string> idx_names;
+  for (HTHashID_t hash_id : { HT_HASH_FNV1A64, HT_HASH_WYHASH64 }) {
+    MemIndex_SetWordHashID(hash_id);
+    idx_names.emplace_back();
+    ASSERT_NO_FATAL_FAILURE(
+      WriteTestIndex("./test_tree/books", "hash" + std::to_string(hash_id),
+                     &idx_names.back()));
+  }
+  MemIndex_SetWordHashID(HT_HASH_FNV1A64);
+
+  {
+    FileIndexReader fir(idx_names[1]);
+    ASSERT_EQ(HT_HASH_WYHASH64, fir.hash_id());
+  }
+
+  // Queries find the same documents in both.
+  QueryProcessor fnv_qp(list<string>(1, idx_names[0]));
+  QueryProcessor wy_qp(list<string>(1, idx_names[1]));
+  for (const char* query : { "whale", "the white whale", "\"white whale\"",
+                             "wh*le", "zzyzzx" }) {
+    vector<QueryProcessor::QueryResult> fnv_res =
+      fnv_qp.ProcessQuery(ParseQuery(query));
+    vector<QueryProcessor::QueryResult> wy_res =
+      wy_qp.ProcessQuery(ParseQuery(query));
+    ASSERT_EQ(fnv_res.size(), wy_res.size());
+    for (size_t i = 0; i < fnv_res.size(); i++) {
+      ASSERT_EQ(fnv_res[i].document_name, wy_res[i].document_name);
+      ASSERT_EQ(fnv_res[i].rank, wy_res[i].rank);
+    }
+  }
+  ASSERT_LT(0U, wy_qp.ProcessQuery(ParseQuery("whale")).size());
+
+  for (const string& name : idx_names) {
+    ASSERT_EQ(0, unlink(name.c_str()));
+  }
+
+  // Done!
+  HW3Environment::AddPoints(10);
+}
+
 }  // namespace hw3
@@ -11,11 +11,24 @@
 
 #include "./test_suite.h"
 
+#include <stdint.h>
+#include <unistd.h>
 #include <iostream>
+#include <sstream>
+#include <string>
+
 #include "gtest/gtest.h"
+extern "C" {
+  #include "libhw2/CrawlFileTree.h"
+  #include "libhw2/DocTable.h"
+  #include "libhw2/MemIndex.h"
+}
+#include "./WriteIndex.h"
 
 using std::cout;
 using std::endl;
+using std::string;
+using std::stringstream;
 
 // static
 int HW4Environment::total_points_ = 0;
@@ -49,6 +62,23 @@ void HW4Environment::OpenTestCase() {
   ::testing::Test::RecordProperty("points", curr_test_points_);
 }
 
+void WriteTestIndex(const string& tree, const string& tag,
+                    string* const idx_name, int* const num_docs) {
+  DocTable* dt;
+  MemIndex* mi;
+  ASSERT_NE(0, CrawlFileTree(const_cast<char*>(tree.c_str()), &dt, &mi));
+  if (num_docs != nullptr) {
+    *num_docs = DocTable_NumDocs(dt);
+  }
+
+  stringstream ss;
+  ss << "/tmp/test_" << tag << "." << (uint32_t) getpid() << ".index";
+  *idx_name = ss.str();
+  int64_t idx_bytes = hw3::WriteIndex(mi, dt, idx_name->c_str());
+  DocTable_Free(dt);
+  MemIndex_Free(mi);
+  ASSERT_LT(0, idx_bytes);
+}
 
 int main(int argc, char **argv) {
   ::testing::InitGoogleTest(&argc, argv);
@@ -12,6 +12,8 @@
 #ifndef HW4_TEST_SUITE_H_
 #define HW4_TEST_SUITE_H_
 
+#include <string>
+
 #include "gtest/gtest.h"
 
 class HW4Environment : public ::testing::Environment {
@@ -29,5 +31,14 @@ class HW4Environment : public ::testing::Environment {
   static int curr_test_points_;
 };
 
+// Crawls the directory "tree" and writes it out to a fresh index file,
+// for tests that need an index with sections that the prebuilt indices in
+// ./unit_test_indices predate.  The file is named after "tag" and this
+// process, and its name is returned in "idx_name"; the caller should
+// unlink() it when done.  If "num_docs" is non-null, it receives the
+// number of documents crawled.  Reports failures with gtest assertions,
+// so call it inside ASSERT_NO_FATAL_FAILURE().
+void WriteTestIndex(const std::string& tree, const std::string& tag,
+                    std::string* const idx_name, int* const num_docs = nullptr);
 
 #endif  // HW4_TEST_SUITE_H_
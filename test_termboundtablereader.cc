@@ -0,0 +1,127 @@
+/*
+ * Copyright ©2024 Hannah C. Tang.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Washington
+ * CSE 333 for use solely during Spring Quarter 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#include <stdint.h>
+#include <unistd.h>
+
+#include <list>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "./FileIndexReader.h"
+#include "./QueryProcessor.h"
+#include "./TermBoundTableReader.h"
+#include "./test_suite.h"
+
+using std::list;
+using std::string;
+using std::vector;
+
+namespace hw3 {
+
+class Test_TermBoundTableReader : public ::testing::Test {
+ protected:
+  // Crawl a test tree and write it out to a fresh index file, since the
+  // indices in ./unit_test_indices predate score bound sections.
+  static void SetUpTestCase() {
+    ASSERT_NO_FATAL_FAILURE(
+      WriteTestIndex("./test_tree/books", "termbounds", &idx_name_));
+  }
+
+  static void TearDownTestCase() {
+    unlink(idx_name_.c_str());
+  }
+
+  static string idx_name_;
+};
+
+// Statics:
+string Test_TermBoundTableReader::idx_name_;
+
+
+TEST_F(Test_TermBoundTableReader, TestTermBoundTableReaderBasic) {
+  HW3Environment::OpenTestCase();
+
+  FileIndexReader fir(idx_name_);
+  TermBoundTableReader* tbr = fir.NewTermBoundTableReader();
+  ASSERT_NE(static_cast<TermBoundTableReader*>(nullptr), tbr);
+
+  float max_score = 0.0f;
+  ASSERT_FALSE(tbr->LookupMaxScore("zzzxxyyqq", &max_score));
+  ASSERT_TRUE(tbr->LookupMaxScore("whale", &max_score));
+  ASSERT_LT(0.0f, max_score);
+
+  // The bound must hold for every document containing the word, and be
+  // reasonably tight.
+  list<string> idx_list;
+  idx_list.push_back(idx_name_);
+  QueryProcessor qp(idx_list, true, QueryProcessor::kRankByBM25);
+  vector<string> query;
+  query.push_back("whale");
+  vector<QueryProcessor::QueryResult> res = qp.ProcessQuery(query);
+  ASSERT_LT(0U, res.size());
+  for (const QueryProcessor::QueryResult& result : res) {
+    ASSERT_LE(result.score, max_score);
+  }
+  ASSERT_FLOAT_EQ(res[0].score, max_score);
+  delete tbr;
+
+  // Done!
+  HW3Environment::AddPoints(10);
+}
+
+TEST_F(Test_TermBoundTableReader, TestQueryProcessorTopK) {
+  HW3Environment::OpenTestCase();
+
+  list<string> idx_list;
+  idx_list.push_back(idx_name_);
+  QueryProcessor qp(idx_list, true, QueryProcessor::kRankByBM25);
+
+  vector<string> query;
+  query.push_back("whale");
+  query.push_back("ocean");
+  query.push_back("the");
+  query.push_back("whale");
+
+  for (int k : {1, 3, 10}) {
+    QueryProcessor::TopKStats exhaustive_stats, pruned_stats;
+    vector<QueryProcessor::QueryResult> exhaustive =
+      qp.ProcessQueryTopK(query, k, &exhaustive_stats, false);
+    vector<QueryProcessor::QueryResult> pruned =
+      qp.ProcessQueryTopK(query, k, &pruned_stats);
+
+    // Exhaustive evaluation scores every posting exactly once.
+    ASSERT_EQ(exhaustive_stats.postings_total,
+              exhaustive_stats.postings_scored);
+    ASSERT_EQ(exhaustive_stats.postings_total, pruned_stats.postings_total);
+    ASSERT_LE(pruned_stats.postings_scored, exhaustive_stats.postings_scored);
+
+    // Pruning never changes the top k scores.  (Ties may be broken
+    // differently, so don't compare names.)
+    ASSERT_LT(0U, pruned.size());
+    ASSERT_GE(static_cast<size_t>(k), pruned.size());
+    ASSERT_EQ(exhaustive.size(), pruned.size());
+    for (size_t i = 0; i < pruned.size(); i++) {
+      ASSERT_EQ(exhaustive[i].score, pruned[i].score);
+      ASSERT_LT(0, pruned[i].rank);
+      ASSERT_NE(string(""), pruned[i].document_name);
+      if (i > 0) {
+        ASSERT_GE(pruned[i - 1].score, pruned[i].score);
+      }
+    }
+  }
+
+  // Done!
+  HW3Environment::AddPoints(10);
+}
+
+}  // namespace hw3
@@ -0,0 +1,192 @@
+/*
+ * Copyright ©2024 Hannah C. Tang.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Washington
+ * CSE 333 for use solely during Spring Quarter 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#include <stdint.h>
+#include <unistd.h>
+
+#include <list>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "./FileIndexReader.h"
+#include "./QueryParser.h"
+#include "./QueryProcessor.h"
+#include "./TermDictReader.h"
+#include "./test_suite.h"
+
+using std::list;
+using std::string;
+using std::vector;
+
+namespace hw3 {
+
+class Test_TermDictReader : public ::testing::Test {
+ protected:
+  // Crawl a test tree and write it out to a fresh index file, since the
+  // indices in ./unit_test_indices predate term dictionaries.
+  static void SetUpTestCase() {
+    ASSERT_NO_FATAL_FAILURE(
+      WriteTestIndex("./test_tree/books", "termdict", &idx_name_));
+  }
+
+  static void TearDownTestCase() {
+    unlink(idx_name_.c_str());
+  }
+
+  static string idx_name_;
+};
+
+// Statics:
+string Test_TermDictReader::idx_name_;
+
+
+TEST_F(Test_TermDictReader, TestMatchesPattern) {
+  HW3Environment::OpenTestCase();
+
+  ASSERT_TRUE(MatchesPattern("whale", "whale"));
+  ASSERT_FALSE(MatchesPattern("whale", "whales"));
+  ASSERT_TRUE(MatchesPattern("whale*", "whale"));
+  ASSERT_TRUE(MatchesPattern("whale*", "whales"));
+  ASSERT_TRUE(MatchesPattern("wh?le", "while"));
+  ASSERT_FALSE(MatchesPattern("wh?le", "whle"));
+  ASSERT_TRUE(MatchesPattern("*ing", "sing"));
+  ASSERT_FALSE(MatchesPattern("*ing", "singer"));
+  ASSERT_TRUE(MatchesPattern("m*ss*pp*", "mississippi"));
+  ASSERT_TRUE(MatchesPattern("a*b*c", "abxbxc"));
+  ASSERT_FALSE(MatchesPattern("a*b*c", "abxbx"));
+
+  HW3Environment::AddPoints(5);
+}
+
+TEST_F(Test_TermDictReader, TestTermDictReaderBasic) {
+  HW3Environment::OpenTestCase();
+
+  FileIndexReader fir(idx_name_);
+  TermDictReader* tdr = fir.NewTermDictReader();
+  ASSERT_NE(static_cast<TermDictReader*>(nullptr), tdr);
+  IndexTableReader* itr = fir.NewIndexTableReader();
+
+  // Every word in the dictionary leads to its own docID table.
+  vector<TermDictReader::Term> terms;
+  ASSERT_TRUE(tdr->LookupPattern("*", tdr->NumTerms(), &terms));
+  ASSERT_EQ(static_cast<size_t>(tdr->NumTerms()), terms.size());
+  for (size_t i = 0; i < terms.size(); i += 97) {
+    if (i > 0) {
+      ASSERT_LT(terms[i - 1].word, terms[i].word);
+    }
+    DocIDTableReader* expected = itr->LookupWord(terms[i].word);
+    ASSERT_NE(static_cast<DocIDTableReader*>(nullptr), expected);
+    DocIDTableReader* actual = itr->LookupElement(terms[i].element);
+    ASSERT_EQ(expected->NumDocIDs(), actual->NumDocIDs());
+    ASSERT_EQ(expected->GetDocIDList().front().doc_id,
+              actual->GetDocIDList().front().doc_id);
+    delete expected;
+    delete actual;
+  }
+
+  // Prefixes and wildcards.
+  terms.clear();
+  ASSERT_TRUE(tdr->LookupPattern("whale", 100, &terms));
+  ASSERT_EQ(1U, terms.size());
+  ASSERT_EQ(string("whale"), terms[0].word);
+
+  terms.clear();
+  ASSERT_TRUE(tdr->LookupPattern("wha*", 100, &terms));
+  ASSERT_LT(1U, terms.size());
+  for (const TermDictReader::Term& term : terms) {
+    ASSERT_EQ(string("wha"), term.word.substr(0, 3));
+  }
+
+  terms.clear();
+  ASSERT_TRUE(tdr->LookupPattern("zzzxxyyqq*", 100, &terms));
+  ASSERT_EQ(0U, terms.size());
+
+  // Too many matches are cut off.
+  terms.clear();
+  ASSERT_FALSE(tdr->LookupPattern("s*", 10, &terms));
+  ASSERT_EQ(10U, terms.size());
+
+  delete itr;
+  delete tdr;
+
+  // Done!
+  HW3Environment::AddPoints(10);
+}
+
+TEST_F(Test_TermDictReader, TestQueryProcessorWildcard) {
+  HW3Environment::OpenTestCase();
+
+  list<string> idx_list;
+  idx_list.push_back(idx_name_);
+  QueryProcessor qp(idx_list, true, QueryProcessor::kRankByBM25);
+
+  // A pattern matches exactly what an OR of the words it expands to does.
+  FileIndexReader fir(idx_name_);
+  TermDictReader* tdr = fir.NewTermDictReader();
+  vector<TermDictReader::Term> terms;
+  ASSERT_TRUE(tdr->LookupPattern("wha*", 100, &terms));
+  delete tdr;
+  string expansion;
+  for (const TermDictReader::Term& term : terms) {
+    expansion += (expansion.empty() ? "" : " OR ") + term.word;
+  }
+
+  vector<QueryProcessor::QueryResult> expected =
+    qp.ProcessQuery(ParseQuery("(" + expansion + ") ocean"));
+  vector<QueryProcessor::QueryResult> actual =
+    qp.ProcessQuery(ParseQuery("ocean wha*"));
+  ASSERT_LT(0U, actual.size());
+  ASSERT_EQ(expected.size(), actual.size());
+
+  // The scores are summed in a different order, so near-ties may come
+  // out in a different order too.
+  std::map<string, const QueryProcessor::QueryResult*> expected_docs;
+  for (const QueryProcessor::QueryResult& result : expected) {
+    expected_docs[result.document_name] = &result;
+  }
+  for (const QueryProcessor::QueryResult& result : actual) {
+    ASSERT_EQ(1U, expected_docs.count(result.document_name));
+    ASSERT_EQ(expected_docs[result.document_name]->rank, result.rank);
+    ASSERT_FLOAT_EQ(expected_docs[result.document_name]->score,
+                    result.score);
+  }
+
+  ASSERT_EQ(0U, qp.ProcessQuery(ParseQuery("zzzxxyyqq*")).size());
+
+  // Patterns that match too many words are reported, once each.
+  vector<string> truncated = { "stale" };
+  qp.ProcessQuery(ParseQuery("ocean wha*"), nullptr, nullptr, &truncated);
+  ASSERT_EQ(0U, truncated.size());
+
+  terms.clear();
+  tdr = fir.NewTermDictReader();
+  ASSERT_FALSE(tdr->LookupPattern("*e*", QueryProcessor::kMaxWildcardTerms,
+                                  &terms));
+  delete tdr;
+  QueryProcessor::QueryExplain explain;
+  QueryNode query = ParseQuery("*e* OR (*e* wha*) OR s*");
+  vector<QueryProcessor::QueryResult> results =
+    qp.ProcessQuery(query, nullptr, &explain, &truncated);
+  ASSERT_LT(0U, results.size());
+  ASSERT_EQ(vector<string>({ "*e*", "s*" }), truncated);
+  ASSERT_EQ(results.size(), qp.MatchQuery(query, &truncated).size());
+  ASSERT_EQ(vector<string>({ "*e*", "s*" }), truncated);
+  for (const QueryProcessor::QueryExplain::Term& term : explain.terms) {
+    ASSERT_EQ(term.term != "wha*", term.truncated);
+  }
+
+  // Done!
+  HW3Environment::AddPoints(10);
+}
+
+}  // namespace hw3
@@ -28,6 +28,51 @@ TEST(Test_Utils, TestCRC32) {
   ASSERT_EQ(((uint32_t) 0xB63CFBCD), crc.GetFinalCRC());
 }
 
+// Checksumming a sequence in pieces and combining the pieces' CRCs should
+// give the same CRC as checksumming it in one go.
+TEST(Test_Utils, TestCRC32Combine) {
+  uint8_t bytes[1000];
+  for (int i = 0; i < 1000; i++) {
+    bytes[i] = static_cast<uint8_t>(i * 7 + i / 13);
+  }
+  CRC32 whole;
+  whole.FoldBytesIntoCRC(bytes, sizeof(bytes));
+  uint32_t expected = whole.GetFinalCRC();
+
+  for (size_t split : {0, 1, 3, 500, 999, 1000}) {
+    CRC32 a, b;
+    a.FoldBytesIntoCRC(bytes, split);
+    b.FoldBytesIntoCRC(bytes + split, sizeof(bytes) - split);
+    ASSERT_EQ(expected, CRC32::Combine(a.GetFinalCRC(), b.GetFinalCRC(),
+                                       sizeof(bytes) - split));
+  }
+}
+
+// The magic number records both the hash function and the format, and
+// callers that don't ask for the format only accept the original one.
+TEST(Test_Utils, TestMagicNumber) {
+  HTHashID_t hash_id;
+  IndexFormat format;
+  ASSERT_EQ(kMagicNumber, MagicNumberForHashID(HT_HASH_FNV1A64));
+  ASSERT_TRUE(HashIDForMagicNumber(kMagicNumber, &hash_id, &format));
+  ASSERT_EQ(HT_HASH_FNV1A64, hash_id);
+  ASSERT_EQ(kIndexFormat32, format);
+
+  for (int id = 0; id < HT_NUM_HASH_IDS; id++) {
+    for (IndexFormat other : {kIndexFormat64, kIndexFormatNative}) {
+      uint32_t magic =
+        MagicNumberForHashID(static_cast<HTHashID_t>(id), other);
+      ASSERT_TRUE(HashIDForMagicNumber(magic, &hash_id, &format));
+      ASSERT_EQ(id, hash_id);
+      ASSERT_EQ(other, format);
+      ASSERT_FALSE(HashIDForMagicNumber(magic, &hash_id));
+    }
+  }
+  ASSERT_FALSE(HashIDForMagicNumber(kMagicNumber + HT_NUM_HASH_IDS, &hash_id,
+                                    &format));
+  ASSERT_FALSE(HashIDForMagicNumber(kMagicNumber + 0x300, &hash_id, &format));
+}
+
 // This is the unit test for the htonll and ntohll macros.
 TEST(Test_Utils, TestHtonll) {
   uint64_t small = 0x01ULL;
@@ -0,0 +1,98 @@
+/*
+ * Copyright ©2024 Hannah C. Tang.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Washington
+ * CSE 333 for use solely during Spring Quarter 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#include <string.h>
+
+#include <string>
+
+#include "gtest/gtest.h"
+
+extern "C" {
+  #include "./MemIndex.h"
+  #include "./WordPool.h"
+}
+
+#include "./test_suite.h"
+
+using std::string;
+
+namespace hw2 {
+
+// Interns a null-terminated word.
+static const char* Intern(const char* word) {
+  int len = strlen(word);
+  return WordPool_Intern(word, len, MemIndex_HashWord(word, len));
+}
+
+TEST(Test_WordPool, Intern) {
+  HW2Environment::OpenTestCase();
+  ASSERT_EQ(0, WordPool_NumWords());
+  WordPool_Acquire();
+
+  const char* whale = Intern("whale");
+  ASSERT_STREQ("whale", whale);
+  ASSERT_EQ(1, WordPool_NumWords());
+
+  // The same word always comes back as the same pointer, however it was
+  // passed in.
+  char buf[] = "whalesong";
+  ASSERT_EQ(whale, WordPool_Intern(buf, 5, MemIndex_HashWord(buf, 5)));
+  ASSERT_EQ(whale, Intern("whale"));
+  ASSERT_EQ(1, WordPool_NumWords());
+
+  const char* ocean = Intern("ocean");
+  ASSERT_NE(whale, ocean);
+  ASSERT_STREQ("ocean", ocean);
+  ASSERT_EQ(2, WordPool_NumWords());
+
+  // Fill a few chunks, with an oversized word in the middle.
+  string big(100 * 1024, 'z');
+  const char* big_copy = nullptr;
+  for (int i = 0; i < 20000; i++) {
+    if (i == 10000) {
+      big_copy = Intern(big.c_str());
+    }
+    Intern(("word" + std::to_string(i)).c_str());
+  }
+  ASSERT_EQ(20003, WordPool_NumWords());
+  ASSERT_EQ(big, big_copy);
+  ASSERT_EQ(big_copy, Intern(big.c_str()));
+  ASSERT_STREQ("word12345", Intern("word12345"));
+  ASSERT_EQ(whale, Intern("whale"));
+  ASSERT_EQ(20003, WordPool_NumWords());
+
+  WordPool_Release();
+  ASSERT_EQ(0, WordPool_NumWords());
+  HW2Environment::AddPoints(10);
+}
+
+TEST(Test_WordPool, SharedByIndices) {
+  HW2Environment::OpenTestCase();
+
+  // Two indices share the pool, which lives until both are freed.
+  MemIndex* first = MemIndex_Allocate();
+  MemIndex* second = MemIndex_Allocate();
+  LinkedList* postings = LinkedList_Allocate();
+  LinkedList_Append(postings, (LLPayload_t) 0);
+  MemIndex_AddPostingList(first, strdup("whale"), 1, postings);
+  postings = LinkedList_Allocate();
+  LinkedList_Append(postings, (LLPayload_t) 0);
+  MemIndex_AddPostingList(second, strdup("whale"), 1, postings);
+  ASSERT_EQ(1, WordPool_NumWords());
+
+  MemIndex_Free(first);
+  ASSERT_EQ(1, WordPool_NumWords());
+  MemIndex_Free(second);
+  ASSERT_EQ(0, WordPool_NumWords());
+  HW2Environment::AddPoints(5);
+}
+
+}  // namespace hw2
@@ -9,13 +9,17 @@
  * author.
  */
 
+#include <sys/stat.h>
 #include <sys/types.h>
 #include <stdint.h>
 #include <unistd.h>
 
+#include <fstream>
 #include <iostream>
+#include <list>
 #include <sstream>
 #include <string>
+#include <vector>
 
 #include "gtest/gtest.h"
 extern "C" {
@@ -24,13 +28,19 @@ extern "C" {
   #include "libhw2/MemIndex.h"
 }
 #include "./test_suite.h"
+#include "./DocIDTableReader.h"
+#include "./DocTableReader.h"
+#include "./FileIndexReader.h"
+#include "./IndexTableReader.h"
 #include "./WriteIndex.h"
 #include "./hw3fsck/FileIndexChecker.h"
 
 using std::cout;
 using std::endl;
+using std::list;
 using std::string;
 using std::stringstream;
+using std::vector;
 
 namespace hw3 {
 
@@ -104,4 +114,179 @@ TEST_F(Test_WriteIndex, Basic) {
   ASSERT_EQ(0, unlink(f_name.c_str()));
 }
 
+// Writes each spill of a budgeted crawl out as a run named after the
+// vector's first element, which is the prefix for the runs' names.
+static bool SpillRun(MemIndex* index, void* arg) {
+  vector<string>* names = static_cast<vector<string>*>(arg);
+  string name = (*names)[0] + std::to_string(names->size());
+  if (WriteIndexRun(index, name.c_str()) <= 0) {
+    return false;
+  }
+  names->push_back(name);
+  return true;
+}
+
+// Checks that every word in the crawl's MemIndex has the same postings in
+// the index file "f_name".
+static void ExpectSamePostings(MemIndex* mi, const string& f_name) {
+  FileIndexReader fir(f_name);
+  IndexTableReader* itr = fir.NewIndexTableReader();
+  HTIterator word_it;
+  for (HTIterator_Init(&word_it, mi);
+       HTIterator_IsValid(&word_it);
+       HTIterator_Next(&word_it)) {
+    HTKeyValue_t word_kv;
+    HTIterator_Get(&word_it, &word_kv);
+    WordPostings* wp = static_cast<WordPostings*>(word_kv.value);
+    DocIDTableReader* ditr = itr->LookupWord(wp->word);
+    ASSERT_NE(nullptr, ditr);
+    ASSERT_EQ(HashTable_NumElements(wp->postings), ditr->NumDocIDs());
+
+    HTIterator doc_it;
+    for (HTIterator_Init(&doc_it, wp->postings);
+         HTIterator_IsValid(&doc_it);
+         HTIterator_Next(&doc_it)) {
+      HTKeyValue_t kv;
+      HTIterator_Get(&doc_it, &kv);
+      list<DocPositionOffset_t> positions;
+      ASSERT_TRUE(ditr->LookupDocID(kv.key, &positions));
+      ASSERT_EQ(LinkedList_NumElements(static_cast<LinkedList*>(kv.value)),
+                static_cast<int>(positions.size()));
+    }
+    delete ditr;
+  }
+  delete itr;
+}
+
+// Test that an index built in bounded memory and merged from runs holds
+// the same postings as one built in memory.
+TEST_F(Test_WriteIndex, MergeRuns) {
+  HW3Environment::OpenTestCase();
+
+  stringstream ss;
+  ss << "/tmp/test." << (uint32_t) getpid() << ".index";
+  string f_name = ss.str();
+
+  // A small budget, so that there are plenty of runs.
+  vector<string> names = {f_name + ".run"};
+  DocTable* dt;
+  ASSERT_TRUE(CrawlFileTree_Spill(
+                const_cast<char*>("./test_tree/enron_email"), &dt,
+                256 * 1024, &SpillRun, &names));
+  names.erase(names.begin());
+  ASSERT_LT(2U, names.size());
+  ASSERT_EQ(DocTable_NumDocs(dt_), DocTable_NumDocs(dt));
+
+  ASSERT_LT(100000, MergeIndexRuns(names, dt, f_name.c_str()));
+  ExpectSamePostings(mi_, f_name);
+  ASSERT_EQ(0, unlink(f_name.c_str()));
+
+  // A run cut short (say, by a full disk) makes the merge fail, leaving
+  // no index file behind, wherever the run ends.
+  struct stat st;
+  ASSERT_EQ(0, stat(names.back().c_str(), &st));
+  for (off_t size : {st.st_size - 1, st.st_size / 2, st.st_size / 8,
+                     static_cast<off_t>(8)}) {
+    ASSERT_EQ(0, truncate(names.back().c_str(), size));
+    ASSERT_GT(0, MergeIndexRuns(names, dt, f_name.c_str()));
+    ASSERT_NE(0, access(f_name.c_str(), F_OK));
+  }
+
+  for (const string& name : names) {
+    ASSERT_EQ(0, unlink(name.c_str()));
+  }
+  DocTable_Free(dt);
+  HW3Environment::AddPoints(20);
+}
+
+// Reads the whole of file "name" into a string.
+static string ReadFile(const string& name) {
+  std::ifstream in(name, std::ios::binary);
+  stringstream ss;
+  ss << in.rdbuf();
+  return ss.str();
+}
+
+// Test that the index file is the same however many threads write it.
+TEST_F(Test_WriteIndex, Parallel) {
+  HW3Environment::OpenTestCase();
+
+  stringstream ss;
+  ss << "/tmp/test." << (uint32_t) getpid() << ".index";
+  string f_name = ss.str();
+
+  int res = WriteIndex(mi_, dt_, f_name.c_str(), 1);
+  ASSERT_LT(100000, res);
+  string serial = ReadFile(f_name);
+  for (int num_threads : {2, 3, 8}) {
+    ASSERT_EQ(res, WriteIndex(mi_, dt_, f_name.c_str(), num_threads));
+    ASSERT_TRUE(serial == ReadFile(f_name)) << num_threads << " threads";
+  }
+
+  ASSERT_EQ(0, unlink(f_name.c_str()));
+  HW3Environment::AddPoints(10);
+}
+
+// Test that an index in the 64-bit format holds the same postings, and
+// that the readers find their way around it.
+TEST_F(Test_WriteIndex, Format64) {
+  HW3Environment::OpenTestCase();
+
+  stringstream ss;
+  ss << "/tmp/test." << (uint32_t) getpid() << ".index";
+  string f_name = ss.str();
+
+  int64_t narrow_bytes = WriteIndex(mi_, dt_, f_name.c_str());
+  ASSERT_LT(100000, narrow_bytes);
+  int64_t wide_bytes = WriteIndex(mi_, dt_, f_name.c_str(), 0,
+                                  kIndexFormat64);
+  ASSERT_LT(narrow_bytes, wide_bytes);
+
+  {
+    FileIndexReader fir(f_name);
+    ASSERT_EQ(kIndexFormat64, fir.format());
+    DocTableReader* dtr = fir.NewDocTableReader();
+    ASSERT_EQ(DocTable_NumDocs(dt_), dtr->NumDocs());
+    string name;
+    ASSERT_TRUE(dtr->LookupDocID(1, &name));
+    ASSERT_STREQ(DocTable_GetDocName(dt_, 1), name.c_str());
+    delete dtr;
+  }
+  ExpectSamePostings(mi_, f_name);
+
+  ASSERT_EQ(0, unlink(f_name.c_str()));
+  HW3Environment::AddPoints(10);
+}
+
+// Test that an index in the native format holds the same postings, and
+// that its padding doesn't depend on how it was written.
+TEST_F(Test_WriteIndex, FormatNative) {
+  HW3Environment::OpenTestCase();
+
+  stringstream ss;
+  ss << "/tmp/test." << (uint32_t) getpid() << ".index";
+  string f_name = ss.str();
+
+  int64_t res = WriteIndex(mi_, dt_, f_name.c_str(), 1, kIndexFormatNative);
+  ASSERT_LT(100000, res);
+  string serial = ReadFile(f_name);
+  ASSERT_EQ(res, WriteIndex(mi_, dt_, f_name.c_str(), 3, kIndexFormatNative));
+  ASSERT_TRUE(serial == ReadFile(f_name));
+
+  {
+    FileIndexReader fir(f_name);
+    ASSERT_EQ(kIndexFormatNative, fir.format());
+    DocTableReader* dtr = fir.NewDocTableReader();
+    ASSERT_EQ(DocTable_NumDocs(dt_), dtr->NumDocs());
+    string name;
+    ASSERT_TRUE(dtr->LookupDocID(1, &name));
+    ASSERT_STREQ(DocTable_GetDocName(dt_, 1), name.c_str());
+    delete dtr;
+  }
+  ExpectSamePostings(mi_, f_name);
+
+  ASSERT_EQ(0, unlink(f_name.c_str()));
+  HW3Environment::AddPoints(10);
+}
+
 }  // namespace hw3
@@ -0,0 +1,137 @@
+/*
+ * Copyright ©2024 Hannah C. Tang.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Washington
+ * CSE 333 for use solely during Spring Quarter 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#include <stdlib.h>
+#include <sys/time.h>
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <list>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "./QueryProcessor.h"
+
+using std::cerr;
+using std::cout;
+using std::endl;
+using std::list;
+using std::string;
+using std::vector;
+
+using hw3::QueryProcessor;
+
+void Usage(char* filename) {
+  cerr << "Usage: " << filename;
+  cerr << " [-k num] queryfile indexfilename+" << endl;
+  cerr << "where:" << endl;
+  cerr << "  num is the number of results to keep (default 10)" << endl;
+  cerr << "  queryfile contains one whitespace-separated query per line"
+       << endl;
+  cerr << "  indexfilename+ are the index files to query" << endl;
+  exit(EXIT_FAILURE);
+}
+
+// Returns the current time, in microseconds.
+static double NowMicros() {
+  struct timeval tv;
+  gettimeofday(&tv, nullptr);
+  return tv.tv_sec * 1e6 + tv.tv_usec;
+}
+
+// Runs every query in a file through QueryProcessor::ProcessQueryTopK()
+// twice, once exhaustively and once with MaxScore pruning, and reports how
+// many postings each one scored and how long it took.  Also checks that
+// pruning didn't change the top-k scores.
+int main(int argc, char** argv) {
+  int k = 10;
+  int arg = 1;
+  if (argc > 2 && strcmp(argv[1], "-k") == 0) {
+    k = atoi(argv[2]);
+    arg += 2;
+  }
+  if (k <= 0 || argc - arg < 2)
+    Usage(argv[0]);
+
+  std::ifstream query_file(argv[arg++]);
+  if (!query_file)
+    Usage(argv[0]);
+
+  list<string> index_list;
+  for (; arg < argc; arg++) {
+    index_list.push_back(argv[arg]);
+  }
+  QueryProcessor qp(index_list, true, QueryProcessor::kRankByBM25);
+
+  cout << "# query\tpostings\texhaustive_scored\tpruned_scored"
+       << "\texhaustive_us\tpruned_us" << endl;
+
+  int64_t total_postings = 0, total_exhaustive = 0, total_pruned = 0;
+  double total_exhaustive_us = 0, total_pruned_us = 0;
+  int num_queries = 0, num_mismatches = 0;
+  string line;
+  while (std::getline(query_file, line)) {
+    std::istringstream ss(line);
+    vector<string> query;
+    string word;
+    while (ss >> word) {
+      std::transform(word.begin(), word.end(), word.begin(), ::tolower);
+      query.push_back(word);
+    }
+    if (query.empty())
+      continue;
+
+    QueryProcessor::TopKStats exhaustive_stats, pruned_stats;
+    double start = NowMicros();
+    vector<QueryProcessor::QueryResult> exhaustive =
+      qp.ProcessQueryTopK(query, k, &exhaustive_stats, false);
+    double exhaustive_us = NowMicros() - start;
+
+    start = NowMicros();
+    vector<QueryProcessor::QueryResult> pruned =
+      qp.ProcessQueryTopK(query, k, &pruned_stats, true);
+    double pruned_us = NowMicros() - start;
+
+    // Ties may be broken differently, so only compare the scores.
+    bool match = exhaustive.size() == pruned.size();
+    for (size_t i = 0; match && i < pruned.size(); i++) {
+      match = exhaustive[i].score == pruned[i].score;
+    }
+    if (!match) {
+      num_mismatches++;
+      cerr << "MISMATCH: " << line << endl;
+    }
+
+    cout << line << "\t" << exhaustive_stats.postings_total
+         << "\t" << exhaustive_stats.postings_scored
+         << "\t" << pruned_stats.postings_scored
+         << "\t" << static_cast<int64_t>(exhaustive_us)
+         << "\t" << static_cast<int64_t>(pruned_us) << endl;
+
+    num_queries++;
+    total_postings += exhaustive_stats.postings_total;
+    total_exhaustive += exhaustive_stats.postings_scored;
+    total_pruned += pruned_stats.postings_scored;
+    total_exhaustive_us += exhaustive_us;
+    total_pruned_us += pruned_us;
+  }
+
+  cout << "# queries=" << num_queries << " k=" << k
+       << " postings=" << total_postings
+       << " exhaustive_scored=" << total_exhaustive
+       << " pruned_scored=" << total_pruned
+       << " exhaustive_us=" << static_cast<int64_t>(total_exhaustive_us)
+       << " pruned_us=" << static_cast<int64_t>(total_pruned_us)
+       << " mismatches=" << num_mismatches << endl;
+  return num_mismatches == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}